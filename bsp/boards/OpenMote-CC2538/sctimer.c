@@ -0,0 +1,85 @@
+/**
+ * Author: Xavier Vilajosana (xvilajosana@eecs.berkeley.edu)
+ *         Pere Tuset (peretuset@openmote.com)
+ * Date:   July 2013
+ * Description: CC2538-specific definition of the "sctimer" bsp module, on
+ *              the sleep timer, which keeps counting in all power modes.
+ *              Built with abstimer=1, instead of bsp_timer.c and
+ *              radiotimer.c.
+ */
+
+#include <headers/hw_ints.h>
+
+#include "string.h"
+#include "sctimer.h"
+#include "board.h"
+#include "interrupt.h"
+#include "sleepmode.h"
+#include "debugpins.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+typedef struct {
+   sctimer_cbt    cb;
+} sctimer_vars_t;
+
+sctimer_vars_t sctimer_vars;
+
+//=========================== prototypes ======================================
+
+void sctimer_isr_private(void);
+
+//=========================== public ==========================================
+
+/**
+ \brief Initialize this module.
+
+ The sleep timer counts from power-up and can not be reset; this does not arm
+ the compare, so no interrupt fires.
+ */
+void sctimer_init() {
+   // clear local variables
+   memset(&sctimer_vars,0,sizeof(sctimer_vars_t));
+
+   IntRegister(INT_SMTIM, sctimer_isr_private);
+}
+
+void sctimer_setCb(sctimer_cbt cb) {
+   sctimer_vars.cb = cb;
+}
+
+/**
+ \brief Fire when the counter next matches val.
+ */
+void sctimer_schedule(PORT_TIMER_WIDTH val) {
+   SleepModeTimerCompareSet(val);
+   IntEnable(INT_SMTIM);
+}
+
+PORT_TIMER_WIDTH sctimer_getValue() {
+   return SleepModeTimerCountGet();
+}
+
+void sctimer_stop() {
+   IntDisable(INT_SMTIM);
+}
+
+void sctimer_clearISR() {
+   IntPendClear(INT_SMTIM);
+}
+
+void sctimer_reset() {
+   // the counter can not be reset, only the compare
+   sctimer_stop();
+}
+
+//=========================== private =========================================
+
+void sctimer_isr_private(void) {
+   debugpins_isr_set();
+   IntPendClear(INT_SMTIM);
+   sctimer_vars.cb();
+   debugpins_isr_clr();
+}
@@ -0,0 +1,87 @@
+#ifndef __ABSTIMER_H
+#define __ABSTIMER_H
+
+/**
+\addtogroup BSP
+\{
+\addtogroup abstimer
+\{
+
+\brief Declaration of the "abstimer" bsp module, which serves the "bsp_timer"
+       and "radiotimer" modules from the single compare channel of the
+       "sctimer".
+
+\author Xavi Vilajosana <xvilajosana@eecs.berkeley.edu>, May 2012.
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, May 2012.
+*/
+
+#include "stdint.h"
+#include "board.h"
+#include "bsp_timer.h"
+#include "radiotimer.h"
+#include "sctimer.h"
+
+//=========================== define ==========================================
+
+/// Ticks ahead of the counter the sctimer compare can be loaded without being missed
+#ifndef ABSTIMER_GUARD_TICKS
+#define ABSTIMER_GUARD_TICKS      2
+#endif
+
+/// Furthest the sctimer is scheduled, so its counter does not wrap around unseen
+#define ABSTIMER_MAX_SCHEDULE     ((PORT_TIMER_WIDTH)(((PORT_TIMER_WIDTH)~0)-(((PORT_TIMER_WIDTH)~0)>>3)))
+
+//=========================== typedef =========================================
+
+/// virtual compare channels, by decreasing priority
+typedef enum {
+   ABSTIMER_SRC_RADIOTIMER_OVERFLOW = 0,
+   ABSTIMER_SRC_RADIOTIMER_COMPARE,
+   ABSTIMER_SRC_BSP_TIMER,
+   ABSTIMER_SRC_MAX,
+} abstimer_src_t;
+
+typedef struct {
+   uint32_t                  num_bsp_timer;           // bsp_timer compare events served
+   uint32_t                  num_radiotimer_overflow; // radiotimer overflow events served
+   uint32_t                  num_radiotimer_compare;  // radiotimer compare events served
+   uint32_t                  num_late_schedule;       // events served after they were due
+   uint32_t                  nested_isr;              // interrupts entered while serving one, should stay 0
+   uint32_t                  consecutive_late;        // late events served by the last interrupt
+   uint32_t                  count_late;              // interrupts which served a late event
+} abstimer_dbg_t;
+
+typedef struct {
+   // time
+   uint64_t                  now;                     // ticks since abstimer_init(), extending the sctimer counter
+   PORT_TIMER_WIDTH          hwNow;                   // value of the sctimer counter at now
+   bool                      inIsr;                   // serving the sctimer interrupt
+   // virtual compare channels
+   bool                      isArmed[ABSTIMER_SRC_MAX];
+   uint64_t                  expiry[ABSTIMER_SRC_MAX];
+   // bsp_timer
+   bsp_timer_cbt             bsp_timer_cb;
+   uint64_t                  bsp_timer_start;         // when the counter of the bsp_timer was reset
+   uint64_t                  bsp_timer_lastCompare;   // compare value scheduleIn() counts from
+   // radiotimer
+   radiotimer_compare_cbt    overflow_cb;
+   radiotimer_compare_cbt    compare_cb;
+   uint64_t                  radiotimer_start;        // when the counter of the radiotimer last wrapped
+   PORT_RADIOTIMER_WIDTH     radiotimer_period;
+} abstimer_vars_t;
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+void               abstimer_init(void);
+
+// interrupt handlers
+kick_scheduler_t   abstimer_isr(void);
+
+/**
+\}
+\}
+*/
+
+#endif
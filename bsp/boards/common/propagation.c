@@ -0,0 +1,276 @@
+/**
+\brief Radio propagation model of the simulated boards.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include <stdlib.h>
+#include <math.h>
+#include "propagation.h"
+
+//=========================== defines =========================================
+
+#define PROPAGATION_MIN_BUCKETS      64
+#define PROPAGATION_MIN_DISTANCE     1.0     // m, where the path loss is pathLoss1m
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+static int      propagation_growNodes(propagation_t* p, uint32_t id);
+static int      propagation_rehash(propagation_t* p, uint32_t numBuckets);
+static void     propagation_insert(propagation_t* p, uint32_t id);
+static void     propagation_remove(propagation_t* p, uint32_t id);
+static uint32_t propagation_bucket(propagation_t* p, int32_t cellX, int32_t cellY);
+static int32_t  propagation_cell(propagation_t* p, double coord);
+
+//=========================== public ==========================================
+
+void propagation_init(propagation_t* p) {
+   p->nodes       = NULL;
+   p->maxNodes    = 0;
+   p->buckets     = NULL;
+   p->numBuckets  = 0;
+   p->numPlaced   = 0;
+   propagation_setModel(
+      p,
+      PROPAGATION_TXPOWER,
+      PROPAGATION_PATHLOSS_1M,
+      PROPAGATION_EXPONENT,
+      PROPAGATION_SENSITIVITY
+   );
+}
+
+void propagation_free(propagation_t* p) {
+   free(p->nodes);
+   free(p->buckets);
+   p->nodes       = NULL;
+   p->maxNodes    = 0;
+   p->buckets     = NULL;
+   p->numBuckets  = 0;
+   p->numPlaced   = 0;
+}
+
+/**
+\brief Change the parameters of the path loss model.
+
+\returns 0 on success, -1 if the parameters are invalid or the index is out
+   of memory.
+*/
+int propagation_setModel(propagation_t* p,
+                           double txPower,
+                           double pathLoss1m,
+                           double exponent,
+                           double sensitivity) {
+   if (exponent<=0) {
+      return -1;
+   }
+   p->txPower     = txPower;
+   p->pathLoss1m  = pathLoss1m;
+   p->exponent    = exponent;
+   p->sensitivity = sensitivity;
+
+   // distance at which the received signal drops to the sensitivity
+   p->range       = pow(10,(txPower-pathLoss1m-sensitivity)/(10*exponent));
+   if (p->range<PROPAGATION_MIN_DISTANCE) {
+      p->range    = PROPAGATION_MIN_DISTANCE;
+   }
+
+   // the size of the cells changed
+   if (p->numPlaced==0) {
+      return 0;
+   }
+   return propagation_rehash(p,p->numBuckets);
+}
+
+/**
+\brief Place a mote on the plane, or move it.
+
+\returns 0 on success, -1 if the index is out of memory.
+*/
+int propagation_setPosition(propagation_t* p, uint32_t id, double x, double y) {
+   propagation_node_t* node;
+
+   if (propagation_growNodes(p,id)<0) {
+      return -1;
+   }
+   node = &p->nodes[id];
+   if (node->placed) {
+      propagation_remove(p,id);
+   } else {
+      node->placed = 1;
+      p->numPlaced++;
+   }
+   node->x = x;
+   node->y = y;
+
+   // keep buckets short
+   if (p->numPlaced>p->numBuckets) {
+      if (propagation_rehash(p,(p->numBuckets==0) ? PROPAGATION_MIN_BUCKETS : 2*p->numBuckets)<0) {
+         node->placed = 0;
+         p->numPlaced--;
+         return -1;
+      }
+      return 0;
+   }
+   propagation_insert(p,id);
+   return 0;
+}
+
+uint8_t propagation_isPlaced(propagation_t* p, uint32_t id) {
+   return id<p->maxNodes && p->nodes[id].placed;
+}
+
+/**
+\brief List the motes which hear a mote.
+
+Writes at most maxLinks links. Their order only depends on the calls made to
+the index, so simulations are repeatable.
+
+\returns the number of motes in range, which can be larger than maxLinks.
+*/
+uint32_t propagation_getLinks(propagation_t* p,
+                                uint32_t id,
+                                propagation_link_t* links,
+                                uint32_t maxLinks) {
+   propagation_node_t* src;
+   propagation_node_t* dst;
+   int32_t             cellX;
+   int32_t             cellY;
+   int32_t             j;
+   int8_t              dx;
+   int8_t              dy;
+   double              distance;
+   double              rssi;
+   double              pdr;
+   uint32_t            numLinks;
+
+   if (propagation_isPlaced(p,id)==0) {
+      return 0;
+   }
+   src      = &p->nodes[id];
+   numLinks = 0;
+   for (dx=-1;dx<=1;dx++) {
+      for (dy=-1;dy<=1;dy++) {
+         cellX = src->cellX+dx;
+         cellY = src->cellY+dy;
+         for (j=p->buckets[propagation_bucket(p,cellX,cellY)];j>=0;j=p->nodes[j].next) {
+            dst = &p->nodes[j];
+            // cells sharing a bucket are looked up separately
+            if ((uint32_t)j==id || dst->cellX!=cellX || dst->cellY!=cellY) {
+               continue;
+            }
+            distance = hypot(dst->x-src->x,dst->y-src->y);
+            if (distance>p->range) {
+               continue;
+            }
+            if (distance<PROPAGATION_MIN_DISTANCE) {
+               distance = PROPAGATION_MIN_DISTANCE;
+            }
+            rssi = p->txPower-p->pathLoss1m-10*p->exponent*log10(distance);
+            pdr  = (rssi-p->sensitivity)/PROPAGATION_PDR_MARGIN;
+            if (pdr<=0) {
+               continue;
+            }
+            if (numLinks<maxLinks) {
+               links[numLinks].dst  = (uint32_t)j;
+               links[numLinks].rssi = (int8_t)((rssi<-128) ? -128 : (rssi>127) ? 127 : lround(rssi));
+               links[numLinks].pdr  = (pdr>1) ? 1 : pdr;
+            }
+            numLinks++;
+         }
+      }
+   }
+   return numLinks;
+}
+
+//=========================== private =========================================
+
+static int propagation_growNodes(propagation_t* p, uint32_t id) {
+   propagation_node_t* nodes;
+   uint32_t            maxNodes;
+   uint32_t            i;
+
+   if (id<p->maxNodes) {
+      return 0;
+   }
+   maxNodes = (p->maxNodes==0) ? 16 : p->maxNodes;
+   while (maxNodes<=id) {
+      maxNodes *= 2;
+   }
+   nodes = realloc(p->nodes,maxNodes*sizeof(propagation_node_t));
+   if (nodes==NULL) {
+      return -1;
+   }
+   for (i=p->maxNodes;i<maxNodes;i++) {
+      nodes[i].placed = 0;
+      nodes[i].next   = -1;
+   }
+   p->nodes    = nodes;
+   p->maxNodes = maxNodes;
+   return 0;
+}
+
+/**
+\brief Rebuild the index with numBuckets buckets.
+
+Also recomputes the cell of each mote, so it is called when the range
+changes.
+*/
+static int propagation_rehash(propagation_t* p, uint32_t numBuckets) {
+   int32_t* buckets;
+   uint32_t i;
+
+   if (numBuckets!=p->numBuckets) {
+      buckets = realloc(p->buckets,numBuckets*sizeof(int32_t));
+      if (buckets==NULL) {
+         return -1;
+      }
+      p->buckets    = buckets;
+      p->numBuckets = numBuckets;
+   }
+   for (i=0;i<p->numBuckets;i++) {
+      p->buckets[i] = -1;
+   }
+   // insert in reverse, so each bucket lists its motes by index
+   for (i=p->maxNodes;i>0;i--) {
+      if (p->nodes[i-1].placed) {
+         propagation_insert(p,i-1);
+      }
+   }
+   return 0;
+}
+
+static void propagation_insert(propagation_t* p, uint32_t id) {
+   propagation_node_t* node;
+   uint32_t            bucket;
+
+   node          = &p->nodes[id];
+   node->cellX   = propagation_cell(p,node->x);
+   node->cellY   = propagation_cell(p,node->y);
+   bucket        = propagation_bucket(p,node->cellX,node->cellY);
+   node->next    = p->buckets[bucket];
+   p->buckets[bucket] = (int32_t)id;
+}
+
+static void propagation_remove(propagation_t* p, uint32_t id) {
+   int32_t* j;
+
+   j = &p->buckets[propagation_bucket(p,p->nodes[id].cellX,p->nodes[id].cellY)];
+   while (*j>=0) {
+      if ((uint32_t)*j==id) {
+         *j = p->nodes[id].next;
+         break;
+      }
+      j = &p->nodes[*j].next;
+   }
+   p->nodes[id].next = -1;
+}
+
+static uint32_t propagation_bucket(propagation_t* p, int32_t cellX, int32_t cellY) {
+   return (((uint32_t)cellX*73856093u)^((uint32_t)cellY*19349663u)) & (p->numBuckets-1);
+}
+
+static int32_t propagation_cell(propagation_t* p, double coord) {
+   return (int32_t)floor(coord/p->range);
+}
@@ -0,0 +1,80 @@
+/**
+\brief Radio propagation model of the simulated boards.
+
+Motes are placed on a plane. The signal a mote receives from another follows
+a log-distance path loss model; a frame is received when that signal is
+above the sensitivity of the radio, with a packet delivery ratio growing
+linearly from 0 at the sensitivity to 1 PROPAGATION_PDR_MARGIN dB above it.
+This bounds the distance a frame travels to the range of the model.
+
+Motes are indexed by the square cell of the plane, one range wide, they are
+in. The motes in range of a mote are therefore in the 3x3 cells around its
+own, and are found in O(neighbors) instead of O(motes). Cells are hashed into
+a table which grows with the number of motes, so the plane is unbounded.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __PROPAGATION_H
+#define __PROPAGATION_H
+
+#include <stdint.h>
+
+//=========================== define ==========================================
+
+#define PROPAGATION_TXPOWER          0       // dBm
+#define PROPAGATION_PATHLOSS_1M      40      // dB, at 2.4GHz
+#define PROPAGATION_EXPONENT         3
+#define PROPAGATION_SENSITIVITY      -97     // dBm
+/// dB above the sensitivity from which every frame is received
+#define PROPAGATION_PDR_MARGIN       10
+
+//=========================== typedef =========================================
+
+typedef struct {
+   double                    x;              ///< in m
+   double                    y;              ///< in m
+   int32_t                   cellX;
+   int32_t                   cellY;
+   int32_t                   next;           ///< next node in the same bucket, -1 at the end
+   uint8_t                   placed;
+} propagation_node_t;
+
+typedef struct {
+   uint32_t                  dst;
+    int8_t                   rssi;
+   double                    pdr;            ///< 0..1
+} propagation_link_t;
+
+typedef struct {
+   //===== model
+   double                    txPower;
+   double                    pathLoss1m;
+   double                    exponent;
+   double                    sensitivity;
+   double                    range;          ///< also the size of a cell
+   //===== spatial index
+   propagation_node_t*       nodes;          ///< indexed by mote
+   uint32_t                  maxNodes;
+   int32_t*                  buckets;        ///< first node of each bucket, -1 if empty
+   uint32_t                  numBuckets;     ///< a power of 2
+   uint32_t                  numPlaced;
+} propagation_t;
+
+//=========================== prototypes ======================================
+
+void      propagation_init(propagation_t* p);
+void      propagation_free(propagation_t* p);
+int       propagation_setModel(propagation_t* p,
+                                 double txPower,
+                                 double pathLoss1m,
+                                 double exponent,
+                                 double sensitivity);
+int       propagation_setPosition(propagation_t* p, uint32_t id, double x, double y);
+uint8_t   propagation_isPlaced(propagation_t* p, uint32_t id);
+uint32_t  propagation_getLinks(propagation_t* p,
+                                 uint32_t id,
+                                 propagation_link_t* links,
+                                 uint32_t maxLinks);
+
+#endif
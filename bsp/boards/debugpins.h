@@ -58,6 +58,14 @@ void debugpins_syncAck_set(void);
 
 void debugpins_debug_clr(void);
 void debugpins_debug_set(void);
+
+// events recorded by the simulator
+void debugpins_task_run(uintptr_t task);
+void debugpins_queue_alloc(uint8_t index, uint8_t creator);
+void debugpins_queue_free(uint8_t index, uint8_t owner);
+void debugpins_state_changed(uint8_t status);
+// host clock of the simulator, in microseconds
+uint32_t debugpins_host_clock(void);
 #endif
 
 /**
@@ -0,0 +1,75 @@
+/**
+\brief POSIX-specific definition of the "board" bsp module.
+
+The same executable runs either a mote or the radio medium the motes share:
+
+   03oos_openwsn_prog --hub [--medium <path>] [--topology full|chain|geo] [--positions <file>]
+   03oos_openwsn_prog --id <n> [--medium <path>] [--serial <link>] [--slowdown <n>]
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include <stdio.h>
+#include <unistd.h>
+#include "opendefs.h"
+#include "board.h"
+// bsp modules
+#include "debugpins.h"
+#include "leds.h"
+#include "uart.h"
+#include "bsp_timer.h"
+#include "radio.h"
+#include "radiotimer.h"
+#include "posix.h"
+#include "medium.h"
+
+//=========================== main ============================================
+
+extern int mote_main(void);
+
+int main(int argc, char** argv) {
+   if (posix_parseArgs(argc,argv)<0) {
+      return 2;
+   }
+   if (posix_vars.hub) {
+      return medium_main();
+   }
+   return mote_main();
+}
+
+//=========================== public ==========================================
+
+void board_init() {
+   posix_init();
+
+   // initialize bsp modules
+   debugpins_init();
+   leds_init();
+   uart_init();
+   bsp_timer_init();
+   radiotimer_init();
+   radio_init();
+}
+
+/**
+\brief Wait for the next interrupt.
+
+Flushes the serial port, then runs the event loop until at least one
+interrupt was dispatched.
+*/
+void board_sleep() {
+   uart_flush();
+   posix_sleep();
+}
+
+/**
+\brief Reboot the mote, by re-executing the process.
+*/
+void board_reset() {
+   uart_flush();
+   execv("/proc/self/exe",posix_vars.argv);
+   perror("board_reset");
+   _exit(1);
+}
+
+//=========================== private =========================================
@@ -0,0 +1,85 @@
+/**
+\brief POSIX-specific board information bsp module.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __BOARD_INFO_H
+#define __BOARD_INFO_H
+
+#include "stdint.h"
+#include "string.h"
+
+//=========================== defines =========================================
+
+// interrupts are only dispatched from board_sleep(), there is nothing to mask
+#define INTERRUPT_DECLARATION()             ;
+#define ENABLE_INTERRUPTS()                 ;
+#define DISABLE_INTERRUPTS()                ;
+
+//===== timer
+
+#define PORT_TIMER_WIDTH                    uint16_t
+#define PORT_RADIOTIMER_WIDTH               uint16_t
+
+#define PORT_SIGNED_INT_WIDTH               int16_t
+#define PORT_TICS_PER_MS                    33
+
+// the scheduler is woken up by the event loop in board_sleep()
+#define SCHEDULER_WAKEUP()
+#define SCHEDULER_ENABLE_INTERRUPT()
+
+//===== pinout
+
+#define PORT_PIN_RADIO_SLP_TR_CNTL_HIGH()
+#define PORT_PIN_RADIO_SLP_TR_CNTL_LOW()
+#define PORT_PIN_RADIO_RESET_HIGH()
+#define PORT_PIN_RADIO_RESET_LOW()
+
+//===== IEEE802154E timing
+#ifdef GOLDEN_IMAGE_ROOT
+// time-slot related
+#define PORT_TsSlotDuration                328    // counter counts one extra count, see datasheet
+// execution speed related
+#define PORT_maxTxDataPrepare               10    //  305us (measured  82us)
+#define PORT_maxRxAckPrepare                10    //  305us (measured  83us)
+#define PORT_maxRxDataPrepare                4    //  122us (measured  22us)
+#define PORT_maxTxAckPrepare                 4    //  122us (measured  94us)
+// radio speed related
+#define PORT_delayTx                         7    //  366us (measured xxxus)
+#define PORT_delayRx                         0    //    0us (can not measure)
+// radio watchdog
+#else
+// time-slot related
+#define PORT_TsSlotDuration                 491   // counter counts one extra count, see datasheet
+// execution speed related
+#define PORT_maxTxDataPrepare               66    // 2014us (measured 746us)
+#define PORT_maxRxAckPrepare                10    //  305us (measured  83us)
+#define PORT_maxRxDataPrepare               33    // 1007us (measured  84us)
+#define PORT_maxTxAckPrepare                10    //  305us (measured 219us)
+// radio speed related
+#define PORT_delayTx                        7     //  214us (measured 219us)
+#define PORT_delayRx                        0     //    0us (can not measure)
+// radio watchdog
+#endif
+
+//===== adaptive_sync accuracy
+
+#define SYNC_ACCURACY                       1
+
+//=========================== typedef  ========================================
+
+//=========================== variables =======================================
+
+static const uint8_t rreg_uriquery[]        = "h=ucb";
+static const uint8_t infoBoardname[]        = "POSIX";
+static const uint8_t infouCName[]           = "POSIX";
+static const uint8_t infoRadioName[]        = "POSIX";
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+//=========================== private =========================================
+
+#endif
@@ -0,0 +1,80 @@
+/**
+\brief POSIX-specific definition of the "bsp_timer" bsp module.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "opendefs.h"
+#include "bsp_timer.h"
+#include "posix.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+typedef struct {
+   bsp_timer_cbt             cb;
+   uint64_t                  start;          ///< tick the counter was reset at
+   uint64_t                  last_compare_value;
+} bsp_timer_vars_t;
+
+bsp_timer_vars_t bsp_timer_vars;
+
+//=========================== prototypes ======================================
+
+static void bsp_timer_fired(void);
+
+//=========================== public ==========================================
+
+void bsp_timer_init() {
+   memset(&bsp_timer_vars,0,sizeof(bsp_timer_vars_t));
+   bsp_timer_vars.start = posix_now();
+   posix_setTimerCb(POSIX_TIMER_BSP_TIMER,bsp_timer_fired);
+}
+
+void bsp_timer_set_callback(bsp_timer_cbt cb) {
+   bsp_timer_vars.cb = cb;
+}
+
+void bsp_timer_reset() {
+   posix_cancel(POSIX_TIMER_BSP_TIMER);
+   bsp_timer_vars.start              = posix_now();
+   bsp_timer_vars.last_compare_value = 0;
+}
+
+/**
+\brief Schedule the callback to be called in some specified time.
+
+The delay is expressed relative to the last compare event, as on the other
+boards. If that time has already passed, the interrupt fires right away.
+*/
+void bsp_timer_scheduleIn(PORT_TIMER_WIDTH delayTicks) {
+   bsp_timer_vars.last_compare_value += delayTicks;
+   posix_schedule(
+      POSIX_TIMER_BSP_TIMER,
+      bsp_timer_vars.start+bsp_timer_vars.last_compare_value
+   );
+}
+
+void bsp_timer_cancel_schedule() {
+   posix_cancel(POSIX_TIMER_BSP_TIMER);
+}
+
+PORT_TIMER_WIDTH bsp_timer_get_currentValue() {
+   return (PORT_TIMER_WIDTH)(posix_now()-bsp_timer_vars.start);
+}
+
+//=========================== private =========================================
+
+static void bsp_timer_fired(void) {
+   bsp_timer_isr();
+}
+
+//=========================== interrupt handlers ==============================
+
+kick_scheduler_t bsp_timer_isr() {
+   if (bsp_timer_vars.cb!=NULL) {
+      bsp_timer_vars.cb();
+   }
+   return KICK_SCHEDULER;
+}
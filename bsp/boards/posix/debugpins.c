@@ -0,0 +1,45 @@
+/**
+\brief POSIX-specific definition of the "debugpins" bsp module.
+
+There are no pins to wiggle, all functions do nothing.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "debugpins.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void debugpins_init() {}
+
+void debugpins_frame_toggle() {}
+void debugpins_frame_clr() {}
+void debugpins_frame_set() {}
+
+void debugpins_slot_toggle() {}
+void debugpins_slot_clr() {}
+void debugpins_slot_set() {}
+
+void debugpins_fsm_toggle() {}
+void debugpins_fsm_clr() {}
+void debugpins_fsm_set() {}
+
+void debugpins_task_toggle() {}
+void debugpins_task_clr() {}
+void debugpins_task_set() {}
+
+void debugpins_isr_toggle() {}
+void debugpins_isr_clr() {}
+void debugpins_isr_set() {}
+
+void debugpins_radio_toggle() {}
+void debugpins_radio_clr() {}
+void debugpins_radio_set() {}
+
+//=========================== private =========================================
@@ -0,0 +1,29 @@
+/**
+\brief POSIX-specific definition of the "eui64" bsp module.
+
+The EUI64 is derived from the --id of the mote.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "string.h"
+#include "eui64.h"
+#include "posix.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+static const uint8_t eui64_prefix[] = {0x14,0x15,0x92,0xcc,0x00,0x00};
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void eui64_get(uint8_t* addressToWrite) {
+   memcpy(addressToWrite,eui64_prefix,sizeof(eui64_prefix));
+   addressToWrite[6] = (uint8_t)(posix_vars.id>>8);
+   addressToWrite[7] = (uint8_t)(posix_vars.id>>0);
+}
+
+//=========================== private =========================================
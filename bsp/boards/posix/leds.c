@@ -0,0 +1,112 @@
+/**
+\brief POSIX-specific definition of the "leds" bsp module.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "opendefs.h"
+#include "leds.h"
+
+//=========================== defines =========================================
+
+#define LED_ERROR       0x01
+#define LED_RADIO       0x02
+#define LED_SYNC        0x04
+#define LED_DEBUG       0x08
+#define LED_ALL         0x0f
+
+//=========================== variables =======================================
+
+static uint8_t leds_state;
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void leds_init() {
+   leds_state = 0;
+}
+
+// error
+void leds_error_on() {
+   leds_state |=  LED_ERROR;
+}
+void leds_error_off() {
+   leds_state &= ~LED_ERROR;
+}
+void leds_error_toggle() {
+   leds_state ^=  LED_ERROR;
+}
+uint8_t leds_error_isOn() {
+   return (leds_state & LED_ERROR)!=0;
+}
+void leds_error_blink() {
+   leds_state  =  LED_ERROR;
+}
+
+// radio
+void leds_radio_on() {
+   leds_state |=  LED_RADIO;
+}
+void leds_radio_off() {
+   leds_state &= ~LED_RADIO;
+}
+void leds_radio_toggle() {
+   leds_state ^=  LED_RADIO;
+}
+uint8_t leds_radio_isOn() {
+   return (leds_state & LED_RADIO)!=0;
+}
+
+// sync
+void leds_sync_on() {
+   leds_state |=  LED_SYNC;
+}
+void leds_sync_off() {
+   leds_state &= ~LED_SYNC;
+}
+void leds_sync_toggle() {
+   leds_state ^=  LED_SYNC;
+}
+uint8_t leds_sync_isOn() {
+   return (leds_state & LED_SYNC)!=0;
+}
+
+// debug
+void leds_debug_on() {
+   leds_state |=  LED_DEBUG;
+}
+void leds_debug_off() {
+   leds_state &= ~LED_DEBUG;
+}
+void leds_debug_toggle() {
+   leds_state ^=  LED_DEBUG;
+}
+uint8_t leds_debug_isOn() {
+   return (leds_state & LED_DEBUG)!=0;
+}
+
+// all
+void leds_all_on() {
+   leds_state  =  LED_ALL;
+}
+void leds_all_off() {
+   leds_state  =  0;
+}
+void leds_all_toggle() {
+   leds_state ^=  LED_ALL;
+}
+
+void leds_circular_shift() {
+   if (leds_state==0) {
+      leds_state = 0x01;
+   } else {
+      leds_state = ((leds_state<<1) | (leds_state>>3)) & LED_ALL;
+   }
+}
+
+void leds_increment() {
+   leds_state = (leds_state+1) & LED_ALL;
+}
+
+//=========================== private =========================================
@@ -0,0 +1,527 @@
+/**
+\brief Radio medium of the POSIX board, mote side and hub.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#define _GNU_SOURCE                  // accept4(), posix_openpt()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "opendefs.h"
+#include "posix.h"
+#include "medium.h"
+#include "propagation.h"
+
+//=========================== defines =========================================
+
+#define MEDIUM_CONNECT_RETRIES       50      // every 100ms
+#define MEDIUM_MAXIDS                0x10000
+#define MEDIUM_EVENTS                64
+
+enum {
+   MEDIUM_TOPOLOGY_FULL = 0,
+   MEDIUM_TOPOLOGY_CHAIN,                    ///< mote i only hears motes i-1 and i+1
+   MEDIUM_TOPOLOGY_GEO,                      ///< motes hear the motes in range
+};
+
+//=========================== variables =======================================
+
+typedef struct {
+   int                       fd;
+   uint16_t                  id;             ///< 0 until the mote said hello
+   uint32_t                  index;          ///< position in medium_hub.clients
+   bool                      heard;          ///< the mote transmitted at least once
+   uint8_t                   listening;      ///< frequency listened on, 0 for none
+} medium_client_t;
+
+typedef struct {
+   int                       listenFd;
+   int                       epollFd;
+   uint8_t                   topology;
+   medium_client_t**         byId;
+   medium_client_t**         clients;        ///< motes which said hello
+   uint32_t                  numClients;
+   // "geo" topology
+   propagation_t             propagation;
+   propagation_link_t*       links;          ///< scratch, for medium_relay()
+   uint32_t                  maxLinks;
+   uint32_t                  randomState;
+   // stats
+   uint64_t                  numFrames;
+   uint64_t                  numDeliveries;
+   uint64_t                  numDropped;
+   uint64_t                  numLost;        ///< not received, as per the propagation model
+   uint32_t                  numHeard;
+} medium_hub_t;
+
+static int                   medium_fd = -1;
+static uint8_t               medium_listening;
+static medium_hub_t          medium_hub;
+static volatile sig_atomic_t medium_stopping;
+
+//=========================== prototypes ======================================
+
+static void medium_receive(void);
+static void medium_address(struct sockaddr_un* addr);
+// hub
+static void medium_stop(int sig);
+static int  medium_loadPositions(const char* path);
+static void medium_place(uint16_t id);
+static void medium_accept(void);
+static void medium_readClient(medium_client_t* client);
+static void medium_closeClient(medium_client_t* client);
+static void medium_unregister(medium_client_t* client);
+static void medium_relay(medium_client_t* src, medium_msg_t* msg, uint32_t len);
+static void medium_relayGeo(medium_client_t* src, medium_msg_t* msg, uint32_t len);
+static void medium_deliver(medium_client_t* dst, medium_msg_t* msg, uint32_t len);
+static uint32_t medium_random(void);
+static void medium_printStats(double duration);
+
+//=========================== public ==========================================
+
+//===== mote
+
+/**
+\brief Connect to the hub, waiting for it to come up if needed.
+*/
+void medium_connect(void) {
+   struct sockaddr_un addr;
+   medium_msg_t       hello;
+   uint8_t            retries;
+
+   medium_fd = socket(AF_UNIX,SOCK_SEQPACKET|SOCK_CLOEXEC,0);
+   if (medium_fd<0) {
+      perror("medium_connect");
+      exit(1);
+   }
+   medium_address(&addr);
+   retries = 0;
+   while (connect(medium_fd,(struct sockaddr*)&addr,sizeof(addr))<0) {
+      if (++retries>=MEDIUM_CONNECT_RETRIES) {
+         fprintf(stderr,"mote %d: no radio medium at %s\n",posix_vars.id,posix_vars.mediumPath);
+         exit(1);
+      }
+      usleep(100000);
+   }
+
+   memset(&hello,0,sizeof(hello));
+   hello.type = MEDIUM_MSG_HELLO;
+   hello.src  = posix_vars.id;
+   send(medium_fd,&hello,MEDIUM_HEADER_LEN,MSG_NOSIGNAL);
+
+   posix_watchFd(POSIX_FD_MEDIUM,medium_fd,medium_receive);
+}
+
+/**
+\brief Put a frame on the air.
+
+The frame is dropped if the hub is not keeping up, as a real radio does not
+wait for its neighbors.
+*/
+void medium_send(uint8_t frequency, uint8_t* buf, uint8_t len) {
+   medium_msg_t msg;
+
+   if (len>MEDIUM_MAXFRAME) {
+      len = MEDIUM_MAXFRAME;
+   }
+   msg.type      = MEDIUM_MSG_FRAME;
+   msg.frequency = frequency;
+   msg.rssi      = 0;
+   msg.len       = len;
+   msg.src       = posix_vars.id;
+   memcpy(msg.payload,buf,len);
+   send(medium_fd,&msg,MEDIUM_HEADER_LEN+len,MSG_DONTWAIT|MSG_NOSIGNAL);
+}
+
+/**
+\brief Tell the hub which frequency the radio listens on, 0 for none.
+*/
+void medium_listen(uint8_t frequency) {
+   medium_msg_t msg;
+
+   if (frequency==medium_listening) {
+      return;
+   }
+   medium_listening = frequency;
+   memset(&msg,0,MEDIUM_HEADER_LEN);
+   msg.type      = MEDIUM_MSG_LISTEN;
+   msg.frequency = frequency;
+   msg.src       = posix_vars.id;
+   send(medium_fd,&msg,MEDIUM_HEADER_LEN,MSG_DONTWAIT|MSG_NOSIGNAL);
+}
+
+//===== hub
+
+/**
+\brief Run the hub until SIGINT or SIGTERM.
+*/
+int medium_main(void) {
+   struct sockaddr_un addr;
+   struct epoll_event ev;
+   struct epoll_event events[MEDIUM_EVENTS];
+   struct rlimit      limit;
+   struct timespec    start;
+   struct timespec    end;
+   int                numEvents;
+   int                i;
+
+   memset(&medium_hub,0,sizeof(medium_hub_t));
+   if (strcmp(posix_vars.topology,"full")==0) {
+      medium_hub.topology = MEDIUM_TOPOLOGY_FULL;
+   } else if (strcmp(posix_vars.topology,"chain")==0) {
+      medium_hub.topology = MEDIUM_TOPOLOGY_CHAIN;
+   } else if (strcmp(posix_vars.topology,"geo")==0) {
+      medium_hub.topology = MEDIUM_TOPOLOGY_GEO;
+   } else {
+      fprintf(stderr,"medium: unknown topology %s\n",posix_vars.topology);
+      return 2;
+   }
+   propagation_init(&medium_hub.propagation);
+   medium_hub.randomState = 0x9e3779b9;
+   if (posix_vars.positions!=NULL && medium_loadPositions(posix_vars.positions)<0) {
+      return 1;
+   }
+   medium_hub.byId    = calloc(MEDIUM_MAXIDS,sizeof(medium_client_t*));
+   medium_hub.clients = calloc(MEDIUM_MAXIDS,sizeof(medium_client_t*));
+   if (medium_hub.byId==NULL || medium_hub.clients==NULL) {
+      perror("medium_main");
+      return 1;
+   }
+
+   // one socket per mote
+   if (getrlimit(RLIMIT_NOFILE,&limit)==0) {
+      limit.rlim_cur = limit.rlim_max;
+      setrlimit(RLIMIT_NOFILE,&limit);
+   }
+
+   medium_address(&addr);
+   unlink(addr.sun_path);
+   medium_hub.listenFd = socket(AF_UNIX,SOCK_SEQPACKET|SOCK_NONBLOCK|SOCK_CLOEXEC,0);
+   if (
+         medium_hub.listenFd<0                                                   ||
+         bind(medium_hub.listenFd,(struct sockaddr*)&addr,sizeof(addr))<0         ||
+         listen(medium_hub.listenFd,SOMAXCONN)<0
+      ) {
+      perror("medium_main");
+      return 1;
+   }
+
+   medium_hub.epollFd = epoll_create1(EPOLL_CLOEXEC);
+   memset(&ev,0,sizeof(ev));
+   ev.events   = EPOLLIN;
+   ev.data.ptr = NULL;
+   epoll_ctl(medium_hub.epollFd,EPOLL_CTL_ADD,medium_hub.listenFd,&ev);
+
+   signal(SIGINT,medium_stop);
+   signal(SIGTERM,medium_stop);
+   signal(SIGPIPE,SIG_IGN);
+   printf("medium: listening on %s (%s topology)\n",posix_vars.mediumPath,posix_vars.topology);
+   fflush(stdout);
+
+   clock_gettime(CLOCK_MONOTONIC,&start);
+   while (medium_stopping==0) {
+      numEvents = epoll_wait(medium_hub.epollFd,events,MEDIUM_EVENTS,-1);
+      if (numEvents<0) {
+         if (errno==EINTR) {
+            continue;
+         }
+         perror("medium_main");
+         break;
+      }
+      for (i=0;i<numEvents;i++) {
+         if (events[i].data.ptr==NULL) {
+            medium_accept();
+         } else {
+            medium_readClient((medium_client_t*)events[i].data.ptr);
+         }
+      }
+   }
+   clock_gettime(CLOCK_MONOTONIC,&end);
+
+   medium_printStats((end.tv_sec-start.tv_sec)+(end.tv_nsec-start.tv_nsec)/1e9);
+   unlink(addr.sun_path);
+   propagation_free(&medium_hub.propagation);
+   free(medium_hub.links);
+   return 0;
+}
+
+//=========================== private =========================================
+
+static void medium_receive(void) {
+   medium_msg_t msg;
+   ssize_t      len;
+
+   while (1) {
+      len = recv(medium_fd,&msg,sizeof(msg),MSG_DONTWAIT);
+      if (len==0) {
+         // the hub went away, so did the air
+         fprintf(stderr,"mote %d: radio medium closed\n",posix_vars.id);
+         exit(0);
+      }
+      if (len<0) {
+         return;
+      }
+      if (msg.type==MEDIUM_MSG_FRAME && len==(ssize_t)(MEDIUM_HEADER_LEN+msg.len)) {
+         radio_rxFrame(msg.frequency,msg.rssi,msg.payload,msg.len);
+      }
+   }
+}
+
+static void medium_address(struct sockaddr_un* addr) {
+   memset(addr,0,sizeof(struct sockaddr_un));
+   addr->sun_family = AF_UNIX;
+   strncpy(addr->sun_path,posix_vars.mediumPath,sizeof(addr->sun_path)-1);
+}
+
+//===== hub
+
+static void medium_stop(int sig) {
+   medium_stopping = 1;
+}
+
+/**
+\brief Place the motes listed in a file, one "id x y" line per mote.
+
+\returns 0 on success, -1 if the file cannot be read.
+*/
+static int medium_loadPositions(const char* path) {
+   FILE*  f;
+   char   line[128];
+   int    id;
+   double x;
+   double y;
+
+   f = fopen(path,"r");
+   if (f==NULL) {
+      perror("medium_loadPositions");
+      return -1;
+   }
+   while (fgets(line,sizeof(line),f)!=NULL) {
+      if (sscanf(line,"%d %lf %lf",&id,&x,&y)!=3 || id<1 || id>=MEDIUM_MAXIDS) {
+         // comments, blank lines
+         continue;
+      }
+      if (propagation_setPosition(&medium_hub.propagation,id,x,y)<0) {
+         fclose(f);
+         fprintf(stderr,"medium: out of memory\n");
+         return -1;
+      }
+   }
+   fclose(f);
+   return 0;
+}
+
+/**
+\brief Place a mote the positions file does not list, on a lattice.
+
+Neighboring motes of the lattice are half the range apart.
+*/
+static void medium_place(uint16_t id) {
+   double spacing;
+
+   if (propagation_isPlaced(&medium_hub.propagation,id)) {
+      return;
+   }
+   spacing = medium_hub.propagation.range/2;
+   propagation_setPosition(
+      &medium_hub.propagation,
+      id,
+      ((id-1)%MEDIUM_GEO_COLUMNS)*spacing,
+      ((id-1)/MEDIUM_GEO_COLUMNS)*spacing
+   );
+}
+
+static void medium_accept(void) {
+   struct epoll_event ev;
+   medium_client_t*   client;
+   int                fd;
+
+   while ((fd = accept4(medium_hub.listenFd,NULL,NULL,SOCK_NONBLOCK|SOCK_CLOEXEC))>=0) {
+      client = calloc(1,sizeof(medium_client_t));
+      if (client==NULL) {
+         close(fd);
+         continue;
+      }
+      client->fd  = fd;
+      memset(&ev,0,sizeof(ev));
+      ev.events   = EPOLLIN;
+      ev.data.ptr = client;
+      epoll_ctl(medium_hub.epollFd,EPOLL_CTL_ADD,fd,&ev);
+   }
+}
+
+static void medium_readClient(medium_client_t* client) {
+   medium_msg_t msg;
+   ssize_t      len;
+
+   while (1) {
+      len = recv(client->fd,&msg,sizeof(msg),MSG_DONTWAIT);
+      if (len==0 || (len<0 && errno!=EAGAIN && errno!=EINTR)) {
+         medium_closeClient(client);
+         return;
+      }
+      if (len<(ssize_t)MEDIUM_HEADER_LEN) {
+         return;
+      }
+      switch (msg.type) {
+         case MEDIUM_MSG_HELLO:
+            if (client->id!=0 || msg.src==0) {
+               break;
+            }
+            if (medium_hub.byId[msg.src]!=NULL) {
+               // a mote which reset reconnects before its old socket is closed
+               medium_unregister(medium_hub.byId[msg.src]);
+            }
+            client->id                          = msg.src;
+            client->index                       = medium_hub.numClients;
+            medium_hub.byId[client->id]         = client;
+            medium_hub.clients[client->index]   = client;
+            medium_hub.numClients++;
+            if (medium_hub.topology==MEDIUM_TOPOLOGY_GEO) {
+               medium_place(client->id);
+            }
+            break;
+         case MEDIUM_MSG_LISTEN:
+            client->listening = msg.frequency;
+            break;
+         case MEDIUM_MSG_FRAME:
+            if (client->id!=0 && len==(ssize_t)(MEDIUM_HEADER_LEN+msg.len)) {
+               medium_relay(client,&msg,(uint32_t)len);
+            }
+            break;
+      }
+   }
+}
+
+static void medium_closeClient(medium_client_t* client) {
+   epoll_ctl(medium_hub.epollFd,EPOLL_CTL_DEL,client->fd,NULL);
+   close(client->fd);
+   medium_unregister(client);
+   free(client);
+}
+
+static void medium_unregister(medium_client_t* client) {
+   medium_client_t* last;
+
+   if (client->id==0) {
+      return;
+   }
+   medium_hub.byId[client->id]          = NULL;
+   client->id                           = 0;
+   // swap-remove from the list of motes
+   last                                 = medium_hub.clients[--medium_hub.numClients];
+   medium_hub.clients[client->index]    = last;
+   last->index                          = client->index;
+}
+
+static void medium_relay(medium_client_t* src, medium_msg_t* msg, uint32_t len) {
+   uint32_t i;
+
+   medium_hub.numFrames++;
+   if (src->heard==FALSE) {
+      src->heard = TRUE;
+      medium_hub.numHeard++;
+   }
+   msg->rssi = MEDIUM_RSSI;
+
+   switch (medium_hub.topology) {
+      case MEDIUM_TOPOLOGY_CHAIN:
+         if (src->id>1) {
+            medium_deliver(medium_hub.byId[src->id-1],msg,len);
+         }
+         if (src->id<MEDIUM_MAXIDS-1) {
+            medium_deliver(medium_hub.byId[src->id+1],msg,len);
+         }
+         break;
+      case MEDIUM_TOPOLOGY_GEO:
+         medium_relayGeo(src,msg,len);
+         break;
+      default:
+         for (i=0;i<medium_hub.numClients;i++) {
+            if (medium_hub.clients[i]!=src) {
+               medium_deliver(medium_hub.clients[i],msg,len);
+            }
+         }
+         break;
+   }
+}
+
+static void medium_relayGeo(medium_client_t* src, medium_msg_t* msg, uint32_t len) {
+   propagation_link_t* links;
+   propagation_link_t* link;
+   uint32_t            numLinks;
+   uint32_t            i;
+
+   numLinks = propagation_getLinks(&medium_hub.propagation,src->id,medium_hub.links,medium_hub.maxLinks);
+   if (numLinks>medium_hub.maxLinks) {
+      links = realloc(medium_hub.links,numLinks*sizeof(propagation_link_t));
+      if (links==NULL) {
+         return;
+      }
+      medium_hub.links    = links;
+      medium_hub.maxLinks = numLinks;
+      propagation_getLinks(&medium_hub.propagation,src->id,medium_hub.links,medium_hub.maxLinks);
+   }
+   for (i=0;i<numLinks;i++) {
+      link = &medium_hub.links[i];
+      if (medium_hub.byId[link->dst]==NULL || medium_hub.byId[link->dst]->listening!=msg->frequency) {
+         continue;
+      }
+      if (link->pdr<1 && medium_random()>=(uint32_t)(link->pdr*0xffffffffu)) {
+         medium_hub.numLost++;
+         continue;
+      }
+      msg->rssi = link->rssi;
+      medium_deliver(medium_hub.byId[link->dst],msg,len);
+   }
+}
+
+static void medium_deliver(medium_client_t* dst, medium_msg_t* msg, uint32_t len) {
+   if (dst==NULL || dst->listening!=msg->frequency) {
+      return;
+   }
+   if (send(dst->fd,msg,len,MSG_DONTWAIT|MSG_NOSIGNAL)<0) {
+      medium_hub.numDropped++;
+   } else {
+      medium_hub.numDeliveries++;
+   }
+}
+
+static uint32_t medium_random(void) {
+   uint32_t x;
+
+   // xorshift32
+   x  = medium_hub.randomState;
+   x ^= x<<13;
+   x ^= x>>17;
+   x ^= x<<5;
+   medium_hub.randomState = x;
+   return x;
+}
+
+/**
+\brief Print the statistics, as key=value pairs on a single line.
+*/
+static void medium_printStats(double duration) {
+   printf(
+      "medium: duration=%.3f motes=%u heard=%u frames=%llu deliveries=%llu dropped=%llu lost=%llu framesPerSec=%.1f\n",
+      duration,
+      medium_hub.numClients,
+      medium_hub.numHeard,
+      (unsigned long long)medium_hub.numFrames,
+      (unsigned long long)medium_hub.numDeliveries,
+      (unsigned long long)medium_hub.numDropped,
+      (unsigned long long)medium_hub.numLost,
+      duration>0 ? medium_hub.numFrames/duration : 0.0
+   );
+   fflush(stdout);
+}
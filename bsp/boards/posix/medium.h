@@ -0,0 +1,64 @@
+/**
+\brief Radio medium shared by the motes of the POSIX board.
+
+The medium is a hub process (started with --hub) listening on a UNIX
+SOCK_SEQPACKET socket. Each mote connects to it, introduces itself with a
+MEDIUM_MSG_HELLO and sends a MEDIUM_MSG_FRAME when the start of frame of one
+of its transmissions goes on the air. A mote also sends a MEDIUM_MSG_LISTEN
+when it starts or stops listening. The hub relays the frame to the neighbors
+of the sender in the topology which are listening on the same frequency:
+- "full": all motes hear each other;
+- "chain": mote i hears motes i-1 and i+1;
+- "geo": motes are placed on a plane, from the --positions file ("id x y"
+  lines, in m) or on a lattice by default, and hear each other according to
+  the propagation model of the simulated boards (see propagation.h). A frame
+  only costs O(neighbors) to relay.
+
+The hub prints its statistics (frames relayed, deliveries, ...) on SIGINT
+or SIGTERM.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __MEDIUM_H
+#define __MEDIUM_H
+
+#include <stddef.h>
+#include "toolchain_defs.h"
+#include "board_info.h"
+
+//=========================== define ==========================================
+
+#define MEDIUM_MAXFRAME              128
+#define MEDIUM_RSSI                  -50
+/// motes per row of the default lattice of the "geo" topology
+#define MEDIUM_GEO_COLUMNS           100
+#define MEDIUM_HEADER_LEN            offsetof(medium_msg_t,payload)
+
+enum {
+   MEDIUM_MSG_HELLO = 1,
+   MEDIUM_MSG_FRAME,
+   MEDIUM_MSG_LISTEN,                        ///< frequency listened on, 0 for none
+};
+
+//=========================== typedef =========================================
+
+typedef struct {
+   uint8_t                   type;           ///< MEDIUM_MSG_*
+   uint8_t                   frequency;
+    int8_t                   rssi;           ///< filled in by the hub
+   uint8_t                   len;
+   uint16_t                  src;            ///< id of the sending mote
+   uint8_t                   payload[MEDIUM_MAXFRAME];
+} medium_msg_t;
+
+//=========================== prototypes ======================================
+
+// mote
+void      medium_connect(void);
+void      medium_send(uint8_t frequency, uint8_t* buf, uint8_t len);
+void      medium_listen(uint8_t frequency);
+// hub
+int       medium_main(void);
+
+#endif
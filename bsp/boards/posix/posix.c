@@ -0,0 +1,308 @@
+/**
+\brief Event loop and clock of the POSIX board.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <getopt.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include "opendefs.h"
+#include "posix.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+posix_vars_t posix_vars;
+
+static const struct option posix_options[] = {
+   {"id",       required_argument, NULL, 'i'},
+   {"hub",      no_argument,       NULL, 'H'},
+   {"medium",   required_argument, NULL, 'm'},
+   {"serial",   required_argument, NULL, 's'},
+   {"slowdown", required_argument, NULL, 'd'},
+   {"topology", required_argument, NULL, 't'},
+   {"positions",required_argument, NULL, 'p'},
+   {NULL,       0,                 NULL,  0 },
+};
+
+//=========================== prototypes ======================================
+
+static uint64_t posix_monotonicNs(void);
+static uint64_t posix_ticksToNs(uint64_t ticks);
+static bool     posix_fireTimers(void);
+static void     posix_armTimer(void);
+static void     posix_usage(const char* prog);
+
+//=========================== public ==========================================
+
+//===== admin
+
+/**
+\brief Parse the command line.
+
+\returns 0 on success, -1 if the command line is invalid.
+*/
+int posix_parseArgs(int argc, char** argv) {
+   int opt;
+   int id;
+
+   memset(&posix_vars,0,sizeof(posix_vars_t));
+   posix_vars.argv       = argv;
+   posix_vars.mediumPath = POSIX_DEFAULT_MEDIUM;
+   posix_vars.topology   = "full";
+   posix_vars.slowdown   = 1;
+   id                    = -1;
+
+   while ((opt = getopt_long(argc,argv,"i:Hm:s:d:t:p:",posix_options,NULL))!=-1) {
+      switch (opt) {
+         case 'i':
+            id = atoi(optarg);
+            break;
+         case 'H':
+            posix_vars.hub = TRUE;
+            break;
+         case 'm':
+            posix_vars.mediumPath = optarg;
+            break;
+         case 's':
+            posix_vars.serialLink = optarg;
+            break;
+         case 'd':
+            posix_vars.slowdown = (uint32_t)atoi(optarg);
+            break;
+         case 't':
+            posix_vars.topology = optarg;
+            break;
+         case 'p':
+            posix_vars.positions = optarg;
+            break;
+         default:
+            posix_usage(argv[0]);
+            return -1;
+      }
+   }
+
+   if (posix_vars.slowdown==0 || (posix_vars.hub==FALSE && (id<1 || id>0xffff))) {
+      posix_usage(argv[0]);
+      return -1;
+   }
+   posix_vars.id = (uint16_t)id;
+   return 0;
+}
+
+/**
+\brief Start the mote clock and create the event loop.
+*/
+void posix_init(void) {
+   struct epoll_event ev;
+   uint8_t            i;
+
+   posix_vars.bootNs  = posix_monotonicNs();
+   posix_vars.armedNs = POSIX_NEVER;
+   for (i=0;i<POSIX_TIMER_MAX;i++) {
+      posix_vars.deadline[i] = POSIX_NEVER;
+   }
+
+   posix_vars.epollFd = epoll_create1(EPOLL_CLOEXEC);
+   posix_vars.timerFd = timerfd_create(CLOCK_MONOTONIC,TFD_NONBLOCK|TFD_CLOEXEC);
+   if (posix_vars.epollFd<0 || posix_vars.timerFd<0) {
+      perror("posix_init");
+      exit(1);
+   }
+   memset(&ev,0,sizeof(ev));
+   ev.events   = EPOLLIN;
+   ev.data.u32 = POSIX_FD_TIMER;
+   epoll_ctl(posix_vars.epollFd,EPOLL_CTL_ADD,posix_vars.timerFd,&ev);
+}
+
+//===== clock
+
+/**
+\brief Current value of the mote clock, in 32kHz ticks since boot.
+*/
+uint64_t posix_now(void) {
+   uint64_t elapsed;
+
+   elapsed = (posix_monotonicNs()-posix_vars.bootNs)/posix_vars.slowdown;
+   return (elapsed/POSIX_NS_PER_SEC)*POSIX_TICKS_PER_SEC+
+          ((elapsed%POSIX_NS_PER_SEC)*POSIX_TICKS_PER_SEC)/POSIX_NS_PER_SEC;
+}
+
+/**
+\brief Duration in ticks, rounded up.
+*/
+uint64_t posix_usToTicks(uint32_t us) {
+   return ((uint64_t)us*POSIX_TICKS_PER_SEC+999999)/1000000;
+}
+
+//===== event loop
+
+void posix_setTimerCb(uint8_t timer, posix_cbt cb) {
+   posix_vars.timerCb[timer] = cb;
+}
+
+/**
+\brief Raise the interrupt of a timer once the mote clock reaches deadline.
+
+A deadline in the past raises the interrupt the next time the mote sleeps.
+*/
+void posix_schedule(uint8_t timer, uint64_t deadline) {
+   posix_vars.deadline[timer] = deadline;
+}
+
+void posix_cancel(uint8_t timer) {
+   posix_vars.deadline[timer] = POSIX_NEVER;
+}
+
+void posix_watchFd(uint8_t slot, int fd, posix_cbt cb) {
+   struct epoll_event ev;
+
+   memset(&ev,0,sizeof(ev));
+   ev.events              = EPOLLIN;
+   ev.data.u32            = slot;
+   posix_vars.fdCb[slot]  = cb;
+   if (epoll_ctl(posix_vars.epollFd,EPOLL_CTL_ADD,fd,&ev)<0) {
+      perror("posix_watchFd");
+      exit(1);
+   }
+}
+
+/**
+\brief Wait for, and dispatch, interrupts.
+
+Returns once at least one interrupt was dispatched. Expired timers are
+dispatched in the order of their deadlines, before the file descriptors.
+*/
+void posix_sleep(void) {
+   struct epoll_event events[POSIX_FD_MAX];
+   uint64_t           expirations;
+   bool               dispatched;
+   int                numEvents;
+   int                i;
+
+   dispatched = FALSE;
+   while (dispatched==FALSE) {
+      dispatched = posix_fireTimers();
+      posix_armTimer();
+
+      numEvents = epoll_wait(posix_vars.epollFd,events,POSIX_FD_MAX,dispatched ? 0 : -1);
+      if (numEvents<0) {
+         if (errno==EINTR) {
+            continue;
+         }
+         perror("posix_sleep");
+         exit(1);
+      }
+      for (i=0;i<numEvents;i++) {
+         if (events[i].data.u32==POSIX_FD_TIMER) {
+            // the expired deadlines are picked up at the next iteration
+            if (read(posix_vars.timerFd,&expirations,sizeof(expirations))<0) {
+               expirations = 0;
+            }
+            posix_vars.armedNs = POSIX_NEVER;
+         } else {
+            posix_vars.fdCb[events[i].data.u32]();
+            dispatched = TRUE;
+         }
+      }
+   }
+}
+
+//=========================== private =========================================
+
+static uint64_t posix_monotonicNs(void) {
+   struct timespec ts;
+
+   clock_gettime(CLOCK_MONOTONIC,&ts);
+   return (uint64_t)ts.tv_sec*POSIX_NS_PER_SEC+(uint64_t)ts.tv_nsec;
+}
+
+/**
+\brief CLOCK_MONOTONIC time at which the mote clock reaches ticks.
+
+Rounded up, so the mote clock has reached ticks when the timerfd fires.
+*/
+static uint64_t posix_ticksToNs(uint64_t ticks) {
+   uint64_t ns;
+
+   ns  = (ticks/POSIX_TICKS_PER_SEC)*POSIX_NS_PER_SEC;
+   ns += ((ticks%POSIX_TICKS_PER_SEC)*POSIX_NS_PER_SEC+POSIX_TICKS_PER_SEC-1)/POSIX_TICKS_PER_SEC;
+   return posix_vars.bootNs+ns*posix_vars.slowdown;
+}
+
+/**
+\brief Dispatch the expired timers, earliest deadline first.
+
+\returns TRUE if at least one timer was dispatched.
+*/
+static bool posix_fireTimers(void) {
+   uint64_t now;
+   uint8_t  earliest;
+   uint8_t  i;
+   bool     dispatched;
+
+   dispatched = FALSE;
+   while (1) {
+      earliest = 0;
+      for (i=1;i<POSIX_TIMER_MAX;i++) {
+         if (posix_vars.deadline[i]<posix_vars.deadline[earliest]) {
+            earliest = i;
+         }
+      }
+      if (posix_vars.deadline[earliest]==POSIX_NEVER) {
+         break;
+      }
+      now = posix_now();
+      if (posix_vars.deadline[earliest]>now) {
+         break;
+      }
+      // the handler may re-arm its own timer
+      posix_vars.deadline[earliest] = POSIX_NEVER;
+      posix_vars.timerCb[earliest]();
+      dispatched = TRUE;
+   }
+   return dispatched;
+}
+
+/**
+\brief Arm the timerfd at the earliest deadline.
+*/
+static void posix_armTimer(void) {
+   struct itimerspec spec;
+   uint64_t          deadline;
+   uint64_t          ns;
+   uint8_t           i;
+
+   deadline = POSIX_NEVER;
+   for (i=0;i<POSIX_TIMER_MAX;i++) {
+      if (posix_vars.deadline[i]<deadline) {
+         deadline = posix_vars.deadline[i];
+      }
+   }
+   if (deadline==POSIX_NEVER) {
+      // nothing to wake up for, an armed timerfd fires harmlessly
+      return;
+   }
+   ns = posix_ticksToNs(deadline);
+   if (ns==posix_vars.armedNs) {
+      return;
+   }
+
+   memset(&spec,0,sizeof(spec));
+   spec.it_value.tv_sec  = ns/POSIX_NS_PER_SEC;
+   spec.it_value.tv_nsec = ns%POSIX_NS_PER_SEC;
+   timerfd_settime(posix_vars.timerFd,TFD_TIMER_ABSTIME,&spec,NULL);
+   posix_vars.armedNs    = ns;
+}
+
+static void posix_usage(const char* prog) {
+   fprintf(stderr,"usage: %s --id <1-65535> [--medium <path>] [--serial <link>] [--slowdown <n>]\n",prog);
+   fprintf(stderr,"       %s --hub [--medium <path>] [--topology full|chain|geo] [--positions <file>]\n",prog);
+}
@@ -0,0 +1,98 @@
+/**
+\brief Internals shared by the modules of the POSIX board.
+
+Each mote is a Linux process. The hardware of the mote is emulated by an event
+loop, which board_sleep() runs until at least one interrupt was dispatched:
+- the timers (radiotimer, bsp_timer, radio, uart) are deadlines in ticks of
+  the 32kHz mote clock; a single timerfd is armed at the earliest one;
+- the pty of the serial port and the socket to the radio medium are watched
+  through epoll.
+Interrupts are only dispatched from board_sleep(), as on the python board, so
+the firmware never gets preempted.
+
+The mote clock is derived from CLOCK_MONOTONIC. It can be slowed down
+(--slowdown) so that more motes than CPU cores can keep up with the clock.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __POSIX_H
+#define __POSIX_H
+
+#include "toolchain_defs.h"
+#include "board_info.h"
+
+//=========================== define ==========================================
+
+#define POSIX_TICKS_PER_SEC          32768
+#define POSIX_NS_PER_SEC             1000000000ULL
+#define POSIX_NEVER                  0xffffffffffffffffULL
+#define POSIX_DEFAULT_MEDIUM         "/tmp/openwsn-medium"
+
+/// sources of interrupts driven by the mote clock
+enum {
+   POSIX_TIMER_RADIOTIMER_OVERFLOW = 0,
+   POSIX_TIMER_RADIOTIMER_COMPARE,
+   POSIX_TIMER_BSP_TIMER,
+   POSIX_TIMER_RADIO,
+   POSIX_TIMER_UART_TX,
+   POSIX_TIMER_UART_RX,
+   POSIX_TIMER_MAX
+};
+
+/// file descriptors watched by the event loop
+enum {
+   POSIX_FD_TIMER = 0,
+   POSIX_FD_UART,
+   POSIX_FD_MEDIUM,
+   POSIX_FD_MAX
+};
+
+//=========================== typedef =========================================
+
+typedef void (*posix_cbt)(void);
+
+typedef struct {
+   //===== command line
+   char**                    argv;           ///< to re-execute on board_reset()
+   uint16_t                  id;
+   bool                      hub;            ///< run the radio medium, not a mote
+   const char*               mediumPath;
+   const char*               serialLink;     ///< symlink to create to the pty
+   const char*               topology;
+   const char*               positions;      ///< file placing the motes on the plane
+   uint32_t                  slowdown;
+   //===== clock
+   uint64_t                  bootNs;
+   //===== event loop
+   int                       epollFd;
+   int                       timerFd;
+   uint64_t                  armedNs;        ///< deadline timerFd is armed at
+   uint64_t                  deadline[POSIX_TIMER_MAX];
+   posix_cbt                 timerCb[POSIX_TIMER_MAX];
+   posix_cbt                 fdCb[POSIX_FD_MAX];
+} posix_vars_t;
+
+//=========================== variables =======================================
+
+extern posix_vars_t posix_vars;
+
+//=========================== prototypes ======================================
+
+// admin
+int       posix_parseArgs(int argc, char** argv);
+void      posix_init(void);
+// clock
+uint64_t  posix_now(void);
+uint64_t  posix_usToTicks(uint32_t us);
+// event loop
+void      posix_setTimerCb(uint8_t timer, posix_cbt cb);
+void      posix_schedule(uint8_t timer, uint64_t deadline);
+void      posix_cancel(uint8_t timer);
+void      posix_watchFd(uint8_t slot, int fd, posix_cbt cb);
+void      posix_sleep(void);
+// board internals
+void      uart_flush(void);
+void      radio_rxFrame(uint8_t frequency, int8_t rssi, uint8_t* buf, uint8_t len);
+
+#endif
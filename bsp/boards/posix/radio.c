@@ -0,0 +1,256 @@
+/**
+\brief POSIX-specific definition of the "radio" bsp module.
+
+Frames go through the radio medium (see medium.h), which only relays them to
+the motes listening on their frequency. The start of frame of a transmission
+is signaled PORT_delayTx ticks after radio_txNow(), which is when the frame is
+handed to the medium; the end of frame follows after the time it takes to
+send the frame at 250kbps.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "opendefs.h"
+#include "radio.h"
+#include "radiotimer.h"
+#include "debugpins.h"
+#include "leds.h"
+#include "posix.h"
+#include "medium.h"
+
+//=========================== defines =========================================
+
+#define RADIO_BUFLEN                 MEDIUM_MAXFRAME
+#define RADIO_US_PER_BYTE            32
+
+//=========================== variables =======================================
+
+typedef struct {
+   radiotimer_capture_cbt    startFrame_cb;
+   radiotimer_capture_cbt    endFrame_cb;
+   radio_state_t             state;
+   uint8_t                   frequency;
+   bool                      sfdPending;     ///< transmitting, start of frame not sent yet
+   // TX
+   uint8_t                   txBuf[RADIO_BUFLEN];
+   uint8_t                   txLen;
+   // RX
+   uint8_t                   rxBuf[RADIO_BUFLEN];
+   uint8_t                   rxLen;
+    int8_t                   rxRssi;
+   bool                      rxCrc;
+} radio_vars_t;
+
+radio_vars_t radio_vars;
+
+//=========================== prototypes ======================================
+
+static void radio_timerFired(void);
+static void radio_endFrameIn(uint8_t len);
+
+//=========================== public ==========================================
+
+//===== admin
+
+void radio_init() {
+   memset(&radio_vars,0,sizeof(radio_vars_t));
+   posix_setTimerCb(POSIX_TIMER_RADIO,radio_timerFired);
+   medium_connect();
+   radio_vars.state          = RADIOSTATE_RFOFF;
+}
+
+void radio_setOverflowCb(radiotimer_compare_cbt cb) {
+   radiotimer_setOverflowCb(cb);
+}
+
+void radio_setCompareCb(radiotimer_compare_cbt cb) {
+   radiotimer_setCompareCb(cb);
+}
+
+void radio_setStartFrameCb(radiotimer_capture_cbt cb) {
+   radio_vars.startFrame_cb  = cb;
+}
+
+void radio_setEndFrameCb(radiotimer_capture_cbt cb) {
+   radio_vars.endFrame_cb    = cb;
+}
+
+//===== reset
+
+void radio_reset() {
+   radio_rfOff();
+}
+
+//===== timer
+
+void radio_startTimer(PORT_TIMER_WIDTH period) {
+   radiotimer_start(period);
+}
+
+PORT_TIMER_WIDTH radio_getTimerValue() {
+   return radiotimer_getValue();
+}
+
+void radio_setTimerPeriod(PORT_TIMER_WIDTH period) {
+   radiotimer_setPeriod(period);
+}
+
+PORT_TIMER_WIDTH radio_getTimerPeriod() {
+   return radiotimer_getPeriod();
+}
+
+//===== RF admin
+
+void radio_setFrequency(uint8_t frequency) {
+   radio_vars.frequency = frequency;
+   radio_vars.state     = RADIOSTATE_FREQUENCY_SET;
+}
+
+void radio_rfOn() {
+   // the RF chain is turned on by radio_txEnable() or radio_rxEnable()
+}
+
+void radio_rfOff() {
+   posix_cancel(POSIX_TIMER_RADIO);
+   radio_vars.sfdPending = FALSE;
+   medium_listen(0);
+
+   // wiggle debug pin
+   debugpins_radio_clr();
+   leds_radio_off();
+
+   radio_vars.state      = RADIOSTATE_RFOFF;
+}
+
+//===== TX
+
+void radio_loadPacket(uint8_t* packet, uint8_t len) {
+   if (len>RADIO_BUFLEN) {
+      len = RADIO_BUFLEN;
+   }
+   memcpy(radio_vars.txBuf,packet,len);
+   radio_vars.txLen = len;
+   radio_vars.state = RADIOSTATE_PACKET_LOADED;
+}
+
+void radio_txEnable() {
+   // wiggle debug pin
+   debugpins_radio_set();
+   leds_radio_on();
+
+   radio_vars.state = RADIOSTATE_TX_ENABLED;
+}
+
+void radio_txNow() {
+   radio_vars.state      = RADIOSTATE_TRANSMITTING;
+   radio_vars.sfdPending = TRUE;
+   posix_schedule(POSIX_TIMER_RADIO,posix_now()+PORT_delayTx);
+}
+
+//===== RX
+
+void radio_rxEnable() {
+   // wiggle debug pin
+   debugpins_radio_set();
+   leds_radio_on();
+
+   radio_vars.state = RADIOSTATE_ENABLING_RX;
+}
+
+void radio_rxNow() {
+   medium_listen(radio_vars.frequency);
+   radio_vars.state = RADIOSTATE_LISTENING;
+}
+
+void radio_getReceivedFrame(uint8_t* pBufRead,
+                            uint8_t* pLenRead,
+                            uint8_t  maxBufLen,
+                             int8_t* pRssi,
+                            uint8_t* pLqi,
+                               bool* pCrc) {
+   uint8_t len;
+
+   len = radio_vars.rxLen;
+   if (len>maxBufLen) {
+      len = maxBufLen;
+   }
+   memcpy(pBufRead,radio_vars.rxBuf,len);
+   *pLenRead = len;
+   *pRssi    = radio_vars.rxRssi;
+   *pLqi     = 0xff;
+   *pCrc     = radio_vars.rxCrc;
+}
+
+/**
+\brief A frame is on the air on some frequency, called by the medium.
+*/
+void radio_rxFrame(uint8_t frequency, int8_t rssi, uint8_t* buf, uint8_t len) {
+   if (frequency!=radio_vars.frequency) {
+      return;
+   }
+   if (radio_vars.state==RADIOSTATE_RECEIVING) {
+      // two frames overlap at this mote
+      radio_vars.rxCrc = FALSE;
+      return;
+   }
+   if (radio_vars.state!=RADIOSTATE_LISTENING) {
+      return;
+   }
+   if (len>RADIO_BUFLEN) {
+      len = RADIO_BUFLEN;
+   }
+   memcpy(radio_vars.rxBuf,buf,len);
+   radio_vars.rxLen  = len;
+   radio_vars.rxRssi = rssi;
+   radio_vars.rxCrc  = TRUE;
+   radio_vars.state  = RADIOSTATE_RECEIVING;
+   radio_endFrameIn(len);
+   if (radio_vars.startFrame_cb!=NULL) {
+      radio_vars.startFrame_cb(radiotimer_getCapturedTime());
+   }
+}
+
+//=========================== private =========================================
+
+static void radio_endFrameIn(uint8_t len) {
+   posix_schedule(
+      POSIX_TIMER_RADIO,
+      posix_now()+posix_usToTicks((1+len)*RADIO_US_PER_BYTE)
+   );
+}
+
+static void radio_timerFired(void) {
+   radio_isr();
+}
+
+//=========================== interrupt handlers ==============================
+
+/**
+\brief Start or end of a frame.
+*/
+kick_scheduler_t radio_isr() {
+   PORT_TIMER_WIDTH capturedTime;
+
+   capturedTime = radiotimer_getCapturedTime();
+   if (radio_vars.sfdPending) {
+      // the start of frame goes on the air
+      radio_vars.sfdPending = FALSE;
+      medium_send(radio_vars.frequency,radio_vars.txBuf,radio_vars.txLen);
+      radio_endFrameIn(radio_vars.txLen);
+      if (radio_vars.startFrame_cb!=NULL) {
+         radio_vars.startFrame_cb(capturedTime);
+      }
+      return KICK_SCHEDULER;
+   }
+
+   if (radio_vars.state==RADIOSTATE_RECEIVING) {
+      // the radio keeps listening until turned off
+      radio_vars.state = RADIOSTATE_LISTENING;
+   } else {
+      radio_vars.state = RADIOSTATE_TXRX_DONE;
+   }
+   if (radio_vars.endFrame_cb!=NULL) {
+      radio_vars.endFrame_cb(capturedTime);
+   }
+   return KICK_SCHEDULER;
+}
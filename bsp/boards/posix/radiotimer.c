@@ -0,0 +1,118 @@
+/**
+\brief POSIX-specific definition of the "radiotimer" bsp module.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "opendefs.h"
+#include "radiotimer.h"
+#include "posix.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+typedef struct {
+   radiotimer_compare_cbt    overflow_cb;
+   radiotimer_compare_cbt    compare_cb;
+   uint64_t                  start;          ///< tick the counter last wrapped at
+   PORT_RADIOTIMER_WIDTH     period;
+} radiotimer_vars_t;
+
+radiotimer_vars_t radiotimer_vars;
+
+//=========================== prototypes ======================================
+
+static void radiotimer_overflow(void);
+static void radiotimer_compare(void);
+
+//=========================== public ==========================================
+
+//===== admin
+
+void radiotimer_init() {
+   memset(&radiotimer_vars,0,sizeof(radiotimer_vars_t));
+   posix_setTimerCb(POSIX_TIMER_RADIOTIMER_OVERFLOW,radiotimer_overflow);
+   posix_setTimerCb(POSIX_TIMER_RADIOTIMER_COMPARE,radiotimer_compare);
+}
+
+void radiotimer_setOverflowCb(radiotimer_compare_cbt cb) {
+   radiotimer_vars.overflow_cb = cb;
+}
+
+void radiotimer_setCompareCb(radiotimer_compare_cbt cb) {
+   radiotimer_vars.compare_cb  = cb;
+}
+
+void radiotimer_setStartFrameCb(radiotimer_capture_cbt cb) {
+   // the radio calls the start of frame callback
+}
+
+void radiotimer_setEndFrameCb(radiotimer_capture_cbt cb) {
+   // the radio calls the end of frame callback
+}
+
+void radiotimer_start(PORT_RADIOTIMER_WIDTH period) {
+   radiotimer_vars.start  = posix_now();
+   radiotimer_vars.period = period;
+   posix_cancel(POSIX_TIMER_RADIOTIMER_COMPARE);
+   posix_schedule(POSIX_TIMER_RADIOTIMER_OVERFLOW,radiotimer_vars.start+period);
+}
+
+//===== direct access
+
+PORT_RADIOTIMER_WIDTH radiotimer_getValue() {
+   return (PORT_RADIOTIMER_WIDTH)(posix_now()-radiotimer_vars.start);
+}
+
+void radiotimer_setPeriod(PORT_RADIOTIMER_WIDTH period) {
+   radiotimer_vars.period = period;
+   // a deadline already passed fires right away
+   posix_schedule(POSIX_TIMER_RADIOTIMER_OVERFLOW,radiotimer_vars.start+period);
+}
+
+PORT_RADIOTIMER_WIDTH radiotimer_getPeriod() {
+   return radiotimer_vars.period;
+}
+
+//===== compare
+
+void radiotimer_schedule(PORT_RADIOTIMER_WIDTH offset) {
+   posix_schedule(POSIX_TIMER_RADIOTIMER_COMPARE,radiotimer_vars.start+offset);
+}
+
+void radiotimer_cancel() {
+   posix_cancel(POSIX_TIMER_RADIOTIMER_COMPARE);
+}
+
+//===== capture
+
+PORT_RADIOTIMER_WIDTH radiotimer_getCapturedTime() {
+   return radiotimer_getValue();
+}
+
+//=========================== interrupt handlers ==============================
+
+kick_scheduler_t radiotimer_isr() {
+   // the interrupts are dispatched by the event loop
+   return DO_NOT_KICK_SCHEDULER;
+}
+
+//=========================== private =========================================
+
+static void radiotimer_overflow(void) {
+   radiotimer_vars.start += radiotimer_vars.period;
+   posix_schedule(
+      POSIX_TIMER_RADIOTIMER_OVERFLOW,
+      radiotimer_vars.start+radiotimer_vars.period
+   );
+   if (radiotimer_vars.overflow_cb!=NULL) {
+      radiotimer_vars.overflow_cb();
+   }
+}
+
+static void radiotimer_compare(void) {
+   if (radiotimer_vars.compare_cb!=NULL) {
+      radiotimer_vars.compare_cb();
+   }
+}
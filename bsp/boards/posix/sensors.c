@@ -0,0 +1,35 @@
+/**
+\brief POSIX-specific definition of the "sensors" bsp module.
+
+The emulated mote has no sensors.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "opendefs.h"
+#include "sensors.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== public ==========================================
+
+void sensors_init(void) {
+}
+
+bool sensors_is_present(uint8_t sensorType) {
+   return FALSE;
+}
+
+callbackRead_cbt sensors_getCallbackRead(uint8_t sensorType) {
+   return NULL;
+}
+
+callbackConvert_cbt sensors_getCallbackConvert(uint8_t sensorType) {
+   return NULL;
+}
+
+//=========================== private =========================================
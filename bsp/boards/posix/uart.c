@@ -0,0 +1,203 @@
+/**
+\brief POSIX-specific definition of the "uart" bsp module.
+
+The serial port is a pseudo-terminal, whose slave side is printed on stdout
+when the mote boots (and linked to from --serial, if given). OpenVisualizer,
+or any other tool, opens it as it would open the serial port of a real mote.
+
+Bytes written by the mote are buffered and written to the pty when the mote
+goes to sleep; the "TX done" interrupt is raised right away. Bytes nobody
+reads are dropped once the pty is full, as on a real serial line.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#define _GNU_SOURCE                  // accept4(), posix_openpt()
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <termios.h>
+#include <unistd.h>
+#include "opendefs.h"
+#include "uart.h"
+#include "posix.h"
+
+//=========================== defines =========================================
+
+#define UART_BUFLEN                  4096
+
+//=========================== variables =======================================
+
+typedef struct {
+   uart_tx_cbt               txCb;
+   uart_rx_cbt               rxCb;
+   bool                      enabled;
+   int                       master;
+   int                       slave;          ///< kept open, see uart_init()
+   // TX
+   uint8_t                   txBuf[UART_BUFLEN];
+   uint16_t                  txLen;
+   // RX
+   uint8_t                   rxBuf[UART_BUFLEN];
+   uint16_t                  rxLen;
+   uint16_t                  rxIdx;
+   uint8_t                   rxByte;
+} uart_vars_t;
+
+uart_vars_t uart_vars;
+
+//=========================== prototypes ======================================
+
+static void uart_readable(void);
+static void uart_txDone(void);
+static void uart_rxReady(void);
+
+//=========================== public ==========================================
+
+void uart_init() {
+   struct termios tio;
+   const char*    name;
+
+   memset(&uart_vars,0,sizeof(uart_vars_t));
+
+   uart_vars.master = posix_openpt(O_RDWR|O_NOCTTY|O_NONBLOCK|O_CLOEXEC);
+   if (
+         uart_vars.master<0            ||
+         grantpt(uart_vars.master)<0   ||
+         unlockpt(uart_vars.master)<0  ||
+         (name = ptsname(uart_vars.master))==NULL
+      ) {
+      perror("uart_init");
+      exit(1);
+   }
+
+   // raw bytes, no echo
+   tcgetattr(uart_vars.master,&tio);
+   cfmakeraw(&tio);
+   tcsetattr(uart_vars.master,TCSANOW,&tio);
+
+   // without a slave open, the master reports a hang-up on every wait
+   uart_vars.slave = open(name,O_RDWR|O_NOCTTY|O_CLOEXEC);
+
+   if (posix_vars.serialLink!=NULL) {
+      unlink(posix_vars.serialLink);
+      if (symlink(name,posix_vars.serialLink)<0) {
+         perror("uart_init");
+      }
+   }
+   printf("mote %d: serial port %s\n",posix_vars.id,name);
+   fflush(stdout);
+
+   posix_setTimerCb(POSIX_TIMER_UART_TX,uart_txDone);
+   posix_setTimerCb(POSIX_TIMER_UART_RX,uart_rxReady);
+   posix_watchFd(POSIX_FD_UART,uart_vars.master,uart_readable);
+}
+
+void uart_setCallbacks(uart_tx_cbt txCb, uart_rx_cbt rxCb) {
+   uart_vars.txCb = txCb;
+   uart_vars.rxCb = rxCb;
+}
+
+void uart_enableInterrupts() {
+   uart_vars.enabled = TRUE;
+   if (uart_vars.rxIdx<uart_vars.rxLen) {
+      posix_schedule(POSIX_TIMER_UART_RX,posix_now());
+   }
+}
+
+void uart_disableInterrupts() {
+   uart_vars.enabled = FALSE;
+   posix_cancel(POSIX_TIMER_UART_RX);
+}
+
+void uart_clearRxInterrupts() {
+}
+
+void uart_clearTxInterrupts() {
+}
+
+void uart_writeByte(uint8_t byteToWrite) {
+   if (uart_vars.txLen==UART_BUFLEN) {
+      uart_flush();
+   }
+   if (uart_vars.txLen<UART_BUFLEN) {
+      uart_vars.txBuf[uart_vars.txLen++] = byteToWrite;
+   }
+   posix_schedule(POSIX_TIMER_UART_TX,posix_now());
+}
+
+uint8_t uart_readByte() {
+   return uart_vars.rxByte;
+}
+
+/**
+\brief Write the buffered bytes to the pty.
+*/
+void uart_flush(void) {
+   ssize_t written;
+
+   if (uart_vars.txLen==0) {
+      return;
+   }
+   written = write(uart_vars.master,uart_vars.txBuf,uart_vars.txLen);
+   if (written>0 && written<uart_vars.txLen) {
+      memmove(uart_vars.txBuf,&uart_vars.txBuf[written],uart_vars.txLen-written);
+      uart_vars.txLen -= (uint16_t)written;
+   } else {
+      // all written, or nobody reading
+      uart_vars.txLen  = 0;
+   }
+}
+
+//=========================== private =========================================
+
+static void uart_readable(void) {
+   ssize_t len;
+
+   if (uart_vars.rxIdx==uart_vars.rxLen) {
+      uart_vars.rxIdx = 0;
+      uart_vars.rxLen = 0;
+   }
+   len = read(uart_vars.master,&uart_vars.rxBuf[uart_vars.rxLen],UART_BUFLEN-uart_vars.rxLen);
+   if (len<=0) {
+      return;
+   }
+   uart_vars.rxLen += (uint16_t)len;
+   if (uart_vars.enabled) {
+      uart_rxReady();
+   }
+   if (uart_vars.rxLen==UART_BUFLEN && uart_vars.rxIdx<uart_vars.rxLen) {
+      // the mote is not reading, drop what it did not get to
+      uart_vars.rxIdx = 0;
+      uart_vars.rxLen = 0;
+   }
+}
+
+static void uart_txDone(void) {
+   uart_tx_isr();
+}
+
+static void uart_rxReady(void) {
+   // feed bytes until the mote closes its serial port
+   while (uart_vars.enabled && uart_vars.rxIdx<uart_vars.rxLen) {
+      uart_vars.rxByte = uart_vars.rxBuf[uart_vars.rxIdx++];
+      uart_rx_isr();
+   }
+}
+
+//=========================== interrupt handlers ==============================
+
+kick_scheduler_t uart_tx_isr() {
+   if (uart_vars.txCb!=NULL) {
+      uart_vars.txCb();
+   }
+   return KICK_SCHEDULER;
+}
+
+kick_scheduler_t uart_rx_isr() {
+   if (uart_vars.rxCb!=NULL) {
+      uart_vars.rxCb();
+   }
+   return KICK_SCHEDULER;
+}
@@ -36,6 +36,16 @@ void board_init(OpenMote* self) {
    radio_init(self);
    radiotimer_init(self);
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_board_init,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_init],NULL);
    if (result == NULL) {
@@ -56,6 +66,15 @@ void board_sleep(OpenMote* self) {
    printf("C@0x%x: board_sleep()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_moteSleep(self);
+      return;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_sleep],NULL);
    if (result == NULL) {
@@ -76,6 +95,15 @@ void board_reset(OpenMote* self) {
    printf("C@0x%x: board_reset()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_moteReset(self);
+      return;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_board_reset],NULL);
    if (result == NULL) {
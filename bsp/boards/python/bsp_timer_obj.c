@@ -28,6 +28,19 @@ void bsp_timer_init(OpenMote* self) {
    printf("C@0x%x: bsp_timer_init()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // anchor the cached counter
+   self->notifcache.bt_running = notifcache_getTicks(self,&self->notifcache.bt_start);
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_bsp_timer_init,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_init],NULL);
    if (result == NULL) {
@@ -48,6 +61,20 @@ void bsp_timer_reset(OpenMote* self) {
    printf("C@0x%x: bsp_timer_reset()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_bsp_timer_reset(self);
+      return;
+   }
+   
+   // anchor the cached counter
+   self->notifcache.bt_running = notifcache_getTicks(self,&self->notifcache.bt_start);
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_bsp_timer_reset,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_reset],NULL);
    if (result == NULL) {
@@ -69,6 +96,17 @@ void bsp_timer_scheduleIn(OpenMote* self, PORT_TIMER_WIDTH delayTicks) {
    printf("C@0x%x: bsp_timer_scheduleIn(delayTicks=%d)... \n",self,delayTicks);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_bsp_timer_scheduleIn(self,delayTicks);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_bsp_timer_scheduleIn,(uint8_t*)&delayTicks,sizeof(delayTicks))==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",delayTicks);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_scheduleIn],arglist);
@@ -91,6 +129,17 @@ void bsp_timer_cancel_schedule(OpenMote* self) {
    printf("C@0x%x: bsp_timer_cancel_schedule()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_bsp_timer_cancel_schedule(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_bsp_timer_cancel_schedule,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_cancel_schedule],NULL);
    if (result == NULL) {
@@ -107,11 +156,26 @@ void bsp_timer_cancel_schedule(OpenMote* self) {
 PORT_TIMER_WIDTH bsp_timer_get_currentValue(OpenMote* self) {
    PyObject*            result;
    PORT_TIMER_WIDTH     returnVal;
+   uint64_t             now;
    
 #ifdef TRACE_ON
    printf("C@0x%x: bsp_timer_get_currentValue()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return simengine_bsp_timer_get_currentValue(self);
+   }
+   
+   // served from the cache
+   if (self->notifcache.bt_running==TRUE && notifcache_getTicks(self,&now)==TRUE) {
+      self->notifcache.numHits++;
+      return (PORT_TIMER_WIDTH)(now-self->notifcache.bt_start);
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_bsp_timer_get_currentValue],NULL);
    if (result == NULL) {
@@ -5,6 +5,12 @@
 */
 
 #include "debugpins_obj.h"
+#include "simtrace_obj.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
 
 //=========================== defines =========================================
 
@@ -21,6 +27,16 @@ void debugpins_init(OpenMote* self) {
    printf("C@0x%x: debugpins_init()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_init,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_init],NULL);
    if (result == NULL) {
@@ -41,6 +57,16 @@ void debugpins_frame_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_frame_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_toggle],NULL);
    if (result == NULL) {
@@ -60,6 +86,16 @@ void debugpins_frame_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_frame_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_clr],NULL);
    if (result == NULL) {
@@ -79,6 +115,16 @@ void debugpins_frame_set(OpenMote* self) {
    printf("C@0x%x: debugpins_frame_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_frame_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_frame_set],NULL);
    if (result == NULL) {
@@ -99,6 +145,16 @@ void debugpins_slot_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_slot_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_toggle],NULL);
    if (result == NULL) {
@@ -118,6 +174,16 @@ void debugpins_slot_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_slot_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_clr],NULL);
    if (result == NULL) {
@@ -137,6 +203,16 @@ void debugpins_slot_set(OpenMote* self) {
    printf("C@0x%x: debugpins_slot_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_slot_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_slot_set],NULL);
    if (result == NULL) {
@@ -157,6 +233,16 @@ void debugpins_fsm_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_fsm_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_toggle],NULL);
    if (result == NULL) {
@@ -176,6 +262,16 @@ void debugpins_fsm_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_fsm_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_clr],NULL);
    if (result == NULL) {
@@ -195,6 +291,16 @@ void debugpins_fsm_set(OpenMote* self) {
    printf("C@0x%x: debugpins_fsm_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_fsm_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_fsm_set],NULL);
    if (result == NULL) {
@@ -215,6 +321,16 @@ void debugpins_task_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_task_toggle(... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_task_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_toggle],NULL);
    if (result == NULL) {
@@ -234,6 +350,16 @@ void debugpins_task_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_task_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_task_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_clr],NULL);
    if (result == NULL) {
@@ -253,6 +379,16 @@ void debugpins_task_set(OpenMote* self) {
    printf("C@0x%x: debugpins_task_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_task_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_task_set],NULL);
    if (result == NULL) {
@@ -273,6 +409,16 @@ void debugpins_isr_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_isr_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_toggle],NULL);
    if (result == NULL) {
@@ -292,6 +438,16 @@ void debugpins_isr_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_isr_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_clr],NULL);
    if (result == NULL) {
@@ -311,6 +467,16 @@ void debugpins_isr_set(OpenMote* self) {
    printf("C@0x%x: debugpins_isr_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_isr_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_isr_set],NULL);
    if (result == NULL) {
@@ -331,6 +497,16 @@ void debugpins_radio_toggle(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_radio_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_toggle],NULL);
    if (result == NULL) {
@@ -350,6 +526,16 @@ void debugpins_radio_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_radio_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_clr],NULL);
    if (result == NULL) {
@@ -369,6 +555,16 @@ void debugpins_radio_set(OpenMote* self) {
    printf("C@0x%x: debugpins_radio_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_radio_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_radio_set],NULL);
    if (result == NULL) {
@@ -389,6 +585,16 @@ void debugpins_ka_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_ka_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_ka_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_ka_clr],NULL);
    if (result == NULL) {
@@ -408,6 +614,16 @@ void debugpins_ka_set(OpenMote* self) {
    printf("C@0x%x: debugpins_ka_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_ka_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_ka_set],NULL);
    if (result == NULL) {
@@ -428,6 +644,16 @@ void debugpins_syncPacket_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_syncPacket_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_syncPacket_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_syncPacket_clr],NULL);
    if (result == NULL) {
@@ -447,6 +673,16 @@ void debugpins_syncPacket_set(OpenMote* self) {
    printf("C@0x%x: debugpins_syncPacket_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_syncPacket_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_syncPacket_set],NULL);
    if (result == NULL) {
@@ -467,6 +703,16 @@ void debugpins_syncAck_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_syncAck_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_syncAck_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_syncAck_clr],NULL);
    if (result == NULL) {
@@ -486,6 +732,16 @@ void debugpins_syncAck_set(OpenMote* self) {
    printf("C@0x%x: debugpins_syncAck_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_syncAck_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_syncAck_set],NULL);
    if (result == NULL) {
@@ -506,6 +762,16 @@ void debugpins_debug_clr(OpenMote* self) {
    printf("C@0x%x: debugpins_debug_clr()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_debug_clr,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_debug_clr],NULL);
    if (result == NULL) {
@@ -525,6 +791,16 @@ void debugpins_debug_set(OpenMote* self) {
    printf("C@0x%x: debugpins_debug_set()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_debugpins_debug_set,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_debugpins_debug_set],NULL);
    if (result == NULL) {
@@ -536,4 +812,51 @@ void debugpins_debug_set(OpenMote* self) {
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
 #endif
-}
\ No newline at end of file
+}
+
+//===== events recorded by the native simulation engine
+
+void debugpins_task_run(OpenMote* self, uintptr_t task) {
+   if (self->engine!=NULL) {
+      simtrace_task(self,task);
+   }
+}
+
+void debugpins_queue_alloc(OpenMote* self, uint8_t index, uint8_t creator) {
+   if (self->engine!=NULL) {
+      simtrace_record(self,self->sim.worker->now,SIMTRACE_QUEUE_ALLOC,index|(creator<<8),NULL,0);
+   }
+}
+
+void debugpins_queue_free(OpenMote* self, uint8_t index, uint8_t owner) {
+   if (self->engine!=NULL) {
+      simtrace_record(self,self->sim.worker->now,SIMTRACE_QUEUE_FREE,index|(owner<<8),NULL,0);
+   }
+}
+
+//===== state generations, see OpenMote.getStateDelta()
+
+void debugpins_state_changed(OpenMote* self, uint8_t status) {
+   self->stateGeneration[status] = ++self->stateClock;
+}
+
+//===== host clock, see SCHEDSTATS_NOW()
+
+uint32_t debugpins_host_clock(OpenMote* self) {
+#ifdef _WIN32
+   LARGE_INTEGER   now;
+   LARGE_INTEGER   freq;
+   
+   QueryPerformanceCounter(&now);
+   QueryPerformanceFrequency(&freq);
+   return (uint32_t)(
+      (now.QuadPart/freq.QuadPart)*1000000+
+      (now.QuadPart%freq.QuadPart)*1000000/freq.QuadPart
+   );
+#else
+   struct timespec now;
+   
+   clock_gettime(CLOCK_MONOTONIC,&now);
+   return (uint32_t)(now.tv_sec*1000000+now.tv_nsec/1000);
+#endif
+}
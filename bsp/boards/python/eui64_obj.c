@@ -23,6 +23,22 @@ void eui64_get(OpenMote* self, uint8_t* addressToWrite) {
    printf("C@0x%x: eui64_get()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      memcpy(addressToWrite,self->sim.eui64,sizeof(self->sim.eui64));
+      return;
+   }
+   
+   // served from the cache
+   if (self->notifcache.eui64Valid==TRUE) {
+      self->notifcache.numHits++;
+      memcpy(addressToWrite,self->notifcache.eui64,sizeof(self->notifcache.eui64));
+      return;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_eui64_get],NULL);
    if (result == NULL) {
@@ -55,6 +71,10 @@ void eui64_get(OpenMote* self, uint8_t* addressToWrite) {
    printf("\n");
 #endif
    
+   // the EUI64 does not change, cache it
+   memcpy(self->notifcache.eui64,addressToWrite,sizeof(self->notifcache.eui64));
+   self->notifcache.eui64Valid = TRUE;
+   
    // dispose of returned value
    Py_DECREF(result);
 }
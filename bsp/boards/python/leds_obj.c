@@ -9,6 +9,13 @@
 
 //=========================== defines =========================================
 
+// state of the LEDs when running on the native simulation engine
+#define LED_ERROR       0x01
+#define LED_RADIO       0x02
+#define LED_SYNC        0x04
+#define LED_DEBUG       0x08
+#define LED_ALL         0x0f
+
 //=========================== variables =======================================
 
 //=========================== prototypes ======================================
@@ -22,6 +29,17 @@ void leds_init(OpenMote* self) {
    printf("C@0x%x: leds_init()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds = 0;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_init,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_init],NULL);
    if (result == NULL) {
@@ -42,6 +60,17 @@ void leds_error_on(OpenMote* self) {
    printf("C@0x%x: leds_error_on()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds |= LED_ERROR;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_error_on,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_on],NULL);
    if (result == NULL) {
@@ -61,6 +90,17 @@ void leds_error_off(OpenMote* self) {
    printf("C@0x%x: leds_error_off()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds &= ~LED_ERROR;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_error_off,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_off],NULL);
    if (result == NULL) {
@@ -80,6 +120,17 @@ void leds_error_toggle(OpenMote* self) {
    printf("C@0x%x: leds_error_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds ^= LED_ERROR;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_error_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_toggle],NULL);
    if (result == NULL) {
@@ -100,6 +151,14 @@ uint8_t leds_error_isOn(OpenMote* self) {
    printf("C@0x%x: leds_error_isOn()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return (self->sim.leds & LED_ERROR)!=0;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_isOn],NULL);
    if (result == NULL) {
@@ -122,6 +181,17 @@ void leds_error_blink(OpenMote* self) {
    printf("C@0x%x: leds_error_blink()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds |= LED_ERROR;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_error_blink,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_error_blink],NULL);
    if (result == NULL) {
@@ -142,6 +212,17 @@ void leds_radio_on(OpenMote* self) {
    printf("C@0x%x: leds_radio_on()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds |= LED_RADIO;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_radio_on,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_on],NULL);
    if (result == NULL) {
@@ -161,6 +242,17 @@ void leds_radio_off(OpenMote* self) {
    printf("C@0x%x: leds_radio_off()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds &= ~LED_RADIO;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_radio_off,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_off],NULL);
    if (result == NULL) {
@@ -180,6 +272,17 @@ void leds_radio_toggle(OpenMote* self) {
    printf("C@0x%x: leds_radio_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds ^= LED_RADIO;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_radio_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_toggle],NULL);
    if (result == NULL) {
@@ -200,6 +303,14 @@ uint8_t leds_radio_isOn(OpenMote* self) {
    printf("C@0x%x: leds_radio_isOn()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return (self->sim.leds & LED_RADIO)!=0;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_radio_isOn],NULL);
    if (result == NULL) {
@@ -224,6 +335,17 @@ void leds_sync_on(OpenMote* self) {
    printf("C@0x%x: leds_sync_on()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds |= LED_SYNC;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_sync_on,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_on],NULL);
    if (result == NULL) {
@@ -243,6 +365,17 @@ void leds_sync_off(OpenMote* self) {
    printf("C@0x%x: leds_sync_off()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds &= ~LED_SYNC;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_sync_off,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_off],NULL);
    if (result == NULL) {
@@ -262,6 +395,17 @@ void leds_sync_toggle(OpenMote* self) {
    printf("C@0x%x: leds_sync_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds ^= LED_SYNC;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_sync_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_toggle],NULL);
    if (result == NULL) {
@@ -282,6 +426,14 @@ uint8_t leds_sync_isOn(OpenMote* self) {
    printf("C@0x%x: leds_sync_isOn()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return (self->sim.leds & LED_SYNC)!=0;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_sync_isOn],NULL);
    if (result == NULL) {
@@ -306,6 +458,17 @@ void leds_debug_on(OpenMote* self) {
    printf("C@0x%x: leds_debug_on()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds |= LED_DEBUG;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_debug_on,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_on],NULL);
    if (result == NULL) {
@@ -325,6 +488,17 @@ void leds_debug_off(OpenMote* self) {
    printf("C@0x%x: leds_debug_off()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds &= ~LED_DEBUG;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_debug_off,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_off],NULL);
    if (result == NULL) {
@@ -344,6 +518,17 @@ void leds_debug_toggle(OpenMote* self) {
    printf("C@0x%x: leds_debug_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds ^= LED_DEBUG;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_debug_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_toggle],NULL);
     if (result == NULL) {
@@ -364,6 +549,14 @@ uint8_t leds_debug_isOn(OpenMote* self) {
    printf("C@0x%x: leds_debug_isOn()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return (self->sim.leds & LED_DEBUG)!=0;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_debug_isOn],NULL);
    if (result == NULL) {
@@ -387,6 +580,17 @@ void leds_all_on(OpenMote* self) {
    printf("C@0x%x: leds_all_on()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds = LED_ALL;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_all_on,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_on],NULL);
    if (result == NULL) {
@@ -406,6 +610,17 @@ void leds_all_off(OpenMote* self) {
    printf("C@0x%x: leds_all_off()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds = 0;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_all_off,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_off],NULL);
    if (result == NULL) {
@@ -425,6 +640,17 @@ void leds_all_toggle(OpenMote* self) {
    printf("C@0x%x: leds_all_toggle()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds ^= LED_ALL;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_all_toggle,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_all_toggle],NULL);
    if (result == NULL) {
@@ -445,6 +671,17 @@ void leds_circular_shift(OpenMote* self) {
    printf("C@0x%x: leds_circular_shift()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds = ((self->sim.leds<<1) | (self->sim.leds>>3)) & LED_ALL;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_circular_shift,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_circular_shift],NULL);
    if (result == NULL) {
@@ -465,6 +702,17 @@ void leds_increment(OpenMote* self) {
    printf("C@0x%x: leds_increment()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      self->sim.leds = (self->sim.leds+1) & LED_ALL;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_leds_increment,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_leds_increment],NULL);
    if (result == NULL) {
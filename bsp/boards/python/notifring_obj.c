@@ -0,0 +1,241 @@
+/**
+\brief Batched notifications from the C mote to the Python BSP.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "openwsnmodule_obj.h"
+#include <stdio.h>
+#include <string.h>
+#include "notifring_obj.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+static bool notifring_reserve(notifring_t* ring, uint16_t recLen, uint32_t* pos);
+static void notifring_drain(notifring_t* ring, uint32_t start, uint32_t stop);
+
+//=========================== public ==========================================
+
+//===== ring
+
+/**
+\brief Install (or remove, with Py_None) the Python drain callback.
+
+Pending notifications are drained before the callback is replaced.
+
+\returns 0 on success, -1 if drainCb is not callable.
+*/
+int notifring_setDrainCb(OpenMote* self, PyObject* drainCb) {
+   
+   if (drainCb==Py_None) {
+      drainCb = NULL;
+   }
+   if (drainCb!=NULL && !PyCallable_Check(drainCb)) {
+      return -1;
+   }
+   
+   // drain what was batched for the previous callback
+   notifring_flush(self);
+   
+   Py_XINCREF(drainCb);
+   Py_XDECREF(self->notifring.drainCb);
+   self->notifring.drainCb = drainCb;
+   
+   return 0;
+}
+
+/**
+\brief Append a notification to the ring.
+
+\returns TRUE if the notification was batched, FALSE if the caller needs to
+   forward it to Python itself.
+*/
+bool notifring_post(OpenMote* self, uint8_t notifId, uint8_t* payload, uint8_t len) {
+   notifring_t* ring;
+   uint16_t     recLen;
+   uint32_t     pos;
+   
+   ring = &self->notifring;
+   
+   if (ring->drainCb==NULL) {
+      return FALSE;
+   }
+   
+   recLen = NOTIFRING_HEADER_LEN+len;
+   
+   // make room, draining the ring if needed
+   if (notifring_reserve(ring,recLen,&pos)==FALSE) {
+      notifring_flush(self);
+      if (notifring_reserve(ring,recLen,&pos)==FALSE) {
+         // only happens when posting from within the drain callback
+         ring->numFallbacks++;
+         return FALSE;
+      }
+   }
+   
+   // write the record
+   ring->buf[pos]   = notifId;
+   ring->buf[pos+1] = len;
+   if (len>0) {
+      memcpy(&ring->buf[pos+NOTIFRING_HEADER_LEN],payload,len);
+   }
+   
+   // publish it
+   ring->head       = pos+recLen;
+   ring->numPosted++;
+   
+   return TRUE;
+}
+
+/**
+\brief Hand all pending notifications to the Python drain callback.
+
+Each contiguous stretch of records is passed as a read-only memoryview. Does
+nothing when called from within the drain callback.
+*/
+void notifring_flush(OpenMote* self) {
+   notifring_t* ring;
+   uint32_t     head;
+   
+   ring = &self->notifring;
+   
+   if (ring->drainCb==NULL || ring->busy==TRUE) {
+      return;
+   }
+   
+   ring->busy = TRUE;
+   while (ring->tail!=ring->head) {
+      head = ring->head;
+      if (head>ring->tail) {
+         // records between tail and head
+         notifring_drain(ring,ring->tail,head);
+         ring->tail = head;
+      } else if (ring->tail<ring->end) {
+         // records between tail and the wrap point
+         notifring_drain(ring,ring->tail,ring->end);
+         ring->tail = 0;
+      } else {
+         ring->tail = 0;
+      }
+   }
+   ring->busy = FALSE;
+}
+
+//===== cache
+
+/**
+\brief Install (or remove, with Py_None) the object holding the mote's time.
+
+\returns 0 on success, -1 if clock does not expose a buffer holding a double.
+*/
+int notifcache_setClock(OpenMote* self, PyObject* clock) {
+   const void* buf;
+   Py_ssize_t  len;
+   
+   if (clock==Py_None) {
+      clock = NULL;
+   }
+   buf = NULL;
+   if (clock!=NULL) {
+      if (PyObject_AsReadBuffer(clock,&buf,&len)!=0) {
+         return -1;
+      }
+      if (len<(Py_ssize_t)sizeof(double)) {
+         PyErr_SetString(PyExc_ValueError, "clock must hold at least one double");
+         return -1;
+      }
+   }
+   
+   Py_XINCREF(clock);
+   Py_XDECREF(self->notifcache.clock);
+   self->notifcache.clock      = clock;
+   self->notifcache.now        = (const double*)buf;
+   
+   // timers need to be re-anchored on the new clock
+   self->notifcache.rt_running = FALSE;
+   self->notifcache.bt_running = FALSE;
+   
+   return 0;
+}
+
+/**
+\brief Read the local time of the mote, in 32kHz ticks.
+
+\returns FALSE if Python does not share its time with the mote.
+*/
+bool notifcache_getTicks(OpenMote* self, uint64_t* ticks) {
+   
+   if (self->notifcache.now==NULL || *self->notifcache.now<0) {
+      return FALSE;
+   }
+   *ticks = (uint64_t)(*self->notifcache.now);
+   return TRUE;
+}
+
+//=========================== private =========================================
+
+/**
+\brief Find room for a record of recLen bytes.
+
+One byte is always left free so a full ring is not mistaken for an empty one.
+Records never straddle the end of the buffer; when the end is reached, head
+wraps around and end remembers where the records stop.
+*/
+static bool notifring_reserve(notifring_t* ring, uint16_t recLen, uint32_t* pos) {
+   uint32_t head;
+   uint32_t tail;
+   
+   head = ring->head;
+   tail = ring->tail;
+   
+   if (head>=tail) {
+      // free space after head
+      if (head+recLen<=NOTIFRING_SIZE) {
+         *pos = head;
+         return TRUE;
+      }
+      // free space at the start of the buffer
+      if (recLen<tail) {
+         ring->end  = head;
+         ring->head = 0;
+         *pos = 0;
+         return TRUE;
+      }
+      return FALSE;
+   }
+   
+   // head has wrapped, free space up to tail
+   if (head+recLen<tail) {
+      *pos = head;
+      return TRUE;
+   }
+   return FALSE;
+}
+
+static void notifring_drain(notifring_t* ring, uint32_t start, uint32_t stop) {
+   Py_buffer   view;
+   PyObject*   mv;
+   PyObject*   result;
+   
+   PyBuffer_FillInfo(&view,NULL,&ring->buf[start],stop-start,1,PyBUF_CONTIG_RO);
+   mv         = PyMemoryView_FromBuffer(&view);
+   if (mv==NULL) {
+      printf("[CRITICAL] notifring_drain() could not create memoryview\r\n");
+      return;
+   }
+   
+   // forward to Python
+   result     = PyObject_CallFunctionObjArgs(ring->drainCb,mv,NULL);
+   Py_DECREF(mv);
+   if (result == NULL) {
+      printf("[CRITICAL] notifring_drain() returned NULL\r\n");
+      return;
+   }
+   Py_DECREF(result);
+   
+   ring->numDrains++;
+}
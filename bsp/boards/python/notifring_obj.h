@@ -0,0 +1,96 @@
+/**
+\brief Batched notifications from the C mote to the Python BSP.
+
+By default, the Python board calls into Python once per MOTE_NOTIF_* event.
+Once a drain callback is installed with OpenMote.set_notifRing(), the
+notifications which do not return a value are instead appended to a
+fixed-size, single-producer/single-consumer ring of binary records. The ring
+is handed to the drain callback as a memoryview at the following points:
+- before board_sleep() and board_reset() are forwarded to Python, so Python
+  has seen everything the mote did before it advances time;
+- before any call which needs a return value is forwarded to Python;
+- when the ring is full.
+
+Each record is laid out as:
+- byte 0: notification id (MOTE_NOTIF_*)
+- byte 1: length of the payload, in bytes
+- payload, with integer arguments in native byte order:
+   - bsp_timer_scheduleIn, radio_startTimer, radio_setTimerPeriod:
+     PORT_TIMER_WIDTH
+   - radiotimer_start, radiotimer_setPeriod, radiotimer_schedule:
+     PORT_RADIOTIMER_WIDTH
+   - radio_setFrequency, uart_writeByte: uint8_t
+   - radio_loadPacket and the FASTSIM uart writes: the raw bytes
+
+The memoryview only covers the mote's own memory, and is only valid during
+the call to the drain callback.
+
+The calls which need a return value (radiotimer_getValue,
+radiotimer_getPeriod, bsp_timer_get_currentValue, eui64_get) are served
+from state cached in C. Timer values need the mote's local time, which
+Python shares through an object installed with OpenMote.set_clock(): any
+object exposing a buffer which starts with a native double holding the
+number of 32kHz ticks elapsed on the mote (e.g. array.array('d',[0.0])).
+Python updates it in place before calling into the mote.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __NOTIFRING_H
+#define __NOTIFRING_H
+
+#include "Python.h"
+
+#include "toolchain_defs.h"
+#include "board_info.h"
+
+//=========================== define ==========================================
+
+#define NOTIFRING_SIZE               4096
+#define NOTIFRING_HEADER_LEN         2
+
+//=========================== typedef =========================================
+
+typedef struct OpenMote OpenMote;
+
+typedef struct {
+   uint8_t                   buf[NOTIFRING_SIZE];
+   volatile uint32_t         head;           ///< next byte written by the mote
+   volatile uint32_t         tail;           ///< next byte drained to Python
+   volatile uint32_t         end;            ///< end of the records when head has wrapped
+   PyObject*                 drainCb;        ///< NULL when notifications are not batched
+   bool                      busy;           ///< drain callback is running
+   // stats
+   uint32_t                  numPosted;
+   uint32_t                  numDrains;
+   uint32_t                  numFallbacks;   ///< forwarded one-by-one because the ring was full
+} notifring_t;
+
+typedef struct {
+   PyObject*                 clock;          ///< NULL when Python does not share its time
+   const double*             now;            ///< local time of the mote, in 32kHz ticks
+   // radiotimer
+   bool                      rt_running;
+   uint64_t                  rt_start;       ///< tick the counter last wrapped
+   PORT_RADIOTIMER_WIDTH     rt_period;
+   // bsp_timer
+   bool                      bt_running;
+   uint64_t                  bt_start;
+   // eui64
+   bool                      eui64Valid;
+   uint8_t                   eui64[8];
+   // stats
+   uint32_t                  numHits;
+} notifcache_t;
+
+//=========================== prototypes ======================================
+
+// ring
+int       notifring_setDrainCb(OpenMote* self, PyObject* drainCb);
+bool      notifring_post(OpenMote* self, uint8_t notifId, uint8_t* payload, uint8_t len);
+void      notifring_flush(OpenMote* self);
+// cache
+int       notifcache_setClock(OpenMote* self, PyObject* clock);
+bool      notifcache_getTicks(OpenMote* self, uint64_t* ticks);
+
+#endif
@@ -13,6 +13,49 @@
 
 //===== members
 
+/**
+\brief Modules of the stack returned by getStateDelta().
+
+Each is a view over the mote's memory, dirty once its generation, bumped by
+debugpins_state_changed(), is past the caller's.
+*/
+typedef struct {
+   const char*          name;
+   uint8_t              status;              ///< STATUS_* of the module
+   size_t               offset;              ///< of its variables in OpenMote
+   size_t               size;
+} statemodule_t;
+
+static const statemodule_t stateModules[] = {
+   {  "idmanager_vars",  STATUS_ID,        offsetof(OpenMote,idmanager_vars),  sizeof(idmanager_vars_t)  },
+   {  "ieee154e_stats",  STATUS_MACSTATS,  offsetof(OpenMote,ieee154e_stats),  sizeof(ieee154e_stats_t)  },
+   {  "schedule_vars",   STATUS_SCHEDULE,  offsetof(OpenMote,schedule_vars),   sizeof(schedule_vars_t)   },
+   {  "openqueue_vars",  STATUS_QUEUE,     offsetof(OpenMote,openqueue_vars),  sizeof(openqueue_vars_t)  },
+   {  "neighbors_vars",  STATUS_NEIGHBORS, offsetof(OpenMote,neighbors_vars),  sizeof(neighbors_vars_t)  },
+};
+
+#ifdef SCHEDULER_STATS
+/**
+\brief List of the bins of num histograms, one list per histogram.
+*/
+static PyObject* OpenMote_histograms(schedstats_hist_t* hists, uint8_t num) {
+   PyObject* returnVal;
+   PyObject* bins;
+   uint8_t   i;
+   uint8_t   b;
+   
+   returnVal = PyList_New(num);
+   for (i=0;i<num;i++) {
+      bins = PyList_New(SCHEDSTATS_NUMBINS);
+      for (b=0;b<SCHEDSTATS_NUMBINS;b++) {
+         PyList_SET_ITEM(bins, b, PyInt_FromLong(hists[i].bins[b]));
+      }
+      PyList_SET_ITEM(returnVal, i, bins);
+   }
+   return returnVal;
+}
+#endif
+
 //===== methods
 
 static PyObject* OpenMote_set_callback(OpenMote* self, PyObject* args) {
@@ -45,6 +88,87 @@ static PyObject* OpenMote_set_callback(OpenMote* self, PyObject* args) {
    Py_RETURN_NONE;
 }
 
+static PyObject* OpenMote_set_notifRing(OpenMote* self, PyObject* args) {
+   PyObject* tempCallback;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "O:set_notifRing", &tempCallback)) {
+      return NULL;
+   }
+   
+   // record the callback (None to stop batching)
+   if (notifring_setDrainCb(self,tempCallback)!=0) {
+      PyErr_SetString(PyExc_TypeError, "parameter must be callable or None");
+      return NULL;
+   }
+   
+   // return successfully
+   Py_RETURN_NONE;
+}
+
+static PyObject* OpenMote_set_clock(OpenMote* self, PyObject* args) {
+   PyObject* clock;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "O:set_clock", &clock)) {
+      return NULL;
+   }
+   
+   // record the clock (None to stop caching timer values)
+   if (notifcache_setClock(self,clock)!=0) {
+      return NULL;
+   }
+   
+   // return successfully
+   Py_RETURN_NONE;
+}
+
+static PyObject* OpenMote_getNotifStats(OpenMote* self) {
+   PyObject* returnVal;
+   
+   returnVal = PyDict_New();
+   PyDict_SetItemString(returnVal, "numPosted",    PyInt_FromLong(self->notifring.numPosted));
+   PyDict_SetItemString(returnVal, "numDrains",    PyInt_FromLong(self->notifring.numDrains));
+   PyDict_SetItemString(returnVal, "numFallbacks", PyInt_FromLong(self->notifring.numFallbacks));
+   PyDict_SetItemString(returnVal, "numCacheHits", PyInt_FromLong(self->notifcache.numHits));
+   PyDict_SetItemString(returnVal, "numSerialFrames",  PyInt_FromLong(self->serialring.numFrames));
+   PyDict_SetItemString(returnVal, "numSerialDropped", PyInt_FromLong(self->serialring.shared.numDropped));
+   PyDict_SetItemString(returnVal, "numSerialRxBytes", PyInt_FromLong(self->serialring.numRxBytes));
+   
+   return returnVal;
+}
+
+static PyObject* OpenMote_serialRing(OpenMote* self) {
+   
+   // no arguments
+   
+   return serialring_attach(self);
+}
+
+static PyObject* OpenMote_snapshot(OpenMote* self) {
+   
+   // no arguments
+   
+   return snapshot_take(self);
+}
+
+static PyObject* OpenMote_restore(OpenMote* self, PyObject* args) {
+   char*     blob;
+   int       len;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "s#:restore", &blob, &len)) {
+      return NULL;
+   }
+   
+   if (snapshot_restore(self,(const uint8_t*)blob,len)<0) {
+      return NULL;
+   }
+   
+   // return successfully
+   Py_RETURN_NONE;
+}
+
 static PyObject* OpenMote_getState(OpenMote* self) {
    PyObject* returnVal;
    PyObject* uart_icb_tx;
@@ -69,11 +193,19 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    PyObject* ieee154e_dbg;
    PyObject* idmanager_vars;
    PyObject* openqueue_vars;
+   PyObject* numInClass;
+   PyObject* numRefused;
+   PyObject* numDropped;
+   PyObject* maxSojourn;
    PyObject* opentimers_vars;
    PyObject* random_vars;
    PyObject* openserial_vars;
    PyObject* scheduler_vars;
    PyObject* scheduler_dbg;
+#ifdef ABSTIMER
+   PyObject* abstimer_dbg;
+#endif
+   uint8_t   i;
    
    returnVal = PyDict_New();
    
@@ -127,7 +259,7 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    
    // neighbors_vars
    neighbors_vars = PyDict_New();
-   // TODO
+   PyDict_SetItemString(neighbors_vars, "myDAGrank",       PyInt_FromLong(self->neighbors_vars.myDAGrank));
    PyDict_SetItemString(returnVal, "neighbors_vars", neighbors_vars);
    
    // sixtop_vars
@@ -147,7 +279,7 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    
    // ieee154e_vars
    ieee154e_vars = PyDict_New();
-   // TODO
+   PyDict_SetItemString(ieee154e_vars, "isSync",           PyBool_FromLong(self->ieee154e_vars.isSync));
    PyDict_SetItemString(returnVal, "ieee154e_vars", ieee154e_vars);
    
    // ieee154e_stats
@@ -165,14 +297,29 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    // TODO
    PyDict_SetItemString(returnVal, "idmanager_vars", idmanager_vars);
    
-   // openqueue_vars
+   // openqueue_vars, per traffic class
    openqueue_vars = PyDict_New();
-   // TODO
+   numInClass     = PyList_New(OPENQUEUE_NUMCLASSES);
+   numRefused     = PyList_New(OPENQUEUE_NUMCLASSES);
+   numDropped     = PyList_New(OPENQUEUE_NUMCLASSES);
+   maxSojourn     = PyList_New(OPENQUEUE_NUMCLASSES);
+   for (i=0;i<OPENQUEUE_NUMCLASSES;i++) {
+      PyList_SetItem(numInClass, i, PyInt_FromLong(self->openqueue_vars.numInClass[i]));
+      PyList_SetItem(numRefused, i, PyInt_FromLong(self->openqueue_vars.numRefused[i]));
+      PyList_SetItem(numDropped, i, PyInt_FromLong(self->openqueue_vars.numDropped[i]));
+      PyList_SetItem(maxSojourn, i, PyInt_FromLong(self->openqueue_vars.maxSojourn[i]));
+   }
+   PyDict_SetItemString(openqueue_vars, "numInClass",      numInClass);
+   PyDict_SetItemString(openqueue_vars, "numRefused",      numRefused);
+   PyDict_SetItemString(openqueue_vars, "numDropped",      numDropped);
+   PyDict_SetItemString(openqueue_vars, "maxSojourn",      maxSojourn);
    PyDict_SetItemString(returnVal, "openqueue_vars", openqueue_vars);
    
    // opentimers_vars
    opentimers_vars = PyDict_New();
-   // TODO
+   PyDict_SetItemString(opentimers_vars, "numWakeups",      PyInt_FromLong(self->opentimers_vars.numWakeups));
+   PyDict_SetItemString(opentimers_vars, "numFired",        PyInt_FromLong(self->opentimers_vars.numFired));
+   PyDict_SetItemString(opentimers_vars, "numCoalesced",    PyInt_FromLong(self->opentimers_vars.numCoalesced));
    PyDict_SetItemString(returnVal, "opentimers_vars", opentimers_vars);
    
    // random_vars
@@ -192,12 +339,84 @@ static PyObject* OpenMote_getState(OpenMote* self) {
    
    // scheduler_dbg
    scheduler_dbg = PyDict_New();
-   // TODO
+   PyDict_SetItemString(scheduler_dbg, "numTasksCur",       PyInt_FromLong(self->scheduler_dbg.numTasksCur));
+   PyDict_SetItemString(scheduler_dbg, "numTasksMax",       PyInt_FromLong(self->scheduler_dbg.numTasksMax));
+   PyDict_SetItemString(scheduler_dbg, "numTasksCoalesced", PyInt_FromLong(self->scheduler_dbg.numTasksCoalesced));
+   PyDict_SetItemString(scheduler_dbg, "numTasksDropped",   PyInt_FromLong(self->scheduler_dbg.numTasksDropped));
+   PyDict_SetItemString(scheduler_dbg, "numTasksDeferred",  PyInt_FromLong(self->scheduler_dbg.numTasksDeferred));
+   PyDict_SetItemString(scheduler_dbg, "numTasksLate",      PyInt_FromLong(self->scheduler_dbg.numTasksLate));
+#ifdef SCHEDULER_STATS
+   // per task priority, then per ISRID_*
+   PyDict_SetItemString(scheduler_dbg, "taskLatency",       OpenMote_histograms(self->scheduler_dbg.taskLatency,TASKPRIO_MAX));
+   PyDict_SetItemString(scheduler_dbg, "taskRuntime",       OpenMote_histograms(self->scheduler_dbg.taskRuntime,TASKPRIO_MAX));
+   PyDict_SetItemString(scheduler_dbg, "isrDuration",       OpenMote_histograms(self->scheduler_dbg.isrDuration,ISRID_MAX));
+   PyDict_SetItemString(scheduler_dbg, "isrNesting",        OpenMote_histograms(self->scheduler_dbg.isrNesting,ISRID_MAX));
+   PyDict_SetItemString(scheduler_dbg, "isrNestingMax",     PyInt_FromLong(self->scheduler_dbg.isrNestingMax));
+   PyDict_SetItemString(scheduler_dbg, "ticksAsleep",       PyInt_FromLong(self->scheduler_dbg.ticksAsleep));
+   PyDict_SetItemString(scheduler_dbg, "ticksAwake",        PyInt_FromLong(self->scheduler_dbg.ticksAwake));
+#endif
    PyDict_SetItemString(returnVal, "scheduler_dbg", scheduler_dbg);
    
+#ifdef ABSTIMER
+   // abstimer_dbg
+   abstimer_dbg = PyDict_New();
+   PyDict_SetItemString(abstimer_dbg, "num_bsp_timer",           PyInt_FromLong(self->abstimer_dbg.num_bsp_timer));
+   PyDict_SetItemString(abstimer_dbg, "num_radiotimer_overflow", PyInt_FromLong(self->abstimer_dbg.num_radiotimer_overflow));
+   PyDict_SetItemString(abstimer_dbg, "num_radiotimer_compare",  PyInt_FromLong(self->abstimer_dbg.num_radiotimer_compare));
+   PyDict_SetItemString(abstimer_dbg, "num_late_schedule",       PyInt_FromLong(self->abstimer_dbg.num_late_schedule));
+   PyDict_SetItemString(abstimer_dbg, "nested_isr",              PyInt_FromLong(self->abstimer_dbg.nested_isr));
+   PyDict_SetItemString(abstimer_dbg, "consecutive_late",        PyInt_FromLong(self->abstimer_dbg.consecutive_late));
+   PyDict_SetItemString(abstimer_dbg, "count_late",              PyInt_FromLong(self->abstimer_dbg.count_late));
+   PyDict_SetItemString(returnVal, "abstimer_dbg", abstimer_dbg);
+#endif
+   
    return returnVal;
 }
 
+/**
+\brief Modules whose state changed since a generation.
+
+\returns (generation, {name: buffer}), the buffers being read-only views over
+   the mote's memory, not copies. Pass generation to the next call.
+*/
+static PyObject* OpenMote_getStateDelta(OpenMote* self, PyObject* args) {
+   unsigned int   since;
+   PyObject*      modules;
+   PyObject*      view;
+   uint8_t        i;
+   
+   // parse arguments
+   since = 0;
+   if (!PyArg_ParseTuple(args, "|I:getStateDelta", &since)) {
+      return NULL;
+   }
+   
+   modules = PyDict_New();
+   if (modules==NULL) {
+      return NULL;
+   }
+   for (i=0;i<sizeof(stateModules)/sizeof(stateModules[0]);i++) {
+      // generation 0 means never written, 'since' 0 asks for all modules
+      if (since!=0 && self->stateGeneration[stateModules[i].status]<=since) {
+         continue;
+      }
+      view = PyBuffer_FromObject(
+         (PyObject*)self,
+         stateModules[i].offset,
+         stateModules[i].size
+      );
+      if (view==NULL || PyDict_SetItemString(modules,stateModules[i].name,view)<0) {
+         Py_XDECREF(view);
+         Py_DECREF(modules);
+         return NULL;
+      }
+      Py_DECREF(view);
+   }
+   
+   return Py_BuildValue("(IN)", self->stateClock, modules);
+}
+
+#ifndef ABSTIMER
 static PyObject* OpenMote_bsp_timer_isr(OpenMote* self) {
    
    // no arguments
@@ -208,6 +427,7 @@ static PyObject* OpenMote_bsp_timer_isr(OpenMote* self) {
    // return successfully
    Py_RETURN_NONE;
 }
+#endif
 
 static PyObject* OpenMote_radio_isr_startFrame(OpenMote* self, PyObject* args) {
    int capturedTime;
@@ -255,6 +475,7 @@ static PyObject* OpenMote_radio_isr_endFrame(OpenMote* self, PyObject* args) {
    Py_RETURN_NONE;
 }
 
+#ifndef ABSTIMER
 static PyObject* OpenMote_radiotimer_isr_compare(OpenMote* self) {
    
    // no arguments
@@ -276,6 +497,7 @@ static PyObject* OpenMote_radiotimer_isr_overflow(OpenMote* self) {
    // return successfully
    Py_RETURN_NONE;
 }
+#endif
 
 static PyObject* OpenMote_uart_isr_tx(OpenMote* self) {
    
@@ -331,12 +553,24 @@ static PyMethodDef OpenMote_methods[] = {
    //=== admin
    {  "set_callback",             (PyCFunction)OpenMote_set_callback,               METH_VARARGS,  ""},
    {  "getState",                 (PyCFunction)OpenMote_getState,                   METH_NOARGS,   ""},
+   {  "getStateDelta",            (PyCFunction)OpenMote_getStateDelta,              METH_VARARGS,  "getStateDelta([since]), (generation, {module: buffer}) of the modules changed since"},
+   {  "set_notifRing",            (PyCFunction)OpenMote_set_notifRing,              METH_VARARGS,  ""},
+   {  "set_clock",                (PyCFunction)OpenMote_set_clock,                  METH_VARARGS,  ""},
+   {  "getNotifStats",            (PyCFunction)OpenMote_getNotifStats,              METH_NOARGS,   ""},
+   {  "serialRing",               (PyCFunction)OpenMote_serialRing,                 METH_NOARGS,   "switch the serial port to a ring shared with the host, returns a memoryview over it"},
+   {  "snapshot",                 (PyCFunction)OpenMote_snapshot,                   METH_NOARGS,   "serialize the state of the mote"},
+   {  "restore",                  (PyCFunction)OpenMote_restore,                    METH_VARARGS,  "restore(snapshot), the mote resumes from its scheduler loop"},
    //=== BSP
+#ifndef ABSTIMER
+   // with abstimer=1, the timers are only emulated by the native engine
    {  "bsp_timer_isr",            (PyCFunction)OpenMote_bsp_timer_isr,              METH_NOARGS,   ""},
+#endif
    {  "radio_isr_startFrame",     (PyCFunction)OpenMote_radio_isr_startFrame,       METH_VARARGS,  ""},
    {  "radio_isr_endFrame",       (PyCFunction)OpenMote_radio_isr_endFrame,         METH_VARARGS,  ""},
+#ifndef ABSTIMER
    {  "radiotimer_isr_compare",   (PyCFunction)OpenMote_radiotimer_isr_compare,     METH_NOARGS,   ""},
    {  "radiotimer_isr_overflow",  (PyCFunction)OpenMote_radiotimer_isr_overflow,    METH_NOARGS,   ""},
+#endif
    {  "uart_isr_tx",              (PyCFunction)OpenMote_uart_isr_tx,                METH_NOARGS,   ""},
    {  "uart_isr_rx",              (PyCFunction)OpenMote_uart_isr_rx,                METH_NOARGS,   ""},
    {  "supply_on",                (PyCFunction)OpenMote_supply_on,                  METH_NOARGS,   ""},
@@ -344,6 +578,38 @@ static PyMethodDef OpenMote_methods[] = {
    {NULL} // sentinel
 };
 
+/*
+\brief Buffers of an OpenMote.
+
+The old-style buffer is a read-only view over the memory of the mote, see
+getStateDelta(). The new-style buffer is the serial port shared with the
+host, see serialRing().
+*/
+static Py_ssize_t OpenMote_getreadbuffer(OpenMote* self, Py_ssize_t segment, void** ptr) {
+   if (segment!=0) {
+      PyErr_SetString(PyExc_SystemError, "accessing non-existent OpenMote segment");
+      return -1;
+   }
+   *ptr = (void*)self;
+   return sizeof(OpenMote);
+}
+
+static Py_ssize_t OpenMote_getsegcount(OpenMote* self, Py_ssize_t* lenp) {
+   if (lenp!=NULL) {
+      *lenp = sizeof(OpenMote);
+   }
+   return 1;
+}
+
+static PyBufferProcs OpenMote_as_buffer = {
+   (readbufferproc)OpenMote_getreadbuffer,   // bf_getreadbuffer
+   0,                                  // bf_getwritebuffer
+   (segcountproc)OpenMote_getsegcount, // bf_getsegcount
+   0,                                  // bf_getcharbuffer
+   (getbufferproc)serialring_getBuffer,// bf_getbuffer
+   0,                                  // bf_releasebuffer
+};
+
 /*
 \brief List of members of the OpenMote class.
 */
@@ -377,8 +643,8 @@ static PyTypeObject openwsn_OpenMoteType = {
    0,                                  // tp_str
    0,                                  // tp_getattro
    0,                                  // tp_setattro
-   0,                                  // tp_as_buffer
-   Py_TPFLAGS_DEFAULT,                 // tp_flags
+   &OpenMote_as_buffer,                // tp_as_buffer
+   Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER, // tp_flags
    "Emulated OpenWSN mote",            // tp_doc
    0,                                  // tp_traverse
    0,                                  // tp_clear
@@ -399,6 +665,396 @@ static PyTypeObject openwsn_OpenMoteType = {
    0,                                  // tp_new (populated at module initialization)
 };
 
+//=========================== SimEngine Class =================================
+
+//===== members
+
+//===== methods
+
+static int SimEngine_init(SimEngine* self, PyObject* args, PyObject* kwds) {
+   unsigned int seed;
+   int          numThreads;
+   
+   // parse arguments
+   seed       = 0;
+   numThreads = 1;
+   if (!PyArg_ParseTuple(args, "|Ii:SimEngine", &seed, &numThreads)) {
+      return -1;
+   }
+   if (numThreads<1 || numThreads>SIMENGINE_MAX_THREADS) {
+      PyErr_SetString(PyExc_ValueError, "wrong number of threads");
+      return -1;
+   }
+   
+   if (simengine_init(self,seed,(uint16_t)numThreads)<0) {
+      PyErr_NoMemory();
+      return -1;
+   }
+   
+   return 0;
+}
+
+static void SimEngine_dealloc(SimEngine* self) {
+   simengine_free(self);
+   self->ob_type->tp_free((PyObject*)self);
+}
+
+static PyObject* SimEngine_addMote(SimEngine* self, PyObject* args) {
+   PyObject* mote;
+   PyObject* eui64List;
+   PyObject* item;
+   uint8_t   eui64[8];
+   int       id;
+   int       i;
+   
+   // parse arguments
+   eui64List = NULL;
+   if (!PyArg_ParseTuple(args, "O!|O:addMote", &openwsn_OpenMoteType, &mote, &eui64List)) {
+      return NULL;
+   }
+   if (((OpenMote*)mote)->engine!=NULL) {
+      PyErr_SetString(PyExc_ValueError, "mote already attached to an engine");
+      return NULL;
+   }
+   
+   // by default, the EUI64 is derived from the position of the mote
+   id = self->numMotes+1;
+   eui64[0] = 0x14;
+   eui64[1] = 0x15;
+   eui64[2] = 0x92;
+   eui64[3] = 0x00;
+   eui64[4] = 0x00;
+   eui64[5] = 0x00;
+   eui64[6] = (id>>8) & 0xff;
+   eui64[7] = (id>>0) & 0xff;
+   if (eui64List!=NULL) {
+      if (!PySequence_Check(eui64List) || PySequence_Size(eui64List)!=8) {
+         PyErr_SetString(PyExc_TypeError, "eui64 must be a sequence of 8 bytes");
+         return NULL;
+      }
+      for (i=0;i<8;i++) {
+         item     = PySequence_GetItem(eui64List,i);
+         eui64[i] = (uint8_t)PyInt_AsLong(item);
+         Py_XDECREF(item);
+      }
+   }
+   
+   id = simengine_addMote(self,(OpenMote*)mote,eui64);
+   if (id<0) {
+      return PyErr_NoMemory();
+   }
+   
+   return PyInt_FromLong(id);
+}
+
+static PyObject* SimEngine_setLink(SimEngine* self, PyObject* args) {
+   int       src;
+   int       dst;
+   double    pdr;
+   int       rssi;
+   
+   // parse arguments
+   rssi = -70;
+   if (!PyArg_ParseTuple(args, "iid|i:setLink", &src, &dst, &pdr, &rssi)) {
+      return NULL;
+   }
+   
+   if (simengine_setLink(self,src,dst,pdr,rssi)<0) {
+      PyErr_SetString(PyExc_ValueError, "invalid link");
+      return NULL;
+   }
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* SimEngine_setPosition(SimEngine* self, PyObject* args) {
+   int       id;
+   double    x;
+   double    y;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "idd:setPosition", &id, &x, &y)) {
+      return NULL;
+   }
+   if (id<0 || id>=self->numMotes) {
+      PyErr_SetString(PyExc_ValueError, "invalid mote");
+      return NULL;
+   }
+   
+   if (simengine_setPosition(self,id,x,y)<0) {
+      return PyErr_NoMemory();
+   }
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* SimEngine_setPropagation(SimEngine* self, PyObject* args) {
+   double    txPower;
+   double    pathLoss1m;
+   double    exponent;
+   double    sensitivity;
+   
+   // parse arguments
+   txPower     = PROPAGATION_TXPOWER;
+   pathLoss1m  = PROPAGATION_PATHLOSS_1M;
+   exponent    = PROPAGATION_EXPONENT;
+   sensitivity = PROPAGATION_SENSITIVITY;
+   if (!PyArg_ParseTuple(args, "|dddd:setPropagation", &txPower, &pathLoss1m, &exponent, &sensitivity)) {
+      return NULL;
+   }
+   
+   if (simengine_setPropagation(self,txPower,pathLoss1m,exponent,sensitivity)<0) {
+      PyErr_SetString(PyExc_ValueError, "invalid propagation model");
+      return NULL;
+   }
+   
+   return PyFloat_FromDouble(self->propagation.range);
+}
+
+static PyObject* SimEngine_set_serialCallback(SimEngine* self, PyObject* args) {
+   PyObject* tempCallback;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "O:set_serialCallback", &tempCallback)) {
+      return NULL;
+   }
+   
+   // None disables the serial output
+   if (tempCallback==Py_None) {
+      tempCallback = NULL;
+   } else if (!PyCallable_Check(tempCallback)) {
+      PyErr_SetString(PyExc_TypeError, "parameter must be callable");
+      return NULL;
+   }
+   
+   // record the callback
+   Py_XINCREF(tempCallback);
+   Py_XDECREF(self->serialCb);
+   self->serialCb = tempCallback;
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* SimEngine_serialInput(SimEngine* self, PyObject* args) {
+   int       id;
+   char*     buf;
+   int       len;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "is#:serialInput", &id, &buf, &len)) {
+      return NULL;
+   }
+   
+   if (simengine_serialInput(self,id,(uint8_t*)buf,len)<0) {
+      PyErr_SetString(PyExc_ValueError, "invalid mote");
+      return NULL;
+   }
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* SimEngine_startTrace(SimEngine* self, PyObject* args) {
+   char*              path;
+   unsigned PY_LONG_LONG maxBytes;
+   
+   // parse arguments
+   maxBytes = SIMTRACE_DEFAULT_SIZE;
+   if (!PyArg_ParseTuple(args, "s|K:startTrace", &path, &maxBytes)) {
+      return NULL;
+   }
+   
+   if (simtrace_start(self,path,maxBytes)<0) {
+      return NULL;
+   }
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* SimEngine_stopTrace(SimEngine* self) {
+   int64_t   numRecords;
+   
+   numRecords = simtrace_stop(self);
+   if (numRecords<0) {
+      return NULL;
+   }
+   
+   return PyLong_FromLongLong(numRecords);
+}
+
+static PyObject* SimEngine_replay(SimEngine* self, PyObject* args) {
+   int       id;
+   char*     path;
+   int       traceMote;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "isi:replay", &id, &path, &traceMote)) {
+      return NULL;
+   }
+   if (id<0 || id>=self->numMotes || traceMote<0 || traceMote>0xffff) {
+      PyErr_SetString(PyExc_ValueError, "invalid mote");
+      return NULL;
+   }
+   
+   if (simengine_replay(self,id,path,traceMote)<0) {
+      return NULL;
+   }
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* SimEngine_run(SimEngine* self, PyObject* args) {
+   double    duration;
+   
+   // parse arguments
+   if (!PyArg_ParseTuple(args, "d:run", &duration)) {
+      return NULL;
+   }
+   if (duration<0) {
+      PyErr_SetString(PyExc_ValueError, "duration must be positive");
+      return NULL;
+   }
+   
+   if (simengine_run(self,(simtime_t)(duration*SIMENGINE_UNITS_PER_SEC))<0) {
+      return NULL;
+   }
+   
+   Py_RETURN_NONE;
+}
+
+static PyObject* SimEngine_getTime(SimEngine* self) {
+   return PyFloat_FromDouble((double)self->now/SIMENGINE_UNITS_PER_SEC);
+}
+
+static PyObject* SimEngine_getStats(SimEngine* self) {
+   unsigned PY_LONG_LONG numLinks;
+   unsigned PY_LONG_LONG numReplayed;
+   unsigned PY_LONG_LONG numReplayMissed;
+   simreplay_t* replay;
+   uint16_t  i;
+   
+   numLinks        = 0;
+   numReplayed     = 0;
+   numReplayMissed = 0;
+   for (i=0;i<self->numMotes;i++) {
+      numLinks += self->motes[i]->sim.numLinks;
+      replay    = self->motes[i]->sim.replay;
+      if (replay!=NULL) {
+         numReplayed     += replay->numReplayed;
+         numReplayMissed += replay->numMissed;
+      }
+   }
+   return Py_BuildValue(
+      "{s:i,s:K,s:i,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K}",
+      "numMotes",       self->numMotes,
+      "numLinks",       numLinks,
+      "numThreads",     self->numWorkers,
+      "numWindows",     (unsigned PY_LONG_LONG)self->numWindows,
+      "traceDigest",    (unsigned PY_LONG_LONG)self->traceDigest,
+      "numEvents",      (unsigned PY_LONG_LONG)self->numEvents,
+      "numResumes",     (unsigned PY_LONG_LONG)self->numResumes,
+      "numFramesTx",    (unsigned PY_LONG_LONG)self->numFramesTx,
+      "numFramesRx",    (unsigned PY_LONG_LONG)self->numFramesRx,
+      "numCollisions",  (unsigned PY_LONG_LONG)self->numCollisions,
+      "numSerialBytes", (unsigned PY_LONG_LONG)self->numSerialBytes,
+      "numTraceBytes",  (unsigned PY_LONG_LONG)((self->trace!=NULL) ? self->trace->used : 0),
+      "numReplayed",    numReplayed,
+      "numReplayMissed",numReplayMissed
+   );
+}
+
+static PyObject* SimEngine_getAsns(SimEngine* self) {
+   PyObject* returnVal;
+   asn_t*    asn;
+   uint16_t  i;
+   
+   returnVal = PyList_New(self->numMotes);
+   if (returnVal==NULL) {
+      return NULL;
+   }
+   for (i=0;i<self->numMotes;i++) {
+      asn = &self->motes[i]->ieee154e_vars.asn;
+      PyList_SET_ITEM(
+         returnVal,
+         i,
+         PyLong_FromUnsignedLongLong(
+            ((unsigned PY_LONG_LONG)asn->byte4<<32)       |
+            ((unsigned PY_LONG_LONG)asn->bytes2and3<<16)  |
+            ((unsigned PY_LONG_LONG)asn->bytes0and1)
+         )
+      );
+   }
+   
+   return returnVal;
+}
+
+//===== admin
+
+/*
+\brief List of methods of the SimEngine class.
+*/
+static PyMethodDef SimEngine_methods[] = {
+   // name                        function                                          flags          doc
+   {  "addMote",                  (PyCFunction)SimEngine_addMote,                   METH_VARARGS,  "attach an OpenMote, returns its index"},
+   {  "setLink",                  (PyCFunction)SimEngine_setLink,                   METH_VARARGS,  "setLink(src,dst,pdr[,rssi])"},
+   {  "setPosition",              (PyCFunction)SimEngine_setPosition,               METH_VARARGS,  "setPosition(moteIndex,x,y), in m"},
+   {  "setPropagation",           (PyCFunction)SimEngine_setPropagation,            METH_VARARGS,  "setPropagation([txPower,pathLoss1m,exponent,sensitivity]), returns the range in m"},
+   {  "set_serialCallback",       (PyCFunction)SimEngine_set_serialCallback,        METH_VARARGS,  "callback(moteIndex,bytes) for serial output"},
+   {  "serialInput",              (PyCFunction)SimEngine_serialInput,               METH_VARARGS,  "serialInput(moteIndex,bytes)"},
+   {  "startTrace",               (PyCFunction)SimEngine_startTrace,                METH_VARARGS,  "startTrace(path[,maxBytes]), record the events of the motes"},
+   {  "stopTrace",                (PyCFunction)SimEngine_stopTrace,                 METH_NOARGS,   "stop recording, returns the number of records"},
+   {  "replay",                   (PyCFunction)SimEngine_replay,                    METH_VARARGS,  "replay(moteIndex,path,traceMote), feed a mote with the inputs of a recorded one"},
+   {  "run",                      (PyCFunction)SimEngine_run,                       METH_VARARGS,  "run(seconds)"},
+   {  "getTime",                  (PyCFunction)SimEngine_getTime,                   METH_NOARGS,   "simulated time, in seconds"},
+   {  "getStats",                 (PyCFunction)SimEngine_getStats,                  METH_NOARGS,   ""},
+   {  "getAsns",                  (PyCFunction)SimEngine_getAsns,                   METH_NOARGS,   "current ASN of each mote"},
+   {NULL} // sentinel
+};
+
+/*
+\brief Declaration of the SimEngine type.
+*/
+static PyTypeObject openwsn_SimEngineType = {
+   PyObject_HEAD_INIT(NULL)
+   0,                                  // ob_size
+   "REPLACE_BY_PROJ_NAME.SimEngine",   // tp_name
+   sizeof(SimEngine),                  // tp_basicsize
+   0,                                  // tp_itemsize
+   (destructor)SimEngine_dealloc,      // tp_dealloc
+   0,                                  // tp_print
+   0,                                  // tp_getattr
+   0,                                  // tp_setattr
+   0,                                  // tp_compare
+   0,                                  // tp_repr
+   0,                                  // tp_as_number
+   0,                                  // tp_as_sequence
+   0,                                  // tp_as_mapping
+   0,                                  // tp_hash
+   0,                                  // tp_call
+   0,                                  // tp_str
+   0,                                  // tp_getattro
+   0,                                  // tp_setattro
+   0,                                  // tp_as_buffer
+   Py_TPFLAGS_DEFAULT,                 // tp_flags
+   "Native engine simulating OpenMotes", // tp_doc
+   0,                                  // tp_traverse
+   0,                                  // tp_clear
+   0,                                  // tp_richcompare
+   0,                                  // tp_weaklistoffset
+   0,                                  // tp_iter
+   0,                                  // tp_iternext
+   SimEngine_methods,                  // tp_methods
+   0,                                  // tp_member
+   0,                                  // tp_getset
+   0,                                  // tp_base
+   0,                                  // tp_dict
+   0,                                  // tp_descr_get
+   0,                                  // tp_descr_set
+   0,                                  // tp_dictoffset
+   (initproc)SimEngine_init,           // tp_init
+   0,                                  // tp_alloc
+   0,                                  // tp_new (populated at module initialization)
+};
+
 //=========================== openwsn module ==================================
 
 //===== members
@@ -424,11 +1080,17 @@ PyMODINIT_FUNC initREPLACE_BY_PROJ_NAME(void) {
       return;
    }
    
+   // populate "new" method for SimEngine object
+   openwsn_SimEngineType.tp_new = PyType_GenericNew;
+   if (PyType_Ready(&openwsn_SimEngineType) < 0) {
+      return;
+   }
+   
    // initialize the openwsn module
    openwsn_module = Py_InitModule3(
       "REPLACE_BY_PROJ_NAME",
       openwsn_methods,
-      "Module which declares the OpenMote class."
+      "Module which declares the OpenMote and SimEngine classes."
    );
    
    // create OpenMote class
@@ -438,4 +1100,12 @@ PyMODINIT_FUNC initREPLACE_BY_PROJ_NAME(void) {
       "OpenMote",
       (PyObject*)&openwsn_OpenMoteType
    );
+   
+   // create SimEngine class
+   Py_INCREF(&openwsn_SimEngineType);
+   PyModule_AddObject(
+      openwsn_module,
+      "SimEngine",
+      (PyObject*)&openwsn_SimEngineType
+   );
 }
@@ -42,6 +42,14 @@
 //#include "tohlone_obj.h"
 #include "uecho_obj.h"
 #include "fragtest_obj.h"
+// native simulation engine
+#include "simengine_obj.h"
+// batched notifications to Python
+#include "notifring_obj.h"
+// checkpointing
+#include "snapshot_obj.h"
+// serial port shared with the host
+#include "serialring_obj.h"
 
 //=========================== prototypes ======================================
 
@@ -53,6 +61,9 @@ void radio_intr_endOfFrame(OpenMote* self, uint16_t capturedTime);
 void radiotimer_intr_compare(OpenMote* self);
 void radiotimer_intr_overflow(OpenMote* self);
 
+// sctimer
+kick_scheduler_t sctimer_isr(OpenMote* self);
+
 // uart
 void uart_intr_tx(OpenMote* self);
 void uart_intr_rx(OpenMote* self);
@@ -199,6 +210,17 @@ typedef struct {
    radiotimer_compare_cbt    compare_cb;
 } radiotimer_icb_t;
 
+typedef kick_scheduler_t (*sctimer_cbt)(OpenMote* self);
+
+typedef struct {
+   sctimer_cbt               cb;
+} sctimer_icb_t;
+
+// stores the callbacks above
+#ifdef ABSTIMER
+#include "abstimer_obj.h"
+#endif
+
 //=========================== struct ==========================================
 
 /**
@@ -213,6 +235,20 @@ struct OpenMote {
    bsp_timer_icb_t      bsp_timer_icb;
    radio_icb_t          radio_icb;
    radiotimer_icb_t     radiotimer_icb;
+   sctimer_icb_t        sctimer_icb;
+   //===== native simulation engine
+   SimEngine*           engine;              ///< NULL when the BSP is in Python
+   simmote_t            sim;
+   //===== batched notifications to Python
+   notifring_t          notifring;
+   notifcache_t         notifcache;
+   //===== serial port shared with the host
+   serialring_t         serialring;
+   //===== checkpointing
+   bool                 restored;            ///< boot into the scheduler loop, see snapshot_main()
+   //===== state generations, see OpenMote.getStateDelta()
+   uint32_t             stateClock;          ///< bumped on each write to a module
+   uint32_t             stateGeneration[STATUS_MAX]; ///< stateClock at the last write to each module
    //===== openstack
    // l4
    icmpv6echo_vars_t    icmpv6echo_vars;
@@ -243,6 +279,11 @@ struct OpenMote {
    // kernel
    scheduler_vars_t     scheduler_vars;
    scheduler_dbg_t      scheduler_dbg;
+#ifdef ABSTIMER
+   // bsp
+   abstimer_vars_t      abstimer_vars;
+   abstimer_dbg_t       abstimer_dbg;
+#endif
    //===== openapps
    c6t_vars_t           c6t_vars;
    cexample_vars_t      cexample_vars;
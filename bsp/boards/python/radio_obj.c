@@ -77,6 +77,16 @@ void radio_init(OpenMote* self) {
    printf("C@0x%x: radio_init()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_init,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_init],NULL);
    if (result == NULL) {
@@ -99,6 +109,17 @@ void radio_reset(OpenMote* self) {
    printf("C@0x%x: radio_reset()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_reset(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_reset,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_reset],NULL);
    if (result == NULL) {
@@ -122,6 +143,21 @@ void radio_startTimer(OpenMote* self, PORT_TIMER_WIDTH period) {
    printf("C@0x%x: radio_startTimer(period=%d)... \n",self,period);
 #endif
    
+   // native simulation engine, through the radiotimer, which abstimer=1 virtualizes
+   if (self->engine!=NULL) {
+      radiotimer_start(self,period);
+      return;
+   }
+   
+   // anchor the cached counter
+   self->notifcache.rt_running = notifcache_getTicks(self,&self->notifcache.rt_start);
+   self->notifcache.rt_period  = period;
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_startTimer,(uint8_t*)&period,sizeof(period))==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",period);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_startTimer],arglist);
@@ -140,11 +176,30 @@ void radio_startTimer(OpenMote* self, PORT_TIMER_WIDTH period) {
 PORT_TIMER_WIDTH radio_getTimerValue(OpenMote* self) {
    PyObject*            result;
    PORT_TIMER_WIDTH     returnVal;
+   uint64_t             now;
    
 #ifdef TRACE_ON
    printf("C@0x%x: radio_getTimerValue()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return radiotimer_getValue(self);
+   }
+   
+   // served from the cache
+   if (
+         self->notifcache.rt_running==TRUE   &&
+         self->notifcache.rt_period>0        &&
+         notifcache_getTicks(self,&now)==TRUE
+      ) {
+      self->notifcache.numHits++;
+      return (PORT_TIMER_WIDTH)((now-self->notifcache.rt_start)%self->notifcache.rt_period);
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_getTimerValue],NULL);
    if (result == NULL) {
@@ -175,6 +230,19 @@ void radio_setTimerPeriod(OpenMote* self, PORT_TIMER_WIDTH period) {
    printf("C@0x%x: radio_setTimerPeriod(period=%d)... \n",self,period);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      radiotimer_setPeriod(self,period);
+      return;
+   }
+   
+   self->notifcache.rt_period  = period;
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_setTimerPeriod,(uint8_t*)&period,sizeof(period))==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",period);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_setTimerPeriod],arglist);
@@ -198,6 +266,20 @@ PORT_TIMER_WIDTH radio_getTimerPeriod(OpenMote* self) {
    printf("C@0x%x: radio_getTimerPeriod()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return radiotimer_getPeriod(self);
+   }
+   
+   // served from the cache
+   if (self->notifcache.rt_running==TRUE) {
+      self->notifcache.numHits++;
+      return self->notifcache.rt_period;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_getTimerPeriod],NULL);
    if (result == NULL) {
@@ -230,6 +312,17 @@ void radio_setFrequency(OpenMote* self, uint8_t frequency) {
    printf("C@0x%x: radio_setFrequency(frequency=%d)... \n",self,frequency);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_setFrequency(self,frequency);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_setFrequency,&frequency,sizeof(frequency))==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",frequency);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_setFrequency],arglist);
@@ -252,6 +345,17 @@ void radio_rfOn(OpenMote* self) {
    printf("C@0x%x: radio_rfOn()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_rfOn(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_rfOn,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rfOn],NULL);
    if (result == NULL) {
@@ -272,6 +376,17 @@ void radio_rfOff(OpenMote* self) {
    printf("C@0x%x: radio_rfOff()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_rfOff(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_rfOff,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rfOff],NULL);
    if (result == NULL) {
@@ -299,6 +414,17 @@ void radio_loadPacket(OpenMote* self, uint8_t* packet, uint8_t len) {
    printf("C@0x%x: radio_loadPacket(len=%d)... \n",self,len);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_loadPacket(self,packet,len);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_loadPacket,packet,len)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    pkt        = PyList_New(len);
    for (i=0;i<len;i++) {
@@ -327,6 +453,17 @@ void radio_txEnable(OpenMote* self) {
    printf("C@0x%x: radio_txEnable()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_txEnable(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_txEnable,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_txEnable],NULL);
    if (result == NULL) {
@@ -347,6 +484,17 @@ void radio_txNow(OpenMote* self) {
    printf("C@0x%x: radio_txNow()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_txNow(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_txNow,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_txNow],NULL);
    if (result == NULL) {
@@ -369,6 +517,17 @@ void radio_rxEnable(OpenMote* self) {
    printf("C@0x%x: radio_rxEnable()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_rxEnable(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_rxEnable,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rxEnable],NULL);
    if (result == NULL) {
@@ -389,6 +548,17 @@ void radio_rxNow(OpenMote* self) {
    printf("C@0x%x: radio_rxNow()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_rxNow(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radio_rxNow,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_rxNow],NULL);
    if (result == NULL) {
@@ -419,6 +589,15 @@ void radio_getReceivedFrame(OpenMote* self,
    printf("C@0x%x: radio_getReceivedFrame()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radio_getReceivedFrame(self,pBufRead,pLenRead,maxBufLen,pRssi,pLqi,pCrc);
+      return;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radio_getReceivedFrame],NULL);
    if (result == NULL) {
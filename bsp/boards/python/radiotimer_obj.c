@@ -49,6 +49,16 @@ void radiotimer_init(OpenMote* self) {
    printf("C@0x%x: radiotimer_init()... \n",self,self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radiotimer_init,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_init],NULL);
    if (result == NULL) {
@@ -69,6 +79,21 @@ void radiotimer_start(OpenMote* self, PORT_RADIOTIMER_WIDTH period) {
    printf("C@0x%x: radiotimer_start(period=%d)... \n",self,period);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radiotimer_start(self,period);
+      return;
+   }
+   
+   // anchor the cached counter
+   self->notifcache.rt_running = notifcache_getTicks(self,&self->notifcache.rt_start);
+   self->notifcache.rt_period  = period;
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radiotimer_start,(uint8_t*)&period,sizeof(period))==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_start],NULL);
    if (result == NULL) {
@@ -87,11 +112,30 @@ void radiotimer_start(OpenMote* self, PORT_RADIOTIMER_WIDTH period) {
 PORT_RADIOTIMER_WIDTH radiotimer_getValue(OpenMote* self) {
    PyObject*  result;
    PORT_RADIOTIMER_WIDTH   returnVal;
+   uint64_t   now;
    
 #ifdef TRACE_ON
    printf("C@0x%x: radiotimer_getValue()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return simengine_radiotimer_getValue(self);
+   }
+   
+   // served from the cache
+   if (
+         self->notifcache.rt_running==TRUE   &&
+         self->notifcache.rt_period>0        &&
+         notifcache_getTicks(self,&now)==TRUE
+      ) {
+      self->notifcache.numHits++;
+      return (PORT_RADIOTIMER_WIDTH)((now-self->notifcache.rt_start)%self->notifcache.rt_period);
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_getValue],NULL);
    if (result == NULL) {
@@ -122,6 +166,19 @@ void radiotimer_setPeriod(OpenMote* self, PORT_RADIOTIMER_WIDTH period) {
    printf("C@0x%x: radiotimer_setPeriod(period=%d)... \n",self,period);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radiotimer_setPeriod(self,period);
+      return;
+   }
+   
+   self->notifcache.rt_period  = period;
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radiotimer_setPeriod,(uint8_t*)&period,sizeof(period))==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",period);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_setPeriod],arglist);
@@ -145,6 +202,20 @@ PORT_RADIOTIMER_WIDTH radiotimer_getPeriod(OpenMote* self) {
    printf("C@0x%x: radiotimer_getPeriod()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return simengine_radiotimer_getPeriod(self);
+   }
+   
+   // served from the cache
+   if (self->notifcache.rt_running==TRUE) {
+      self->notifcache.numHits++;
+      return self->notifcache.rt_period;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_getPeriod],NULL);
    if (result == NULL) {
@@ -177,6 +248,17 @@ void radiotimer_schedule(OpenMote* self, PORT_RADIOTIMER_WIDTH offset) {
    printf("C@0x%x: radiotimer_schedule(offset=%d)... \n",self,offset);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radiotimer_schedule(self,offset);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radiotimer_schedule,(uint8_t*)&offset,sizeof(offset))==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",offset);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_schedule],arglist);
@@ -199,6 +281,17 @@ void radiotimer_cancel(OpenMote* self) {
    printf("C@0x%x: radiotimer_cancel()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_radiotimer_cancel(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_radiotimer_cancel,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_cancel],NULL);
    if (result == NULL) {
@@ -222,6 +315,14 @@ PORT_RADIOTIMER_WIDTH radiotimer_getCapturedTime(OpenMote* self) {
    printf("C@0x%x: radiotimer_getCapturedTime()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return simengine_radiotimer_getCapturedTime(self);
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_radiotimer_getCapturedTime],NULL);
    if (result == NULL) {
@@ -265,6 +366,11 @@ void radiotimer_intr_overflow(OpenMote* self) {
    printf("C@0x%x: radiotimer_intr_overflow(), calling 0x%x... \n",self,self->radiotimer_icb.overflow_cb);
 #endif
    
+   // the cached counter wraps
+   if (self->notifcache.rt_running==TRUE) {
+      self->notifcache.rt_start += self->notifcache.rt_period;
+   }
+   
    self->radiotimer_icb.overflow_cb(self);
    
 #ifdef TRACE_ON
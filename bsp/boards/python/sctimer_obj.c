@@ -0,0 +1,96 @@
+/**
+\brief Python-specific definition of the "sctimer" bsp module.
+
+Only emulated by the native simulation engine, which has the sctimer share
+the counter and compare channel of the bsp_timer; build with abstimer=1 to
+have the "abstimer" serve the bsp_timer and radiotimer from it.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, May 2013.
+*/
+
+#include <stdio.h>
+#include "sctimer_obj.h"
+
+//=========================== defines =========================================
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+//=========================== callbacks =======================================
+
+void sctimer_setCb(OpenMote* self, sctimer_cbt cb) {
+   self->sctimer_icb.cb     = cb;
+}
+
+//=========================== public ==========================================
+
+void sctimer_init(OpenMote* self) {
+
+#ifdef TRACE_ON
+   printf("C@0x%x: sctimer_init()... \n",self);
+#endif
+
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_bsp_timer_reset(self);
+      return;
+   }
+
+   printf("[CRITICAL] sctimer_init() requires the native simulation engine\r\n");
+}
+
+void sctimer_stop(OpenMote* self) {
+
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_bsp_timer_cancel_schedule(self);
+   }
+}
+
+void sctimer_schedule(OpenMote* self, PORT_TIMER_WIDTH val) {
+
+#ifdef TRACE_ON
+   printf("C@0x%x: sctimer_schedule(val=%d)... \n",self,val);
+#endif
+
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_sctimer_schedule(self,val);
+   }
+}
+
+PORT_TIMER_WIDTH sctimer_getValue(OpenMote* self) {
+
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return simengine_bsp_timer_get_currentValue(self);
+   }
+
+   return 0;
+}
+
+void sctimer_clearISR(OpenMote* self) {
+   // nothing to clear
+}
+
+void sctimer_reset(OpenMote* self) {
+
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_bsp_timer_reset(self);
+   }
+}
+
+//=========================== private =========================================
+
+//=========================== interrupt handlers ==============================
+
+kick_scheduler_t sctimer_isr(OpenMote* self) {
+
+#ifdef TRACE_ON
+   printf("C@0x%x: sctimer_isr()...\n",self);
+#endif
+
+   return self->sctimer_icb.cb(self);
+}
@@ -0,0 +1,190 @@
+/**
+\brief Serial port of the mote shared with the host as a ring buffer.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "openwsnmodule_obj.h"
+#include <string.h>
+#include "serialring_obj.h"
+
+//=========================== defines =========================================
+
+#define SERIALRING_HDLC_FLAG         0x7e
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+static void serialring_post(serialring_t* ring, uint8_t* frame, uint16_t len);
+static bool serialring_reserve(serialring_shared_t* shared, uint32_t recLen, uint32_t* pos);
+
+//=========================== public ==========================================
+
+/**
+\brief Switch the serial port of the mote to the shared ring.
+
+\returns a writable memoryview over the shared part of the ring, which keeps
+   the mote alive, NULL (with a Python exception set) on failure.
+*/
+PyObject* serialring_attach(OpenMote* self) {
+   PyObject*   mv;
+
+   mv         = PyMemoryView_FromObject((PyObject*)self);
+   if (mv==NULL) {
+      return NULL;
+   }
+
+   self->serialring.attached = TRUE;
+   return mv;
+}
+
+/**
+\brief New-style buffer interface of the OpenMote type.
+
+Memoryviews re-acquire it when sliced.
+*/
+int serialring_getBuffer(OpenMote* self, Py_buffer* view, int flags) {
+   return PyBuffer_FillInfo(
+      view,
+      (PyObject*)self,
+      &self->serialring.shared,
+      sizeof(serialring_shared_t),
+      0,
+      flags
+   );
+}
+
+//===== mote->host
+
+/**
+\brief Append the bytes written to the serial port, one record per HDLC frame.
+
+The bytes are whole frames, as openserial only starts sending after closing
+the frames in its output buffer.
+*/
+void serialring_write(OpenMote* self, uint8_t* buffer, uint16_t len) {
+   uint16_t start;
+   uint16_t i;
+
+   start = 0;
+   for (i=0;i<len;i++) {
+      // a frame ends at the first flag after its opening one
+      if (buffer[i]==SERIALRING_HDLC_FLAG && i>start) {
+         serialring_post(&self->serialring,&buffer[start],i+1-start);
+         start = i+1;
+      }
+   }
+   if (start<len) {
+      serialring_post(&self->serialring,&buffer[start],len-start);
+   }
+}
+
+//===== host->mote
+
+bool serialring_rxPending(OpenMote* self) {
+   return self->serialring.attached==TRUE &&
+          self->serialring.shared.rxTail!=self->serialring.shared.rxHead;
+}
+
+/**
+\brief Read the next byte written by the host.
+
+\returns FALSE if the host has not written anything.
+*/
+bool serialring_rxByte(OpenMote* self, uint8_t* byte) {
+   serialring_shared_t* shared;
+   uint32_t             tail;
+
+   shared = &self->serialring.shared;
+   tail   = shared->rxTail;
+   if (tail==shared->rxHead || tail>=SERIALRING_RX_SIZE) {
+      return FALSE;
+   }
+   // read the byte after its index
+   __sync_synchronize();
+   *byte          = shared->rx[tail];
+   shared->rxTail = (tail+1)%SERIALRING_RX_SIZE;
+   self->serialring.numRxBytes++;
+   return TRUE;
+}
+
+/**
+\brief Feed the bytes written by the host to the mote, Python board only.
+
+Each byte raises the "RX" interrupt, until the ring is empty or the mote
+closes its serial port; uart_readByte() returns it without calling Python.
+*/
+void serialring_feed(OpenMote* self) {
+   serialring_t* ring;
+
+   ring = &self->serialring;
+
+   ring->feeding = TRUE;
+   while (ring->rxEnabled==TRUE && serialring_rxByte(self,&ring->rxByte)==TRUE) {
+      self->uart_icb.rxCb(self);
+   }
+   ring->feeding = FALSE;
+}
+
+//=========================== private =========================================
+
+static void serialring_post(serialring_t* ring, uint8_t* frame, uint16_t len) {
+   serialring_shared_t* shared;
+   uint32_t             recLen;
+   uint32_t             pos;
+
+   shared = &ring->shared;
+   recLen = (SERIALRING_HEADER_LEN+len+1)&~1;
+
+   if (serialring_reserve(shared,recLen,&pos)==FALSE) {
+      shared->numDropped++;
+      return;
+   }
+   memcpy(&shared->tx[pos],&len,SERIALRING_HEADER_LEN);
+   memcpy(&shared->tx[pos+SERIALRING_HEADER_LEN],frame,len);
+
+   // publish the record after writing it
+   __sync_synchronize();
+   shared->txHead = pos+recLen;
+   ring->numFrames++;
+}
+
+/**
+\brief Find room for a record of recLen bytes.
+
+Same as notifring_reserve(): records never straddle the end of the ring; when
+the end is reached, txHead wraps around and txEnd remembers where the records
+stop.
+*/
+static bool serialring_reserve(serialring_shared_t* shared, uint32_t recLen, uint32_t* pos) {
+   uint32_t head;
+   uint32_t tail;
+
+   head = shared->txHead;
+   tail = shared->txTail;
+
+   if (head>=tail) {
+      // free space after head
+      if (head+recLen<=SERIALRING_TX_SIZE) {
+         *pos = head;
+         return TRUE;
+      }
+      // free space at the start of the ring
+      if (recLen<tail) {
+         shared->txEnd  = head;
+         __sync_synchronize();
+         shared->txHead = 0;
+         *pos = 0;
+         return TRUE;
+      }
+      return FALSE;
+   }
+
+   // head has wrapped, free space up to tail
+   if (head+recLen<tail) {
+      *pos = head;
+      return TRUE;
+   }
+   return FALSE;
+}
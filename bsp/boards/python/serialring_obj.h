@@ -0,0 +1,94 @@
+/**
+\brief Serial port of the mote shared with the host as a ring buffer.
+
+By default, the FASTSIM serial output of the Python board is handed to Python
+as a list of integers per write (or, in the native simulation engine, as a
+string per flush), and each input byte is read through a call into Python.
+Once OpenMote.serialRing() has been called, the serial port of the mote is
+instead a pair of single-producer/single-consumer rings in the mote's memory,
+which the host accesses in place through the writable memoryview that call
+returns.
+
+The memoryview starts with the following native-endian uint32_t indices:
+- txHead: end of the records written by the mote, updated by the mote
+- txEnd:  where the records stop when txHead has wrapped, updated by the mote
+- txTail: next record to be read by the host, updated by the host
+- rxHead: end of the bytes written by the host, updated by the host
+- rxTail: next byte to be read by the mote, updated by the mote
+- numDropped: frames dropped because the mote->host ring was full
+
+followed by the mote->host ring (SERIALRING_TX_SIZE bytes), then by the
+host->mote ring (SERIALRING_RX_SIZE bytes).
+
+Mote->host, each HDLC frame written by the mote is a record made of its
+length (native-endian uint16_t) followed by the frame, flags included, padded
+to an even length. Records never straddle the end of the ring, so the host
+consumes each frame as a slice of the memoryview. One byte is always left
+free so a full ring is not mistaken for an empty one; frames which do not fit
+are dropped and counted, so the host drains the ring at least every
+SERIALRING_TX_SIZE bytes of output (e.g. at board_sleep(), or between
+SimEngine.run() calls). As with the callbacks, the Python BSP raises the "TX
+done" interrupt (OpenMote.uart_isr_tx()) itself.
+
+Host->mote, the host appends raw (HDLC-encoded) bytes to the rx ring, then
+either calls OpenMote.uart_isr_rx() once, which feeds them all to openserial
+while the mote keeps its serial port open, or, in the native simulation
+engine, lets the mote read them the next time it opens its serial port.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __SERIALRING_H
+#define __SERIALRING_H
+
+#include "Python.h"
+
+#include "toolchain_defs.h"
+
+//=========================== define ==========================================
+
+#define SERIALRING_TX_SIZE           8192
+#define SERIALRING_RX_SIZE           1024
+#define SERIALRING_HEADER_LEN        2
+
+//=========================== typedef =========================================
+
+typedef struct OpenMote OpenMote;
+
+/**
+\brief Part of the ring shared with the host, see the layout above.
+*/
+typedef struct {
+   volatile uint32_t         txHead;
+   volatile uint32_t         txEnd;
+   volatile uint32_t         txTail;
+   volatile uint32_t         rxHead;
+   volatile uint32_t         rxTail;
+   volatile uint32_t         numDropped;
+   uint8_t                   tx[SERIALRING_TX_SIZE];
+   uint8_t                   rx[SERIALRING_RX_SIZE];
+} serialring_shared_t;
+
+typedef struct {
+   serialring_shared_t       shared;
+   bool                      attached;       ///< the host called OpenMote.serialRing()
+   bool                      rxEnabled;      ///< the mote keeps its serial port open
+   bool                      feeding;        ///< rxByte holds the byte being read
+   uint8_t                   rxByte;
+   // stats
+   uint32_t                  numFrames;
+   uint32_t                  numRxBytes;
+} serialring_t;
+
+//=========================== prototypes ======================================
+
+PyObject* serialring_attach(OpenMote* self);
+int       serialring_getBuffer(OpenMote* self, Py_buffer* view, int flags);
+// mote->host
+void      serialring_write(OpenMote* self, uint8_t* buffer, uint16_t len);
+// host->mote
+bool      serialring_rxPending(OpenMote* self);
+bool      serialring_rxByte(OpenMote* self, uint8_t* byte);
+void      serialring_feed(OpenMote* self);
+
+#endif
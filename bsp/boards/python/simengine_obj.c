@@ -0,0 +1,1521 @@
+/**
+\brief Native multi-mote simulation engine for the Python board.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "openwsnmodule_obj.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <sched.h>
+#include "simengine_obj.h"
+#include "bsp_timer_obj.h"
+#include "radiotimer_obj.h"
+#include "radio_obj.h"
+#include "uart_obj.h"
+#include "snapshot_obj.h"
+
+//=========================== defines =========================================
+
+/// spins at a barrier before yielding the CPU
+#define SIMENGINE_BARRIER_SPINS      1000
+#define SIMENGINE_FNV_OFFSET         0xcbf29ce484222325ULL
+#define SIMENGINE_FNV_PRIME          0x100000001b3ULL
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+// timeline
+static void     simengine_schedule(OpenMote* mote, uint8_t type, simtime_t time);
+static void     simengine_cancel(OpenMote* mote, uint8_t type);
+static void     simengine_cancelAll(OpenMote* mote);
+static bool     simengine_before(simevent_t* a, simevent_t* b);
+static void     simengine_heapSwap(simworker_t* worker, uint32_t i, uint32_t j);
+static void     simengine_heapUp(simworker_t* worker, uint32_t i);
+static void     simengine_heapDown(simworker_t* worker, uint32_t i);
+static void     simengine_dispatch(simworker_t* worker, simevent_t* ev);
+// threads
+static int      simengine_runParallel(SimEngine* engine, simtime_t until);
+static bool     simengine_nextWindow(SimEngine* engine, simtime_t until);
+static void     simengine_runWindow(simworker_t* worker, simtime_t horizon);
+static void*    simengine_workerMain(void* arg);
+static void     simengine_barrier(SimEngine* engine);
+// execution
+static void     simengine_moteMain(unsigned int hi, unsigned int lo);
+static void     simengine_prepareBoot(OpenMote* mote);
+static void     simengine_makeContext(OpenMote* mote);
+static void     simengine_resume(OpenMote* mote);
+static void     simengine_replayInput(simworker_t* worker, OpenMote* mote);
+static void     simengine_replaySchedule(OpenMote* mote);
+// helpers
+static int      simengine_updateLinks(SimEngine* engine);
+static uint32_t simengine_pdr(double pdr);
+static void     simengine_propagate(SimEngine* engine, OpenMote* src);
+static void     simengine_trace(SimEngine* engine, const void* data, uint32_t len);
+static uint32_t simengine_random(SimEngine* engine);
+static int      simengine_flushPending(SimEngine* engine);
+static int      simengine_flushMote(SimEngine* engine, OpenMote* mote);
+
+//=========================== public ==========================================
+
+//===== admin
+
+/**
+\brief Initialize an engine running its motes on numThreads threads.
+
+\returns 0 on success, -1 if the engine is out of memory.
+*/
+int simengine_init(SimEngine* engine, uint32_t seed, uint16_t numThreads) {
+   uint16_t i;
+
+   engine->now            = 0;
+   engine->motes          = NULL;
+   engine->numMotes       = 0;
+   engine->maxMotes       = 0;
+   if (numThreads<1) {
+      numThreads = 1;
+   }
+   if (numThreads>SIMENGINE_MAX_THREADS) {
+      numThreads = SIMENGINE_MAX_THREADS;
+   }
+   engine->workers        = calloc(numThreads,sizeof(simworker_t));
+   if (engine->workers==NULL) {
+      engine->numWorkers  = 0;
+      return -1;
+   }
+   engine->numWorkers     = numThreads;
+   for (i=0;i<numThreads;i++) {
+      engine->workers[i].engine = engine;
+      engine->workers[i].index  = i;
+   }
+   engine->horizon        = 0;
+   engine->stopping       = FALSE;
+   engine->barrierCount   = 0;
+   engine->barrierSense   = 0;
+   propagation_init(&engine->propagation);
+   engine->linksDirty     = FALSE;
+   engine->randomState    = (seed!=0) ? seed : 0x9e3779b9;
+   engine->traceDigest    = SIMENGINE_FNV_OFFSET;
+   engine->trace          = NULL;
+   engine->serialCb       = NULL;
+   engine->numEvents      = 0;
+   engine->numResumes     = 0;
+   engine->numFramesTx    = 0;
+   engine->numFramesRx    = 0;
+   engine->numCollisions  = 0;
+   engine->numSerialBytes = 0;
+   engine->numWindows     = 0;
+   return 0;
+}
+
+void simengine_free(SimEngine* engine) {
+   OpenMote*    mote;
+   simworker_t* worker;
+   uint16_t     i;
+
+   if (simtrace_stop(engine)<0) {
+      PyErr_Clear();
+   }
+   for (i=0;i<engine->numMotes;i++) {
+      mote = engine->motes[i];
+      simtrace_replayClose(mote->sim.replay);
+      free(mote->sim.stack);
+      free(mote->sim.links);
+      free(mote->sim.serialOut);
+      free(mote->sim.serialIn);
+      memset(&mote->sim,0,sizeof(simmote_t));
+      mote->engine = NULL;
+      Py_DECREF(mote);
+   }
+   free(engine->motes);
+   engine->motes    = NULL;
+   engine->numMotes = 0;
+   for (i=0;i<engine->numWorkers;i++) {
+      worker = &engine->workers[i];
+      free(worker->heap);
+      free(worker->txMotes);
+      free(worker->flushMotes);
+   }
+   free(engine->workers);
+   engine->workers    = NULL;
+   engine->numWorkers = 0;
+   propagation_free(&engine->propagation);
+   Py_CLEAR(engine->serialCb);
+}
+
+/**
+\brief Attach a mote to the engine.
+
+\returns the index of the mote in the engine, -1 if the engine is out of memory.
+*/
+int simengine_addMote(SimEngine* engine, OpenMote* mote, uint8_t* eui64) {
+   OpenMote**   motes;
+   simevent_t** heap;
+   simworker_t* worker;
+   uint16_t     maxMotes;
+   uint8_t      type;
+
+   // grow the mote table
+   if (engine->numMotes==engine->maxMotes) {
+      maxMotes = (engine->maxMotes==0) ? 16 : 2*engine->maxMotes;
+      motes    = realloc(engine->motes,maxMotes*sizeof(OpenMote*));
+      if (motes==NULL) {
+         return -1;
+      }
+      engine->motes    = motes;
+      engine->maxMotes = maxMotes;
+   }
+
+   // motes are dealt to the workers in turn; grow the worker's tables
+   worker = &engine->workers[engine->numMotes%engine->numWorkers];
+   if (worker->numMotes*SIMEVENT_MAX==worker->heapMax) {
+      maxMotes = (worker->heapMax==0) ? 16 : 2*worker->heapMax/SIMEVENT_MAX;
+      heap     = realloc(worker->heap,maxMotes*SIMEVENT_MAX*sizeof(simevent_t*));
+      if (heap==NULL) {
+         return -1;
+      }
+      worker->heap       = heap;
+      motes    = realloc(worker->txMotes,maxMotes*sizeof(OpenMote*));
+      if (motes==NULL) {
+         return -1;
+      }
+      worker->txMotes    = motes;
+      motes    = realloc(worker->flushMotes,maxMotes*sizeof(OpenMote*));
+      if (motes==NULL) {
+         return -1;
+      }
+      worker->flushMotes = motes;
+      worker->heapMax    = maxMotes*SIMEVENT_MAX;
+   }
+
+   memset(&mote->sim,0,sizeof(simmote_t));
+   mote->sim.stack = malloc(SIMENGINE_STACK_SIZE);
+   if (mote->sim.stack==NULL) {
+      return -1;
+   }
+   mote->sim.id     = engine->numMotes;
+   mote->sim.worker = worker;
+   worker->numMotes++;
+   memcpy(mote->sim.eui64,eui64,sizeof(mote->sim.eui64));
+   for (type=0;type<SIMEVENT_MAX;type++) {
+      mote->sim.events[type].mote    = mote;
+      mote->sim.events[type].type    = type;
+      mote->sim.events[type].heapIdx = -1;
+   }
+
+   Py_INCREF(mote);
+   mote->engine = engine;
+   engine->motes[engine->numMotes++] = mote;
+
+   return mote->sim.id;
+}
+
+/**
+\brief Declare a one-way link between two motes.
+
+A pdr of 0 removes the link.
+*/
+int simengine_setLink(SimEngine* engine, uint16_t src, uint16_t dst, double pdr, int8_t rssi) {
+   simmote_t*   sim;
+   simlink_t*   links;
+   uint16_t     i;
+
+   if (src>=engine->numMotes || dst>=engine->numMotes || src==dst) {
+      return -1;
+   }
+   sim = &engine->motes[src]->sim;
+
+   for (i=0;i<sim->numLinks;i++) {
+      if (sim->links[i].dst==dst) {
+         break;
+      }
+   }
+   if (pdr<=0) {
+      // remove the link, if any
+      if (i<sim->numLinks) {
+         sim->links[i] = sim->links[--sim->numLinks];
+      }
+      return 0;
+   }
+   if (i==sim->numLinks) {
+      if (sim->numLinks==sim->maxLinks) {
+         links = realloc(sim->links,(sim->maxLinks+8)*sizeof(simlink_t));
+         if (links==NULL) {
+            return -1;
+         }
+         sim->links     = links;
+         sim->maxLinks += 8;
+      }
+      sim->numLinks++;
+   }
+   sim->links[i].dst  = dst;
+   sim->links[i].rssi = rssi;
+   sim->links[i].pdr  = simengine_pdr(pdr);
+   return 0;
+}
+
+/**
+\brief Place a mote on the plane.
+
+The links of the motes which have a position are derived from the propagation
+model the next time the engine runs, replacing those declared with
+simengine_setLink().
+*/
+int simengine_setPosition(SimEngine* engine, uint16_t id, double x, double y) {
+   if (id>=engine->numMotes) {
+      return -1;
+   }
+   if (propagation_setPosition(&engine->propagation,id,x,y)<0) {
+      return -1;
+   }
+   engine->linksDirty = TRUE;
+   return 0;
+}
+
+int simengine_setPropagation(SimEngine* engine, double txPower, double pathLoss1m, double exponent, double sensitivity) {
+   if (propagation_setModel(&engine->propagation,txPower,pathLoss1m,exponent,sensitivity)<0) {
+      return -1;
+   }
+   engine->linksDirty = TRUE;
+   return 0;
+}
+
+/**
+\brief Queue bytes to be received over the serial port of a mote.
+
+The bytes are fed to the mote the next time it opens its serial port for
+input.
+*/
+int simengine_serialInput(SimEngine* engine, uint16_t id, uint8_t* buf, uint32_t len) {
+   simmote_t*   sim;
+   uint8_t*     serialIn;
+
+   if (id>=engine->numMotes) {
+      return -1;
+   }
+   sim = &engine->motes[id]->sim;
+
+   serialIn = realloc(sim->serialIn,sim->serialInLen+len);
+   if (serialIn==NULL) {
+      return -1;
+   }
+   sim->serialIn = serialIn;
+   memcpy(&sim->serialIn[sim->serialInLen],buf,len);
+   sim->serialInLen += len;
+   return 0;
+}
+
+/**
+\brief Feed a mote with the inputs mote traceMote received in a recorded run.
+
+The mote also takes the EUI64 of the recorded one, so it needs to be booted
+afterwards, at the time the recorded mote booted.
+
+\returns 0 on success, -1 (with a Python exception set) on failure.
+*/
+int simengine_replay(SimEngine* engine, uint16_t id, const char* path, uint16_t traceMote) {
+   simreplay_t* replay;
+   OpenMote*    mote;
+
+   if (id>=engine->numMotes) {
+      PyErr_SetString(PyExc_ValueError, "invalid mote");
+      return -1;
+   }
+   mote   = engine->motes[id];
+   replay = simtrace_replayOpen(path,traceMote,mote->sim.eui64);
+   if (replay==NULL) {
+      return -1;
+   }
+   simtrace_replayClose(mote->sim.replay);
+   mote->sim.replay = replay;
+   simengine_replaySchedule(mote);
+   return 0;
+}
+
+/**
+\brief Advance the simulation by duration.
+
+\returns 0 on success, -1 if a Python callback raised an exception.
+*/
+int simengine_run(SimEngine* engine, simtime_t duration) {
+   simworker_t* worker;
+   simtime_t    until;
+   simevent_t*  ev;
+   int          ret;
+   uint16_t     i;
+
+   if (engine->linksDirty && simengine_updateLinks(engine)<0) {
+      PyErr_NoMemory();
+      return -1;
+   }
+
+   until = engine->now+duration;
+   ret   = 0;
+   if (engine->numWorkers>1) {
+      ret = simengine_runParallel(engine,until);
+   } else {
+      worker = &engine->workers[0];
+      while (worker->heapSize>0 && worker->heap[0]->time<=until) {
+         ev = worker->heap[0];
+         simengine_cancel(ev->mote,ev->type);
+         simengine_dispatch(worker,ev);
+         if (worker->numFlushMotes>0 && simengine_flushPending(engine)<0) {
+            ret = -1;
+            break;
+         }
+      }
+   }
+   if (ret==0) {
+      engine->now = until;
+   }
+
+   // fold the workers' stats into the engine's
+   for (i=0;i<engine->numWorkers;i++) {
+      worker = &engine->workers[i];
+      worker->now             = engine->now;
+      engine->numEvents      += worker->numEvents;
+      engine->numResumes     += worker->numResumes;
+      engine->numFramesTx    += worker->numFramesTx;
+      engine->numFramesRx    += worker->numFramesRx;
+      engine->numSerialBytes += worker->numSerialBytes;
+      worker->numEvents       = 0;
+      worker->numResumes      = 0;
+      worker->numFramesTx     = 0;
+      worker->numFramesRx     = 0;
+      worker->numSerialBytes  = 0;
+   }
+   if (ret<0) {
+      return -1;
+   }
+
+   return simengine_flushSerial(engine);
+}
+
+int simengine_flushSerial(SimEngine* engine) {
+   uint16_t i;
+
+   if (simengine_flushPending(engine)<0) {
+      return -1;
+   }
+   for (i=0;i<engine->numMotes;i++) {
+      if (simengine_flushMote(engine,engine->motes[i])<0) {
+         return -1;
+      }
+   }
+   return 0;
+}
+
+//===== execution
+
+void simengine_moteBoot(OpenMote* self) {
+   self->sim.worker->now  = self->engine->now;
+   self->sim.isOn         = TRUE;
+   self->sim.resetPending = TRUE;
+   simtrace_record(self,self->sim.worker->now,SIMTRACE_BOOT,0,self->sim.eui64,sizeof(self->sim.eui64));
+   simengine_resume(self);
+}
+
+void simengine_moteOff(OpenMote* self) {
+   self->sim.isOn        = FALSE;
+   self->sim.radio_state = SIMRADIO_OFF;
+   simengine_cancelAll(self);
+}
+
+/**
+\brief Called by board_sleep(), hands control back to the engine.
+*/
+void simengine_moteSleep(OpenMote* self) {
+   swapcontext(&self->sim.ctx,&self->sim.worker->ctx);
+}
+
+void simengine_moteReset(OpenMote* self) {
+   self->sim.resetPending = TRUE;
+   if (self->sim.worker->current==self) {
+      // called from a task, abandon the coroutine; it is rebuilt by the engine
+      swapcontext(&self->sim.ctx,&self->sim.worker->ctx);
+   }
+}
+
+/**
+\brief Save the state of the emulated BSP, relative to the current time.
+*/
+void simengine_moteSave(OpenMote* self, simsnapshot_t* snap) {
+   simmote_t* sim;
+   simtime_t  now;
+   uint8_t    type;
+
+   sim = &self->sim;
+   now = sim->worker->now;
+
+   memset(snap,0,sizeof(simsnapshot_t));
+   snap->isOn            = sim->isOn;
+   snap->radio_state     = sim->radio_state;
+   snap->radio_frequency = sim->radio_frequency;
+   snap->leds            = sim->leds;
+   snap->uart_enabled    = sim->uart_enabled;
+   snap->uart_rxByte     = sim->uart_rxByte;
+   snap->rxCrc           = sim->rxCrc;
+   snap->rxRssi          = sim->rxRssi;
+   snap->rt_elapsed      = now-sim->rt_start;
+   snap->rt_period       = sim->rt_period;
+   snap->rt_captured     = sim->rt_captured;
+   snap->bt_elapsed      = now-sim->bt_start;
+   snap->bt_lastCompare  = sim->bt_lastCompare;
+   snap->txLen           = sim->txLen;
+   snap->rxLen           = sim->rxLen;
+   memcpy(snap->txBuf,sim->txBuf,sizeof(snap->txBuf));
+   memcpy(snap->rxBuf,sim->rxBuf,sizeof(snap->rxBuf));
+   // the replay of a trace is not part of the state of the mote
+   for (type=SIMEVENT_REPLAY+1;type<SIMEVENT_MAX;type++) {
+      if (sim->events[type].heapIdx>=0) {
+         snap->eventPending[type] = TRUE;
+         snap->eventIn[type]      = sim->events[type].time-now;
+      }
+   }
+}
+
+/**
+\brief Restore the state of the emulated BSP, relative to the current time.
+
+The mote's coroutine is rebuilt so that, once resumed, the mote enters its
+scheduler loop with the restored stack state.
+*/
+void simengine_moteRestore(OpenMote* self, const simsnapshot_t* snap) {
+   simmote_t* sim;
+   simtime_t  now;
+   uint8_t    type;
+
+   sim = &self->sim;
+   sim->worker->now = self->engine->now;
+   now = sim->worker->now;
+
+   simengine_cancelAll(self);
+   sim->isOn            = snap->isOn;
+   sim->resetPending    = FALSE;
+   sim->radio_state     = snap->radio_state;
+   sim->radio_frequency = snap->radio_frequency;
+   sim->leds            = snap->leds;
+   sim->uart_enabled    = snap->uart_enabled;
+   sim->uart_rxByte     = snap->uart_rxByte;
+   sim->rxCrc           = snap->rxCrc;
+   sim->rxRssi          = snap->rxRssi;
+   // the counters may have started before time 0 of this engine; timer
+   // arithmetic wraps around, so this is harmless
+   sim->rt_start        = now-snap->rt_elapsed;
+   sim->rt_period       = snap->rt_period;
+   sim->rt_captured     = snap->rt_captured;
+   sim->bt_start        = now-snap->bt_elapsed;
+   sim->bt_lastCompare  = snap->bt_lastCompare;
+   sim->txLen           = snap->txLen;
+   sim->rxLen           = snap->rxLen;
+   memcpy(sim->txBuf,snap->txBuf,sizeof(sim->txBuf));
+   memcpy(sim->rxBuf,snap->rxBuf,sizeof(sim->rxBuf));
+   for (type=0;type<SIMEVENT_MAX;type++) {
+      if (snap->eventPending[type]) {
+         simengine_schedule(self,type,now+snap->eventIn[type]);
+      }
+   }
+   if (sim->events[SIMEVENT_RADIO_STARTFRAME].heapIdx>=0 && sim->txPending==FALSE) {
+      sim->txPending = TRUE;
+      sim->worker->txMotes[sim->worker->numTxMotes++] = self;
+   }
+   simengine_replaySchedule(self);
+
+   simengine_makeContext(self);
+}
+
+//===== bsp_timer
+
+void simengine_bsp_timer_reset(OpenMote* self) {
+   self->sim.bt_start       = self->sim.worker->now;
+   self->sim.bt_lastCompare = 0;
+   simengine_cancel(self,SIMEVENT_BSP_TIMER);
+}
+
+void simengine_bsp_timer_scheduleIn(OpenMote* self, PORT_TIMER_WIDTH delayTicks) {
+   simtime_t fireTime;
+
+   // relative to the previous compare value, as the hardware timer does
+   self->sim.bt_lastCompare += delayTicks;
+   fireTime = self->sim.bt_start+self->sim.bt_lastCompare*SIMENGINE_SUBTICKS;
+   if ((int64_t)(fireTime-self->sim.worker->now)<0) {
+      // we're already too late, fire right now
+      fireTime = self->sim.worker->now;
+   }
+   simengine_schedule(self,SIMEVENT_BSP_TIMER,fireTime);
+}
+
+void simengine_bsp_timer_cancel_schedule(OpenMote* self) {
+   simengine_cancel(self,SIMEVENT_BSP_TIMER);
+}
+
+PORT_TIMER_WIDTH simengine_bsp_timer_get_currentValue(OpenMote* self) {
+   return (PORT_TIMER_WIDTH)((self->sim.worker->now-self->sim.bt_start)/SIMENGINE_SUBTICKS);
+}
+
+//===== sctimer
+
+/**
+\brief Fire when the counter of the bsp_timer next matches val.
+
+As the hardware does, a compare value matching the counter right now only
+fires after the counter wraps around.
+*/
+void simengine_sctimer_schedule(OpenMote* self, PORT_TIMER_WIDTH val) {
+   simtime_t ticks;
+   simtime_t delay;
+
+   ticks = (self->sim.worker->now-self->sim.bt_start)/SIMENGINE_SUBTICKS;
+   delay = (PORT_TIMER_WIDTH)(val-(PORT_TIMER_WIDTH)ticks);
+   if (delay==0) {
+      delay = (simtime_t)1<<(8*sizeof(PORT_TIMER_WIDTH));
+   }
+   simengine_schedule(
+      self,
+      SIMEVENT_BSP_TIMER,
+      self->sim.bt_start+(ticks+delay)*SIMENGINE_SUBTICKS
+   );
+}
+
+//===== radiotimer
+
+void simengine_radiotimer_start(OpenMote* self, PORT_RADIOTIMER_WIDTH period) {
+   self->sim.rt_start  = self->sim.worker->now;
+   self->sim.rt_period = period;
+   simengine_cancel(self,SIMEVENT_RADIOTIMER_COMPARE);
+   simengine_schedule(
+      self,
+      SIMEVENT_RADIOTIMER_OVERFLOW,
+      self->sim.rt_start+(simtime_t)period*SIMENGINE_SUBTICKS
+   );
+}
+
+PORT_RADIOTIMER_WIDTH simengine_radiotimer_getValue(OpenMote* self) {
+   return (PORT_RADIOTIMER_WIDTH)((self->sim.worker->now-self->sim.rt_start)/SIMENGINE_SUBTICKS);
+}
+
+void simengine_radiotimer_setPeriod(OpenMote* self, PORT_RADIOTIMER_WIDTH period) {
+   simtime_t fireTime;
+
+   self->sim.rt_period = period;
+   fireTime = self->sim.rt_start+(simtime_t)period*SIMENGINE_SUBTICKS;
+   if ((int64_t)(fireTime-self->sim.worker->now)<0) {
+      fireTime = self->sim.worker->now;
+   }
+   simengine_schedule(self,SIMEVENT_RADIOTIMER_OVERFLOW,fireTime);
+}
+
+PORT_RADIOTIMER_WIDTH simengine_radiotimer_getPeriod(OpenMote* self) {
+   return self->sim.rt_period;
+}
+
+void simengine_radiotimer_schedule(OpenMote* self, PORT_RADIOTIMER_WIDTH offset) {
+   simtime_t fireTime;
+
+   fireTime = self->sim.rt_start+(simtime_t)offset*SIMENGINE_SUBTICKS;
+   if ((int64_t)(fireTime-self->sim.worker->now)<0) {
+      fireTime = self->sim.worker->now;
+   }
+   simengine_schedule(self,SIMEVENT_RADIOTIMER_COMPARE,fireTime);
+}
+
+void simengine_radiotimer_cancel(OpenMote* self) {
+   simengine_cancel(self,SIMEVENT_RADIOTIMER_COMPARE);
+}
+
+PORT_RADIOTIMER_WIDTH simengine_radiotimer_getCapturedTime(OpenMote* self) {
+   return self->sim.rt_captured;
+}
+
+//===== radio
+
+void simengine_radio_reset(OpenMote* self) {
+   simengine_radio_rfOff(self);
+}
+
+void simengine_radio_setFrequency(OpenMote* self, uint8_t frequency) {
+   self->sim.radio_frequency = frequency;
+}
+
+void simengine_radio_rfOn(OpenMote* self) {
+   // nothing to do, the RF chain is turned on by txEnable/rxEnable
+}
+
+void simengine_radio_rfOff(OpenMote* self) {
+   self->sim.radio_state = SIMRADIO_OFF;
+   simengine_cancel(self,SIMEVENT_RADIO_STARTFRAME);
+   simengine_cancel(self,SIMEVENT_RADIO_ENDFRAME);
+}
+
+void simengine_radio_loadPacket(OpenMote* self, uint8_t* packet, uint8_t len) {
+   if (len>SIMENGINE_RADIO_BUFLEN) {
+      len = SIMENGINE_RADIO_BUFLEN;
+   }
+   memcpy(self->sim.txBuf,packet,len);
+   self->sim.txLen = len;
+}
+
+void simengine_radio_txEnable(OpenMote* self) {
+   self->sim.radio_state = SIMRADIO_TXENABLED;
+}
+
+void simengine_radio_txNow(OpenMote* self) {
+   self->sim.radio_state = SIMRADIO_TRANSMITTING;
+   self->sim.worker->numFramesTx++;
+   // the start of frame is signaled once the preamble and SFD are out
+   simengine_schedule(
+      self,
+      SIMEVENT_RADIO_STARTFRAME,
+      self->sim.worker->now+SIMENGINE_LOOKAHEAD
+   );
+   // the engine makes sure no mote runs past the start of frame
+   if (self->sim.txPending==FALSE) {
+      self->sim.txPending = TRUE;
+      self->sim.worker->txMotes[self->sim.worker->numTxMotes++] = self;
+   }
+}
+
+void simengine_radio_rxEnable(OpenMote* self) {
+   self->sim.radio_state = SIMRADIO_RXENABLED;
+}
+
+void simengine_radio_rxNow(OpenMote* self) {
+   self->sim.radio_state = SIMRADIO_LISTENING;
+}
+
+void simengine_radio_getReceivedFrame(OpenMote* self,
+                             uint8_t* pBufRead,
+                             uint8_t* pLenRead,
+                             uint8_t  maxBufLen,
+                              int8_t* pRssi,
+                             uint8_t* pLqi,
+                                bool* pCrc) {
+   uint8_t len;
+
+   len = self->sim.rxLen;
+   if (len>maxBufLen) {
+      len = maxBufLen;
+   }
+   memcpy(pBufRead,self->sim.rxBuf,len);
+   *pLenRead = len;
+   *pRssi    = self->sim.rxRssi;
+   *pLqi     = 0xff;
+   *pCrc     = self->sim.rxCrc;
+}
+
+//===== uart
+
+void simengine_uart_enableInterrupts(OpenMote* self) {
+   self->sim.uart_enabled = TRUE;
+   if (self->sim.serialInIdx<self->sim.serialInLen || serialring_rxPending(self)==TRUE) {
+      simengine_schedule(self,SIMEVENT_UART_RX,self->sim.worker->now);
+   }
+}
+
+void simengine_uart_disableInterrupts(OpenMote* self) {
+   self->sim.uart_enabled = FALSE;
+   simengine_cancel(self,SIMEVENT_UART_RX);
+}
+
+/**
+\brief Bytes written to the serial port by the mote.
+
+The bytes are buffered and handed to Python in bulk, or written to the ring
+shared with the host; the "TX done" interrupt is raised right away.
+*/
+void simengine_uart_write(OpenMote* self, uint8_t* buffer, uint16_t len) {
+   simmote_t* sim;
+   uint8_t*   serialOut;
+   uint32_t   serialOutMax;
+
+   sim = &self->sim;
+   sim->worker->numSerialBytes += len;
+   if (self->serialring.attached==TRUE) {
+      serialring_write(self,buffer,len);
+   } else if (self->engine->serialCb!=NULL) {
+      if (sim->serialOutLen+len>sim->serialOutMax) {
+         serialOutMax = 2*(sim->serialOutLen+len);
+         serialOut    = realloc(sim->serialOut,serialOutMax);
+         if (serialOut!=NULL) {
+            sim->serialOut    = serialOut;
+            sim->serialOutMax = serialOutMax;
+         }
+      }
+      if (sim->serialOutLen+len<=sim->serialOutMax) {
+         memcpy(&sim->serialOut[sim->serialOutLen],buffer,len);
+         sim->serialOutLen += len;
+      }
+      // Python is called by the main thread only, between two events
+      if (sim->serialOutLen>=SIMENGINE_SERIAL_FLUSH && sim->flushPending==FALSE) {
+         sim->flushPending = TRUE;
+         sim->worker->flushMotes[sim->worker->numFlushMotes++] = self;
+      }
+   }
+   simengine_schedule(self,SIMEVENT_UART_TX,self->sim.worker->now);
+}
+
+uint8_t simengine_uart_readByte(OpenMote* self) {
+   return self->sim.uart_rxByte;
+}
+
+//=========================== private =========================================
+
+//===== timeline
+
+static bool simengine_before(simevent_t* a, simevent_t* b) {
+   if (a->time!=b->time) {
+      return a->time<b->time;
+   }
+   // same time: order by mote, then by event type, so runs are reproducible
+   if (a->mote->sim.id!=b->mote->sim.id) {
+      return a->mote->sim.id<b->mote->sim.id;
+   }
+   return a->type<b->type;
+}
+
+static void simengine_heapSwap(simworker_t* worker, uint32_t i, uint32_t j) {
+   simevent_t* tmp;
+
+   tmp             = worker->heap[i];
+   worker->heap[i] = worker->heap[j];
+   worker->heap[j] = tmp;
+   worker->heap[i]->heapIdx = i;
+   worker->heap[j]->heapIdx = j;
+}
+
+static void simengine_heapUp(simworker_t* worker, uint32_t i) {
+   while (i>0 && simengine_before(worker->heap[i],worker->heap[(i-1)/2])) {
+      simengine_heapSwap(worker,i,(i-1)/2);
+      i = (i-1)/2;
+   }
+}
+
+static void simengine_heapDown(simworker_t* worker, uint32_t i) {
+   uint32_t smallest;
+   uint32_t child;
+
+   while (1) {
+      smallest = i;
+      child    = 2*i+1;
+      if (child<worker->heapSize && simengine_before(worker->heap[child],worker->heap[smallest])) {
+         smallest = child;
+      }
+      child++;
+      if (child<worker->heapSize && simengine_before(worker->heap[child],worker->heap[smallest])) {
+         smallest = child;
+      }
+      if (smallest==i) {
+         break;
+      }
+      simengine_heapSwap(worker,i,smallest);
+      i = smallest;
+   }
+}
+
+static void simengine_schedule(OpenMote* mote, uint8_t type, simtime_t time) {
+   simworker_t* worker;
+   simevent_t*  ev;
+
+   worker   = mote->sim.worker;
+   ev       = &mote->sim.events[type];
+   ev->time = time;
+   if (ev->heapIdx<0) {
+      ev->heapIdx = worker->heapSize;
+      worker->heap[worker->heapSize++] = ev;
+      simengine_heapUp(worker,ev->heapIdx);
+   } else {
+      simengine_heapUp(worker,ev->heapIdx);
+      simengine_heapDown(worker,ev->heapIdx);
+   }
+}
+
+static void simengine_cancel(OpenMote* mote, uint8_t type) {
+   simworker_t* worker;
+   simevent_t*  ev;
+   uint32_t     i;
+
+   worker = mote->sim.worker;
+   ev     = &mote->sim.events[type];
+   if (ev->heapIdx<0) {
+      return;
+   }
+   i = ev->heapIdx;
+   ev->heapIdx = -1;
+   worker->heapSize--;
+   if (i==worker->heapSize) {
+      return;
+   }
+   worker->heap[i] = worker->heap[worker->heapSize];
+   worker->heap[i]->heapIdx = i;
+   simengine_heapUp(worker,i);
+   simengine_heapDown(worker,worker->heap[i]->heapIdx);
+}
+
+static void simengine_cancelAll(OpenMote* mote) {
+   uint8_t type;
+
+   for (type=0;type<SIMEVENT_MAX;type++) {
+      simengine_cancel(mote,type);
+   }
+}
+
+/**
+\brief Execute the interrupt handler of an event, then let the mote run.
+*/
+static void simengine_dispatch(simworker_t* worker, simevent_t* ev) {
+   OpenMote*  mote;
+   simmote_t* sim;
+   uint32_t   fed;
+   uint8_t    len;
+   uint8_t    fedBytes[0xff];
+
+   mote        = ev->mote;
+   sim         = &mote->sim;
+   worker->now = ev->time;
+   worker->numEvents++;
+
+   if (ev->type==SIMEVENT_RADIOTIMER_OVERFLOW ||
+       ev->type==SIMEVENT_RADIOTIMER_COMPARE  ||
+       ev->type==SIMEVENT_BSP_TIMER) {
+      simtrace_record(mote,worker->now,SIMTRACE_TIMER,ev->type,NULL,0);
+   }
+
+   switch (ev->type) {
+      case SIMEVENT_REPLAY:
+         simengine_replayInput(worker,mote);
+         break;
+#ifdef ABSTIMER
+      case SIMEVENT_BSP_TIMER:
+         // the compare channel of the sctimer, which the abstimer virtualizes
+         sctimer_isr(mote);
+         break;
+#else
+      case SIMEVENT_RADIOTIMER_OVERFLOW:
+         sim->rt_start += (simtime_t)sim->rt_period*SIMENGINE_SUBTICKS;
+         simengine_schedule(
+            mote,
+            SIMEVENT_RADIOTIMER_OVERFLOW,
+            sim->rt_start+(simtime_t)sim->rt_period*SIMENGINE_SUBTICKS
+         );
+         radiotimer_intr_overflow(mote);
+         break;
+      case SIMEVENT_RADIOTIMER_COMPARE:
+         radiotimer_intr_compare(mote);
+         break;
+      case SIMEVENT_BSP_TIMER:
+         bsp_timer_isr(mote);
+         break;
+#endif
+      case SIMEVENT_RADIO_STARTFRAME:
+         if (sim->radio_state==SIMRADIO_TRANSMITTING) {
+            simengine_propagate(worker->engine,mote);
+         }
+         sim->rt_captured = radiotimer_getValue(mote);
+         radio_intr_startOfFrame(mote,sim->rt_captured);
+         break;
+      case SIMEVENT_RADIO_ENDFRAME:
+         if (sim->radio_state==SIMRADIO_TRANSMITTING) {
+            sim->radio_state = SIMRADIO_TXENABLED;
+         } else if (sim->radio_state==SIMRADIO_RECEIVING) {
+            // the radio keeps listening until turned off
+            sim->radio_state = SIMRADIO_LISTENING;
+            if (sim->rxCrc) {
+               worker->numFramesRx++;
+            }
+         }
+         sim->rt_captured = radiotimer_getValue(mote);
+         radio_intr_endOfFrame(mote,sim->rt_captured);
+         break;
+      case SIMEVENT_UART_TX:
+         uart_intr_tx(mote);
+         break;
+      case SIMEVENT_UART_RX:
+         // feed bytes until the mote closes its serial port
+         fed = sim->serialInIdx;
+         while (sim->uart_enabled && sim->serialInIdx<sim->serialInLen) {
+            sim->uart_rxByte = sim->serialIn[sim->serialInIdx++];
+            uart_intr_rx(mote);
+         }
+         while (fed<sim->serialInIdx) {
+            len  = (sim->serialInIdx-fed>0xff) ? 0xff : sim->serialInIdx-fed;
+            simtrace_record(mote,worker->now,SIMTRACE_SERIAL_IN,0,&sim->serialIn[fed],len);
+            fed += len;
+         }
+         if (sim->serialInIdx==sim->serialInLen) {
+            sim->serialInIdx = 0;
+            sim->serialInLen = 0;
+         }
+         // then the bytes the host wrote to the shared serial port
+         len = 0;
+         while (sim->uart_enabled && serialring_rxByte(mote,&fedBytes[len])==TRUE) {
+            sim->uart_rxByte = fedBytes[len++];
+            uart_intr_rx(mote);
+            if (len==sizeof(fedBytes)) {
+               simtrace_record(mote,worker->now,SIMTRACE_SERIAL_IN,0,fedBytes,len);
+               len = 0;
+            }
+         }
+         if (len>0) {
+            simtrace_record(mote,worker->now,SIMTRACE_SERIAL_IN,0,fedBytes,len);
+         }
+         break;
+   }
+
+   // only switch to the mote if the interrupt gave it something to do
+   if (sim->resetPending || mote->scheduler_vars.readyBitmap!=0) {
+      simengine_resume(mote);
+   }
+}
+
+//===== threads
+
+/**
+\brief Run the motes on all workers until the given time.
+
+The main thread drives worker 0 and executes the window boundaries.
+*/
+static int simengine_runParallel(SimEngine* engine, simtime_t until) {
+   simworker_t* worker;
+   simevent_t*  ev;
+   simevent_t*  top;
+   uint16_t     started;
+   uint16_t     i;
+   int          ret;
+
+   ret                  = 0;
+   engine->stopping     = FALSE;
+   engine->barrierCount = 0;
+   for (started=1;started<engine->numWorkers;started++) {
+      worker = &engine->workers[started];
+      if (pthread_create(&worker->thread,NULL,simengine_workerMain,worker)!=0) {
+         break;
+      }
+   }
+   if (started<engine->numWorkers) {
+      // the barrier needs every worker, give up
+      PyErr_SetString(PyExc_RuntimeError, "could not start the simulation threads");
+      ret = -1;
+   }
+
+   while (ret==0 && simengine_nextWindow(engine,until)) {
+      engine->numWindows++;
+
+      // in parallel, run the motes up to the window boundary
+      simengine_barrier(engine);
+      simengine_runWindow(&engine->workers[0],engine->horizon);
+      simengine_barrier(engine);
+
+      // one by one, execute the events at the boundary, in timeline order
+      while (engine->horizon<=until) {
+         ev = NULL;
+         for (i=0;i<engine->numWorkers;i++) {
+            worker = &engine->workers[i];
+            if (worker->heapSize==0) {
+               continue;
+            }
+            top = worker->heap[0];
+            if (ev==NULL || simengine_before(top,ev)) {
+               ev = top;
+            }
+         }
+         if (ev==NULL || ev->time!=engine->horizon) {
+            break;
+         }
+         simengine_cancel(ev->mote,ev->type);
+         simengine_dispatch(ev->mote->sim.worker,ev);
+      }
+
+      if (simengine_flushPending(engine)<0) {
+         ret = -1;
+      }
+   }
+
+   // release the workers, waiting at the barrier
+   __atomic_store_n(&engine->stopping,TRUE,__ATOMIC_RELEASE);
+   for (i=1;i<started;i++) {
+      pthread_join(engine->workers[i].thread,NULL);
+   }
+   return ret;
+}
+
+/**
+\brief Compute the end of the next window.
+
+\returns FALSE if no event is left before until.
+*/
+static bool simengine_nextWindow(SimEngine* engine, simtime_t until) {
+   simworker_t* worker;
+   OpenMote*    mote;
+   simevent_t*  ev;
+   simtime_t    earliest;
+   simtime_t    horizon;
+   uint16_t     i;
+   uint16_t     j;
+   bool         found;
+
+   // earliest pending event
+   found    = FALSE;
+   earliest = 0;
+   for (i=0;i<engine->numWorkers;i++) {
+      worker = &engine->workers[i];
+      if (worker->heapSize>0 && (found==FALSE || worker->heap[0]->time<earliest)) {
+         earliest = worker->heap[0]->time;
+         found    = TRUE;
+      }
+   }
+   if (found==FALSE || earliest>until) {
+      return FALSE;
+   }
+
+   // no frame can start earlier than this one without being scheduled already
+   horizon = earliest+SIMENGINE_LOOKAHEAD;
+
+   // earliest start of frame already scheduled
+   for (i=0;i<engine->numWorkers;i++) {
+      worker = &engine->workers[i];
+      j = 0;
+      while (j<worker->numTxMotes) {
+         mote = worker->txMotes[j];
+         ev   = &mote->sim.events[SIMEVENT_RADIO_STARTFRAME];
+         if (ev->heapIdx<0 || mote->sim.radio_state!=SIMRADIO_TRANSMITTING) {
+            // frame sent or aborted
+            mote->sim.txPending = FALSE;
+            worker->txMotes[j]  = worker->txMotes[--worker->numTxMotes];
+            continue;
+         }
+         if (ev->time<horizon) {
+            horizon = ev->time;
+         }
+         j++;
+      }
+   }
+
+   if (horizon>until) {
+      horizon = until+1;
+   }
+   engine->horizon = horizon;
+   return TRUE;
+}
+
+/**
+\brief Execute the events of a worker up to (excluding) horizon.
+*/
+static void simengine_runWindow(simworker_t* worker, simtime_t horizon) {
+   simevent_t* ev;
+
+   while (worker->heapSize>0 && worker->heap[0]->time<horizon) {
+      ev = worker->heap[0];
+      simengine_cancel(ev->mote,ev->type);
+      simengine_dispatch(worker,ev);
+   }
+}
+
+static void* simengine_workerMain(void* arg) {
+   simworker_t* worker;
+   SimEngine*   engine;
+
+   worker = (simworker_t*)arg;
+   engine = worker->engine;
+   while (1) {
+      // wait for the window to be published
+      simengine_barrier(engine);
+      if (__atomic_load_n(&engine->stopping,__ATOMIC_ACQUIRE)) {
+         break;
+      }
+      simengine_runWindow(worker,engine->horizon);
+      simengine_barrier(engine);
+   }
+   return NULL;
+}
+
+/**
+\brief Sense-reversing barrier between all workers.
+
+Windows are short, so workers spin rather than sleep. Returns early once the
+engine is stopping.
+*/
+static void simengine_barrier(SimEngine* engine) {
+   uint32_t sense;
+   uint32_t spins;
+
+   sense = __atomic_load_n(&engine->barrierSense,__ATOMIC_ACQUIRE);
+   if (__atomic_add_fetch(&engine->barrierCount,1,__ATOMIC_ACQ_REL)==engine->numWorkers) {
+      // last to arrive, release the others
+      __atomic_store_n(&engine->barrierCount,0,__ATOMIC_RELAXED);
+      __atomic_store_n(&engine->barrierSense,sense^1,__ATOMIC_RELEASE);
+      return;
+   }
+   spins = 0;
+   while (__atomic_load_n(&engine->barrierSense,__ATOMIC_ACQUIRE)==sense) {
+      if (__atomic_load_n(&engine->stopping,__ATOMIC_ACQUIRE)) {
+         return;
+      }
+      if (++spins>=SIMENGINE_BARRIER_SPINS) {
+         sched_yield();
+         spins = 0;
+      }
+   }
+}
+
+//===== execution
+
+static void simengine_moteMain(unsigned int hi, unsigned int lo) {
+   OpenMote* self;
+
+   self = (OpenMote*)((((uintptr_t)hi)<<16<<16)|(uintptr_t)lo);
+   snapshot_main(self);
+   // the firmware never returns on a healthy mote
+   self->sim.isOn = FALSE;
+}
+
+/**
+\brief (Re)create the mote's coroutine, as after a power cycle.
+*/
+static void simengine_prepareBoot(OpenMote* mote) {
+   simmote_t* sim;
+
+   sim = &mote->sim;
+   sim->resetPending = FALSE;
+   simengine_cancelAll(mote);
+   simengine_replaySchedule(mote);
+   sim->rt_start     = sim->worker->now;
+   sim->rt_period    = 0;
+   sim->bt_start     = sim->worker->now;
+   sim->bt_lastCompare = 0;
+   sim->radio_state  = SIMRADIO_OFF;
+   sim->uart_enabled = FALSE;
+   sim->leds         = 0;
+   simengine_makeContext(mote);
+}
+
+/**
+\brief Create a coroutine which runs the mote's firmware from the start.
+*/
+static void simengine_makeContext(OpenMote* mote) {
+   simmote_t* sim;
+   uintptr_t  ptr;
+
+   sim = &mote->sim;
+   ptr = (uintptr_t)mote;
+   getcontext(&sim->ctx);
+   sim->ctx.uc_stack.ss_sp   = sim->stack;
+   sim->ctx.uc_stack.ss_size = SIMENGINE_STACK_SIZE;
+   sim->ctx.uc_link          = &sim->worker->ctx;
+   makecontext(
+      &sim->ctx,
+      (void (*)(void))simengine_moteMain,
+      2,
+      (unsigned int)(ptr>>16>>16),
+      (unsigned int)(ptr&0xffffffff)
+   );
+}
+
+static void simengine_resume(OpenMote* mote) {
+   simworker_t* worker;
+
+   worker = mote->sim.worker;
+   do {
+      if (mote->sim.resetPending) {
+         simengine_prepareBoot(mote);
+      }
+      if (mote->sim.isOn==FALSE) {
+         return;
+      }
+      worker->current = mote;
+      worker->numResumes++;
+      swapcontext(&worker->ctx,&mote->sim.ctx);
+      worker->current = NULL;
+   } while (mote->sim.resetPending);
+
+   if (mote->sim.isOn==FALSE) {
+      simengine_cancelAll(mote);
+   }
+}
+
+/**
+\brief Feed the mote with the next input of its trace.
+
+Frames are delivered as simengine_propagate() does, if the mote is listening
+on the frequency they were sent on.
+*/
+static void simengine_replayInput(simworker_t* worker, OpenMote* mote) {
+   simmote_t*               sim;
+   simreplay_t*             replay;
+   const simtrace_record_t* record;
+   const uint8_t*           payload;
+
+   sim     = &mote->sim;
+   replay  = sim->replay;
+   record  = replay->records[replay->next++];
+   payload = (const uint8_t*)&record[1];
+
+   switch (record->type) {
+      case SIMTRACE_RADIO_RX:
+         if (sim->isOn==FALSE                               ||
+             sim->radio_state!=SIMRADIO_LISTENING           ||
+             sim->radio_frequency!=(record->arg & 0xff)     ||
+             record->len>SIMENGINE_RADIO_BUFLEN) {
+            replay->numMissed++;
+            break;
+         }
+         memcpy(sim->rxBuf,payload,record->len);
+         sim->rxLen       = record->len;
+         sim->rxRssi      = (int8_t)(record->arg>>8);
+         sim->rxCrc       = TRUE;
+         sim->radio_state = SIMRADIO_RECEIVING;
+         simengine_schedule(mote,SIMEVENT_RADIO_STARTFRAME,worker->now);
+         simengine_schedule(mote,SIMEVENT_RADIO_ENDFRAME,worker->now+(1+record->len)*SIMENGINE_BYTE_DURATION);
+         simtrace_record(mote,worker->now,SIMTRACE_RADIO_RX,record->arg,payload,record->len);
+         replay->numReplayed++;
+         break;
+      case SIMTRACE_RADIO_COLLISION:
+         if (sim->radio_state!=SIMRADIO_RECEIVING) {
+            replay->numMissed++;
+            break;
+         }
+         sim->rxCrc = FALSE;
+         simtrace_record(mote,worker->now,SIMTRACE_RADIO_COLLISION,0,NULL,0);
+         replay->numReplayed++;
+         break;
+      case SIMTRACE_SERIAL_IN:
+         // the bytes were read as soon as they were available
+         if (simengine_serialInput(mote->engine,sim->id,(uint8_t*)payload,record->len)<0) {
+            replay->numMissed++;
+            break;
+         }
+         if (sim->uart_enabled) {
+            simengine_schedule(mote,SIMEVENT_UART_RX,worker->now);
+         }
+         replay->numReplayed++;
+         break;
+   }
+
+   simengine_replaySchedule(mote);
+}
+
+/**
+\brief Schedule the next input of the trace the mote is fed from, if any.
+
+Inputs older than the current time, missed while the mote was off, are
+skipped.
+*/
+static void simengine_replaySchedule(OpenMote* mote) {
+   simreplay_t* replay;
+
+   replay = mote->sim.replay;
+   if (replay==NULL || mote->sim.isOn==FALSE) {
+      return;
+   }
+   while (replay->next<replay->numRecords && replay->records[replay->next]->time<mote->sim.worker->now) {
+      replay->next++;
+      replay->numMissed++;
+   }
+   if (replay->next<replay->numRecords) {
+      simengine_schedule(mote,SIMEVENT_REPLAY,replay->records[replay->next]->time);
+   }
+}
+
+//===== helpers
+
+/**
+\brief Derive the links of the motes which have a position from the propagation model.
+*/
+static int simengine_updateLinks(SimEngine* engine) {
+   propagation_link_t* found;
+   propagation_link_t* grown;
+   simmote_t*          sim;
+   simlink_t*          links;
+   uint32_t            maxFound;
+   uint32_t            numFound;
+   uint16_t            i;
+   uint32_t            j;
+
+   maxFound = 64;
+   found    = malloc(maxFound*sizeof(propagation_link_t));
+   if (found==NULL) {
+      return -1;
+   }
+   for (i=0;i<engine->numMotes;i++) {
+      if (propagation_isPlaced(&engine->propagation,i)==0) {
+         continue;
+      }
+      sim      = &engine->motes[i]->sim;
+      numFound = propagation_getLinks(&engine->propagation,i,found,maxFound);
+      if (numFound>maxFound) {
+         grown = realloc(found,numFound*sizeof(propagation_link_t));
+         if (grown==NULL) {
+            free(found);
+            return -1;
+         }
+         found    = grown;
+         maxFound = numFound;
+         propagation_getLinks(&engine->propagation,i,found,maxFound);
+      }
+      if (numFound>sim->maxLinks) {
+         links = realloc(sim->links,numFound*sizeof(simlink_t));
+         if (links==NULL) {
+            free(found);
+            return -1;
+         }
+         sim->links    = links;
+         sim->maxLinks = numFound;
+      }
+      for (j=0;j<numFound;j++) {
+         sim->links[j].dst  = (uint16_t)found[j].dst;
+         sim->links[j].rssi = found[j].rssi;
+         sim->links[j].pdr  = simengine_pdr(found[j].pdr);
+      }
+      sim->numLinks = numFound;
+   }
+   free(found);
+   engine->linksDirty = FALSE;
+   return 0;
+}
+
+static uint32_t simengine_pdr(double pdr) {
+   return (pdr>=1) ? SIMENGINE_PDR_ALWAYS : (uint32_t)(pdr*SIMENGINE_PDR_ALWAYS);
+}
+
+/**
+\brief Deliver the frame a mote starts transmitting to its listening neighbors.
+
+Only called at a window boundary, when no other worker is running.
+*/
+static void simengine_propagate(SimEngine* engine, OpenMote* src) {
+   simmote_t* sim;
+   simmote_t* rx;
+   simlink_t* link;
+   OpenMote*  dst;
+   simtime_t  now;
+   simtime_t  endTime;
+   uint16_t   i;
+   uint8_t    delivered;
+
+   sim     = &src->sim;
+   now     = sim->worker->now;
+   endTime = now+(1+sim->txLen)*SIMENGINE_BYTE_DURATION;
+   simengine_schedule(src,SIMEVENT_RADIO_ENDFRAME,endTime);
+
+   simengine_trace(engine,&now,sizeof(now));
+   simengine_trace(engine,&sim->id,sizeof(sim->id));
+   simengine_trace(engine,&sim->radio_frequency,sizeof(sim->radio_frequency));
+   simengine_trace(engine,sim->txBuf,sim->txLen);
+   simtrace_record(src,now,SIMTRACE_RADIO_TX,sim->radio_frequency,sim->txBuf,sim->txLen);
+
+   for (i=0;i<sim->numLinks;i++) {
+      link = &sim->links[i];
+      dst  = engine->motes[link->dst];
+      rx   = &dst->sim;
+      if (rx->isOn==FALSE || rx->radio_frequency!=sim->radio_frequency) {
+         continue;
+      }
+      if (rx->radio_state==SIMRADIO_RECEIVING) {
+         // two frames overlap at the receiver
+         rx->rxCrc = FALSE;
+         engine->numCollisions++;
+         simtrace_record(dst,now,SIMTRACE_RADIO_COLLISION,0,NULL,0);
+         delivered = FALSE;
+         simengine_trace(engine,&rx->id,sizeof(rx->id));
+         simengine_trace(engine,&delivered,sizeof(delivered));
+         continue;
+      }
+      if (rx->radio_state!=SIMRADIO_LISTENING) {
+         continue;
+      }
+      if (link->pdr!=SIMENGINE_PDR_ALWAYS && simengine_random(engine)>=link->pdr) {
+         continue;
+      }
+      memcpy(rx->rxBuf,sim->txBuf,sim->txLen);
+      rx->rxLen       = sim->txLen;
+      rx->rxRssi      = link->rssi;
+      rx->rxCrc       = TRUE;
+      rx->radio_state = SIMRADIO_RECEIVING;
+      simengine_schedule(dst,SIMEVENT_RADIO_STARTFRAME,now);
+      simengine_schedule(dst,SIMEVENT_RADIO_ENDFRAME,endTime);
+      simtrace_record(
+         dst,
+         now,
+         SIMTRACE_RADIO_RX,
+         sim->radio_frequency|((uint8_t)link->rssi<<8),
+         sim->txBuf,
+         sim->txLen
+      );
+      delivered = TRUE;
+      simengine_trace(engine,&rx->id,sizeof(rx->id));
+      simengine_trace(engine,&delivered,sizeof(delivered));
+   }
+}
+
+/**
+\brief Fold data into the digest of the radio trace (FNV-1a).
+*/
+static void simengine_trace(SimEngine* engine, const void* data, uint32_t len) {
+   const uint8_t* bytes;
+   uint64_t       digest;
+   uint32_t       i;
+
+   bytes  = (const uint8_t*)data;
+   digest = engine->traceDigest;
+   for (i=0;i<len;i++) {
+      digest ^= bytes[i];
+      digest *= SIMENGINE_FNV_PRIME;
+   }
+   engine->traceDigest = digest;
+}
+
+static uint32_t simengine_random(SimEngine* engine) {
+   uint32_t x;
+
+   // xorshift32
+   x  = engine->randomState;
+   x ^= x<<13;
+   x ^= x>>17;
+   x ^= x<<5;
+   engine->randomState = x;
+   return x;
+}
+
+/**
+\brief Hand to Python the serial bytes of the motes which buffered enough.
+*/
+static int simengine_flushPending(SimEngine* engine) {
+   simworker_t* worker;
+   OpenMote*    mote;
+   uint16_t     i;
+   int          ret;
+
+   ret = 0;
+   for (i=0;i<engine->numWorkers;i++) {
+      worker = &engine->workers[i];
+      while (worker->numFlushMotes>0) {
+         mote = worker->flushMotes[--worker->numFlushMotes];
+         mote->sim.flushPending = FALSE;
+         if (ret==0 && simengine_flushMote(engine,mote)<0) {
+            ret = -1;
+         }
+      }
+   }
+   return ret;
+}
+
+static int simengine_flushMote(SimEngine* engine, OpenMote* mote) {
+   PyObject* result;
+
+   if (engine->serialCb==NULL || mote->sim.serialOutLen==0) {
+      return 0;
+   }
+   result = PyObject_CallFunction(
+      engine->serialCb,
+      "(is#)",
+      mote->sim.id,
+      mote->sim.serialOut,
+      mote->sim.serialOutLen
+   );
+   mote->sim.serialOutLen = 0;
+   if (result==NULL) {
+      return -1;
+   }
+   Py_DECREF(result);
+   return 0;
+}
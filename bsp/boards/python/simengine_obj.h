@@ -0,0 +1,321 @@
+/**
+\brief Native multi-mote simulation engine for the Python board.
+
+When an OpenMote is attached to a SimEngine, its BSP (radiotimer, bsp_timer,
+radio, uart, leds, debugpins, eui64) is emulated in C instead of being
+forwarded to Python. The engine keeps a single timeline for all attached
+motes, delivers radio frames between motes in C and only calls back into
+Python for coarse events (serial bytes).
+
+A frame reaches the motes the sender has a link to. Links are either declared
+one by one (setLink), or derived from the positions of the motes by the
+propagation model (see propagation.h), in which case each mote only has links
+to the motes in range and a frame costs O(neighbors) to deliver.
+
+The events of the motes can be recorded into a binary trace, and the inputs
+of one mote of a recorded run replayed into a mote of its own (see
+simtrace_obj.h).
+
+Each mote runs its firmware in its own coroutine: board_sleep() returns
+control to the engine, which pops the next event from its timeline, executes
+the corresponding interrupt handler and resumes the mote's scheduler if the
+handler posted a task.
+
+The engine can spread the motes over several worker threads, each with its
+own timeline. Motes only interact through the frames they transmit, and a
+frame starts PORT_delayTx ticks after radio_txNow() is called. The engine
+therefore advances time in windows which end at the earliest of:
+- PORT_delayTx ticks after the earliest pending event, the first time a
+  start of frame the workers do not yet know about can happen;
+- the earliest start of frame already scheduled.
+Within a window, the workers run their motes in parallel. At the window
+boundary, all workers wait at a barrier and the main thread executes the
+events at that instant one by one, in the same (time, mote, type) order as
+a single-threaded run, which includes delivering the frames. Runs are
+therefore identical whatever the number of threads.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __SIMENGINE_H
+#define __SIMENGINE_H
+
+#include "Python.h"
+
+#include <ucontext.h>
+#include <pthread.h>
+#include "toolchain_defs.h"
+#include "board_info.h"
+#include "propagation.h"
+#include "simtrace_obj.h"
+
+//=========================== define ==========================================
+
+/// number of engine time units per tick of the 32kHz mote clock
+#define SIMENGINE_SUBTICKS           32
+#define SIMENGINE_TICKS_PER_SEC      32768
+#define SIMENGINE_UNITS_PER_SEC      (SIMENGINE_TICKS_PER_SEC*SIMENGINE_SUBTICKS)
+
+/// 32us per byte at 250kbps, expressed in engine time units
+#define SIMENGINE_BYTE_DURATION      34
+
+#define SIMENGINE_STACK_SIZE         (64*1024)
+#define SIMENGINE_RADIO_BUFLEN       128
+/// serial bytes buffered per mote before the engine flushes them to Python
+#define SIMENGINE_SERIAL_FLUSH       4096
+#define SIMENGINE_PDR_ALWAYS         0xffffffff
+#define SIMENGINE_MAX_THREADS        64
+/// minimum delay between a mote acting and a frame reaching another mote
+#define SIMENGINE_LOOKAHEAD          (PORT_delayTx*SIMENGINE_SUBTICKS)
+
+/// events each mote can have pending on the engine's timeline
+enum {
+   SIMEVENT_REPLAY = 0,                      ///< input from a trace, before the mote's events at the same time
+   SIMEVENT_RADIOTIMER_OVERFLOW,
+   SIMEVENT_RADIOTIMER_COMPARE,
+   SIMEVENT_BSP_TIMER,
+   SIMEVENT_RADIO_STARTFRAME,
+   SIMEVENT_RADIO_ENDFRAME,
+   SIMEVENT_UART_TX,
+   SIMEVENT_UART_RX,
+   SIMEVENT_MAX
+};
+
+/// state of the emulated radio
+enum {
+   SIMRADIO_OFF = 0,
+   SIMRADIO_TXENABLED,
+   SIMRADIO_TRANSMITTING,
+   SIMRADIO_RXENABLED,
+   SIMRADIO_LISTENING,
+   SIMRADIO_RECEIVING,
+};
+
+//=========================== typedef =========================================
+
+typedef struct OpenMote  OpenMote;
+typedef struct SimEngine SimEngine;
+typedef struct simworker simworker_t;
+
+/// absolute engine time, in units of 1/SIMENGINE_UNITS_PER_SEC s
+typedef uint64_t simtime_t;
+
+typedef struct {
+   simtime_t                 time;
+   OpenMote*                 mote;
+   uint8_t                   type;
+   int32_t                   heapIdx;        ///< -1 when not scheduled
+} simevent_t;
+
+typedef struct {
+   uint16_t                  dst;            ///< index of the receiving mote
+   int8_t                    rssi;
+   uint32_t                  pdr;            ///< 0..SIMENGINE_PDR_ALWAYS
+} simlink_t;
+
+/**
+\brief Per-mote state of the emulated BSP.
+*/
+typedef struct {
+   // admin
+   uint16_t                  id;             ///< index of the mote in the engine
+   uint8_t                   eui64[8];
+   bool                      isOn;
+   bool                      resetPending;
+   simworker_t*              worker;         ///< thread (and timeline) running this mote
+   bool                      txPending;      ///< listed in worker->txMotes
+   bool                      flushPending;   ///< listed in worker->flushMotes
+   // execution
+   ucontext_t                ctx;
+   uint8_t*                  stack;
+   // radiotimer
+   simtime_t                 rt_start;       ///< time the counter last wrapped
+   PORT_RADIOTIMER_WIDTH     rt_period;
+   PORT_RADIOTIMER_WIDTH     rt_captured;
+   // bsp_timer
+   simtime_t                 bt_start;
+   uint64_t                  bt_lastCompare; ///< in ticks since bt_start
+   // radio
+   uint8_t                   radio_state;
+   uint8_t                   radio_frequency;
+   uint8_t                   txBuf[SIMENGINE_RADIO_BUFLEN];
+   uint8_t                   txLen;
+   uint8_t                   rxBuf[SIMENGINE_RADIO_BUFLEN];
+   uint8_t                   rxLen;
+   int8_t                    rxRssi;
+   bool                      rxCrc;
+   // leds
+   uint8_t                   leds;
+   // uart
+   bool                      uart_enabled;
+   uint8_t                   uart_rxByte;
+   uint8_t*                  serialOut;
+   uint32_t                  serialOutLen;
+   uint32_t                  serialOutMax;
+   uint8_t*                  serialIn;
+   uint32_t                  serialInLen;
+   uint32_t                  serialInIdx;
+   // propagation
+   simlink_t*                links;
+   uint16_t                  numLinks;
+   uint16_t                  maxLinks;
+   // replay
+   simreplay_t*              replay;         ///< NULL unless fed from a trace
+   // timeline
+   simevent_t                events[SIMEVENT_MAX];
+} simmote_t;
+
+/**
+\brief State of the emulated BSP of a mote, as stored in a snapshot.
+
+Times are relative to the engine's time when the snapshot was taken, so the
+state can be restored at any time, in any engine.
+*/
+typedef struct {
+   uint8_t                   isOn;
+   uint8_t                   radio_state;
+   uint8_t                   radio_frequency;
+   uint8_t                   leds;
+   uint8_t                   uart_enabled;
+   uint8_t                   uart_rxByte;
+   uint8_t                   rxCrc;
+    int8_t                   rxRssi;
+   // radiotimer
+   simtime_t                 rt_elapsed;     ///< time since the counter last wrapped
+   PORT_RADIOTIMER_WIDTH     rt_period;
+   PORT_RADIOTIMER_WIDTH     rt_captured;
+   // bsp_timer
+   simtime_t                 bt_elapsed;
+   uint64_t                  bt_lastCompare;
+   // radio
+   uint8_t                   txLen;
+   uint8_t                   rxLen;
+   uint8_t                   txBuf[SIMENGINE_RADIO_BUFLEN];
+   uint8_t                   rxBuf[SIMENGINE_RADIO_BUFLEN];
+   // timeline
+   uint8_t                   eventPending[SIMEVENT_MAX];
+   simtime_t                 eventIn[SIMEVENT_MAX];
+} simsnapshot_t;
+
+/**
+\brief A thread of the engine, with the timeline of the motes it runs.
+*/
+struct simworker {
+   SimEngine*                engine;
+   uint16_t                  index;
+   pthread_t                 thread;
+   //===== timeline
+   simtime_t                 now;
+   simevent_t**              heap;
+   uint32_t                  heapSize;
+   uint32_t                  heapMax;
+   //===== motes
+   uint16_t                  numMotes;
+   OpenMote*                 current;        ///< mote whose coroutine is running
+   ucontext_t                ctx;
+   OpenMote**                txMotes;        ///< motes with a start of frame scheduled
+   uint16_t                  numTxMotes;
+   OpenMote**                flushMotes;     ///< motes with serial bytes to hand to Python
+   uint16_t                  numFlushMotes;
+   //===== stats, folded into the engine's after each run
+   uint64_t                  numEvents;
+   uint64_t                  numResumes;
+   uint64_t                  numFramesTx;
+   uint64_t                  numFramesRx;
+   uint64_t                  numSerialBytes;
+};
+
+/**
+\brief Memory footprint of a SimEngine instance.
+*/
+struct SimEngine {
+   PyObject_HEAD // No ';' allows since in macro
+   simtime_t                 now;
+   //===== motes
+   OpenMote**                motes;
+   uint16_t                  numMotes;
+   uint16_t                  maxMotes;
+   //===== workers
+   simworker_t*              workers;
+   uint16_t                  numWorkers;
+   simtime_t                 horizon;        ///< end (excluded) of the current window
+   bool                      stopping;
+   volatile uint32_t         barrierCount;
+   volatile uint32_t         barrierSense;
+   //===== propagation
+   propagation_t             propagation;
+   bool                      linksDirty;     ///< motes moved since the links were computed
+   uint32_t                  randomState;
+   uint64_t                  traceDigest;    ///< hash of every frame sent and delivered
+   simtrace_t*               trace;          ///< NULL unless recording
+   //===== callbacks to Python
+   PyObject*                 serialCb;
+   //===== stats
+   uint64_t                  numEvents;
+   uint64_t                  numResumes;
+   uint64_t                  numFramesTx;
+   uint64_t                  numFramesRx;
+   uint64_t                  numCollisions;
+   uint64_t                  numSerialBytes;
+   uint64_t                  numWindows;
+};
+
+//=========================== prototypes ======================================
+
+// admin
+int       simengine_init(SimEngine* engine, uint32_t seed, uint16_t numThreads);
+void      simengine_free(SimEngine* engine);
+int       simengine_addMote(SimEngine* engine, OpenMote* mote, uint8_t* eui64);
+int       simengine_setLink(SimEngine* engine, uint16_t src, uint16_t dst, double pdr, int8_t rssi);
+int       simengine_setPosition(SimEngine* engine, uint16_t id, double x, double y);
+int       simengine_setPropagation(SimEngine* engine, double txPower, double pathLoss1m, double exponent, double sensitivity);
+int       simengine_serialInput(SimEngine* engine, uint16_t id, uint8_t* buf, uint32_t len);
+int       simengine_replay(SimEngine* engine, uint16_t id, const char* path, uint16_t traceMote);
+int       simengine_run(SimEngine* engine, simtime_t duration);
+int       simengine_flushSerial(SimEngine* engine);
+// execution (called from the BSP)
+void      simengine_moteBoot(OpenMote* self);
+void      simengine_moteOff(OpenMote* self);
+void      simengine_moteSleep(OpenMote* self);
+void      simengine_moteReset(OpenMote* self);
+void      simengine_moteSave(OpenMote* self, simsnapshot_t* snap);
+void      simengine_moteRestore(OpenMote* self, const simsnapshot_t* snap);
+// bsp_timer
+void      simengine_bsp_timer_reset(OpenMote* self);
+void      simengine_bsp_timer_scheduleIn(OpenMote* self, PORT_TIMER_WIDTH delayTicks);
+void      simengine_bsp_timer_cancel_schedule(OpenMote* self);
+PORT_TIMER_WIDTH simengine_bsp_timer_get_currentValue(OpenMote* self);
+// radiotimer
+void      simengine_radiotimer_start(OpenMote* self, PORT_RADIOTIMER_WIDTH period);
+PORT_RADIOTIMER_WIDTH simengine_radiotimer_getValue(OpenMote* self);
+void      simengine_radiotimer_setPeriod(OpenMote* self, PORT_RADIOTIMER_WIDTH period);
+PORT_RADIOTIMER_WIDTH simengine_radiotimer_getPeriod(OpenMote* self);
+void      simengine_radiotimer_schedule(OpenMote* self, PORT_RADIOTIMER_WIDTH offset);
+void      simengine_radiotimer_cancel(OpenMote* self);
+PORT_RADIOTIMER_WIDTH simengine_radiotimer_getCapturedTime(OpenMote* self);
+// sctimer, on the counter of the bsp_timer
+void      simengine_sctimer_schedule(OpenMote* self, PORT_TIMER_WIDTH val);
+// radio
+void      simengine_radio_reset(OpenMote* self);
+void      simengine_radio_setFrequency(OpenMote* self, uint8_t frequency);
+void      simengine_radio_rfOn(OpenMote* self);
+void      simengine_radio_rfOff(OpenMote* self);
+void      simengine_radio_loadPacket(OpenMote* self, uint8_t* packet, uint8_t len);
+void      simengine_radio_txEnable(OpenMote* self);
+void      simengine_radio_txNow(OpenMote* self);
+void      simengine_radio_rxEnable(OpenMote* self);
+void      simengine_radio_rxNow(OpenMote* self);
+void      simengine_radio_getReceivedFrame(OpenMote* self,
+                             uint8_t* pBufRead,
+                             uint8_t* pLenRead,
+                             uint8_t  maxBufLen,
+                              int8_t* pRssi,
+                             uint8_t* pLqi,
+                                bool* pCrc);
+// uart
+void      simengine_uart_enableInterrupts(OpenMote* self);
+void      simengine_uart_disableInterrupts(OpenMote* self);
+void      simengine_uart_write(OpenMote* self, uint8_t* buffer, uint16_t len);
+uint8_t   simengine_uart_readByte(OpenMote* self);
+
+#endif
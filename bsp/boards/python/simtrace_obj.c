@@ -0,0 +1,359 @@
+/**
+\brief Binary event trace of the native simulation engine, and its replay.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "openwsnmodule_obj.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "simtrace_obj.h"
+
+//=========================== defines =========================================
+
+#define SIMTRACE_RECORD_LEN(len)     ((sizeof(simtrace_record_t)+(len)+SIMTRACE_ALIGN-1)&~(uint64_t)(SIMTRACE_ALIGN-1))
+
+//=========================== variables =======================================
+
+//=========================== prototypes ======================================
+
+static uint64_t simtrace_length(const uint8_t* map, uint64_t size);
+static int      simtrace_compare(const void* a, const void* b);
+
+//=========================== public ==========================================
+
+//===== recording
+
+/**
+\brief Start recording the events of the engine's motes into a file.
+
+The file is created (or truncated) with the given size, which bounds the
+length of the trace; records which do not fit are counted, then dropped.
+
+\returns 0 on success, -1 (with a Python exception set) on failure.
+*/
+int simtrace_start(SimEngine* engine, const char* path, uint64_t size) {
+   simtrace_t*        trace;
+   simtrace_header_t* header;
+   Dl_info            info;
+
+   if (size<sizeof(simtrace_header_t)+SIMTRACE_RECORD_LEN(0)) {
+      PyErr_SetString(PyExc_ValueError, "trace too small");
+      return -1;
+   }
+   if (engine->trace!=NULL && simtrace_stop(engine)<0) {
+      return -1;
+   }
+
+   trace = calloc(1,sizeof(simtrace_t));
+   if (trace==NULL) {
+      PyErr_NoMemory();
+      return -1;
+   }
+   trace->fd = open(path,O_RDWR|O_CREAT|O_TRUNC,0644);
+   if (trace->fd<0) {
+      free(trace);
+      PyErr_SetFromErrnoWithFilename(PyExc_IOError,(char*)path);
+      return -1;
+   }
+   // the file is sparse, only the pages written to use disk space
+   if (ftruncate(trace->fd,size)<0) {
+      PyErr_SetFromErrnoWithFilename(PyExc_IOError,(char*)path);
+      close(trace->fd);
+      free(trace);
+      return -1;
+   }
+   trace->map = mmap(NULL,size,PROT_READ|PROT_WRITE,MAP_SHARED,trace->fd,0);
+   if (trace->map==MAP_FAILED) {
+      PyErr_SetFromErrnoWithFilename(PyExc_IOError,(char*)path);
+      close(trace->fd);
+      free(trace);
+      return -1;
+   }
+   trace->size       = size;
+   trace->imageBase  = (dladdr((void*)&simtrace_start,&info)!=0) ? (uintptr_t)info.dli_fbase : 0;
+   trace->used       = 0;
+   trace->length     = size-sizeof(simtrace_header_t);
+   trace->numDropped = 0;
+
+   header = (simtrace_header_t*)trace->map;
+   header->magic       = SIMTRACE_MAGIC;
+   header->version     = SIMTRACE_VERSION;
+   header->recordLen   = sizeof(simtrace_record_t);
+   header->unitsPerSec = SIMENGINE_UNITS_PER_SEC;
+
+   engine->trace = trace;
+   return 0;
+}
+
+/**
+\brief Stop recording, and trim the file to the records it holds.
+
+\returns the number of records, -1 (with a Python exception set) on failure.
+*/
+int64_t simtrace_stop(SimEngine* engine) {
+   simtrace_t*        trace;
+   simtrace_header_t* header;
+   uint64_t           length;
+   uint64_t           offset;
+   uint64_t           numRecords;
+   int                ret;
+
+   trace = engine->trace;
+   if (trace==NULL) {
+      return 0;
+   }
+   engine->trace = NULL;
+
+   length = trace->used;
+   if (length>trace->length) {
+      length = trace->length;
+   }
+   numRecords = 0;
+   for (offset=0;offset<length;offset+=SIMTRACE_RECORD_LEN(((simtrace_record_t*)&trace->map[sizeof(simtrace_header_t)+offset])->len)) {
+      numRecords++;
+   }
+   header = (simtrace_header_t*)trace->map;
+   header->numRecords = numRecords;
+   header->length     = length;
+   header->numDropped = trace->numDropped;
+
+   ret = 0;
+   if (munmap(trace->map,trace->size)<0 ||
+       ftruncate(trace->fd,sizeof(simtrace_header_t)+length)<0) {
+      PyErr_SetFromErrno(PyExc_IOError);
+      ret = -1;
+   }
+   close(trace->fd);
+   free(trace);
+   return (ret<0) ? -1 : (int64_t)numRecords;
+}
+
+/**
+\brief Append a record to the trace of the engine of the mote, if any.
+
+Can be called by several workers at once.
+*/
+void simtrace_record(OpenMote* mote,
+                       uint64_t time,
+                       uint8_t  type,
+                       uint32_t arg,
+                       const uint8_t* payload,
+                       uint8_t  len) {
+   simtrace_t*        trace;
+   simtrace_record_t* record;
+   uint64_t           recordLen;
+   uint64_t           offset;
+   uint64_t           end;
+   asn_t*             asn;
+
+   trace = mote->engine->trace;
+   if (trace==NULL) {
+      return;
+   }
+
+   recordLen = SIMTRACE_RECORD_LEN(len);
+   offset    = __sync_fetch_and_add(&trace->used,recordLen);
+   if (offset+recordLen>trace->size-sizeof(simtrace_header_t)) {
+      // the trace ends at the first record which does not fit
+      end = trace->length;
+      while (offset<end && __sync_bool_compare_and_swap(&trace->length,end,offset)==0) {
+         end = trace->length;
+      }
+      __sync_fetch_and_add(&trace->numDropped,1);
+      return;
+   }
+
+   asn            = &mote->ieee154e_vars.asn;
+   record         = (simtrace_record_t*)&trace->map[sizeof(simtrace_header_t)+offset];
+   record->time   = time;
+   record->arg    = arg;
+   record->mote   = mote->sim.id;
+   record->type   = type;
+   record->len    = len;
+   record->asn[0] = (uint8_t)(asn->bytes0and1>>0);
+   record->asn[1] = (uint8_t)(asn->bytes0and1>>8);
+   record->asn[2] = (uint8_t)(asn->bytes2and3>>0);
+   record->asn[3] = (uint8_t)(asn->bytes2and3>>8);
+   record->asn[4] = asn->byte4;
+   if (len>0) {
+      memcpy(&record[1],payload,len);
+   }
+}
+
+/**
+\brief Record the execution of a task by the scheduler of the mote.
+*/
+void simtrace_task(OpenMote* mote, uintptr_t task) {
+   simtrace_t* trace;
+
+   trace = mote->engine->trace;
+   if (trace==NULL) {
+      return;
+   }
+   simtrace_record(
+      mote,
+      mote->sim.worker->now,
+      SIMTRACE_TASK,
+      (uint32_t)(task-trace->imageBase),
+      NULL,
+      0
+   );
+}
+
+//===== replay
+
+/**
+\brief Load the inputs of mote traceMote from a trace.
+
+If the trace holds the boot of the mote, its EUI64 is written to eui64.
+
+\returns the inputs, NULL (with a Python exception set) on failure.
+*/
+simreplay_t* simtrace_replayOpen(const char* path, uint16_t traceMote, uint8_t* eui64) {
+   simreplay_t*              replay;
+   const simtrace_header_t*  header;
+   const simtrace_record_t*  record;
+   const simtrace_record_t** records;
+   struct stat               st;
+   uint64_t                  length;
+   uint64_t                  offset;
+   uint32_t                  maxRecords;
+   int                       fd;
+
+   replay = calloc(1,sizeof(simreplay_t));
+   if (replay==NULL) {
+      PyErr_NoMemory();
+      return NULL;
+   }
+   fd = open(path,O_RDONLY);
+   if (fd<0 || fstat(fd,&st)<0) {
+      PyErr_SetFromErrnoWithFilename(PyExc_IOError,(char*)path);
+      if (fd>=0) {
+         close(fd);
+      }
+      free(replay);
+      return NULL;
+   }
+   if ((uint64_t)st.st_size<sizeof(simtrace_header_t)) {
+      close(fd);
+      free(replay);
+      PyErr_SetString(PyExc_ValueError, "not a trace");
+      return NULL;
+   }
+   replay->size = st.st_size;
+   replay->map  = mmap(NULL,replay->size,PROT_READ,MAP_PRIVATE,fd,0);
+   close(fd);
+   if (replay->map==MAP_FAILED) {
+      free(replay);
+      PyErr_SetFromErrnoWithFilename(PyExc_IOError,(char*)path);
+      return NULL;
+   }
+
+   header = (const simtrace_header_t*)replay->map;
+   if (header->magic!=SIMTRACE_MAGIC                   ||
+       header->version!=SIMTRACE_VERSION               ||
+       header->recordLen!=sizeof(simtrace_record_t)    ||
+       header->unitsPerSec!=SIMENGINE_UNITS_PER_SEC) {
+      simtrace_replayClose(replay);
+      PyErr_SetString(PyExc_ValueError, "not a trace of this engine");
+      return NULL;
+   }
+   length = simtrace_length(replay->map,replay->size);
+
+   // keep the inputs of the mote
+   maxRecords = 0;
+   for (offset=0;offset<length;offset+=SIMTRACE_RECORD_LEN(record->len)) {
+      record = (const simtrace_record_t*)&replay->map[sizeof(simtrace_header_t)+offset];
+      if (record->mote!=traceMote) {
+         continue;
+      }
+      switch (record->type) {
+         case SIMTRACE_BOOT:
+            if (record->len==8) {
+               memcpy(eui64,&record[1],8);
+            }
+            break;
+         case SIMTRACE_RADIO_RX:
+         case SIMTRACE_RADIO_COLLISION:
+         case SIMTRACE_SERIAL_IN:
+            if (replay->numRecords==maxRecords) {
+               maxRecords = (maxRecords==0) ? 256 : 2*maxRecords;
+               records    = realloc(replay->records,maxRecords*sizeof(simtrace_record_t*));
+               if (records==NULL) {
+                  simtrace_replayClose(replay);
+                  PyErr_NoMemory();
+                  return NULL;
+               }
+               replay->records = records;
+            }
+            replay->records[replay->numRecords++] = record;
+            break;
+      }
+   }
+
+   // records are only ordered per mote when the engine ran on several threads
+   qsort(replay->records,replay->numRecords,sizeof(simtrace_record_t*),simtrace_compare);
+   return replay;
+}
+
+void simtrace_replayClose(simreplay_t* replay) {
+   if (replay==NULL) {
+      return;
+   }
+   munmap(replay->map,replay->size);
+   free(replay->records);
+   free(replay);
+}
+
+//=========================== private =========================================
+
+/**
+\brief Length of the records of a mapped trace.
+
+A trace which was not stopped (its process crashed) ends at the first zeroed
+record.
+*/
+static uint64_t simtrace_length(const uint8_t* map, uint64_t size) {
+   const simtrace_header_t* header;
+   const simtrace_record_t* record;
+   uint64_t                 max;
+   uint64_t                 offset;
+
+   header = (const simtrace_header_t*)map;
+   max    = size-sizeof(simtrace_header_t);
+   if (header->length!=0) {
+      return (header->length<max) ? header->length : max;
+   }
+   offset = 0;
+   while (offset+sizeof(simtrace_record_t)<=max) {
+      record = (const simtrace_record_t*)&map[sizeof(simtrace_header_t)+offset];
+      if (record->type==0 || offset+SIMTRACE_RECORD_LEN(record->len)>max) {
+         break;
+      }
+      offset += SIMTRACE_RECORD_LEN(record->len);
+   }
+   return offset;
+}
+
+/**
+\brief Order records by time, then by position in the trace.
+*/
+static int simtrace_compare(const void* a, const void* b) {
+   const simtrace_record_t* ra;
+   const simtrace_record_t* rb;
+
+   ra = *(const simtrace_record_t* const*)a;
+   rb = *(const simtrace_record_t* const*)b;
+   if (ra->time!=rb->time) {
+      return (ra->time<rb->time) ? -1 : 1;
+   }
+   return (ra<rb) ? -1 : (ra>rb);
+}
@@ -0,0 +1,129 @@
+/**
+\brief Binary event trace of the native simulation engine, and its replay.
+
+SimEngine.startTrace() records the events of every mote attached to the
+engine into a memory-mapped file. Each record has a fixed-size header, stamped
+with the engine time and the ASN of the mote, followed by its payload:
+- the frames each mote transmits and starts receiving (with their bytes);
+- the radiotimer and bsp_timer interrupts;
+- the tasks the scheduler executes (the offset of the task's function in the
+  module, to be resolved with nm or addr2line);
+- the packet buffers openqueue allocates and frees;
+- the boot of a mote and the bytes it reads from its serial port.
+Workers reserve space in the file with an atomic add, so recording costs a
+few stores per event and no system call. Records are written in the order
+they are reserved; with several threads, they are only ordered in time per
+mote. projects/python/simtrace.py decodes a trace.
+
+SimEngine.replay() feeds the frames one mote of a recorded run received, and
+the serial bytes it read, back into a single OpenMote, at the same engine
+times. The mote takes the EUI64 of the recorded one, so once booted at the
+same time, it goes through the same states as in the recorded run, without
+simulating its neighbors.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __SIMTRACE_H
+#define __SIMTRACE_H
+
+#include "Python.h"
+
+#include "toolchain_defs.h"
+
+//=========================== define ==========================================
+
+#define SIMTRACE_MAGIC               0x52544f57 // "WOTR"
+#define SIMTRACE_VERSION             1
+#define SIMTRACE_DEFAULT_SIZE        (256*1024*1024)
+/// records are padded to a multiple of this size
+#define SIMTRACE_ALIGN               8
+
+/// type of a record
+enum {
+   SIMTRACE_BOOT = 1,                        ///< payload: EUI64
+   SIMTRACE_RADIO_TX,                        ///< at the start of frame; arg: frequency; payload: frame
+   SIMTRACE_RADIO_RX,                        ///< at the start of frame; arg: frequency|rssi<<8; payload: frame
+   SIMTRACE_RADIO_COLLISION,                 ///< another frame corrupted the one being received
+   SIMTRACE_TIMER,                           ///< arg: SIMEVENT_*
+   SIMTRACE_TASK,                            ///< arg: offset of the task in the module
+   SIMTRACE_QUEUE_ALLOC,                     ///< arg: index|creator<<8
+   SIMTRACE_QUEUE_FREE,                      ///< arg: index|owner<<8
+   SIMTRACE_SERIAL_IN,                       ///< bytes fed to the mote; payload: bytes
+};
+
+//=========================== typedef =========================================
+
+typedef struct OpenMote  OpenMote;
+typedef struct SimEngine SimEngine;
+
+/**
+\brief Start of a trace file.
+*/
+typedef struct {
+   uint32_t                  magic;
+   uint16_t                  version;
+   uint16_t                  recordLen;      ///< sizeof(simtrace_record_t)
+   uint32_t                  unitsPerSec;    ///< of the time of the records
+   uint32_t                  reserved;
+   uint64_t                  numRecords;
+   uint64_t                  length;         ///< bytes of records following the header
+   uint64_t                  numDropped;     ///< records which did not fit
+} simtrace_header_t;
+
+/**
+\brief A record, followed by len bytes of payload and padding.
+*/
+typedef struct {
+   uint64_t                  time;           ///< engine time
+   uint32_t                  arg;
+   uint16_t                  mote;           ///< index of the mote in the engine
+   uint8_t                   type;           ///< SIMTRACE_*
+   uint8_t                   len;
+   uint8_t                   asn[5];         ///< little endian
+   uint8_t                   reserved[3];
+} simtrace_record_t;
+
+/**
+\brief A trace being recorded.
+*/
+typedef struct {
+   int                       fd;
+   uint8_t*                  map;
+   uint64_t                  size;           ///< of the mapping
+   uintptr_t                 imageBase;      ///< of the module, for SIMTRACE_TASK
+   volatile uint64_t         used;           ///< bytes reserved after the header
+   volatile uint64_t         length;         ///< end of the last record which fit
+   volatile uint64_t         numDropped;
+} simtrace_t;
+
+/**
+\brief Replay of the inputs of a recorded mote.
+*/
+typedef struct {
+   uint8_t*                  map;
+   uint64_t                  size;
+   const simtrace_record_t** records;        ///< inputs of the mote, by time
+   uint32_t                  numRecords;
+   uint32_t                  next;           ///< next record to replay
+   uint64_t                  numReplayed;
+   uint64_t                  numMissed;      ///< inputs the mote was not in a state to take
+} simreplay_t;
+
+//=========================== prototypes ======================================
+
+// recording
+int       simtrace_start(SimEngine* engine, const char* path, uint64_t size);
+int64_t   simtrace_stop(SimEngine* engine);
+void      simtrace_record(OpenMote* mote,
+                             uint64_t time,
+                             uint8_t  type,
+                             uint32_t arg,
+                             const uint8_t* payload,
+                             uint8_t  len);
+void      simtrace_task(OpenMote* mote, uintptr_t task);
+// replay
+simreplay_t* simtrace_replayOpen(const char* path, uint16_t traceMote, uint8_t* eui64);
+void      simtrace_replayClose(simreplay_t* replay);
+
+#endif
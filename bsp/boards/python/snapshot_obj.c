@@ -0,0 +1,517 @@
+/**
+\brief Snapshot and restore of the complete state of an emulated mote.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include "openwsnmodule_obj.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dlfcn.h>
+#include "snapshot_obj.h"
+
+//=========================== defines =========================================
+
+/// zero-run encoding: a literal run ends at this many zeros
+#define SNAPSHOT_MIN_ZERO_RUN        8
+#define SNAPSHOT_MAX_RUN             0xffff
+
+//=========================== variables =======================================
+
+/// parts of struct OpenMote which are saved, as [start,stop) offsets
+static const size_t snapshot_regions[][2] = {
+   // internal C callbacks
+   {offsetof(OpenMote,uart_icb),        offsetof(OpenMote,engine)},
+   // openstack, drivers, kernel and openapps
+   {offsetof(OpenMote,icmpv6echo_vars), sizeof(OpenMote)},
+};
+
+#define SNAPSHOT_NUM_REGIONS (sizeof(snapshot_regions)/sizeof(snapshot_regions[0]))
+
+/// a pointer of the saved state, or that pointer in each structure of an array
+#define SNAPSHOT_MEMBER(m)           (((OpenMote*)0)->m)
+#define SNAPSHOT_COUNT(a)            (sizeof(SNAPSHOT_MEMBER(a))/sizeof(SNAPSHOT_MEMBER(a)[0]))
+#define SNAPSHOT_PTR(f)              {offsetof(OpenMote,f),0,1,0,1}
+#define SNAPSHOT_PTRS(a,f)           {offsetof(OpenMote,a[0].f),sizeof(SNAPSHOT_MEMBER(a)[0]),SNAPSHOT_COUNT(a),0,1}
+#define SNAPSHOT_PTRS2(a,b,f)        {offsetof(OpenMote,a[0].b[0].f),sizeof(SNAPSHOT_MEMBER(a)[0]),SNAPSHOT_COUNT(a),sizeof(SNAPSHOT_MEMBER(a)[0].b[0]),SNAPSHOT_COUNT(a[0].b)}
+
+/// the pointers of an OpenQueueEntry_t
+#define SNAPSHOT_PKT_PTR(p) \
+   SNAPSHOT_PTR(p.payload), \
+   SNAPSHOT_PTR(p.big), \
+   SNAPSHOT_PTR(p.fragmentPayload), \
+   SNAPSHOT_PTR(p.l4_payload), \
+   SNAPSHOT_PTR(p.l2_payload), \
+   SNAPSHOT_PTR(p.l2_ASNpayload), \
+   SNAPSHOT_PTR(p.l2_FrameCounter)
+#define SNAPSHOT_PKT_PTRS(a) \
+   SNAPSHOT_PTRS(a,payload), \
+   SNAPSHOT_PTRS(a,big), \
+   SNAPSHOT_PTRS(a,fragmentPayload), \
+   SNAPSHOT_PTRS(a,l4_payload), \
+   SNAPSHOT_PTRS(a,l2_payload), \
+   SNAPSHOT_PTRS(a,l2_ASNpayload), \
+   SNAPSHOT_PTRS(a,l2_FrameCounter)
+
+/// the pointers of a coap_resource_desc_t
+#define SNAPSHOT_DESC_PTR(d) \
+   SNAPSHOT_PTR(d.path0val), \
+   SNAPSHOT_PTR(d.path1val), \
+   SNAPSHOT_PTR(d.callbackRx), \
+   SNAPSHOT_PTR(d.callbackSendDone), \
+   SNAPSHOT_PTR(d.next)
+
+/// the pointers in the saved parts of struct OpenMote, see snapshot_obj.h
+static const snapshot_ptr_t snapshot_ptrs[] = {
+   // internal C callbacks
+   SNAPSHOT_PTR(uart_icb.txCb),
+   SNAPSHOT_PTR(uart_icb.rxCb),
+   SNAPSHOT_PTR(bsp_timer_icb.cb),
+   SNAPSHOT_PTR(radio_icb.startFrame_cb),
+   SNAPSHOT_PTR(radio_icb.endFrame_cb),
+   SNAPSHOT_PTR(radiotimer_icb.overflow_cb),
+   SNAPSHOT_PTR(radiotimer_icb.compare_cb),
+   SNAPSHOT_PTR(sctimer_icb.cb),
+   // l4
+   SNAPSHOT_PTR(opencoap_vars.resources),
+   SNAPSHOT_PTR(tcp_vars.dataToSend),
+   SNAPSHOT_PTR(tcp_vars.dataReceived),
+   // l3
+   SNAPSHOT_PTRS(fragmentqueue_vars.queue,msg),
+   SNAPSHOT_PTRS2(fragmentqueue_vars.queue,list,fragment),
+   SNAPSHOT_PTRS(fragment_timers,pkt),
+   // l2b
+   SNAPSHOT_PTR(neighbors_vars.dio),
+   SNAPSHOT_PTRS(schedule_vars.scheduleBuf,next),
+   SNAPSHOT_PTR(schedule_vars.currentScheduleEntry),
+   // l2a
+   SNAPSHOT_PTRS(ieee802154_security_vars.MacKeyTable.KeyDescriptorElement,DeviceTable),
+   SNAPSHOT_PKT_PTR(ieee154e_vars.localCopyForTransmission),
+   SNAPSHOT_PTR(ieee154e_vars.dataToSend),
+   SNAPSHOT_PTR(ieee154e_vars.dataReceived),
+   SNAPSHOT_PTR(ieee154e_vars.ackToSend),
+   SNAPSHOT_PTR(ieee154e_vars.ackReceived),
+   // cross-layer
+   SNAPSHOT_PKT_PTRS(openqueue_vars.queue),
+   // drivers
+   SNAPSHOT_PTRS(opentimers_vars.timersBuf,callback),
+   // kernel
+   SNAPSHOT_PTRS(scheduler_vars.taskBuf,cb),
+   SNAPSHOT_PTRS(scheduler_vars.taskBuf,ctxCb),
+#ifdef ABSTIMER
+   // bsp
+   SNAPSHOT_PTR(abstimer_vars.bsp_timer_cb),
+   SNAPSHOT_PTR(abstimer_vars.overflow_cb),
+   SNAPSHOT_PTR(abstimer_vars.compare_cb),
+#endif
+   // openapps
+   SNAPSHOT_DESC_PTR(c6t_vars.desc),
+   SNAPSHOT_DESC_PTR(cexample_vars.desc),
+   SNAPSHOT_DESC_PTR(cinfo_vars.desc),
+   SNAPSHOT_DESC_PTR(cleds_vars.desc),
+   SNAPSHOT_DESC_PTR(cstorm_vars.desc),
+   SNAPSHOT_DESC_PTR(cwellknown_vars.desc),
+   SNAPSHOT_DESC_PTR(rrt_vars.desc),
+};
+
+#define SNAPSHOT_NUM_PTRS (sizeof(snapshot_ptrs)/sizeof(snapshot_ptrs[0]))
+
+//=========================== prototypes ======================================
+
+extern int mote_main(OpenMote* self);
+
+static uint32_t  snapshot_stateLen(void);
+static uint32_t  snapshot_maxRelocs(void);
+static int32_t   snapshot_stateIdx(size_t offset);
+static uintptr_t snapshot_imageBase(void);
+static uint32_t  snapshot_encode(const uint8_t* state, uint32_t len, uint8_t* out);
+static int       snapshot_decode(const uint8_t* in, uint32_t inLen, uint8_t* state, uint32_t len);
+
+//=========================== public ==========================================
+
+/**
+\brief Serialize the state of a mote.
+
+\returns a new Python string holding the snapshot, NULL with an exception set
+   on failure.
+*/
+PyObject* snapshot_take(OpenMote* self) {
+   snapshot_header_t header;
+   simsnapshot_t     sim;
+   PyObject*         blob;
+   uint8_t*          state;
+   uint8_t*          encoded;
+   uint32_t*         relocs;
+   uint8_t*          out;
+   uintptr_t         imageBase;
+   uintptr_t         moteStart;
+   uintptr_t         moteStop;
+   uintptr_t         value;
+   Dl_info           info;
+   uint32_t          stateIdx;
+   int32_t           idx;
+   const char*       error;
+   size_t            offset;
+   size_t            i;
+   size_t            j;
+   uint8_t           kind;
+   uint8_t           p;
+   uint8_t           r;
+
+   memset(&header,0,sizeof(header));
+   header.magic      = SNAPSHOT_MAGIC;
+   header.version    = SNAPSHOT_VERSION;
+   header.hasSim     = (self->engine!=NULL);
+   header.moteSize   = sizeof(OpenMote);
+   header.stateLen   = snapshot_stateLen();
+
+   imageBase         = snapshot_imageBase();
+   moteStart         = (uintptr_t)self;
+   moteStop          = moteStart+sizeof(OpenMote);
+
+   state             = malloc(header.stateLen);
+   relocs            = malloc((snapshot_maxRelocs()+1)*sizeof(uint32_t));
+   encoded           = malloc(header.stateLen+4*(header.stateLen/SNAPSHOT_MIN_ZERO_RUN+2));
+   if (state==NULL || relocs==NULL || encoded==NULL) {
+      free(state);
+      free(relocs);
+      free(encoded);
+      return PyErr_NoMemory();
+   }
+
+   // copy the state
+   stateIdx = 0;
+   for (r=0;r<SNAPSHOT_NUM_REGIONS;r++) {
+      memcpy(
+         &state[stateIdx],
+         (uint8_t*)self+snapshot_regions[r][0],
+         snapshot_regions[r][1]-snapshot_regions[r][0]
+      );
+      stateIdx += snapshot_regions[r][1]-snapshot_regions[r][0];
+   }
+
+   // turn the pointers into offsets
+   error = NULL;
+   for (p=0;p<SNAPSHOT_NUM_PTRS && error==NULL;p++) {
+      for (i=0;i<snapshot_ptrs[p].count && error==NULL;i++) {
+         for (j=0;j<snapshot_ptrs[p].count2 && error==NULL;j++) {
+            offset = snapshot_ptrs[p].offset+i*snapshot_ptrs[p].stride+j*snapshot_ptrs[p].stride2;
+            idx    = snapshot_stateIdx(offset);
+            if (idx<0) {
+               error = "is not in the saved state";
+               break;
+            }
+            memcpy(&value,&state[idx],sizeof(uintptr_t));
+            if (value==0) {
+               continue;
+            } else if (value>=moteStart && value<=moteStop) {
+               kind   = SNAPSHOT_RELOC_MOTE;
+               value -= moteStart;
+            } else if (value>=imageBase && dladdr((void*)value,&info)!=0 &&
+                       (uintptr_t)info.dli_fbase==imageBase) {
+               kind   = SNAPSHOT_RELOC_IMAGE;
+               value -= imageBase;
+            } else {
+               error = "points to neither the mote nor the module";
+               break;
+            }
+            memcpy(&state[idx],&value,sizeof(uintptr_t));
+            relocs[header.numRelocs++] = ((uint32_t)idx<<2) | kind;
+         }
+      }
+   }
+   if (error!=NULL) {
+      free(state);
+      free(relocs);
+      free(encoded);
+      PyErr_Format(PyExc_ValueError,"pointer at offset %lu of the mote %s",(unsigned long)offset,error);
+      return NULL;
+   }
+
+   header.encodedLen = snapshot_encode(state,header.stateLen,encoded);
+
+   // assemble the blob
+   blob = PyString_FromStringAndSize(
+      NULL,
+      sizeof(header)+header.numRelocs*sizeof(uint32_t)+header.encodedLen+
+      (header.hasSim ? sizeof(simsnapshot_t) : 0)
+   );
+   if (blob!=NULL) {
+      out = (uint8_t*)PyString_AS_STRING(blob);
+      memcpy(out,&header,sizeof(header));
+      out += sizeof(header);
+      memcpy(out,relocs,header.numRelocs*sizeof(uint32_t));
+      out += header.numRelocs*sizeof(uint32_t);
+      memcpy(out,encoded,header.encodedLen);
+      out += header.encodedLen;
+      if (header.hasSim) {
+         simengine_moteSave(self,&sim);
+         memcpy(out,&sim,sizeof(simsnapshot_t));
+      }
+   }
+
+   free(state);
+   free(relocs);
+   free(encoded);
+   return blob;
+}
+
+/**
+\brief Load a snapshot into a mote.
+
+The mote resumes from its scheduler loop the next time it runs: right away
+when attached to a SimEngine, at the next supply_on() otherwise.
+
+\returns 0 on success, -1 with an exception set if the blob is not a
+   snapshot of this build.
+*/
+int snapshot_restore(OpenMote* self, const uint8_t* blob, uint32_t len) {
+   snapshot_header_t header;
+   simsnapshot_t     sim;
+   const uint8_t*    in;
+   uint8_t*          state;
+   uintptr_t         value;
+   uint32_t          reloc;
+   uint32_t          offset;
+   uint32_t          stateIdx;
+   uint32_t          i;
+   uint8_t           r;
+
+   // check the blob
+   if (len<sizeof(header)) {
+      PyErr_SetString(PyExc_ValueError, "snapshot too short");
+      return -1;
+   }
+   memcpy(&header,blob,sizeof(header));
+   if (header.magic!=SNAPSHOT_MAGIC || header.version!=SNAPSHOT_VERSION) {
+      PyErr_SetString(PyExc_ValueError, "not a snapshot");
+      return -1;
+   }
+   if (header.moteSize!=sizeof(OpenMote) || header.stateLen!=snapshot_stateLen()) {
+      PyErr_SetString(PyExc_ValueError, "snapshot taken with another build");
+      return -1;
+   }
+   if ((uint64_t)len!=sizeof(header)+(uint64_t)header.numRelocs*sizeof(uint32_t)+
+                      header.encodedLen+(header.hasSim ? sizeof(simsnapshot_t) : 0)) {
+      PyErr_SetString(PyExc_ValueError, "snapshot has the wrong length");
+      return -1;
+   }
+   if (self->engine!=NULL && header.hasSim==FALSE) {
+      PyErr_SetString(PyExc_ValueError, "snapshot does not hold the state of the emulated BSP");
+      return -1;
+   }
+
+   // decode the state
+   state = malloc(header.stateLen);
+   if (state==NULL) {
+      PyErr_NoMemory();
+      return -1;
+   }
+   in = blob+sizeof(header)+header.numRelocs*sizeof(uint32_t);
+   if (snapshot_decode(in,header.encodedLen,state,header.stateLen)<0) {
+      free(state);
+      PyErr_SetString(PyExc_ValueError, "corrupted snapshot");
+      return -1;
+   }
+
+   // turn offsets back into pointers
+   in = blob+sizeof(header);
+   for (i=0;i<header.numRelocs;i++) {
+      memcpy(&reloc,&in[i*sizeof(uint32_t)],sizeof(uint32_t));
+      offset = reloc>>2;
+      if (offset+sizeof(uintptr_t)>header.stateLen) {
+         free(state);
+         PyErr_SetString(PyExc_ValueError, "corrupted snapshot");
+         return -1;
+      }
+      memcpy(&value,&state[offset],sizeof(uintptr_t));
+      switch (reloc & SNAPSHOT_RELOC_MASK) {
+         case SNAPSHOT_RELOC_MOTE:
+            value += (uintptr_t)self;
+            break;
+         case SNAPSHOT_RELOC_IMAGE:
+            value += snapshot_imageBase();
+            break;
+      }
+      memcpy(&state[offset],&value,sizeof(uintptr_t));
+   }
+
+   // overwrite the mote's state
+   stateIdx = 0;
+   for (r=0;r<SNAPSHOT_NUM_REGIONS;r++) {
+      memcpy(
+         (uint8_t*)self+snapshot_regions[r][0],
+         &state[stateIdx],
+         snapshot_regions[r][1]-snapshot_regions[r][0]
+      );
+      stateIdx += snapshot_regions[r][1]-snapshot_regions[r][0];
+   }
+   free(state);
+   
+   // all of the mote's state has changed
+   self->stateClock++;
+   for (r=0;r<STATUS_MAX;r++) {
+      self->stateGeneration[r] = self->stateClock;
+   }
+
+   // boot into the scheduler loop
+   self->restored = TRUE;
+   if (self->engine!=NULL) {
+      memcpy(&sim,blob+len-sizeof(simsnapshot_t),sizeof(simsnapshot_t));
+      simengine_moteRestore(self,&sim);
+   } else {
+      // the Python BSP restores its timers, re-anchor the cached values
+      self->notifcache.rt_running = FALSE;
+      self->notifcache.bt_running = FALSE;
+   }
+
+   return 0;
+}
+
+/**
+\brief Run the firmware of a mote which was just switched on.
+
+A restored mote skips the initialization, its state having been initialized
+by the mote the snapshot was taken from.
+*/
+void snapshot_main(OpenMote* self) {
+   if (self->restored==TRUE) {
+      self->restored = FALSE;
+      scheduler_start(self);
+   } else {
+      mote_main(self);
+   }
+}
+
+//=========================== private =========================================
+
+static uint32_t snapshot_stateLen(void) {
+   uint32_t len;
+   uint8_t  r;
+
+   len = 0;
+   for (r=0;r<SNAPSHOT_NUM_REGIONS;r++) {
+      len += snapshot_regions[r][1]-snapshot_regions[r][0];
+   }
+   return len;
+}
+
+/**
+\brief Most relocations a snapshot holds, all pointers of snapshot_ptrs being set.
+*/
+static uint32_t snapshot_maxRelocs(void) {
+   uint32_t num;
+   uint8_t  p;
+
+   num = 0;
+   for (p=0;p<SNAPSHOT_NUM_PTRS;p++) {
+      num += snapshot_ptrs[p].count*snapshot_ptrs[p].count2;
+   }
+   return num;
+}
+
+/**
+\brief Index in the state of the byte at an offset of struct OpenMote.
+
+\returns -1 if that byte is not saved.
+*/
+static int32_t snapshot_stateIdx(size_t offset) {
+   uint32_t stateIdx;
+   uint8_t  r;
+
+   stateIdx = 0;
+   for (r=0;r<SNAPSHOT_NUM_REGIONS;r++) {
+      if (offset>=snapshot_regions[r][0] && offset<snapshot_regions[r][1]) {
+         return stateIdx+offset-snapshot_regions[r][0];
+      }
+      stateIdx += snapshot_regions[r][1]-snapshot_regions[r][0];
+   }
+   return -1;
+}
+
+/**
+\brief Address the module the firmware is linked in was loaded at.
+*/
+static uintptr_t snapshot_imageBase(void) {
+   Dl_info info;
+
+   if (dladdr((void*)&snapshot_main,&info)==0) {
+      return 0;
+   }
+   return (uintptr_t)info.dli_fbase;
+}
+
+/**
+\brief Zero-run encoding of the state.
+
+The output is a sequence of (number of zeros, number of literal bytes,
+literal bytes), both counts being native uint16_t. Most of the state (empty
+queues and tables) is zeros.
+
+\returns the number of bytes written to out.
+*/
+static uint32_t snapshot_encode(const uint8_t* state, uint32_t len, uint8_t* out) {
+   uint32_t idx;
+   uint32_t outLen;
+   uint32_t zeros;
+   uint32_t start;
+   uint32_t run;
+   uint16_t count;
+
+   idx    = 0;
+   outLen = 0;
+   while (idx<len) {
+      // zeros
+      zeros = 0;
+      while (idx<len && state[idx]==0 && zeros<SNAPSHOT_MAX_RUN) {
+         idx++;
+         zeros++;
+      }
+      // literals, up to the next long enough run of zeros
+      start = idx;
+      run   = 0;
+      while (idx<len && idx-start<SNAPSHOT_MAX_RUN) {
+         run = (state[idx]==0) ? run+1 : 0;
+         idx++;
+         if (run==SNAPSHOT_MIN_ZERO_RUN) {
+            idx -= run;
+            break;
+         }
+      }
+      count = (uint16_t)zeros;
+      memcpy(&out[outLen],&count,sizeof(uint16_t));
+      count = (uint16_t)(idx-start);
+      memcpy(&out[outLen+2],&count,sizeof(uint16_t));
+      memcpy(&out[outLen+4],&state[start],idx-start);
+      outLen += 4+idx-start;
+   }
+   return outLen;
+}
+
+static int snapshot_decode(const uint8_t* in, uint32_t inLen, uint8_t* state, uint32_t len) {
+   uint32_t inIdx;
+   uint32_t idx;
+   uint16_t zeros;
+   uint16_t literals;
+
+   inIdx = 0;
+   idx   = 0;
+   while (inIdx<inLen) {
+      if (inIdx+4>inLen) {
+         return -1;
+      }
+      memcpy(&zeros,   &in[inIdx],  sizeof(uint16_t));
+      memcpy(&literals,&in[inIdx+2],sizeof(uint16_t));
+      inIdx += 4;
+      if (idx+zeros+literals>len || inIdx+literals>inLen) {
+         return -1;
+      }
+      memset(&state[idx],0,zeros);
+      idx   += zeros;
+      memcpy(&state[idx],&in[inIdx],literals);
+      idx   += literals;
+      inIdx += literals;
+   }
+   return (idx==len) ? 0 : -1;
+}
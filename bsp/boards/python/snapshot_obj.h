@@ -0,0 +1,95 @@
+/**
+\brief Snapshot and restore of the complete state of an emulated mote.
+
+OpenMote.snapshot() serializes the state of the stack, drivers and kernel
+(everything declared after the "openstack" banner of struct OpenMote, plus
+the interrupt callbacks registered with the BSP) into a binary blob.
+OpenMote.restore() loads such a blob into another OpenMote, which then
+resumes from the scheduler loop instead of booting, e.g. to fork a network
+which has already formed into several experiment runs.
+
+The state holds pointers, which are only valid for the mote they were taken
+from:
+- pointers into the OpenMote (the task list, the packets in the queue, ...)
+  are stored as offsets from the start of the OpenMote;
+- pointers into the module (the task and timer callbacks, constant tables)
+  are stored as offsets from the base address of the module.
+The pointers are listed in a table of the fields which hold one, so no other
+bytes are rewritten; a pointer field added to the state of a module must be
+added to that table, snapshot_ptrs in snapshot_obj.c. A blob can therefore
+be restored in another process, but only with the exact same build of the
+module.
+
+When the mote is attached to a SimEngine, the blob also holds the state of
+the emulated BSP (timers, radio, pending events), relative to the engine's
+current time. Otherwise, the Python BSP has to save and restore its own
+state.
+
+A snapshot is only consistent while the mote is waiting in board_sleep(),
+i.e. between two calls to SimEngine.run(), or while the Python BSP holds the
+mote in board_sleep().
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef __SNAPSHOT_H
+#define __SNAPSHOT_H
+
+#include "Python.h"
+
+#include "toolchain_defs.h"
+
+//=========================== define ==========================================
+
+#define SNAPSHOT_MAGIC               0x4e53574f // "OWSN"
+#define SNAPSHOT_VERSION             2
+
+/// kind of relocation, in the 2 low bits of an entry (offset in the state<<2)
+enum {
+   SNAPSHOT_RELOC_MOTE = 1,                  ///< pointer into the OpenMote
+   SNAPSHOT_RELOC_IMAGE = 2,                 ///< pointer into the module
+   SNAPSHOT_RELOC_MASK = 0x3,
+};
+
+//=========================== typedef =========================================
+
+typedef struct OpenMote OpenMote;
+
+/**
+\brief A pointer field of the saved state.
+
+The field is at offset+i*stride+j*stride2 in struct OpenMote, for each i
+below count and j below count2, i.e. in each structure of a (2-dimensional)
+array.
+*/
+typedef struct {
+   size_t                    offset;
+   size_t                    stride;
+   size_t                    count;
+   size_t                    stride2;
+   size_t                    count2;
+} snapshot_ptr_t;
+
+/**
+\brief Start of a snapshot.
+
+It is followed by numRelocs uint32_t relocation entries, the zero-run encoded
+state and, if hasSim is set, a simsnapshot_t.
+*/
+typedef struct {
+   uint32_t                  magic;
+   uint16_t                  version;
+   uint16_t                  hasSim;         ///< the blob holds the emulated BSP
+   uint32_t                  moteSize;       ///< sizeof(OpenMote) of the build
+   uint32_t                  stateLen;       ///< bytes of state, once decoded
+   uint32_t                  numRelocs;
+   uint32_t                  encodedLen;     ///< bytes of zero-run encoded state
+} snapshot_header_t;
+
+//=========================== prototypes ======================================
+
+PyObject* snapshot_take(OpenMote* self);
+int       snapshot_restore(OpenMote* self, const uint8_t* blob, uint32_t len);
+void      snapshot_main(OpenMote* self);
+
+#endif
@@ -15,8 +15,6 @@
 
 //=========================== public ==========================================
 
-extern int mote_main();
-
 void supply_init(OpenMote* self) {
    
 #ifdef TRACE_ON
@@ -37,7 +35,11 @@ void supply_on(OpenMote* self) {
 #endif
    
    // start the mote's execution
-   mote_main(self);
+   if (self->engine!=NULL) {
+      simengine_moteBoot(self);
+   } else {
+      snapshot_main(self);
+   }
    
 #ifdef TRACE_ON
    printf("C@0x%x: ...done.\n",self);
@@ -50,6 +52,10 @@ void supply_off(OpenMote* self) {
    printf("C@0x%x: supply_off()... \n",self);
 #endif
    
+   if (self->engine!=NULL) {
+      simengine_moteOff(self);
+   }
+   
    // TODO
    
 #ifdef TRACE_ON
@@ -37,6 +37,16 @@ void uart_init(OpenMote* self) {
    printf("C@0x%x: uart_init()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_uart_init,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_init],NULL);
    if (result == NULL) {
@@ -57,6 +67,19 @@ void uart_enableInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_enableInterrupts()... \n",self);
 #endif
    
+   self->serialring.rxEnabled = TRUE;
+   
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_uart_enableInterrupts(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_uart_enableInterrupts,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_enableInterrupts],NULL);
    if (result == NULL) {
@@ -77,6 +100,19 @@ void uart_disableInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_disableInterrupts()... \n",self);
 #endif
    
+   self->serialring.rxEnabled = FALSE;
+   
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_uart_disableInterrupts(self);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_uart_disableInterrupts,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_disableInterrupts],NULL);
    if (result == NULL) {
@@ -97,6 +133,16 @@ void uart_clearRxInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_clearRxInterrupts()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_uart_clearRxInterrupts,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_clearRxInterrupts],NULL);
    if (result == NULL) {
@@ -117,6 +163,16 @@ void uart_clearTxInterrupts(OpenMote* self) {
    printf("C@0x%x: uart_clearTxInterrupts()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_uart_clearTxInterrupts,NULL,0)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_clearTxInterrupts],NULL);
    if (result == NULL) {
@@ -143,6 +199,17 @@ void uart_writeByte(OpenMote* self, uint8_t byteToWrite) {
    printf("C@0x%x: uart_writeByte()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_uart_write(self,&byteToWrite,1);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_uart_writeByte,&byteToWrite,sizeof(byteToWrite))==TRUE) {
+      return;
+   }
+   
    // forward to Python
    arglist    = Py_BuildValue("(i)",byteToWrite);
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_writeByte],arglist);
@@ -167,6 +234,7 @@ void uart_writeCircularBuffer_FASTSIM(OpenMote* self, uint8_t* buffer, uint8_t*
    int         res;
    uint8_t     len;
    uint8_t     i;
+   uint8_t     bytes[256];
    
 #ifdef TRACE_ON
    printf("C@0x%x: uart_writeCircularBuffer_FASTSIM(buffer=%x,outputBufIdxR=%x,outputBufIdxW=%x)... \n",
@@ -177,8 +245,33 @@ void uart_writeCircularBuffer_FASTSIM(OpenMote* self, uint8_t* buffer, uint8_t*
    );
 #endif
    
-   // forward to Python
+   // the output buffer is 256 bytes long, the indexes wrap around
    len        = (*outputBufIdxW)-(*outputBufIdxR);
+   for (i=0;i<len;i++) {
+      bytes[i] = buffer[(uint8_t)(*outputBufIdxR+i)];
+   }
+   
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_uart_write(self,bytes,len);
+      *outputBufIdxR = *outputBufIdxW;
+      return;
+   }
+   
+   // serial port shared with the host
+   if (self->serialring.attached==TRUE) {
+      serialring_write(self,bytes,len);
+      *outputBufIdxR = *outputBufIdxW;
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_uart_writeCircularBuffer_FASTSIM,bytes,len)==TRUE) {
+      *outputBufIdxR = *outputBufIdxW;
+      return;
+   }
+   
+   // forward to Python
    frame      = PyList_New(len);
    i = 0;
    while (*outputBufIdxR!=*outputBufIdxW) {
@@ -226,6 +319,23 @@ void uart_writeBufferByLen_FASTSIM(OpenMote* self, uint8_t* buffer, uint8_t len)
    );
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      simengine_uart_write(self,buffer,len);
+      return;
+   }
+   
+   // serial port shared with the host
+   if (self->serialring.attached==TRUE) {
+      serialring_write(self,buffer,len);
+      return;
+   }
+   
+   // batch in notification ring
+   if (notifring_post(self,MOTE_NOTIF_uart_writeBufferByLen_FASTSIM,buffer,len)==TRUE) {
+      return;
+   }
+   
    // forward to Python
    frame      = PyList_New(len);
    if (frame==NULL) {
@@ -263,6 +373,19 @@ uint8_t uart_readByte(OpenMote* self) {
    printf("C@0x%x: uart_readByte()... \n",self);
 #endif
    
+   // native simulation engine
+   if (self->engine!=NULL) {
+      return simengine_uart_readByte(self);
+   }
+   
+   // serial port shared with the host
+   if (self->serialring.feeding==TRUE) {
+      return self->serialring.rxByte;
+   }
+   
+   // drain batched notifications first
+   notifring_flush(self);
+   
    // forward to Python
    result     = PyObject_CallObject(self->callback[MOTE_NOTIF_uart_readByte],NULL);
    if (result == NULL) {
@@ -306,6 +429,12 @@ void uart_intr_rx(OpenMote* self) {
    printf("C@0x%x: uart_intr_rx(), calling 0x%x... \n",self,self->uart_icb.txCb);
 #endif
    
+   // all the bytes the host wrote to the shared serial port
+   if (self->engine==NULL && serialring_rxPending(self)==TRUE) {
+      serialring_feed(self);
+      return;
+   }
+   
    self->uart_icb.rxCb(self);
    
 #ifdef TRACE_ON
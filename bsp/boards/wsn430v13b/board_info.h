@@ -87,6 +87,11 @@ to this board.
 
 #define SYNC_ACCURACY                       1     // ticks
 
+//===== openqueue
+
+// OpenQueueEntry_t is 240B with 16-bit pointers, 32 (the most openqueue supports) take 7680B
+#define QUEUELENGTH                         32
+
 //=========================== variables =======================================
 
 // The variables below are used by CoAP's registration engine.
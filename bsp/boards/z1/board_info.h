@@ -74,6 +74,11 @@ to return the board's description.
 
 #define SYNC_ACCURACY                       1     // ticks
 
+//===== openqueue
+
+// OpenQueueEntry_t is 240B with 16-bit pointers, 32 (the most openqueue supports) take 7680B
+#define QUEUELENGTH                         32
+
 //=========================== typedef  ========================================
 
 //=========================== variables =======================================
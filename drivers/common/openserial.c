@@ -20,6 +20,7 @@
 #include "openhdlc.h"
 #include "schedule.h"
 #include "icmpv6rpl.h"
+#include "scheduler.h"
 
 //=========================== variables =======================================
 
@@ -241,6 +242,7 @@ owerror_t openserial_printCritical(uint8_t calling_component, uint8_t error_code
    
    // schedule for the mote to reboot in 10s
    opentimers_start(10000,
+                    OPENTIMERS_SLACK_NONE,
                     TIMER_ONESHOT,TIME_MS,
                     openserial_board_reset_cb);
    
@@ -378,6 +380,14 @@ void openserial_startOutput() {
          if (debugPrint_kaPeriod()==TRUE) {
             break;
          }
+      case STATUS_SCHEDSTATS:
+         if (debugPrint_schedStats()==TRUE) {
+            break;
+         }
+      case STATUS_QUEUESTATS:
+         if (debugPrint_queueStats()==TRUE) {
+            break;
+         }
       default:
          DISABLE_INTERRUPTS();
          openserial_vars.debugPrintCounter=0;
@@ -4,6 +4,30 @@
 This driver uses a single hardware timer, which it virtualizes to support
 at most MAX_NUM_TIMERS timers.
 
+Each running timer holds the time it elapses at (its expiry), in ticks since
+opentimers_init(), a monotonic 64-bit count extending the hardware timer,
+which may be narrower; opentimers_getTime() returns it. A timer can be started
+for a time, rather than after a duration, and the MAC layer converts an ASN to
+that time (see ieee154e_asnToTime()).
+
+The running timers are kept in a min-heap ordered by expiry, so the next one
+to elapse is known in O(1) and starting or stopping a timer costs
+O(log MAX_NUM_TIMERS); the hardware timer only fires for the timer at the top
+of the heap. The same array holds the unused timers after the running ones,
+so a free timer is found in O(1) as well.
+
+A timer may be given a slack, how late after its expiry it may fire. The
+hardware timer is then scheduled at the earliest expiry plus slack among the
+timers elapsing until then, the latest time none of them is late, and all
+timers elapsed by that time fire in a single wakeup. Only the timers elapsing
+before that time are visited, the others sit below them in the heap.
+
+Time is counted from compare event to compare event, as bsp_timer_scheduleIn()
+does, so periodic timers do not drift. The hardware timer is scheduled at
+most OPENTIMERS_MAX_SCHEDULE ticks ahead, so the time elapsed since the last
+compare event can always be read from it; it fires that far ahead while no
+timer runs, to keep counting.
+
 \author Xavi Vilajosana <xvilajosana@eecs.berkeley.edu>, March 2012.
  */
 
@@ -11,17 +35,35 @@ at most MAX_NUM_TIMERS timers.
 #include "opentimers.h"
 #include "bsp_timer.h"
 #include "leds.h"
+#include "board.h"
 
 //=========================== define ==========================================
 
+// furthest the hardware timer is scheduled, so its value does not wrap around
+// before the compare interrupt is served
+#define OPENTIMERS_MAX_SCHEDULE   ((PORT_TIMER_WIDTH)(MAX_TICKS_IN_SINGLE_CLOCK-(MAX_TICKS_IN_SINGLE_CLOCK>>3)))
+
+// whether timer a elapses before timer b
+#define OPENTIMERS_EARLIER(a,b)   (opentimers_vars.timersBuf[a].expiry<opentimers_vars.timersBuf[b].expiry)
+
 //=========================== variables =======================================
 
 opentimers_vars_t opentimers_vars;
-//uint32_t counter; //counts the elapsed time.
 
 //=========================== prototypes ======================================
 
 void opentimers_timer_callback(void);
+static void opentimers_fire(void);
+static void opentimers_schedule(void);
+static uint64_t opentimers_fireTime(void);
+static void opentimers_reschedule(opentimer_id_t id);
+// heap
+static void opentimers_heapInsert(opentimer_id_t id);
+static void opentimers_heapRemove(opentimer_id_t id);
+static void opentimers_heapUpdate(opentimer_id_t id);
+static void opentimers_heapSwap(uint8_t i, uint8_t j);
+static void opentimers_siftUp(uint8_t i);
+static void opentimers_siftDown(uint8_t i);
 
 //=========================== public ==========================================
 
@@ -34,30 +76,38 @@ void opentimers_init(){
    uint8_t i;
 
    // initialize local variables
-   opentimers_vars.running=FALSE;
+   memset(&opentimers_vars,0,sizeof(opentimers_vars_t));
    for (i=0;i<MAX_NUM_TIMERS;i++) {
-      opentimers_vars.timersBuf[i].period_ticks       = 0;
-      opentimers_vars.timersBuf[i].ticks_remaining    = 0;
       opentimers_vars.timersBuf[i].type               = TIMER_ONESHOT;
       opentimers_vars.timersBuf[i].isrunning          = FALSE;
       opentimers_vars.timersBuf[i].callback           = NULL;
-      opentimers_vars.timersBuf[i].hasExpired         = FALSE;
+      // all timers are unused
+      opentimers_vars.timersBuf[i].heapIdx            = i;
+      opentimers_vars.heap[i]                         = i;
    }
+   opentimers_vars.firing=FALSE;
 
    // set callback for bsp_timers module
    bsp_timer_set_callback(opentimers_timer_callback);
+
+   // start counting
+   bsp_timer_reset();
+   opentimers_schedule();
 }
 
 /**
 \brief Start a timer.
 
 The timer works as follows:
-- currentTimeout is the number of ticks before the next timer expires.
-- if a new timer is inserted, we check that it is not earlier than the soonest
-- if it is earliest, replace it
-- if not, insert it in the list
+- it elapses duration after now, which sets its expiry
+- it is inserted in the heap of running timers
+- if it can not wait for the hardware timer to fire, the hardware timer is
+  re-scheduled
 
 \param duration Number milli-seconds after which the timer will fire.
+\param slack    How much later than <tt>duration</tt> the timer may fire, in
+   the same units, so it shares a wakeup with other timers. Use
+   #OPENTIMERS_SLACK_NONE for a timer which must fire on time.
 \param type     Type of timer:
    - #TIMER_PERIODIC for a periodic timer.
    - #TIMER_ONESHOT for a on-shot timer.
@@ -70,99 +120,84 @@ The timer works as follows:
          timer could be started.
 \returns TOO_MANY_TIMERS_ERROR if the timer could NOT be started.
  */
-opentimer_id_t opentimers_start(uint32_t duration, timer_type_t type, time_type_t timetype, opentimers_cbt callback) {
+opentimer_id_t opentimers_start(uint32_t duration, uint32_t slack, timer_type_t type, time_type_t timetype, opentimers_cbt callback) {
+   return opentimers_startAt(
+      opentimers_getTime()+opentimers_toTicks(duration,timetype),
+      duration,
+      slack,
+      type,
+      timetype,
+      callback
+   );
+}
 
-   uint8_t  id;
+/**
+\brief Start a timer elapsing at a given time.
+
+A periodic timer then elapses every period after that time, without drifting.
+A time already past elapses right away.
+
+\param time     When the timer elapses, in ticks, as opentimers_getTime().
+\param period   Period of a periodic timer, in <tt>timetype</tt> units,
+   which opentimers_restart() uses for a one-shot timer.
+\param slack    How much later the timer may fire, in <tt>timetype</tt>
+   units, see opentimers_start().
+\param type     Type of timer, see opentimers_start().
+\param timetype Units of <tt>period</tt> and <tt>slack</tt>.
+\param callback The function to call when the timer fires.
 
-   // find an unused timer
-   for (id=0; id<MAX_NUM_TIMERS && opentimers_vars.timersBuf[id].isrunning==TRUE; id++);
+\returns The id of the timer if the timer could be started.
+\returns TOO_MANY_TIMERS_ERROR if the timer could NOT be started.
+ */
+opentimer_id_t opentimers_startAt(uint64_t time, uint32_t period, uint32_t slack, timer_type_t type, time_type_t timetype, opentimers_cbt callback) {
+   opentimer_id_t id;
+   INTERRUPT_DECLARATION();
 
-   if (id<MAX_NUM_TIMERS) {
-      // we found an unused timer
+   DISABLE_INTERRUPTS();
 
-      // register the timer
-      if (timetype==TIME_MS) {
-         opentimers_vars.timersBuf[id].period_ticks      = duration*PORT_TICS_PER_MS;
-         opentimers_vars.timersBuf[id].wraps_remaining   = (duration*PORT_TICS_PER_MS/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-      } else if (timetype==TIME_TICS) {
-         opentimers_vars.timersBuf[id].period_ticks      = duration;
-         opentimers_vars.timersBuf[id].wraps_remaining   = (duration/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t  
-      } else {
-         while (1); //error
-      }
-      //if the number of ticks falls below a 16bit value, use it, otherwise set to max 16bit value
-      if(opentimers_vars.timersBuf[id].wraps_remaining==0){
-         if (timetype==TIME_MS){ 
-            opentimers_vars.timersBuf[id].ticks_remaining   = duration*PORT_TICS_PER_MS;
-         } else if (timetype==TIME_TICS) {
-            opentimers_vars.timersBuf[id].ticks_remaining   = duration;
-         } else {
-            // this should never happpen!
-   
-            // we can not print from within the drivers. Instead:
-            // blink the error LED
-            leds_error_blink();
-            // reset the board
-            board_reset();
-         }
-      }else{
-         opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
-      }                                                   
-      opentimers_vars.timersBuf[id].type              = type;
-      opentimers_vars.timersBuf[id].isrunning         = TRUE;
-      opentimers_vars.timersBuf[id].callback          = callback;
-      opentimers_vars.timersBuf[id].hasExpired        = FALSE;
+   if (opentimers_vars.heapSize==MAX_NUM_TIMERS) {
+      ENABLE_INTERRUPTS();
+      return TOO_MANY_TIMERS_ERROR;
+   }
 
-      // re-schedule the running timer, if needed
-      if (
-            (opentimers_vars.running==FALSE)
-            ||
-            (opentimers_vars.timersBuf[id].ticks_remaining < opentimers_vars.currentTimeout)
-      ) {  
-         opentimers_vars.currentTimeout            = opentimers_vars.timersBuf[id].ticks_remaining;
-         if (opentimers_vars.running==FALSE) {
-            bsp_timer_reset();
-         }
-         bsp_timer_scheduleIn(opentimers_vars.timersBuf[id].ticks_remaining);
-      }
+   // the first unused timer follows the running ones
+   id = opentimers_vars.heap[opentimers_vars.heapSize];
 
-      opentimers_vars.running                         = TRUE;
+   // register the timer
+   opentimers_vars.timersBuf[id].period_ticks         = opentimers_toTicks(period,timetype);
+   opentimers_vars.timersBuf[id].expiry               = time;
+   opentimers_vars.timersBuf[id].slack_ticks          = opentimers_toTicks(slack,timetype);
+   opentimers_vars.timersBuf[id].type                 = type;
+   opentimers_vars.timersBuf[id].isrunning            = TRUE;
+   opentimers_vars.timersBuf[id].callback             = callback;
+   opentimers_heapInsert(id);
 
-   } else {
-      return TOO_MANY_TIMERS_ERROR;
-   }
+   // re-schedule the hardware timer, if needed
+   opentimers_reschedule(id);
+
+   ENABLE_INTERRUPTS();
 
    return id;
 }
 
 /**
-\brief Replace the period of a running timer.
+\brief Replace the period of a timer.
+
+A running timer then elapses newDuration after now.
  */
 void  opentimers_setPeriod(opentimer_id_t id,time_type_t timetype,uint32_t newDuration) {
-   if        (timetype==TIME_MS) {
-      opentimers_vars.timersBuf[id].period_ticks      = newDuration*PORT_TICS_PER_MS;
-      opentimers_vars.timersBuf[id].wraps_remaining   = (newDuration*PORT_TICS_PER_MS/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-   } else if (timetype==TIME_TICS) {
-      opentimers_vars.timersBuf[id].period_ticks      = newDuration;
-      opentimers_vars.timersBuf[id].wraps_remaining   = (newDuration/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-   } else {
-      // this should never happpen!
-      
-      // we can not print from within the drivers. Instead:
-      // blink the error LED
-      leds_error_blink();
-      // reset the board
-      board_reset();
-   }
-   if(opentimers_vars.timersBuf[id].wraps_remaining==0) {
-      if        (timetype==TIME_MS){
-         opentimers_vars.timersBuf[id].ticks_remaining   = newDuration*PORT_TICS_PER_MS;
-      } else if (timetype==TIME_TICS){
-         opentimers_vars.timersBuf[id].ticks_remaining   = newDuration;
-      }
-   } else {
-      opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   opentimers_vars.timersBuf[id].period_ticks         = opentimers_toTicks(newDuration,timetype);
+   if (opentimers_vars.timersBuf[id].isrunning==TRUE) {
+      opentimers_vars.timersBuf[id].expiry            = opentimers_getTime()+opentimers_vars.timersBuf[id].period_ticks;
+      opentimers_heapUpdate(id);
+      opentimers_reschedule(id);
    }
+
+   ENABLE_INTERRUPTS();
 }
 
 /**
@@ -172,18 +207,94 @@ Sets the timer to "not running". the system recovers even if this was the next
 timer to expire.
  */
 void opentimers_stop(opentimer_id_t id) {
-   opentimers_vars.timersBuf[id].isrunning=FALSE;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   if (opentimers_vars.timersBuf[id].isrunning==TRUE) {
+      opentimers_heapRemove(id);
+      opentimers_vars.timersBuf[id].isrunning         = FALSE;
+   }
+
+   ENABLE_INTERRUPTS();
 }
 
 /**
 \brief Restart a stop timer.
 
-Sets the timer to " running".
+Sets the timer to "running", elapsing one period after now.
  */
 void opentimers_restart(opentimer_id_t id) {
-   opentimers_vars.timersBuf[id].isrunning=TRUE;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   if (opentimers_vars.timersBuf[id].isrunning==FALSE) {
+      opentimers_vars.timersBuf[id].expiry            = opentimers_getTime()+opentimers_vars.timersBuf[id].period_ticks;
+      opentimers_vars.timersBuf[id].isrunning         = TRUE;
+      opentimers_heapInsert(id);
+      opentimers_reschedule(id);
+   }
+
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Account for time during which the hardware timer was stopped.
+
+Called by the boards which stop the hardware timer while asleep, with the
+number of ticks they slept for.
+ */
+void opentimers_sleepTimeCompesation(uint16_t sleepTime) {
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   // restart counting from now
+   opentimers_vars.lastCompare       = opentimers_getTime()+sleepTime;
+   opentimers_vars.hwLastCompare     = 0;
+   bsp_timer_reset();
+
+   opentimers_fire();
+
+   ENABLE_INTERRUPTS();
 }
 
+/**
+\brief Current time, in ticks since opentimers_init().
+
+Monotonic, it does not wrap around.
+ */
+uint64_t opentimers_getTime() {
+   return opentimers_vars.lastCompare+
+      (PORT_TIMER_WIDTH)(bsp_timer_get_currentValue()-opentimers_vars.hwLastCompare);
+}
+
+/**
+\brief Convert a duration to ticks, for a time passed to opentimers_startAt().
+
+\param duration The duration, in <tt>timetype</tt> units.
+\param timetype Units of the <tt>duration</tt>, see opentimers_start().
+
+\returns The duration in ticks.
+ */
+uint32_t opentimers_toTicks(uint32_t duration, time_type_t timetype) {
+   if (timetype==TIME_MS) {
+      // exact, rather than PORT_TICS_PER_MS
+      return (uint32_t)(((uint64_t)duration*PORT_TICS_PER_S)/1000);
+   } else if (timetype==TIME_TICS) {
+      return duration;
+   } else {
+      // this should never happpen!
+
+      // we can not print from within the drivers. Instead:
+      // blink the error LED
+      leds_error_blink();
+      // reset the board
+      board_reset();
+      return 0;
+   }
+}
 
 //=========================== private =========================================
 
@@ -197,167 +308,219 @@ corresponding callback(s), and restarts the hardware timer with the next timer
 to expire.
  */
 void opentimers_timer_callback() {
-   
-   opentimer_id_t   id;
-   PORT_TIMER_WIDTH min_timeout;
-   bool             found;
-    
-   // step 1. Identify expired timers
-   for(id=0; id<MAX_NUM_TIMERS; id++) {
-      if (opentimers_vars.timersBuf[id].isrunning==TRUE) {
-
-         if(opentimers_vars.currentTimeout >= opentimers_vars.timersBuf[id].ticks_remaining) {
-            // this timer has expired
-            //check to see if we have completed the whole timer, or we're just wrapping around the max 16bit value
-            if(opentimers_vars.timersBuf[id].wraps_remaining == 0){
-               // declare as so
-               opentimers_vars.timersBuf[id].hasExpired  = TRUE;
-            }else{
-               opentimers_vars.timersBuf[id].wraps_remaining--;
-               if(opentimers_vars.timersBuf[id].wraps_remaining == 0){
-                  //if we have fully wrapped around, then set the remainring ticks to the modulus of the total ticks and the max clock value
-                  opentimers_vars.timersBuf[id].ticks_remaining = (opentimers_vars.timersBuf[id].period_ticks) % MAX_TICKS_IN_SINGLE_CLOCK;
-               }else{
-                  opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
-               }
-            }
-         } else {
-            // this timer is not expired
-
-            // update its counter
-            opentimers_vars.timersBuf[id].ticks_remaining -= opentimers_vars.currentTimeout;
-         }   
-      }
-   }
+   opentimers_vars.numWakeups++;
+   opentimers_vars.lastCompare      += opentimers_vars.currentTimeout;
+   opentimers_vars.hwLastCompare    += opentimers_vars.currentTimeout;
 
-   // step 2. call callbacks of expired timers
-   for(id=0; id<MAX_NUM_TIMERS; id++) {
-      if (opentimers_vars.timersBuf[id].hasExpired==TRUE){
+   opentimers_fire();
+}
 
-         // call the callback
-         opentimers_vars.timersBuf[id].callback(id);
-         opentimers_vars.timersBuf[id].hasExpired     = FALSE;
+/**
+\brief Call back the timers elapsed at lastCompare, then schedule the next one.
+ */
+static void opentimers_fire() {
+   opentimer_id_t id;
+   bool           shared;
+
+   opentimers_vars.firing = TRUE;
+   shared                 = FALSE;
+   while (
+         opentimers_vars.heapSize>0 &&
+         opentimers_vars.timersBuf[opentimers_vars.heap[0]].expiry<=opentimers_vars.lastCompare
+      ) {
+      id = opentimers_vars.heap[0];
 
-         // reload the timer, if applicable
-         if (opentimers_vars.timersBuf[id].type==TIMER_PERIODIC) {
-            opentimers_vars.timersBuf[id].wraps_remaining   = (opentimers_vars.timersBuf[id].period_ticks/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-            //if the number of ticks falls below a 16bit value, use it, otherwise set to max 16bit value
-            if(opentimers_vars.timersBuf[id].wraps_remaining==0)                                                
-               opentimers_vars.timersBuf[id].ticks_remaining   = opentimers_vars.timersBuf[id].period_ticks;
-            else
-               opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
+      opentimers_vars.numFired++;
+      if (shared==TRUE) {
+         // fired in the wakeup of another timer
+         opentimers_vars.numCoalesced++;
+      }
+      shared = TRUE;
 
+      // reload the timer before calling it back, which may change its period
+      if (opentimers_vars.timersBuf[id].type==TIMER_PERIODIC) {
+         if (opentimers_vars.timersBuf[id].period_ticks==0) {
+            // fire at the next compare event rather than in a loop
+            opentimers_vars.timersBuf[id].expiry = opentimers_vars.lastCompare+1;
          } else {
-            opentimers_vars.timersBuf[id].isrunning   = FALSE;
+            opentimers_vars.timersBuf[id].expiry += opentimers_vars.timersBuf[id].period_ticks;
          }
+         opentimers_siftDown(0);
+      } else {
+         opentimers_heapRemove(id);
+         opentimers_vars.timersBuf[id].isrunning = FALSE;
       }
 
+      // call the callback
+      opentimers_vars.timersBuf[id].callback(id);
    }
+   opentimers_vars.firing = FALSE;
 
-   // step 3. find the minimum remaining timeout among running timers
-   found = FALSE;
-   for(id=0;id<MAX_NUM_TIMERS;id++) {
-      if (
-            opentimers_vars.timersBuf[id].isrunning==TRUE &&
-            (
-                  found==FALSE
-                  ||
-                  opentimers_vars.timersBuf[id].ticks_remaining < min_timeout
-            )
-      ) {
-         min_timeout    = opentimers_vars.timersBuf[id].ticks_remaining;
-         found          = TRUE;
-      }
-   }
+   opentimers_schedule();
+}
+
+/**
+\brief Schedule the hardware timer for the next timers to fire.
 
-   // step 4. schedule next timeout
-   if (found==TRUE) {
+Relative to lastCompare, when the hardware timer was last scheduled from.
+ */
+static void opentimers_schedule() {
+   uint64_t timeout;
+
+   timeout = OPENTIMERS_MAX_SCHEDULE;
+   if (opentimers_vars.heapSize>0) {
       // at least one timer pending
-      opentimers_vars.currentTimeout = min_timeout;
-      bsp_timer_scheduleIn(opentimers_vars.currentTimeout);
-   } else {
-      // no more timers pending
-      opentimers_vars.running = FALSE;
+      timeout = opentimers_fireTime();
+      if (timeout<=opentimers_vars.lastCompare) {
+         // already elapsed, fire right away
+         timeout = 1;
+      } else {
+         timeout -= opentimers_vars.lastCompare;
+      }
    }
+   if (timeout>OPENTIMERS_MAX_SCHEDULE) {
+      // fire on the way, so the hardware timer does not wrap around
+      timeout = OPENTIMERS_MAX_SCHEDULE;
+   }
+   opentimers_vars.currentTimeout    = (PORT_TIMER_WIDTH)timeout;
+   bsp_timer_scheduleIn(opentimers_vars.currentTimeout);
 }
 
-void opentimers_sleepTimeCompesation(uint16_t sleepTime)
-{
-   opentimer_id_t   id;
-   PORT_TIMER_WIDTH min_timeout;
-   bool             found;
-   
-   //step 1. reCount the ticks_remain after waking up from sleep
-   for(id=0; id<MAX_NUM_TIMERS; id++)
-   {
-     if (opentimers_vars.timersBuf[id].isrunning==TRUE) 
-     {
-       if(opentimers_vars.timersBuf[id].ticks_remaining > sleepTime)
-       {
-         opentimers_vars.timersBuf[id].ticks_remaining -= sleepTime;
-       }
-       else
-       {
-         if(opentimers_vars.timersBuf[id].wraps_remaining > 0)
-         {
-           opentimers_vars.timersBuf[id].wraps_remaining--;
-           opentimers_vars.timersBuf[id].ticks_remaining += (MAX_TICKS_IN_SINGLE_CLOCK - sleepTime);
-         }
-         else
-         {
-           opentimers_vars.timersBuf[id].hasExpired  = TRUE;
-         }
-       }
-     }
-   }
-   
-   // step 2. call callbacks of expired timers
-   for(id=0; id<MAX_NUM_TIMERS; id++) {
-      if (opentimers_vars.timersBuf[id].hasExpired==TRUE){
-
-         // call the callback
-         opentimers_vars.timersBuf[id].callback(id);
-         opentimers_vars.timersBuf[id].hasExpired     = FALSE;
-
-         // reload the timer, if applicable
-         if (opentimers_vars.timersBuf[id].type==TIMER_PERIODIC) {
-            opentimers_vars.timersBuf[id].wraps_remaining   = (opentimers_vars.timersBuf[id].period_ticks/MAX_TICKS_IN_SINGLE_CLOCK);//65535=maxValue of uint16_t
-            //if the number of ticks falls below a 16bit value, use it, otherwise set to max 16bit value
-            if(opentimers_vars.timersBuf[id].wraps_remaining==0)                                                
-               opentimers_vars.timersBuf[id].ticks_remaining   = opentimers_vars.timersBuf[id].period_ticks;
-            else
-               opentimers_vars.timersBuf[id].ticks_remaining = MAX_TICKS_IN_SINGLE_CLOCK;
+/**
+\brief Latest time the next timers to elapse can fire at, none of them late.
 
-         } else {
-            opentimers_vars.timersBuf[id].isrunning   = FALSE;
-         }
+That is the earliest expiry plus slack of the timers elapsing by then. The
+heap is walked from its top, skipping the timers elapsing later, and those
+below them.
+ */
+static uint64_t opentimers_fireTime() {
+   uint8_t        stack[MAX_NUM_TIMERS];
+   uint8_t        depth;
+   uint8_t        i;
+   opentimer_id_t id;
+   uint64_t       fireTime;
+
+   id        = opentimers_vars.heap[0];
+   fireTime  = opentimers_vars.timersBuf[id].expiry+opentimers_vars.timersBuf[id].slack_ticks;
+   stack[0]  = 0;
+   depth     = 1;
+   while (depth>0) {
+      i  = stack[--depth];
+      id = opentimers_vars.heap[i];
+      if (opentimers_vars.timersBuf[id].expiry>fireTime) {
+         continue;
+      }
+      if (opentimers_vars.timersBuf[id].expiry+opentimers_vars.timersBuf[id].slack_ticks<fireTime) {
+         fireTime = opentimers_vars.timersBuf[id].expiry+opentimers_vars.timersBuf[id].slack_ticks;
       }
+      if (2*i+1<opentimers_vars.heapSize) {
+         stack[depth++] = 2*i+1;
+      }
+      if (2*i+2<opentimers_vars.heapSize) {
+         stack[depth++] = 2*i+2;
+      }
+   }
+   return fireTime;
+}
 
+/**
+\brief Re-schedule the hardware timer if timer id can not wait for it.
+
+The hardware timer can only be scheduled further from the last compare event,
+so it is reset to schedule it earlier. A timer elapsing before the hardware
+timer fires, but with enough slack to wait for it, fires in that wakeup.
+ */
+static void opentimers_reschedule(opentimer_id_t id) {
+   if (opentimers_vars.firing==TRUE) {
+      // scheduled after the callbacks
+      return;
    }
-   
-   // step 3. find the minimum remaining timeout among running timers
-   found = FALSE;
-   for(id=0;id<MAX_NUM_TIMERS;id++) {
-      if (
-            opentimers_vars.timersBuf[id].isrunning==TRUE &&
-            (
-                  found==FALSE
-                  ||
-                  opentimers_vars.timersBuf[id].ticks_remaining < min_timeout
-            )
+
+   if (
+         opentimers_vars.timersBuf[id].expiry+opentimers_vars.timersBuf[id].slack_ticks<
+         opentimers_vars.lastCompare+opentimers_vars.currentTimeout
       ) {
-         min_timeout    = opentimers_vars.timersBuf[id].ticks_remaining;
-         found          = TRUE;
+      opentimers_vars.lastCompare    = opentimers_getTime();
+      opentimers_vars.hwLastCompare  = 0;
+      bsp_timer_reset();
+      opentimers_schedule();
+   }
+}
+
+//===== heap
+
+/**
+\brief Add an unused timer to the running ones.
+ */
+static void opentimers_heapInsert(opentimer_id_t id) {
+   uint8_t i;
+
+   i = opentimers_vars.heapSize;
+   opentimers_heapSwap(i,opentimers_vars.timersBuf[id].heapIdx);
+   opentimers_vars.heapSize++;
+   opentimers_siftUp(i);
+}
+
+/**
+\brief Move a running timer to the unused ones.
+ */
+static void opentimers_heapRemove(opentimer_id_t id) {
+   uint8_t i;
+
+   i = opentimers_vars.timersBuf[id].heapIdx;
+   opentimers_vars.heapSize--;
+   opentimers_heapSwap(i,opentimers_vars.heapSize);
+   if (i<opentimers_vars.heapSize) {
+      opentimers_siftDown(i);
+      opentimers_siftUp(i);
+   }
+}
+
+/**
+\brief Restore the heap after the expiry of a running timer changed.
+ */
+static void opentimers_heapUpdate(opentimer_id_t id) {
+   opentimers_siftDown(opentimers_vars.timersBuf[id].heapIdx);
+   opentimers_siftUp(opentimers_vars.timersBuf[id].heapIdx);
+}
+
+static void opentimers_heapSwap(uint8_t i, uint8_t j) {
+   opentimer_id_t id;
+
+   id                                                 = opentimers_vars.heap[i];
+   opentimers_vars.heap[i]                            = opentimers_vars.heap[j];
+   opentimers_vars.heap[j]                            = id;
+   opentimers_vars.timersBuf[opentimers_vars.heap[i]].heapIdx = i;
+   opentimers_vars.timersBuf[opentimers_vars.heap[j]].heapIdx = j;
+}
+
+static void opentimers_siftUp(uint8_t i) {
+   uint8_t parent;
+
+   while (i>0) {
+      parent = (i-1)/2;
+      if (!OPENTIMERS_EARLIER(opentimers_vars.heap[i],opentimers_vars.heap[parent])) {
+         break;
       }
+      opentimers_heapSwap(i,parent);
+      i = parent;
    }
+}
 
-   // step 4. schedule next timeout
-   if (found==TRUE) {
-      // at least one timer pending
-      opentimers_vars.currentTimeout = min_timeout;
-      bsp_timer_scheduleIn(opentimers_vars.currentTimeout);
-   } else {
-      // no more timers pending
-      opentimers_vars.running = FALSE;
+static void opentimers_siftDown(uint8_t i) {
+   uint8_t child;
+
+   while ((child=2*i+1)<opentimers_vars.heapSize) {
+      if (
+            child+1<opentimers_vars.heapSize &&
+            OPENTIMERS_EARLIER(opentimers_vars.heap[child+1],opentimers_vars.heap[child])
+         ) {
+         child++;
+      }
+      if (!OPENTIMERS_EARLIER(opentimers_vars.heap[child],opentimers_vars.heap[i])) {
+         break;
+      }
+      opentimers_heapSwap(i,child);
+      i = child;
    }
 }
@@ -18,13 +18,43 @@
 
 //=========================== define ==========================================
 
-/// Maximum number of timers that can run concurrently
+/// Maximum number of timers that can run concurrently, at most 254
+#ifndef MAX_NUM_TIMERS
 #define MAX_NUM_TIMERS            10
+#endif
 
 #define MAX_TICKS_IN_SINGLE_CLOCK ((PORT_TIMER_WIDTH)0xFFFFFFFF)
 
+/// Frequency of the hardware timer, PORT_TICS_PER_MS is rounded: 32 or 33 is
+/// a 32768Hz crystal, other boards are taken to tick PORT_TICS_PER_MS times a ms
+#ifndef PORT_TICS_PER_S
+#if PORT_TICS_PER_MS==32 || PORT_TICS_PER_MS==33
+#define PORT_TICS_PER_S           32768
+#else
+#define PORT_TICS_PER_S           (PORT_TICS_PER_MS*1000UL)
+#endif
+#endif
+
+/// Frequency of the slot timer (radiotimer), a 32768Hz crystal on all boards,
+/// whatever the rate of the hardware timer above (k20 ticks its bsp_timer faster)
+#ifndef PORT_RADIOTIMER_TICS_PER_S
+#define PORT_RADIOTIMER_TICS_PER_S 32768
+#endif
+
+/// radiotimer ticks as opentimers ticks, rounded down, or up (_UP)
+#if PORT_TICS_PER_S==PORT_RADIOTIMER_TICS_PER_S
+#define OPENTIMERS_FROM_RADIOTIMER(t)    ((uint64_t)(t))
+#define OPENTIMERS_FROM_RADIOTIMER_UP(t) ((uint64_t)(t))
+#else
+#define OPENTIMERS_FROM_RADIOTIMER(t)    (((uint64_t)(t)*PORT_TICS_PER_S)/PORT_RADIOTIMER_TICS_PER_S)
+#define OPENTIMERS_FROM_RADIOTIMER_UP(t) (((uint64_t)(t)*PORT_TICS_PER_S+PORT_RADIOTIMER_TICS_PER_S-1)/PORT_RADIOTIMER_TICS_PER_S)
+#endif
+
 #define TOO_MANY_TIMERS_ERROR     255
 
+/// Slack of a timer which must fire when it elapses
+#define OPENTIMERS_SLACK_NONE     0
+
 #define opentimer_id_t uint8_t
 
 typedef void (*opentimers_cbt)(opentimer_id_t id);
@@ -43,36 +73,51 @@ typedef enum {
 } time_type_t;
 
 typedef struct {
+   uint64_t             expiry;             // when the timer elapses, in ticks since opentimers_init()
    uint32_t             period_ticks;       // total number of clock ticks
-   PORT_TIMER_WIDTH     ticks_remaining;    // ticks remaining before elapses
-   uint16_t             wraps_remaining;    // the clock register is 16 bit, and can't count beyond 32k...
-                                            // so period_ticks = wraps_remaining*(32k or uint16_t)
+   uint32_t             slack_ticks;        // how late after expiry it may fire, to share a wakeup
    timer_type_t         type;               // periodic or one-shot
    bool                 isrunning;          // is running?
    opentimers_cbt       callback;           // function to call when elapses
-   bool                 hasExpired;         // whether the callback has to be called
+   uint8_t              heapIdx;            // position in opentimers_vars.heap, if running
 } opentimers_t;
 
 //=========================== module variables ================================
 
 typedef struct {
    opentimers_t         timersBuf[MAX_NUM_TIMERS];
-   bool                 running;
-   PORT_TIMER_WIDTH     currentTimeout; // current timeout, in ticks
+   opentimer_id_t       heap[MAX_NUM_TIMERS]; // running timers, a min-heap on expiry
+   uint8_t              heapSize;
+   bool                 firing;         // the elapsed timers are being called back
+   uint64_t             lastCompare;    // time of the last compare event, or reset
+   PORT_TIMER_WIDTH     hwLastCompare;  // hardware timer value at lastCompare
+   PORT_TIMER_WIDTH     currentTimeout; // current timeout, in ticks after lastCompare
+   uint32_t             numWakeups;     // compare events of the hardware timer
+   uint32_t             numFired;       // timers called back
+   uint32_t             numCoalesced;   // timers called back in the wakeup of another timer
 } opentimers_vars_t;
 
 //=========================== prototypes ======================================
 
 void           opentimers_init(void);
 opentimer_id_t opentimers_start(uint32_t       duration,
+                                uint32_t       slack,
                                 timer_type_t   type,
                                 time_type_t timetype,
                                 opentimers_cbt callback);
+opentimer_id_t opentimers_startAt(uint64_t       time,
+                                  uint32_t       period,
+                                  uint32_t       slack,
+                                  timer_type_t   type,
+                                  time_type_t    timetype,
+                                  opentimers_cbt callback);
 void           opentimers_setPeriod(opentimer_id_t id,time_type_t timetype, uint32_t       newPeriod);
 void           opentimers_stop(opentimer_id_t id);
 void           opentimers_restart(opentimer_id_t id);
 
 void           opentimers_sleepTimeCompesation(uint16_t sleepTime);
+uint64_t       opentimers_getTime(void);
+uint32_t       opentimers_toTicks(uint32_t duration, time_type_t timetype);
 
 /**
 \}
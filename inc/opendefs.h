@@ -113,7 +113,9 @@ enum {
    STATUS_QUEUE                        =  8,
    STATUS_NEIGHBORS                    =  9,
    STATUS_KAPERIOD                     = 10,
-   STATUS_MAX                          = 11,
+   STATUS_SCHEDSTATS                   = 11,
+   STATUS_QUEUESTATS                   = 12,
+   STATUS_MAX                          = 13,
 };
 
 //component identifiers
@@ -252,6 +254,7 @@ enum {
    // fragmentation
    ERR_FRAG_RESERVING                  = 0x3c, // trying to get an used fragment
    ERR_FREEING_BIG                     = 0x3d, // trying to free an unused big packet
+   ERR_FRAGMENT_LENGTH                 = 0x3e, // fragment payload not in the entry, length {0}, fragment length {1}
    ERR_NO_FREE_FRAGMENT_BUFFER         = 0x2c, // no free fragment buffer
    ERR_INPUTBUFFER_OVERLAPS            = 0x2d, // incoming fragment overlaps with previously received one
    ERR_EXPIRED_TIMER                   = 0x2e, // fragment timer expired
@@ -289,21 +292,30 @@ END_PACK
 
 typedef struct {
    //admin
+   uint8_t*      payload;                        // pointer to the start of the payload within 'packet'
+   uint8_t*      big;                            // pointer to the run of big packet segments, if used
+   uint8_t*      fragmentPayload;                // payload of a 6LoWPAN fragment, sent behind 'payload' from its big packet
+   uint16_t      length;                         // length in bytes of the payload, with 'fragmentLength'
+   uint8_t       fragmentLength;                 // length in bytes of 'fragmentPayload', counted in 'length'
+   // when 'fragmentPayload' is set, only the first length-fragmentLength bytes
+   // of the payload are at 'payload', the rest being at 'fragmentPayload'.
+   // Only packetfunctions_duplicatePacket() reads such a payload, into one buffer
    uint8_t       creator;                        // the component which called getFreePacketBuffer()
    uint8_t       owner;                          // the component which currently owns the entry
-   uint8_t*      payload;                        // pointer to the start of the payload within 'packet'
-   uint16_t      length;                         // length in bytes of the payload
    //l4
-   uint8_t       l4_protocol;                    // l4 protocol to be used
-   bool          l4_protocol_compressed;         // is the l4 protocol header compressed?
-   uint16_t      l4_sourcePortORicmpv6Type;      // l4 source port
-   uint16_t      l4_destination_port;            // l4 destination port
    uint8_t*      l4_payload;                     // pointer to the start of the payload of l4 (used for retransmits)
    uint16_t      l4_length;                      // length of the payload of l4 (used for retransmits)
+   uint16_t      l4_sourcePortORicmpv6Type;      // l4 source port
+   uint16_t      l4_destination_port;            // l4 destination port
+   uint8_t       l4_protocol;                    // l4 protocol to be used
+   bool          l4_protocol_compressed;         // is the l4 protocol header compressed?
    //l3
    open_addr_t   l3_destinationAdd;              // 128b IPv6 destination (down stack) 
    open_addr_t   l3_sourceAdd;                   // 128b IPv6 source address 
    //l2
+   uint8_t*      l2_payload;                     // pointer to the start of the payload of l2 (used for MAC to fill in ASN in ADV)
+   uint8_t*      l2_ASNpayload;                  // pointer to the ASN in EB
+   int16_t       l2_timeCorrection;              // record the timeCorrection and print out at endOfslot
    owerror_t     l2_sendDoneError;               // outcome of trying to send this packet
    open_addr_t   l2_nextORpreviousHop;           // 64b IEEE802.15.4 next (down stack) or previous (up) hop address
    uint8_t       l2_frameType;                   // beacon, data, ack, cmd
@@ -311,30 +323,23 @@ typedef struct {
    uint8_t       l2_retriesLeft;                 // number Tx retries left before packet dropped (dropped when hits 0)
    uint8_t       l2_numTxAttempts;               // number Tx attempts
    asn_t         l2_asn;                         // at what ASN the packet was Tx'ed or Rx'ed
-   uint8_t*      l2_payload;                     // pointer to the start of the payload of l2 (used for MAC to fill in ASN in ADV)
-   uint8_t*      l2_scheduleIE_cellObjects;      // pointer to the start of cell Objects in scheduleIE
-   uint8_t       l2_scheduleIE_numOfCells;       // number of cells were going to be scheduled or removed.
-   uint8_t       l2_scheduleIE_frameID;          // frameID in scheduleIE
-   uint8_t*      l2_ASNpayload;                  // pointer to the ASN in EB
+   asn_t         l2_enqueueAsn;                  // at what ASN the packet was queued for the MAC
    uint8_t       l2_joinPriority;                // the join priority received in EB
    bool          l2_IEListPresent;               //did have IE field?
    bool          l2_payloadIEpresent;            // did I have payload IE field
    bool          l2_joinPriorityPresent;
-   int16_t       l2_timeCorrection;              // record the timeCorrection and print out at endOfslot
    //layer-2 security
+   uint8_t*      l2_FrameCounter;                //pointer to the FrameCounter in the MAC header
    uint8_t       l2_securityLevel;               //the security level specified for the current frame
    uint8_t       l2_keyIdMode;                   //the key Identifier mode specified for the current frame
    uint8_t       l2_keyIndex;                    //the key Index specified for the current frame
-   open_addr_t   l2_keySource;                   //the key Source specified for the current frame
    uint8_t       l2_authenticationLength;        //the length of the authentication field
    uint8_t       commandFrameIdentifier;         //used in case of Command Frames
-   uint8_t*      l2_FrameCounter;                //pointer to the FrameCounter in the MAC header
    //l1 (drivers)
    uint8_t       l1_txPower;                     // power for packet to Tx at
    int8_t        l1_rssi;                        // RSSI of received packet
    uint8_t       l1_lqi;                         // LQI of received packet
    bool          l1_crc;                         // did received packet pass CRC check?
-   uint8_t*      big;                            // pointer to a big packet buffer struct, if used
    //the packet
    uint8_t       packet[1+1+125+2+1];            // 1B spi address, 1B length, 125B data, 2B CRC, 1B LQI
 } OpenQueueEntry_t;
@@ -66,38 +66,6 @@
 #ifndef FREERTOS_CONFIG_H
 #define FREERTOS_CONFIG_H
 
-#include <msp430x44x.h>
-
-/*
-Two interrupt examples are provided -
-
- + Method 1 does everything in C code.
- + Method 2 uses an assembly file wrapper.
-
-Code size:
-Method 1 uses assembly macros to save and restore the task context, whereas
-method 2 uses functions. This means method 1 will be faster, but method 2 will
-use less code space.
-
-Simplicity:
-Method 1 is very simplistic, whereas method 2 is more elaborate. This
-elaboration results in the code space saving, but also requires a slightly more
-complex procedure to define interrupt service routines.
-
-Interrupt efficiency:
-Method 1 uses the compiler generated function prologue and epilogue code to save
-and restore the necessary registers within an interrupt service routine (other
-than the RTOS tick ISR). Should a context switch be required from within the ISR
-the entire processor context is saved. This can result in some registers being saved
-twice - once by the compiler generated code, and then again by the FreeRTOS code.
-Method 2 saves and restores all the processor registers within each interrupt service
-routine, whether or not a context switch actually occurs. This means no registers
-ever get saved twice, but imposes an overhead on the occasions that no context switch
-occurs.
-*/
-
-#define configINTERRUPT_EXAMPLE_METHOD 1
-
 /*-----------------------------------------------------------
  * Application specific definitions.
  *
@@ -110,19 +78,22 @@ occurs.
  * See http://www.freertos.org/a00110.html.
  *----------------------------------------------------------*/
 
-#define configUSE_PREEMPTION		1
-#define configUSE_IDLE_HOOK			1
+/* The tasks of the OpenWSN stack run to completion: FreeRTOS is cooperative,
+see kernel/freertos/scheduler.c. */
+#define configUSE_PREEMPTION		0
+#define configUSE_IDLE_HOOK			0
 #define configUSE_TICK_HOOK			0
-#define configCPU_CLOCK_HZ			( ( unsigned long ) 7995392 ) /* Clock setup from main.c in the demo application. */
 #define configTICK_RATE_HZ			( ( TickType_t ) 1000 )
 #define configMAX_PRIORITIES		( 4 )
-#define configMINIMAL_STACK_SIZE	( ( unsigned short ) 50 )
-#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 1700 ) )
 #define configMAX_TASK_NAME_LEN		( 8 )
 #define configUSE_TRACE_FACILITY	0
-#define configUSE_16_BIT_TICKS		1
 #define configIDLE_SHOULD_YIELD		1
 
+/* The idle task sleeps with the tick suppressed, until the next interrupt. */
+extern void scheduler_sleep( uint32_t xExpectedIdleTime );
+#define configUSE_TICKLESS_IDLE		2
+#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) scheduler_sleep( ( uint32_t ) ( xExpectedIdleTime ) )
+
 /* Co-routine definitions. */
 #define configUSE_CO_ROUTINES 		0
 #define configMAX_CO_ROUTINE_PRIORITIES ( 2 )
@@ -134,9 +105,85 @@ to exclude the API function. */
 #define INCLUDE_uxTaskPriorityGet			0
 #define INCLUDE_vTaskDelete					1
 #define INCLUDE_vTaskCleanUpResources		0
-#define INCLUDE_vTaskSuspend				0
+#define INCLUDE_vTaskSuspend				1	/* required by the tickless idle */
 #define INCLUDE_vTaskDelayUntil				1
 #define INCLUDE_vTaskDelay					1
 #define INCLUDE_uxTaskGetStackHighWaterMark 0
 
+#if defined( __MSP430__ )
+
+	#include <msp430x44x.h>
+
+	/*
+	Two interrupt examples are provided -
+
+	 + Method 1 does everything in C code.
+	 + Method 2 uses an assembly file wrapper.
+
+	Code size:
+	Method 1 uses assembly macros to save and restore the task context, whereas
+	method 2 uses functions. This means method 1 will be faster, but method 2 will
+	use less code space.
+
+	Simplicity:
+	Method 1 is very simplistic, whereas method 2 is more elaborate. This
+	elaboration results in the code space saving, but also requires a slightly more
+	complex procedure to define interrupt service routines.
+
+	Interrupt efficiency:
+	Method 1 uses the compiler generated function prologue and epilogue code to save
+	and restore the necessary registers within an interrupt service routine (other
+	than the RTOS tick ISR). Should a context switch be required from within the ISR
+	the entire processor context is saved. This can result in some registers being saved
+	twice - once by the compiler generated code, and then again by the FreeRTOS code.
+	Method 2 saves and restores all the processor registers within each interrupt service
+	routine, whether or not a context switch actually occurs. This means no registers
+	ever get saved twice, but imposes an overhead on the occasions that no context switch
+	occurs.
+	*/
+
+	#define configINTERRUPT_EXAMPLE_METHOD 1
+
+	#define configCPU_CLOCK_HZ			( ( unsigned long ) 7995392 ) /* Clock setup from main.c in the demo application. */
+	#define configMINIMAL_STACK_SIZE	( ( unsigned short ) 50 )
+	#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 1700 ) )
+	#define configUSE_16_BIT_TICKS		1
+
+	/* The tick is not stopped while asleep: its interrupt wakes the CPU up,
+	then the idle task puts it back to sleep. */
+	#define configSTOP_TICK()
+	#define configSTART_TICK()
+
+#elif defined( __arm__ )
+
+	extern uint32_t SystemCoreClock;
+	#define configCPU_CLOCK_HZ			( SystemCoreClock )
+	#define configMINIMAL_STACK_SIZE	( ( unsigned short ) 128 )
+	#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 4096 ) )
+	#define configUSE_16_BIT_TICKS		0
+
+	/* Lowest priority for the kernel interrupts, the interrupts calling
+	FreeRTOS functions must not be above priority 5 (on 3 priority bits). */
+	#define configKERNEL_INTERRUPT_PRIORITY			255
+	#define configMAX_SYSCALL_INTERRUPT_PRIORITY	191
+
+	/* Stop the SysTick while asleep. */
+	#define configSTOP_TICK()			( *( ( volatile uint32_t * ) 0xe000e010 ) &= ~1UL )
+	#define configSTART_TICK()			( *( ( volatile uint32_t * ) 0xe000e010 ) |= 1UL )
+
+#else
+
+	/* posix board, see kernel/freertos/posix/portmacro.h */
+	#define configCPU_CLOCK_HZ			( ( unsigned long ) 1000000 )
+	#define configMINIMAL_STACK_SIZE	( ( unsigned short ) 16 )
+	#define configTOTAL_HEAP_SIZE		( ( size_t ) ( 0 ) ) /* heap_3.c uses malloc() */
+	#define configUSE_16_BIT_TICKS		0
+	#define configPOSIX_STACK_SIZE		( 64 * 1024 )
+
+	/* There is no tick interrupt. */
+	#define configSTOP_TICK()
+	#define configSTART_TICK()
+
+#endif
+
 #endif /* FREERTOS_CONFIG_H */
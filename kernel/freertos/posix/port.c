@@ -0,0 +1,111 @@
+/**
+\brief FreeRTOS port to the posix board, see portmacro.h.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#include <stdlib.h>
+#include <ucontext.h>
+#include "FreeRTOS.h"
+#include "task.h"
+
+//=========================== define ==========================================
+
+#ifndef configPOSIX_STACK_SIZE
+   #define configPOSIX_STACK_SIZE    (64*1024)
+#endif
+
+//=========================== typedef =========================================
+
+/**
+\brief Context of a task, what FreeRTOS sees as its top of stack.
+*/
+typedef struct {
+   ucontext_t                context;
+   TaskFunction_t            code;
+   void*                     params;
+} portTask_t;
+
+//=========================== variables =======================================
+
+// the first member of the TCB is the top of stack, i.e. the portTask_t
+extern void* volatile pxCurrentTCB;
+
+static ucontext_t port_mainContext;
+
+//=========================== prototypes ======================================
+
+static void        prvTaskStart(void);
+static portTask_t* prvCurrentTask(void);
+
+//=========================== public ==========================================
+
+/**
+\brief Set up the context of a new task.
+
+The stack allocated by FreeRTOS is not used: the task runs on a host stack of
+configPOSIX_STACK_SIZE bytes, as the libc and the posix BSP need more than
+the stack sizes FreeRTOS is configured with.
+*/
+StackType_t* pxPortInitialiseStack(StackType_t* pxTopOfStack, TaskFunction_t pxCode, void* pvParameters) {
+   portTask_t* task;
+
+   (void)pxTopOfStack;
+
+   task = (portTask_t*)malloc(sizeof(portTask_t));
+   if (task==NULL || getcontext(&task->context)!=0) {
+      abort();
+   }
+   task->code                       = pxCode;
+   task->params                     = pvParameters;
+   task->context.uc_stack.ss_sp     = malloc(configPOSIX_STACK_SIZE);
+   task->context.uc_stack.ss_size   = configPOSIX_STACK_SIZE;
+   task->context.uc_link            = &port_mainContext;
+   if (task->context.uc_stack.ss_sp==NULL) {
+      abort();
+   }
+   makecontext(&task->context,prvTaskStart,0);
+
+   return (StackType_t*)task;
+}
+
+/**
+\brief Run the first task, returns once vPortEndScheduler() is called.
+*/
+BaseType_t xPortStartScheduler(void) {
+   swapcontext(&port_mainContext,&prvCurrentTask()->context);
+   return pdFALSE;
+}
+
+void vPortEndScheduler(void) {
+   swapcontext(&prvCurrentTask()->context,&port_mainContext);
+}
+
+/**
+\brief Switch to the task FreeRTOS selects, if not the running one.
+*/
+void vPortYield(void) {
+   portTask_t* from;
+   portTask_t* to;
+
+   from = prvCurrentTask();
+   vTaskSwitchContext();
+   to   = prvCurrentTask();
+
+   if (to!=from) {
+      swapcontext(&from->context,&to->context);
+   }
+}
+
+//=========================== private =========================================
+
+static void prvTaskStart(void) {
+   portTask_t* task;
+
+   task = prvCurrentTask();
+   task->code(task->params);
+}
+
+static portTask_t* prvCurrentTask(void) {
+   return *(portTask_t**)pxCurrentTCB;
+}
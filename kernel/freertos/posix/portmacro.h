@@ -0,0 +1,70 @@
+/**
+\brief FreeRTOS port to the posix board.
+
+Each FreeRTOS task runs on a stack of its own, allocated from the host heap,
+and switches to another task only when it yields or blocks, using the POSIX
+ucontext calls. There is no tick interrupt: FreeRTOS must be cooperative and
+tickless (see FreeRTOSConfig.h), its tick is stepped by the time spent asleep.
+
+As the interrupts of the posix board are only raised from board_sleep(),
+called from the idle task, interrupts never need to be masked, and the
+critical sections are empty.
+
+\author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2026.
+*/
+
+#ifndef PORTMACRO_H
+#define PORTMACRO_H
+
+#include <stdint.h>
+
+//=========================== define ==========================================
+
+#define portCHAR                  char
+#define portFLOAT                 float
+#define portDOUBLE                double
+#define portLONG                  long
+#define portSHORT                 short
+#define portSTACK_TYPE            uintptr_t
+#define portBASE_TYPE             long
+
+#if( configUSE_16_BIT_TICKS == 1 )
+   #error the posix port uses 32-bit ticks
+#endif
+#define portMAX_DELAY             ( TickType_t ) 0xffffffffUL
+
+#define portSTACK_GROWTH          ( -1 )
+#define portTICK_PERIOD_MS        ( ( TickType_t ) 1000 / configTICK_RATE_HZ )
+#define portBYTE_ALIGNMENT        8
+#define portPOINTER_SIZE_TYPE     uintptr_t
+
+// scheduler utilities
+#define portYIELD()               vPortYield()
+#define portEND_SWITCHING_ISR(x)  ( void ) ( x )
+#define portYIELD_FROM_ISR(x)     portEND_SWITCHING_ISR( x )
+
+// critical sections
+#define portSET_INTERRUPT_MASK_FROM_ISR()     0
+#define portCLEAR_INTERRUPT_MASK_FROM_ISR(x)  ( void ) ( x )
+#define portDISABLE_INTERRUPTS()
+#define portENABLE_INTERRUPTS()
+#define portENTER_CRITICAL()
+#define portEXIT_CRITICAL()
+
+#define portTASK_FUNCTION_PROTO( vFunction, pvParameters ) void vFunction( void *pvParameters )
+#define portTASK_FUNCTION( vFunction, pvParameters ) void vFunction( void *pvParameters )
+
+#define portNOP()
+
+//=========================== typedef =========================================
+
+typedef portSTACK_TYPE StackType_t;
+typedef long           BaseType_t;
+typedef unsigned long  UBaseType_t;
+typedef uint32_t       TickType_t;
+
+//=========================== prototypes ======================================
+
+void vPortYield(void);
+
+#endif
@@ -1,5 +1,18 @@
 /**
-\brief Task scheduler.
+\brief FreeRTOS scheduler.
+
+The tasks pushed by the stack are run by FreeRTOS tasks, the workers, each
+serving a range of task_prio_t with a FreeRTOS priority mirroring it. Within a
+worker, the tasks run in the same order as with OpenOS, kept in the same
+per-priority queues. The MAC keeps running in interrupt context, above all the
+workers.
+
+FreeRTOS is cooperative (configUSE_PREEMPTION is 0): the stack expects its
+tasks to run to completion, so a worker yields between tasks rather than
+being preempted in the middle of one. When no worker has a task to run, the
+idle task puts the CPU to sleep until the next interrupt, with the FreeRTOS
+tick suppressed (configUSE_TICKLESS_IDLE): the CPU is woken by the slot timer
+and by the timer opentimers schedules, as with OpenOS.
 
 \author Thomas Watteyne <watteyne@eecs.berkeley.edu>, October 2014.
 */
@@ -9,26 +22,499 @@
 #include "board.h"
 #include "debugpins.h"
 #include "leds.h"
+#include "bsp_timer.h"
+#include "opentimers.h"
+#include "openserial.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+
+//=========================== define ==========================================
+
+#if TASK_LIST_DEPTH>16 || TASKPRIO_MAX>16
+   #error the bitmaps of the scheduler hold at most 16 entries
+#endif
+
+#if configUSE_PREEMPTION!=0
+   #error the tasks of the stack run to completion, FreeRTOS must be cooperative
+#endif
+
+// bit of priority or task container i in a bitmap, the first one is the MSB
+#define SCHEDULER_BIT(i)          ((uint16_t)(0x8000>>(i)))
+
+// task priorities first to last, as a bitmap
+#define SCHEDULER_PRIOS(first,last) ((uint16_t)((0xffff>>(first))&(0xffff<<(15-(last)))))
+
+#define SCHEDULER_NUM_WORKERS     3
+
+// time source of the instrumentation, see the OpenOS scheduler
+#define SCHEDSTATS_NOW()          ((PORT_TIMER_WIDTH)opentimers_getTime())
+
+//=========================== typedef =========================================
+
+typedef struct {
+   const char*                    name;
+   uint16_t                       prios;     // task priorities served, as a bitmap
+   UBaseType_t                    priority;  // FreeRTOS priority
+} scheduler_worker_t;
 
 //=========================== variables =======================================
 
 scheduler_vars_t scheduler_vars;
 scheduler_dbg_t  scheduler_dbg;
 
+static const scheduler_worker_t scheduler_workers[SCHEDULER_NUM_WORKERS] = {
+   // tasks triggered by the radio, right below the MAC
+   { "sixtop", SCHEDULER_PRIOS(TASKPRIO_SIXTOP_NOTIF_RX,TASKPRIO_SIXTOP_NOTIF_TXDONE), tskIDLE_PRIORITY+3 },
+   // tasks triggered by timers
+   { "stack",  SCHEDULER_PRIOS(TASKPRIO_SIXTOP,TASKPRIO_OTF),                         tskIDLE_PRIORITY+2 },
+   // tasks triggered by other interrupts
+   { "other",  SCHEDULER_PRIOS(TASKPRIO_BUTTON,TASKPRIO_MAX-1),                       tskIDLE_PRIORITY+1 },
+};
+
+// given when a task is pushed to the worker
+static SemaphoreHandle_t scheduler_workerSem[SCHEDULER_NUM_WORKERS];
+
 //=========================== prototypes ======================================
 
+static void scheduler_worker(void* pvParameters);
+static bool scheduler_runTask(uint16_t prios);
+static void scheduler_push(task_cbt cb, task_ctx_cbt ctxCb, uintptr_t ctx, task_prio_t prio, uint8_t flags, uint16_t duration, PORT_TIMER_WIDTH deadline);
+static port_INLINE uint8_t scheduler_clz(uint16_t bitmap);
+#ifdef SCHEDULER_STATS
+static void scheduler_stats_record(schedstats_hist_t* hist, PORT_TIMER_WIDTH duration);
+#endif
+
 //=========================== public ==========================================
 
-void scheduler_init() {   
-   // TODO: fill in as part of FW-16.
+void scheduler_init() {
+   uint8_t prio;
+   uint8_t w;
+
+   // initialization module variables
+   memset(&scheduler_vars,0,sizeof(scheduler_vars_t));
+   memset(&scheduler_dbg,0,sizeof(scheduler_dbg_t));
+
+   // all task containers are free, no task is ready
+   scheduler_vars.freeBitmap = (uint16_t)(0xffff<<(16-TASK_LIST_DEPTH));
+   for (prio=0;prio<TASKPRIO_MAX;prio++) {
+      scheduler_vars.taskFifo[prio].head = TASK_NONE;
+      scheduler_vars.taskFifo[prio].tail = TASK_NONE;
+   }
+
+   // create the workers, which start running in scheduler_start()
+   for (w=0;w<SCHEDULER_NUM_WORKERS;w++) {
+      scheduler_workerSem[w] = xSemaphoreCreateBinary();
+      if (
+            scheduler_workerSem[w]==NULL ||
+            xTaskCreate(
+               scheduler_worker,
+               scheduler_workers[w].name,
+               configMINIMAL_STACK_SIZE,
+               (void*)&scheduler_workers[w],
+               scheduler_workers[w].priority,
+               NULL
+            )!=pdPASS
+         ) {
+         // out of FreeRTOS heap, see configTOTAL_HEAP_SIZE
+         leds_error_blink();
+         board_reset();
+      }
+   }
+
+   // enable the scheduler's interrupt so SW can wake up the scheduler
+   SCHEDULER_ENABLE_INTERRUPT();
 }
 
 void scheduler_start() {
-   // TODO: fill in as part of FW-16.
+   vTaskStartScheduler();
 }
 
  void scheduler_push_task(task_cbt cb, task_prio_t prio) {
-   // TODO: fill in as part of FW-16.
+   scheduler_push(cb,NULL,0,prio,TASK_FLAG_NONE,TASK_DURATION_NONE,0);
+}
+
+void scheduler_push_task_flags(task_cbt cb, task_prio_t prio, uint8_t flags) {
+   scheduler_push(cb,NULL,0,prio,flags,TASK_DURATION_NONE,0);
+}
+
+void scheduler_push_task_ctx(task_ctx_cbt cb, task_prio_t prio, uintptr_t ctx, uint8_t flags) {
+   scheduler_push(NULL,cb,ctx,prio,flags,TASK_DURATION_NONE,0);
+}
+
+/**
+\brief Push a task which declares how long it runs, and by when it must start.
+
+The workers do not defer such tasks to the idle slots as OpenOS does, as a
+worker waiting for a slot boundary would need the FreeRTOS tick, suppressed
+while asleep.
+*/
+void scheduler_push_task_deadline(task_cbt cb, task_prio_t prio, uint16_t duration, PORT_TIMER_WIDTH deadline) {
+   scheduler_push(cb,NULL,0,prio,TASK_FLAG_NONE,duration,deadline);
+}
+
+/**
+\brief Put the CPU to sleep until the next interrupt, from the idle task.
+
+Called by FreeRTOS, with the scheduler suspended, as portSUPPRESS_TICKS_AND_SLEEP()
+(see FreeRTOSConfig.h). The FreeRTOS tick is not needed to wake up: the
+workers wait for tasks without a timeout, the slot timer and the timer of
+opentimers wake the CPU up. It is stepped by the time spent asleep, read from
+opentimers, as the bsp_timer is reset when opentimers reschedules.
+*/
+void scheduler_sleep(uint32_t xExpectedIdleTime) {
+   PORT_TIMER_WIDTH sleepTime;
+   PORT_TIMER_WIDTH wakeTime;
+   uint32_t         elapsed;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   // an interrupt pushed a task since the idle task decided to sleep
+   if (eTaskConfirmSleepModeStatus()==eAbortSleep) {
+      ENABLE_INTERRUPTS();
+      return;
+   }
+
+   sleepTime                      = (PORT_TIMER_WIDTH)opentimers_getTime();
+#ifdef SCHEDULER_STATS
+   scheduler_dbg.ticksAwake      += (PORT_TIMER_WIDTH)(sleepTime-scheduler_dbg.wakeTime);
+#endif
+
+   debugpins_task_clr();
+   configSTOP_TICK();
+   board_sleep();
+   configSTART_TICK();
+   debugpins_task_set();
+
+   wakeTime                       = (PORT_TIMER_WIDTH)opentimers_getTime();
+#ifdef SCHEDULER_STATS
+   scheduler_dbg.wakeTime         = wakeTime;
+   scheduler_dbg.ticksAsleep     += (PORT_TIMER_WIDTH)(wakeTime-sleepTime);
+#endif
+
+   // step the tick by the time spent asleep, in 32kHz ticks
+   elapsed = ((uint32_t)(PORT_TIMER_WIDTH)(wakeTime-sleepTime)*configTICK_RATE_HZ)/32768;
+   if (elapsed>=xExpectedIdleTime) {
+      elapsed = xExpectedIdleTime-1;
+   }
+   if (elapsed>0) {
+      vTaskStepTick(elapsed);
+   }
+
+   ENABLE_INTERRUPTS();
+}
+
+//======= instrumentation
+
+/**
+\brief Record the entry in an interrupt handler, when built with SCHEDULER_STATS.
+
+Called with interrupts disabled, as are the interrupt handlers.
+*/
+void scheduler_isr_enter(isr_id_t isr) {
+#ifdef SCHEDULER_STATS
+   scheduler_dbg.isrStart[isr]    = SCHEDSTATS_NOW();
+   if (scheduler_dbg.isrNesting[isr].bins[scheduler_dbg.isrNestingCur]<0xffff) {
+      scheduler_dbg.isrNesting[isr].bins[scheduler_dbg.isrNestingCur]++;
+   }
+   if (scheduler_dbg.isrNestingCur<SCHEDSTATS_NUMBINS-1) {
+      scheduler_dbg.isrNestingCur++;
+   }
+   if (scheduler_dbg.isrNestingCur>scheduler_dbg.isrNestingMax) {
+      scheduler_dbg.isrNestingMax = scheduler_dbg.isrNestingCur;
+   }
+#endif
+}
+
+/**
+\brief Record the exit from an interrupt handler, see scheduler_isr_enter().
+*/
+void scheduler_isr_exit(isr_id_t isr) {
+#ifdef SCHEDULER_STATS
+   scheduler_stats_record(
+      &scheduler_dbg.isrDuration[isr],
+      SCHEDSTATS_NOW()-scheduler_dbg.isrStart[isr]
+   );
+   if (scheduler_dbg.isrNestingCur>0) {
+      scheduler_dbg.isrNestingCur--;
+   }
+#endif
+}
+
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+Prints one row of the instrumentation at a time, see schedstats_row_t.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_schedStats() {
+#ifdef SCHEDULER_STATS
+   schedstats_row_t output;
+   uint8_t          row;
+   INTERRUPT_DECLARATION();
+
+   row                            = scheduler_dbg.statsRow;
+   scheduler_dbg.statsRow         = (row+1)%(TASKPRIO_MAX+ISRID_MAX);
+
+   DISABLE_INTERRUPTS();
+   output.row                     = row;
+   output.isrNestingMax           = scheduler_dbg.isrNestingMax;
+   output.ticksAsleep             = scheduler_dbg.ticksAsleep;
+   output.ticksAwake              = scheduler_dbg.ticksAwake;
+   output.numTasksDeferred        = scheduler_dbg.numTasksDeferred;
+   output.numTasksLate            = scheduler_dbg.numTasksLate;
+   if (row<TASKPRIO_MAX) {
+      memcpy(&output.first, &scheduler_dbg.taskLatency[row],sizeof(schedstats_hist_t));
+      memcpy(&output.second,&scheduler_dbg.taskRuntime[row],sizeof(schedstats_hist_t));
+   } else {
+      memcpy(&output.first, &scheduler_dbg.isrDuration[row-TASKPRIO_MAX],sizeof(schedstats_hist_t));
+      memcpy(&output.second,&scheduler_dbg.isrNesting[row-TASKPRIO_MAX], sizeof(schedstats_hist_t));
+   }
+   ENABLE_INTERRUPTS();
+
+   openserial_printStatus(STATUS_SCHEDSTATS,(uint8_t*)&output,sizeof(schedstats_row_t));
+   return TRUE;
+#else
+   return FALSE;
+#endif
 }
 
 //=========================== private =========================================
+
+/**
+\brief Body of a worker: run its tasks, yielding to the other workers after each.
+*/
+static void scheduler_worker(void* pvParameters) {
+   const scheduler_worker_t* worker;
+   uint8_t                   w;
+
+   worker = (const scheduler_worker_t*)pvParameters;
+   w      = worker-scheduler_workers;
+
+   while (1) {
+      xSemaphoreTake(scheduler_workerSem[w],portMAX_DELAY);
+      while (scheduler_runTask(worker->prios)==TRUE) {
+         taskYIELD();
+      }
+   }
+}
+
+/**
+\brief Run the oldest task of the highest of the given priorities.
+
+\returns FALSE if no task of these priorities is ready.
+*/
+static bool scheduler_runTask(uint16_t prios) {
+   taskList_item_t* pThisTask;
+   taskFifo_t*      pFifo;
+   uint8_t          taskId;
+#ifdef SCHEDULER_STATS
+   PORT_TIMER_WIDTH startTime;
+#endif
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   if ((scheduler_vars.readyBitmap & prios)==0) {
+      ENABLE_INTERRUPTS();
+      return FALSE;
+   }
+
+   // the task to execute is the oldest one of the highest priority
+   pFifo                          = &scheduler_vars.taskFifo[scheduler_clz(scheduler_vars.readyBitmap & prios)];
+   taskId                         = pFifo->head;
+   pThisTask                      = &scheduler_vars.taskBuf[taskId];
+
+   // shift the queue of that priority by one task
+   pFifo->head                    = pThisTask->next;
+   if (pFifo->head==TASK_NONE) {
+      pFifo->tail                 = TASK_NONE;
+      scheduler_vars.readyBitmap &= ~SCHEDULER_BIT(pThisTask->prio);
+   }
+
+   ENABLE_INTERRUPTS();
+
+#ifdef SCHEDULER_STATS
+   startTime                      = SCHEDSTATS_NOW();
+   scheduler_stats_record(
+      &scheduler_dbg.taskLatency[pThisTask->prio],
+      startTime-pThisTask->pushTime
+   );
+#endif
+
+   // execute the current task
+   if (pThisTask->ctxCb!=NULL) {
+      pThisTask->ctxCb(pThisTask->ctx);
+   } else {
+      pThisTask->cb();
+   }
+
+#ifdef SCHEDULER_STATS
+   scheduler_stats_record(
+      &scheduler_dbg.taskRuntime[pThisTask->prio],
+      SCHEDSTATS_NOW()-startTime
+   );
+#endif
+
+   // free up this task container
+   DISABLE_INTERRUPTS();
+   pThisTask->cb                  = NULL;
+   pThisTask->ctxCb               = NULL;
+   pThisTask->ctx                 = 0;
+   pThisTask->prio                = TASKPRIO_NONE;
+   pThisTask->duration            = TASK_DURATION_NONE;
+   pThisTask->next                = TASK_NONE;
+   scheduler_vars.freeBitmap     |= SCHEDULER_BIT(taskId);
+   scheduler_dbg.numTasksCur--;
+   ENABLE_INTERRUPTS();
+
+   return TRUE;
+}
+
+/**
+\brief Same as with OpenOS, then wake up the worker of that priority up.
+
+Called from interrupt handlers as well as from tasks, hence the "FromISR"
+FreeRTOS call: as FreeRTOS is cooperative, the worker runs once the running
+task (or the idle task) yields.
+*/
+static void scheduler_push(task_cbt cb, task_ctx_cbt ctxCb, uintptr_t ctx, task_prio_t prio, uint8_t flags, uint16_t duration, PORT_TIMER_WIDTH deadline) {
+   taskList_item_t*  taskContainer;
+   taskFifo_t*       pFifo;
+   uint8_t           taskId;
+   uint8_t           w;
+   BaseType_t        woken;
+   INTERRUPT_DECLARATION();
+
+   DISABLE_INTERRUPTS();
+
+   pFifo                          = &scheduler_vars.taskFifo[prio];
+
+   // do not push a task which is already pending
+   if (flags & TASK_FLAG_COALESCE) {
+      for (taskId=pFifo->head;taskId!=TASK_NONE;taskId=scheduler_vars.taskBuf[taskId].next) {
+         taskContainer            = &scheduler_vars.taskBuf[taskId];
+         if (
+               taskContainer->cb    == cb    &&
+               taskContainer->ctxCb == ctxCb &&
+               taskContainer->ctx   == ctx
+            ) {
+            scheduler_dbg.numTasksCoalesced++;
+            ENABLE_INTERRUPTS();
+            return;
+         }
+      }
+   }
+
+   // find an empty task container
+   if (scheduler_vars.freeBitmap==0) {
+      // task list has overflown, see the OpenOS scheduler
+      if (flags & TASK_FLAG_COALESCE) {
+         scheduler_dbg.numTasksDropped++;
+         leds_error_on();
+         ENABLE_INTERRUPTS();
+         return;
+      }
+      leds_error_blink();
+      board_reset();
+      ENABLE_INTERRUPTS();
+      return;
+   }
+   taskId                         = scheduler_clz(scheduler_vars.freeBitmap);
+   scheduler_vars.freeBitmap     &= ~SCHEDULER_BIT(taskId);
+
+   // fill that task container with this task
+   taskContainer                  = &scheduler_vars.taskBuf[taskId];
+   taskContainer->cb              = cb;
+   taskContainer->ctxCb           = ctxCb;
+   taskContainer->ctx             = ctx;
+   taskContainer->prio            = prio;
+   taskContainer->duration        = duration;
+   taskContainer->deadline        = deadline;
+   taskContainer->deferred        = FALSE;
+   taskContainer->next            = TASK_NONE;
+#ifdef SCHEDULER_STATS
+   taskContainer->pushTime        = SCHEDSTATS_NOW();
+#endif
+
+   // append it to the queue of its priority
+   if (pFifo->tail==TASK_NONE) {
+      pFifo->head                 = taskId;
+   } else {
+      scheduler_vars.taskBuf[pFifo->tail].next = taskId;
+   }
+   pFifo->tail                    = taskId;
+   scheduler_vars.readyBitmap    |= SCHEDULER_BIT(prio);
+
+   // maintain debug stats
+   scheduler_dbg.numTasksCur++;
+   if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
+      scheduler_dbg.numTasksMax   = scheduler_dbg.numTasksCur;
+   }
+
+   // wake up the worker serving that priority
+   for (w=0;w<SCHEDULER_NUM_WORKERS;w++) {
+      if (scheduler_workers[w].prios & SCHEDULER_BIT(prio)) {
+         woken = pdFALSE;
+         xSemaphoreGiveFromISR(scheduler_workerSem[w],&woken);
+         break;
+      }
+   }
+
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Number of leading zeros of a non-zero bitmap, i.e. its first entry.
+*/
+static port_INLINE uint8_t scheduler_clz(uint16_t bitmap) {
+#if defined(__GNUC__)
+   return __builtin_clz(bitmap)-(8*sizeof(unsigned int)-16);
+#else
+   uint8_t n;
+
+   n = 0;
+   if ((bitmap&0xff00)==0) {
+      n       += 8;
+      bitmap <<= 8;
+   }
+   if ((bitmap&0xf000)==0) {
+      n       += 4;
+      bitmap <<= 4;
+   }
+   if ((bitmap&0xc000)==0) {
+      n       += 2;
+      bitmap <<= 2;
+   }
+   if ((bitmap&0x8000)==0) {
+      n       += 1;
+   }
+   return n;
+#endif
+}
+
+#ifdef SCHEDULER_STATS
+/**
+\brief Count a duration in the log2 bin it falls in.
+*/
+static void scheduler_stats_record(schedstats_hist_t* hist, PORT_TIMER_WIDTH duration) {
+   uint8_t bin;
+
+   if (duration==0) {
+      bin = 0;
+   } else if (duration>=((PORT_TIMER_WIDTH)1<<(SCHEDSTATS_NUMBINS-2))) {
+      bin = SCHEDSTATS_NUMBINS-1;
+   } else {
+      // duration fits in 16 bits, one more than its highest bit
+      bin = 16-scheduler_clz((uint16_t)duration);
+   }
+   if (hist->bins[bin]<0xffff) {
+      hist->bins[bin]++;
+   }
+}
+#endif
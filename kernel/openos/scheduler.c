@@ -9,6 +9,28 @@
 #include "board.h"
 #include "debugpins.h"
 #include "leds.h"
+#include "bsp_timer.h"
+#include "opentimers.h"
+#include "radio.h"
+#include "openserial.h"
+
+//=========================== define ==========================================
+
+#if TASK_LIST_DEPTH>16 || TASKPRIO_MAX>16
+   #error the bitmaps of the scheduler hold at most 16 entries
+#endif
+
+// bit of priority or task container i in a bitmap, the first one is the MSB
+#define SCHEDULER_BIT(i)          ((uint16_t)(0x8000>>(i)))
+
+// time source of the instrumentation
+#ifdef OPENSIM
+   // host microseconds, as simulated time stands still while a mote runs
+   #define SCHEDSTATS_NOW()       debugpins_host_clock()
+#else
+   // opentimers time, as the bsp_timer is reset when opentimers reschedules
+   #define SCHEDSTATS_NOW()       ((PORT_TIMER_WIDTH)opentimers_getTime())
+#endif
 
 //=========================== variables =======================================
 
@@ -18,81 +40,304 @@ scheduler_dbg_t  scheduler_dbg;
 //=========================== prototypes ======================================
 
 void consumeTask(uint8_t taskId);
+static void scheduler_push(task_cbt cb, task_ctx_cbt ctxCb, uintptr_t ctx, task_prio_t prio, uint8_t flags, uint16_t duration, PORT_TIMER_WIDTH deadline);
+static uint8_t scheduler_nextTask(void);
+static bool scheduler_fits(taskList_item_t* pTask, PORT_TIMER_WIDTH* timeLeft);
+static port_INLINE uint8_t scheduler_clz(uint16_t bitmap);
+#ifdef SCHEDULER_STATS
+static void scheduler_stats_record(schedstats_hist_t* hist, PORT_TIMER_WIDTH duration);
+#endif
 
 //=========================== public ==========================================
 
 void scheduler_init() {   
+   uint8_t prio;
    
    // initialization module variables
    memset(&scheduler_vars,0,sizeof(scheduler_vars_t));
    memset(&scheduler_dbg,0,sizeof(scheduler_dbg_t));
    
+   // all task containers are free, no task is ready
+   scheduler_vars.freeBitmap = (uint16_t)(0xffff<<(16-TASK_LIST_DEPTH));
+   for (prio=0;prio<TASKPRIO_MAX;prio++) {
+      scheduler_vars.taskFifo[prio].head = TASK_NONE;
+      scheduler_vars.taskFifo[prio].tail = TASK_NONE;
+   }
+   
    // enable the scheduler's interrupt so SW can wake up the scheduler
    SCHEDULER_ENABLE_INTERRUPT();
 }
 
 void scheduler_start() {
    taskList_item_t* pThisTask;
+   uint8_t          taskId;
+#ifdef SCHEDULER_STATS
+   PORT_TIMER_WIDTH startTime;
+   PORT_TIMER_WIDTH sleepTime;
+#endif
+   INTERRUPT_DECLARATION();
+   
    while (1) {
-      while(scheduler_vars.task_list!=NULL) {
-         // there is still at least one task in the linked-list of tasks
+      while((taskId=scheduler_nextTask())!=TASK_NONE) {
+         // there is still at least one task which can run now
+         pThisTask                = &scheduler_vars.taskBuf[taskId];
          
-         // the task to execute is the one at the head of the queue
-         pThisTask                = scheduler_vars.task_list;
-         
-         // shift the queue by one task
-         scheduler_vars.task_list = pThisTask->next;
+#ifdef SCHEDULER_STATS
+         startTime                = SCHEDSTATS_NOW();
+         scheduler_stats_record(
+            &scheduler_dbg.taskLatency[pThisTask->prio],
+            startTime-pThisTask->pushTime
+         );
+#endif
          
          // execute the current task
-         pThisTask->cb();
+         if (pThisTask->ctxCb!=NULL) {
+#ifdef OPENSIM
+            debugpins_task_run((uintptr_t)pThisTask->ctxCb);
+#endif
+            pThisTask->ctxCb(pThisTask->ctx);
+         } else {
+#ifdef OPENSIM
+            debugpins_task_run((uintptr_t)pThisTask->cb);
+#endif
+            pThisTask->cb();
+         }
+         
+#ifdef SCHEDULER_STATS
+         scheduler_stats_record(
+            &scheduler_dbg.taskRuntime[pThisTask->prio],
+            SCHEDSTATS_NOW()-startTime
+         );
+#endif
          
          // free up this task container
+         DISABLE_INTERRUPTS();
          pThisTask->cb            = NULL;
+         pThisTask->ctxCb         = NULL;
+         pThisTask->ctx           = 0;
          pThisTask->prio          = TASKPRIO_NONE;
-         pThisTask->next          = NULL;
+         pThisTask->duration      = TASK_DURATION_NONE;
+         pThisTask->deferred      = FALSE;
+         pThisTask->next          = TASK_NONE;
+         scheduler_vars.freeBitmap |= SCHEDULER_BIT(taskId);
          scheduler_dbg.numTasksCur--;
+         ENABLE_INTERRUPTS();
       }
       debugpins_task_clr();
+#ifdef SCHEDULER_STATS
+      sleepTime                   = SCHEDSTATS_NOW();
+      scheduler_dbg.ticksAwake   += (PORT_TIMER_WIDTH)(sleepTime-scheduler_dbg.wakeTime);
+#endif
       board_sleep();
+#ifdef SCHEDULER_STATS
+      scheduler_dbg.wakeTime      = SCHEDSTATS_NOW();
+      scheduler_dbg.ticksAsleep  += (PORT_TIMER_WIDTH)(scheduler_dbg.wakeTime-sleepTime);
+#endif
       debugpins_task_set();                      // IAR should halt here if nothing to do
    }
 }
 
  void scheduler_push_task(task_cbt cb, task_prio_t prio) {
+   scheduler_push(cb,NULL,0,prio,TASK_FLAG_NONE,TASK_DURATION_NONE,0);
+}
+
+/**
+\brief Push a task, with flags.
+
+With TASK_FLAG_COALESCE, the task is not pushed again while it is pending,
+i.e. pushed but not started yet. Such a task handles all the events which
+happened since it was first pushed; as it is no longer pending once started,
+an event which happens while it runs pushes it again.
+*/
+void scheduler_push_task_flags(task_cbt cb, task_prio_t prio, uint8_t flags) {
+   scheduler_push(cb,NULL,0,prio,flags,TASK_DURATION_NONE,0);
+}
+
+/**
+\brief Push a task which is called with a context argument.
+
+The same task pushed with different contexts is not coalesced.
+*/
+void scheduler_push_task_ctx(task_ctx_cbt cb, task_prio_t prio, uintptr_t ctx, uint8_t flags) {
+   scheduler_push(NULL,cb,ctx,prio,flags,TASK_DURATION_NONE,0);
+}
+
+/**
+\brief Push a task which declares how long it runs, and by when it must start.
+
+Such a task is not started if it would still be running at the next slot
+boundary, i.e. when the slot timer fires, which would make that slot late
+(ERR_WRONG_STATE_IN_STARTSLOT where interrupts wait for the running task);
+lower-priority tasks which fit run instead. It is deferred to the idle slots
+following the next active one, over which the slot timer is stretched, unless
+it has waited for deadline ticks already.
+
+\param[in] duration Estimated run time, in 32kHz ticks.
+\param[in] deadline Time after which the task starts regardless, in 32kHz ticks.
+*/
+void scheduler_push_task_deadline(task_cbt cb, task_prio_t prio, uint16_t duration, PORT_TIMER_WIDTH deadline) {
+   scheduler_push(cb,NULL,0,prio,TASK_FLAG_NONE,duration,deadline);
+}
+
+//======= instrumentation
+
+/**
+\brief Record the entry in an interrupt handler, when built with SCHEDULER_STATS.
+
+Called with interrupts disabled, as are the interrupt handlers.
+*/
+void scheduler_isr_enter(isr_id_t isr) {
+#ifdef SCHEDULER_STATS
+   scheduler_dbg.isrStart[isr]    = SCHEDSTATS_NOW();
+   if (scheduler_dbg.isrNesting[isr].bins[scheduler_dbg.isrNestingCur]<0xffff) {
+      scheduler_dbg.isrNesting[isr].bins[scheduler_dbg.isrNestingCur]++;
+   }
+   if (scheduler_dbg.isrNestingCur<SCHEDSTATS_NUMBINS-1) {
+      scheduler_dbg.isrNestingCur++;
+   }
+   if (scheduler_dbg.isrNestingCur>scheduler_dbg.isrNestingMax) {
+      scheduler_dbg.isrNestingMax = scheduler_dbg.isrNestingCur;
+   }
+#endif
+}
+
+/**
+\brief Record the exit from an interrupt handler, see scheduler_isr_enter().
+*/
+void scheduler_isr_exit(isr_id_t isr) {
+#ifdef SCHEDULER_STATS
+   scheduler_stats_record(
+      &scheduler_dbg.isrDuration[isr],
+      SCHEDSTATS_NOW()-scheduler_dbg.isrStart[isr]
+   );
+   if (scheduler_dbg.isrNestingCur>0) {
+      scheduler_dbg.isrNestingCur--;
+   }
+#endif
+}
+
+/**
+\brief Trigger this module to print status information, over serial.
+
+debugPrint_* functions are used by the openserial module to continuously print
+status information about several modules in the OpenWSN stack.
+
+Prints one row of the instrumentation at a time, see schedstats_row_t.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_schedStats() {
+#ifdef SCHEDULER_STATS
+   schedstats_row_t output;
+   uint8_t          row;
+   INTERRUPT_DECLARATION();
+   
+   row                            = scheduler_dbg.statsRow;
+   scheduler_dbg.statsRow         = (row+1)%(TASKPRIO_MAX+ISRID_MAX);
+   
+   DISABLE_INTERRUPTS();
+   output.row                     = row;
+   output.isrNestingMax           = scheduler_dbg.isrNestingMax;
+   output.ticksAsleep             = scheduler_dbg.ticksAsleep;
+   output.ticksAwake              = scheduler_dbg.ticksAwake;
+   output.numTasksDeferred        = scheduler_dbg.numTasksDeferred;
+   output.numTasksLate            = scheduler_dbg.numTasksLate;
+   if (row<TASKPRIO_MAX) {
+      memcpy(&output.first, &scheduler_dbg.taskLatency[row],sizeof(schedstats_hist_t));
+      memcpy(&output.second,&scheduler_dbg.taskRuntime[row],sizeof(schedstats_hist_t));
+   } else {
+      memcpy(&output.first, &scheduler_dbg.isrDuration[row-TASKPRIO_MAX],sizeof(schedstats_hist_t));
+      memcpy(&output.second,&scheduler_dbg.isrNesting[row-TASKPRIO_MAX], sizeof(schedstats_hist_t));
+   }
+   ENABLE_INTERRUPTS();
+   
+   openserial_printStatus(STATUS_SCHEDSTATS,(uint8_t*)&output,sizeof(schedstats_row_t));
+   return TRUE;
+#else
+   return FALSE;
+#endif
+}
+
+//=========================== private =========================================
+
+static void scheduler_push(task_cbt cb, task_ctx_cbt ctxCb, uintptr_t ctx, task_prio_t prio, uint8_t flags, uint16_t duration, PORT_TIMER_WIDTH deadline) {
    taskList_item_t*  taskContainer;
-   taskList_item_t** taskListWalker;
+   taskFifo_t*       pFifo;
+   uint8_t           taskId;
    INTERRUPT_DECLARATION();
    
    DISABLE_INTERRUPTS();
    
-   // find an empty task container
-   taskContainer = &scheduler_vars.taskBuf[0];
-   while (taskContainer->cb!=NULL &&
-          taskContainer<=&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-      taskContainer++;
+   pFifo                          = &scheduler_vars.taskFifo[prio];
+   
+   // do not push a task which is already pending
+   if (flags & TASK_FLAG_COALESCE) {
+      for (taskId=pFifo->head;taskId!=TASK_NONE;taskId=scheduler_vars.taskBuf[taskId].next) {
+         taskContainer            = &scheduler_vars.taskBuf[taskId];
+         if (
+               taskContainer->cb    == cb    &&
+               taskContainer->ctxCb == ctxCb &&
+               taskContainer->ctx   == ctx
+            ) {
+            scheduler_dbg.numTasksCoalesced++;
+            ENABLE_INTERRUPTS();
+            return;
+         }
+      }
    }
-   if (taskContainer>&scheduler_vars.taskBuf[TASK_LIST_DEPTH-1]) {
-      // task list has overflown. This should never happpen!
    
-      // we can not print from within the kernel. Instead:
+   // find an empty task container
+   if (scheduler_vars.freeBitmap==0) {
+      // task list has overflown. This should never happpen!
+      
+      if (flags & TASK_FLAG_COALESCE) {
+         // a task pushed with TASK_FLAG_COALESCE handles the events of the
+         // dropped push the next time it runs: drop it, count it and turn on
+         // the error LED
+         scheduler_dbg.numTasksDropped++;
+         leds_error_on();
+         ENABLE_INTERRUPTS();
+         return;
+      }
+      
+      // any other task would be lost for good, and we can not print from
+      // within the kernel. Instead:
       // blink the error LED
       leds_error_blink();
       // reset the board
       board_reset();
+      ENABLE_INTERRUPTS();
+      return;
    }
+   taskId                         = scheduler_clz(scheduler_vars.freeBitmap);
+   scheduler_vars.freeBitmap     &= ~SCHEDULER_BIT(taskId);
+   
    // fill that task container with this task
+   taskContainer                  = &scheduler_vars.taskBuf[taskId];
    taskContainer->cb              = cb;
+   taskContainer->ctxCb           = ctxCb;
+   taskContainer->ctx             = ctx;
    taskContainer->prio            = prio;
+   taskContainer->duration        = duration;
+   taskContainer->deadline        = deadline;
+   if (duration!=TASK_DURATION_NONE) {
+      taskContainer->pushTicks    = (PORT_TIMER_WIDTH)opentimers_getTime();
+   }
+   taskContainer->deferred        = FALSE;
+   taskContainer->next            = TASK_NONE;
+#ifdef SCHEDULER_STATS
+   taskContainer->pushTime        = SCHEDSTATS_NOW();
+#endif
    
-   // find position in queue
-   taskListWalker                 = &scheduler_vars.task_list;
-   while (*taskListWalker!=NULL &&
-          (*taskListWalker)->prio < taskContainer->prio) {
-      taskListWalker              = (taskList_item_t**)&((*taskListWalker)->next);
+   // append it to the queue of its priority
+   if (pFifo->tail==TASK_NONE) {
+      pFifo->head                 = taskId;
+   } else {
+      scheduler_vars.taskBuf[pFifo->tail].next = taskId;
    }
-   // insert at that position
-   taskContainer->next            = *taskListWalker;
-   *taskListWalker                = taskContainer;
+   pFifo->tail                    = taskId;
+   scheduler_vars.readyBitmap    |= SCHEDULER_BIT(prio);
+   
    // maintain debug stats
    scheduler_dbg.numTasksCur++;
    if (scheduler_dbg.numTasksCur>scheduler_dbg.numTasksMax) {
@@ -102,4 +347,138 @@ void scheduler_start() {
    ENABLE_INTERRUPTS();
 }
 
-//=========================== private =========================================
+/**
+\brief Dequeue the next task to run.
+
+The task to run is the oldest one of the highest priority, unless it does not
+fit before the next slot boundary, see scheduler_push_task_deadline(). Only
+the oldest task of each priority is considered, so the tasks of a priority
+still run in push order.
+
+\returns the index of the task in taskBuf, TASK_NONE if no task can run now.
+*/
+static uint8_t scheduler_nextTask() {
+   taskList_item_t*  pThisTask;
+   taskFifo_t*       pFifo;
+   uint16_t          ready;
+   uint8_t           taskId;
+   PORT_TIMER_WIDTH  timeLeft;
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   
+   ready                          = scheduler_vars.readyBitmap;
+   timeLeft                       = 0;
+   while (ready!=0) {
+      pFifo                       = &scheduler_vars.taskFifo[scheduler_clz(ready)];
+      taskId                      = pFifo->head;
+      pThisTask                   = &scheduler_vars.taskBuf[taskId];
+      if (scheduler_fits(pThisTask,&timeLeft)==TRUE) {
+         break;
+      }
+      // leave it for after the slot boundary
+      if (pThisTask->deferred==FALSE) {
+         pThisTask->deferred      = TRUE;
+         scheduler_dbg.numTasksDeferred++;
+      }
+      ready                      &= ~SCHEDULER_BIT(pThisTask->prio);
+   }
+   if (ready==0) {
+      ENABLE_INTERRUPTS();
+      return TASK_NONE;
+   }
+   
+   // shift the queue of that priority by one task
+   pFifo->head                    = pThisTask->next;
+   if (pFifo->head==TASK_NONE) {
+      pFifo->tail                 = TASK_NONE;
+      scheduler_vars.readyBitmap &= ~SCHEDULER_BIT(pThisTask->prio);
+   }
+   
+   ENABLE_INTERRUPTS();
+   
+   return taskId;
+}
+
+/**
+\brief Whether a task can start now, see scheduler_push_task_deadline().
+
+\param[in,out] timeLeft Time left until the next slot boundary, read from the
+   slot timer the first time it is needed (when 0).
+*/
+static bool scheduler_fits(taskList_item_t* pTask, PORT_TIMER_WIDTH* timeLeft) {
+   PORT_TIMER_WIDTH period;
+   PORT_TIMER_WIDTH value;
+   
+   if (pTask->duration==TASK_DURATION_NONE) {
+      return TRUE;
+   }
+   
+   if (*timeLeft==0) {
+      period                      = radio_getTimerPeriod();
+      value                       = radio_getTimerValue();
+      *timeLeft                   = (value<period) ? period-value : 1;
+   }
+   if (pTask->duration<*timeLeft) {
+      return TRUE;
+   }
+   
+   // opentimers time, as the bsp_timer is reset when opentimers reschedules
+   if ((PORT_TIMER_WIDTH)((PORT_TIMER_WIDTH)opentimers_getTime()-pTask->pushTicks)>=pTask->deadline) {
+      // waited long enough, run it even if it makes the next slot late
+      scheduler_dbg.numTasksLate++;
+      return TRUE;
+   }
+   
+   return FALSE;
+}
+
+/**
+\brief Number of leading zeros of a non-zero bitmap, i.e. its first entry.
+*/
+static port_INLINE uint8_t scheduler_clz(uint16_t bitmap) {
+#if defined(__GNUC__)
+   return __builtin_clz(bitmap)-(8*sizeof(unsigned int)-16);
+#else
+   uint8_t n;
+   
+   n = 0;
+   if ((bitmap&0xff00)==0) {
+      n       += 8;
+      bitmap <<= 8;
+   }
+   if ((bitmap&0xf000)==0) {
+      n       += 4;
+      bitmap <<= 4;
+   }
+   if ((bitmap&0xc000)==0) {
+      n       += 2;
+      bitmap <<= 2;
+   }
+   if ((bitmap&0x8000)==0) {
+      n       += 1;
+   }
+   return n;
+#endif
+}
+
+#ifdef SCHEDULER_STATS
+/**
+\brief Count a duration in the log2 bin it falls in.
+*/
+static void scheduler_stats_record(schedstats_hist_t* hist, PORT_TIMER_WIDTH duration) {
+   uint8_t bin;
+   
+   if (duration==0) {
+      bin = 0;
+   } else if (duration>=((PORT_TIMER_WIDTH)1<<(SCHEDSTATS_NUMBINS-2))) {
+      bin = SCHEDSTATS_NUMBINS-1;
+   } else {
+      // duration fits in 16 bits, one more than its highest bit
+      bin = 16-scheduler_clz((uint16_t)duration);
+   }
+   if (hist->bins[bin]<0xffff) {
+      hist->bins[bin]++;
+   }
+}
+#endif
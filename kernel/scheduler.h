@@ -32,22 +32,91 @@ typedef enum {
 } task_prio_t;
 
 #define TASK_LIST_DEPTH           10
+#define TASK_NONE                 0xff       // end of a list of tasks
+
+// interrupt handlers instrumented when built with SCHEDULER_STATS
+typedef enum {
+   ISRID_IEEE154E_NEWSLOT         = 0x00,
+   ISRID_IEEE154E_TIMER           = 0x01,
+   ISRID_IEEE154E_STARTOFFRAME    = 0x02,
+   ISRID_IEEE154E_ENDOFFRAME      = 0x03,
+   ISRID_MAX                      = 0x04,
+} isr_id_t;
+
+// bin b>0 of a histogram counts durations in [2^(b-1),2^b) ticks, the last bin
+// all longer ones
+#define SCHEDSTATS_NUMBINS        12
+
+// flags of scheduler_push_task_flags() and scheduler_push_task_ctx()
+#define TASK_FLAG_NONE            0x00
+#define TASK_FLAG_COALESCE        0x01       // not pushed if the same task is already pending
+
+// estimated run time of scheduler_push_task_deadline() tasks, in 32kHz ticks
+#define TASK_DURATION_NONE        0          // not estimated, the task is never deferred
+#define TASK_DURATION_SENDPKT     33         // ~1ms, builds one packet and hands it down the stack
+// time by which such tasks start even if they make the next slot late, in 32kHz ticks
+#define TASK_DEADLINE_SENDPKT     16384      // 500ms
 
 //=========================== typedef =========================================
 
 typedef void (*task_cbt)(void);
+typedef void (*task_ctx_cbt)(uintptr_t ctx);
 
 typedef struct task_llist_t {
    task_cbt                       cb;
+   task_ctx_cbt                   ctxCb;     // called with ctx instead of cb, if not NULL
+   uintptr_t                      ctx;
    task_prio_t                    prio;
-   void*                          next;
+   uint16_t                       duration;  // estimated run time, TASK_DURATION_NONE if unknown
+   PORT_TIMER_WIDTH               deadline;  // time after pushTicks by which the task starts
+   PORT_TIMER_WIDTH               pushTicks; // opentimers_getTime() when pushed, its low bits
+   bool                           deferred;  // the task was deferred past a slot boundary
+#ifdef SCHEDULER_STATS
+   PORT_TIMER_WIDTH               pushTime;
+#endif
+   uint8_t                        next;      // index in taskBuf of the next task of the same priority
 } taskList_item_t;
 
+typedef struct {
+   uint8_t                        head;      // index in taskBuf, TASK_NONE if empty
+   uint8_t                        tail;
+} taskFifo_t;
+
+typedef struct {
+   uint16_t                       bins[SCHEDSTATS_NUMBINS]; // saturate at 0xffff
+} schedstats_hist_t;
+
+/**
+\brief Payload of the STATUS_SCHEDSTATS status element.
+
+Rows 0 to TASKPRIO_MAX-1 hold, for that task priority, the time tasks waited
+between being pushed and starting (first), then the time they ran (second).
+The following ISRID_MAX rows hold, for that interrupt handler, its duration
+(first), then the number of times it was entered at each nesting depth
+(second, linear bins). Every row also holds the time spent asleep in
+board_sleep() and awake, to compare the sleep residency of the kernels, and
+the counters of scheduler_push_task_deadline().
+*/
+BEGIN_PACK
+typedef struct {
+   uint8_t                        row;
+   uint8_t                        isrNestingMax;
+   uint32_t                       ticksAsleep;
+   uint32_t                       ticksAwake;
+   uint16_t                       numTasksDeferred;
+   uint16_t                       numTasksLate;
+   schedstats_hist_t              first;
+   schedstats_hist_t              second;
+} schedstats_row_t;
+END_PACK
+
 //=========================== module variables ================================
 
 typedef struct {
    taskList_item_t                taskBuf[TASK_LIST_DEPTH];
-   taskList_item_t*               task_list;
+   taskFifo_t                     taskFifo[TASKPRIO_MAX]; // tasks of each priority, in push order
+   uint16_t                       readyBitmap;  // bit 15-prio set when taskFifo[prio] is not empty
+   uint16_t                       freeBitmap;   // bit 15-i set when taskBuf[i] is free
    uint8_t                        numTasksCur;
    uint8_t                        numTasksMax;
 } scheduler_vars_t;
@@ -55,6 +124,24 @@ typedef struct {
 typedef struct {
    uint8_t                        numTasksCur;
    uint8_t                        numTasksMax;
+   uint16_t                       numTasksCoalesced; // not pushed, the same task was pending
+   uint16_t                       numTasksDropped;   // coalesced tasks not pushed, the task list was full
+   uint16_t                       numTasksDeferred;  // deferred past a slot boundary they would have made late
+   uint16_t                       numTasksLate;      // started at their deadline, too long for the time left
+#ifdef SCHEDULER_STATS
+   schedstats_hist_t              taskLatency[TASKPRIO_MAX];
+   schedstats_hist_t              taskRuntime[TASKPRIO_MAX];
+   schedstats_hist_t              isrDuration[ISRID_MAX];
+   schedstats_hist_t              isrNesting[ISRID_MAX];
+   PORT_TIMER_WIDTH               isrStart[ISRID_MAX];
+   uint8_t                        isrNestingCur;
+   uint8_t                        isrNestingMax;
+   uint8_t                        statsRow;          // next row printed by debugPrint_schedStats()
+   // sleep residency
+   uint32_t                       ticksAsleep;
+   uint32_t                       ticksAwake;
+   PORT_TIMER_WIDTH               wakeTime;
+#endif
 } scheduler_dbg_t;
 
 //=========================== prototypes ======================================
@@ -62,6 +149,13 @@ typedef struct {
 void scheduler_init(void);
 void scheduler_start(void);
 void scheduler_push_task(task_cbt task_cb, task_prio_t prio);
+void scheduler_push_task_flags(task_cbt task_cb, task_prio_t prio, uint8_t flags);
+void scheduler_push_task_ctx(task_ctx_cbt task_cb, task_prio_t prio, uintptr_t ctx, uint8_t flags);
+void scheduler_push_task_deadline(task_cbt task_cb, task_prio_t prio, uint16_t duration, PORT_TIMER_WIDTH deadline);
+// instrumentation
+void scheduler_isr_enter(isr_id_t isr);
+void scheduler_isr_exit(isr_id_t isr);
+bool debugPrint_schedStats(void);
 
 /**
 \}
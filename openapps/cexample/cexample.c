@@ -19,6 +19,8 @@
 
 /// inter-packet period (in ms)
 #define CEXAMPLEPERIOD  10000
+/// how late a packet may be sent, to share a wakeup (in ms)
+#define CEXAMPLESLACK   1000
 #define PAYLOADLEN      40
 
 const uint8_t cexample_path0[] = "ex";
@@ -54,6 +56,7 @@ void cexample_init() {
    
    opencoap_register(&cexample_vars.desc);
    cexample_vars.timerId    = opentimers_start(CEXAMPLEPERIOD,
+                                                CEXAMPLESLACK,
                                                 TIMER_PERIODIC,TIME_MS,
                                                 cexample_timer_cb);
 }
@@ -69,7 +72,7 @@ owerror_t cexample_receive(OpenQueueEntry_t* msg,
 //timer fired, but we don't want to execute task in ISR mode
 //instead, push task to scheduler with COAP priority, and let scheduler take care of it
 void cexample_timer_cb(opentimer_id_t id){
-   scheduler_push_task(cexample_task_cb,TASKPRIO_COAP);
+   scheduler_push_task_deadline(cexample_task_cb,TASKPRIO_COAP,TASK_DURATION_SENDPKT,TASK_DEADLINE_SENDPKT);
 }
 
 void cexample_task_cb() {
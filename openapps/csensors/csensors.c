@@ -292,7 +292,7 @@ void csensors_timer_cb(opentimer_id_t id){
          break;
       }
    }
-   scheduler_push_task(csensors_task_cb,TASKPRIO_COAP);
+   scheduler_push_task_deadline(csensors_task_cb,TASKPRIO_COAP,TASK_DURATION_SENDPKT,TASK_DEADLINE_SENDPKT);
 }
 
 /**
@@ -390,6 +390,7 @@ void csensors_setPeriod(uint32_t period,
       } else {
          csensors_vars.csensors_resource[id].timerId = opentimers_start(
             (uint32_t)((period*openrandom_get16b())/0xffff),
+            OPENTIMERS_SLACK_NONE,
             TIMER_PERIODIC,TIME_MS,
             csensors_timer_cb);
       }
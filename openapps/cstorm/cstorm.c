@@ -31,7 +31,7 @@ owerror_t cstorm_receive(
    coap_header_iht*  coap_header,
    coap_option_iht*  coap_options
 );
-void cstorm_timer_cb(void);
+void cstorm_timer_cb(opentimer_id_t id);
 void cstorm_task_cb(void);
 void cstorm_sendDone(OpenQueueEntry_t* msg, owerror_t error);
 
@@ -50,20 +50,18 @@ void cstorm_init(void) {
    cstorm_vars.desc.callbackSendDone      = &cstorm_sendDone;
    opencoap_register(&cstorm_vars.desc);
    
-   /*
+#ifdef CSTORM_ENABLED
    //start a periodic timer
-   //comment : not running by default
-   cstorm_vars.period           = 6553; 
+   //comment : not running by default, build with cstorm=1
+   cstorm_vars.period           = CSTORM_PERIOD_MS;
    
    cstorm_vars.timerId                    = opentimers_start(
       cstorm_vars.period,
+      OPENTIMERS_SLACK_NONE,
       TIMER_PERIODIC,TIME_MS,
       cstorm_timer_cb
    );
-   
-   //stop 
-   //opentimers_stop(cstorm_vars.timerId);
-   */
+#endif
 }
 
 //=========================== private =========================================
@@ -141,8 +139,8 @@ owerror_t cstorm_receive(
 \note timer fired, but we don't want to execute task in ISR mode instead, push
    task to scheduler with CoAP priority, and let scheduler take care of it.
 */
-void cstorm_timer_cb(){
-   scheduler_push_task(cstorm_task_cb,TASKPRIO_COAP);
+void cstorm_timer_cb(opentimer_id_t id){
+   scheduler_push_task_deadline(cstorm_task_cb,TASKPRIO_COAP,TASK_DURATION_SENDPKT,TASK_DEADLINE_SENDPKT);
 }
 
 void cstorm_task_cb() {
@@ -173,7 +171,6 @@ void cstorm_task_cb() {
       openserial_printError(COMPONENT_CSTORM,ERR_NO_FREE_PACKET_BUFFER,
                             (errorparameter_t)0,
                             (errorparameter_t)0);
-      openqueue_freePacketBuffer(pkt);
       return;
    }
    
@@ -12,6 +12,11 @@
 
 //=========================== define ==========================================
 
+/// inter-packet period (in ms) cstorm starts with, when built with cstorm=1
+#ifndef CSTORM_PERIOD_MS
+#define CSTORM_PERIOD_MS 1000
+#endif
+
 //=========================== typedef =========================================
 
 //=========================== variables =======================================
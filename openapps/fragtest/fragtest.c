@@ -10,6 +10,7 @@
 #include "idmanager.h"
 #include "openrandom.h"
 #include "fragment.h"
+#include <stdio.h>
 
 //=========================== variables =======================================
 
@@ -44,6 +45,7 @@ void fragtest_init() {
    // start periodic timer
    fragtest_vars.timerId = opentimers_start(
       FRAGTEST_PERIOD_MS,
+      FRAGTEST_SLACK_MS,
       TIMER_PERIODIC,TIME_MS,
       fragtest_timer_cb
    );
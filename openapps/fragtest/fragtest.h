@@ -13,6 +13,7 @@
 //=========================== define ==========================================
 
 #define FRAGTEST_PERIOD_MS 500000
+#define FRAGTEST_SLACK_MS  50000
 
 //=========================== typedef =========================================
 
@@ -33,6 +33,7 @@ void uinject_init() {
    // start periodic timer
    uinject_vars.timerId                    = opentimers_start(
       UINJECT_PERIOD_MS,
+      UINJECT_SLACK_MS,
       TIMER_PERIODIC,TIME_MS,
       uinject_timer_cb
    );
@@ -62,7 +63,7 @@ void uinject_receive(OpenQueueEntry_t* pkt) {
 */
 void uinject_timer_cb(opentimer_id_t id){
    
-   scheduler_push_task(uinject_task_cb,TASKPRIO_COAP);
+   scheduler_push_task_deadline(uinject_task_cb,TASKPRIO_COAP,TASK_DURATION_SENDPKT,TASK_DEADLINE_SENDPKT);
 }
 
 void uinject_task_cb() {
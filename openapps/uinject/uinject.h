@@ -13,6 +13,7 @@
 //=========================== define ==========================================
 
 #define UINJECT_PERIOD_MS 30000
+#define UINJECT_SLACK_MS  3000
 
 //=========================== typedef =========================================
 
@@ -199,6 +199,11 @@ void ieee802154_retrieveHeader(OpenQueueEntry_t*      msg,
    uint8_t  byte0;
    uint8_t  byte1;
    int16_t  timeCorrection;
+   
+   // clear the fields the frame does not carry, rather than leaving whatever
+   // the caller's stack held, e.g. the addresses absent from an ACK
+   memset(ieee802514_header,0,sizeof(ieee802154_header_iht));
+   
    // by default, let's assume the header is not valid, in case we leave this
    // function because the packet ends up being shorter than the header.
    ieee802514_header->valid=FALSE;
@@ -16,6 +16,7 @@
 #include "sixtop.h"
 #include "adaptive_sync.h"
 #include "processIE.h"
+#include "opentimers.h"
 
 //=========================== variables =======================================
 
@@ -69,7 +70,9 @@ bool     isValidJoin(OpenQueueEntry_t* eb, ieee802154_header_iht *parsedHeader);
 // IEs Handling
 bool     ieee154e_processIEs(OpenQueueEntry_t* pkt, uint16_t* lenIE);
 // ASN handling
-void     incrementAsnOffset(void);
+void     incrementAsnOffset(uint16_t numSlots);
+uint64_t ieee154e_asnToUint64(asn_t* asn);
+void     ieee154e_nextSlot(uint64_t* time, uint64_t* asn);
 void     ieee154e_syncSlotOffset(void);
 void     asnStoreFromEB(uint8_t* asn);
 void     joinPriorityStoreFromEB(uint8_t jp);
@@ -92,6 +95,7 @@ void     updateStats(PORT_SIGNED_INT_WIDTH timeCorrection);
 uint8_t  calculateFrequency(uint8_t channelOffset);
 void     changeState(ieee154e_state_t newstate);
 void     endSlot(void);
+void     skipIdleSlots(void);
 bool     debugPrint_asn(void);
 bool     debugPrint_isSync(void);
 // interrupts
@@ -150,30 +154,49 @@ void ieee154e_init() {
 
 \param[in] someASN some ASN to compare to the current
 
-\returns The ASN difference, or 0xffff if more than 65535 different
+\returns The ASN difference, or 0xffffffff if more than that, or if someASN is
+         ahead of the current ASN
 */
-PORT_RADIOTIMER_WIDTH ieee154e_asnDiff(asn_t* someASN) {
-   PORT_RADIOTIMER_WIDTH diff;
+uint32_t ieee154e_asnDiff(asn_t* someASN) {
+   uint64_t diff;
    INTERRUPT_DECLARATION();
+   
    DISABLE_INTERRUPTS();
-   if (ieee154e_vars.asn.byte4 != someASN->byte4) {
-      ENABLE_INTERRUPTS();
-      return (PORT_RADIOTIMER_WIDTH)0xFFFFFFFF;;
-   }
+   diff = ieee154e_asnToUint64(&ieee154e_vars.asn)-ieee154e_asnToUint64(someASN);
+   ENABLE_INTERRUPTS();
    
-   diff = 0;
-   if (ieee154e_vars.asn.bytes2and3 == someASN->bytes2and3) {
-      ENABLE_INTERRUPTS();
-      return ieee154e_vars.asn.bytes0and1-someASN->bytes0and1;
-   } else if (ieee154e_vars.asn.bytes2and3-someASN->bytes2and3==1) {
-      diff  = ieee154e_vars.asn.bytes0and1;
-      diff += 0xffff-someASN->bytes0and1;
-      diff += 1;
+   // an ASN ahead wraps around to more than 0xffffffff
+   return diff>0xffffffff ? 0xffffffff : (uint32_t)diff;
+}
+
+/**
+\brief Time at which a slot starts, as returned by opentimers_getTime().
+
+Extrapolated from the end of the current slot, so only meaningful while
+synchronized; the further the slot, the more time corrections it misses.
+
+The slot duration, in radiotimer ticks, is scaled to opentimers ticks, which
+differ on a board such as k20 (see PORT_RADIOTIMER_TICS_PER_S). The time is
+rounded to the first tick in the slot.
+
+\param[in] asn the ASN of the slot
+
+\returns The time the slot starts at, in ticks.
+*/
+uint64_t ieee154e_asnToTime(asn_t* asn) {
+   uint64_t nextTime;
+   uint64_t nextAsn;
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   ieee154e_nextSlot(&nextTime,&nextAsn);
+   ENABLE_INTERRUPTS();
+   
+   if (ieee154e_asnToUint64(asn)>=nextAsn) {
+      return nextTime+OPENTIMERS_FROM_RADIOTIMER_UP((ieee154e_asnToUint64(asn)-nextAsn)*TsSlotDuration);
    } else {
-      diff = (PORT_RADIOTIMER_WIDTH)0xFFFFFFFF;;
+      return nextTime-OPENTIMERS_FROM_RADIOTIMER((nextAsn-ieee154e_asnToUint64(asn))*TsSlotDuration);
    }
-   ENABLE_INTERRUPTS();
-   return diff;
 }
 
 //======= events
@@ -184,11 +207,14 @@ PORT_RADIOTIMER_WIDTH ieee154e_asnDiff(asn_t* someASN) {
 This function executes in ISR mode, when the new slot timer fires.
 */
 void isr_ieee154e_newSlot() {
+#ifdef SCHEDULER_STATS
+   scheduler_isr_enter(ISRID_IEEE154E_NEWSLOT);
+#endif
    radio_setTimerPeriod(TsSlotDuration);
    if (ieee154e_vars.isSync==FALSE) {
       if (idmanager_getIsDAGroot()==TRUE) {
          changeIsSync(TRUE);
-         incrementAsnOffset();
+         incrementAsnOffset(1);
          ieee154e_syncSlotOffset();
          ieee154e_vars.nextActiveSlotOffset = schedule_getNextActiveSlotOffset();
       } else {
@@ -202,6 +228,9 @@ void isr_ieee154e_newSlot() {
       activity_ti1ORri1();
    }
    ieee154e_dbg.num_newSlot++;
+#ifdef SCHEDULER_STATS
+   scheduler_isr_exit(ISRID_IEEE154E_NEWSLOT);
+#endif
 }
 
 /**
@@ -210,6 +239,9 @@ void isr_ieee154e_newSlot() {
 This function executes in ISR mode, when the FSM timer fires.
 */
 void isr_ieee154e_timer() {
+#ifdef SCHEDULER_STATS
+   scheduler_isr_enter(ISRID_IEEE154E_TIMER);
+#endif
    switch (ieee154e_vars.state) {
       case S_TXDATAOFFSET:
          activity_ti2();
@@ -281,6 +313,9 @@ void isr_ieee154e_timer() {
          break;
    }
    ieee154e_dbg.num_timer++;
+#ifdef SCHEDULER_STATS
+   scheduler_isr_exit(ISRID_IEEE154E_TIMER);
+#endif
 }
 
 /**
@@ -289,6 +324,9 @@ void isr_ieee154e_timer() {
 This function executes in ISR mode.
 */
 void ieee154e_startOfFrame(PORT_RADIOTIMER_WIDTH capturedTime) {
+#ifdef SCHEDULER_STATS
+   scheduler_isr_enter(ISRID_IEEE154E_STARTOFFRAME);
+#endif
    if (ieee154e_vars.isSync==FALSE) {
      activity_synchronize_startOfFrame(capturedTime);
    } else {
@@ -329,6 +367,9 @@ void ieee154e_startOfFrame(PORT_RADIOTIMER_WIDTH capturedTime) {
       }
    }
    ieee154e_dbg.num_startOfFrame++;
+#ifdef SCHEDULER_STATS
+   scheduler_isr_exit(ISRID_IEEE154E_STARTOFFRAME);
+#endif
 }
 
 /**
@@ -337,6 +378,9 @@ void ieee154e_startOfFrame(PORT_RADIOTIMER_WIDTH capturedTime) {
 This function executes in ISR mode.
 */
 void ieee154e_endOfFrame(PORT_RADIOTIMER_WIDTH capturedTime) {
+#ifdef SCHEDULER_STATS
+   scheduler_isr_enter(ISRID_IEEE154E_ENDOFFRAME);
+#endif
    if (ieee154e_vars.isSync==FALSE) {
       activity_synchronize_endOfFrame(capturedTime);
    } else {
@@ -364,6 +408,9 @@ void ieee154e_endOfFrame(PORT_RADIOTIMER_WIDTH capturedTime) {
       }
    }
    ieee154e_dbg.num_endOfFrame++;
+#ifdef SCHEDULER_STATS
+   scheduler_isr_exit(ISRID_IEEE154E_ENDOFFRAME);
+#endif
 }
 
 //======= misc
@@ -468,7 +515,7 @@ port_INLINE void activity_synchronize_newSlot() {
    }
    
    // increment ASN (used only to schedule serial activity)
-   incrementAsnOffset();
+   incrementAsnOffset(1);
    
    // to be able to receive and transmist serial even when not synchronized
    // take turns every 8 slots sending and receiving
@@ -821,13 +868,14 @@ port_INLINE bool ieee154e_processIEs(OpenQueueEntry_t* pkt, uint16_t* lenIE) {
 port_INLINE void activity_ti1ORri1() {
    cellType_t  cellType;
    open_addr_t neighbor;
-   uint8_t     i;
    sync_IE_ht  sync_IE;
    bool        changeToRX=FALSE;
    bool        couldSendEB=FALSE;
+   bool        dropped=FALSE;
+   OpenQueueEntry_t* ebToSend;
 
    // increment ASN (do this first so debug pins are in sync)
-   incrementAsnOffset();
+   incrementAsnOffset(1);
    
    // wiggle debug pins
    debugpins_slot_toggle();
@@ -849,6 +897,9 @@ port_INLINE void activity_ti1ORri1() {
             
          // update the statistics
          ieee154e_stats.numDeSync++;
+#ifdef OPENSIM
+         debugpins_state_changed(STATUS_MACSTATS);
+#endif
             
          // abort
          endSlot();
@@ -877,6 +928,8 @@ port_INLINE void activity_ti1ORri1() {
       ieee154e_vars.nextActiveSlotOffset = schedule_getNextActiveSlotOffset();
    } else {
       // this is NOT the next active slot, abort
+      // sleep through the following idle slots as well
+      skipIdleSlots();
       // stop using serial
       openserial_stop();
       // abort the slot
@@ -899,10 +952,22 @@ port_INLINE void activity_ti1ORri1() {
          if (schedule_getOkToSend()) {
             schedule_getNeighbor(&neighbor);
             ieee154e_vars.dataToSend = openqueue_macGetDataPacket(&neighbor);
-            if ((ieee154e_vars.dataToSend==NULL) && (cellType==CELLTYPE_TXRX)) {
-               couldSendEB=TRUE;
-               // look for an EB packet in the queue
-               ieee154e_vars.dataToSend = openqueue_macGetEBPacket();
+            if (ieee154e_vars.dataToSend!=NULL && openqueue_macDrop(ieee154e_vars.dataToSend)==TRUE) {
+               // waited too long in the queue, hand it back as not sent. At
+               // most one per cell, which sends nothing, for tt1 to be armed
+               // in time
+               notif_sendDone(ieee154e_vars.dataToSend,E_FAIL);
+               ieee154e_vars.dataToSend = NULL;
+               dropped                  = TRUE;
+            }
+            if (cellType==CELLTYPE_TXRX && dropped==FALSE) {
+               // look for an EB packet in the queue, sent ahead of data of a
+               // lower traffic class
+               ebToSend = openqueue_macGetEBPacket(ieee154e_vars.dataToSend);
+               if (ebToSend!=NULL) {
+                  couldSendEB=TRUE;
+                  ieee154e_vars.dataToSend = ebToSend;
+               }
             }
          }
          if (ieee154e_vars.dataToSend==NULL) {
@@ -953,9 +1018,7 @@ port_INLINE void activity_ti1ORri1() {
          radio_setTimerPeriod(TsSlotDuration*(NUMSERIALRX));
          
          //increase ASN by NUMSERIALRX-1 slots as at this slot is already incremented by 1
-         for (i=0;i<NUMSERIALRX-1;i++){
-            incrementAsnOffset();
-         }
+         incrementAsnOffset(NUMSERIALRX-1);
 #ifdef ADAPTIVE_SYNC
          // deal with the case when schedule multi slots
          adaptive_sync_countCompensationTimeout_compoundSlots(NUMSERIALRX-1);
@@ -983,7 +1046,13 @@ port_INLINE void activity_ti2() {
    changeState(S_TXDATAPREPARE);
 
    // make a local copy of the frame
-   packetfunctions_duplicatePacket(&ieee154e_vars.localCopyForTransmission, ieee154e_vars.dataToSend);
+   if (packetfunctions_duplicatePacket(&ieee154e_vars.localCopyForTransmission, ieee154e_vars.dataToSend) != E_SUCCESS) {
+      // no room for the copy, hand the packet back as not sent
+      notif_sendDone(ieee154e_vars.dataToSend,E_FAIL);
+      ieee154e_vars.dataToSend = NULL;
+      endSlot(); // abort
+      return;
+   }
 
    // check if packet needs to be encrypted/authenticated before transmission 
    if (ieee154e_vars.localCopyForTransmission.l2_securityLevel != IEEE154_ASH_SLF_TYPE_NOSEC) { // security enabled
@@ -1786,12 +1855,17 @@ port_INLINE bool isValidAck(ieee802154_header_iht* ieee802514_header, OpenQueueE
 
 //======= ASN handling
 
-port_INLINE void incrementAsnOffset() {
+/**
+\brief Advance the ASN and the offsets by numSlots slots, in constant time.
+*/
+port_INLINE void incrementAsnOffset(uint16_t numSlots) {
    frameLength_t frameLength;
+   uint32_t      bytes0and1;
    
    // increment the asn
-   ieee154e_vars.asn.bytes0and1++;
-   if (ieee154e_vars.asn.bytes0and1==0) {
+   bytes0and1                     = (uint32_t)ieee154e_vars.asn.bytes0and1+numSlots;
+   ieee154e_vars.asn.bytes0and1   = (uint16_t)bytes0and1;
+   if (bytes0and1>0xffff) {
       ieee154e_vars.asn.bytes2and3++;
       if (ieee154e_vars.asn.bytes2and3==0) {
          ieee154e_vars.asn.byte4++;
@@ -1801,11 +1875,28 @@ port_INLINE void incrementAsnOffset() {
    // increment the offsets
    frameLength = schedule_getFrameLength();
    if (frameLength == 0) {
-      ieee154e_vars.slotOffset++;
+      ieee154e_vars.slotOffset += numSlots;
    } else {
-      ieee154e_vars.slotOffset  = (ieee154e_vars.slotOffset+1)%frameLength;
+      ieee154e_vars.slotOffset  = (ieee154e_vars.slotOffset+numSlots)%frameLength;
    }
-   ieee154e_vars.asnOffset   = (ieee154e_vars.asnOffset+1)%16;
+   ieee154e_vars.asnOffset   = (ieee154e_vars.asnOffset+numSlots)%16;
+}
+
+port_INLINE uint64_t ieee154e_asnToUint64(asn_t* asn) {
+   return ((uint64_t)asn->byte4<<32) | ((uint32_t)asn->bytes2and3<<16) | asn->bytes0and1;
+}
+
+/**
+\brief Time and ASN of the next slot the slot timer starts.
+
+Compound slots advance the ASN when they start, so the next slot follows the
+current ASN when the slot timer fires, whatever its period. The radiotimer
+ticks left in the slot are scaled to opentimers ticks. Call with interrupts
+disabled.
+*/
+port_INLINE void ieee154e_nextSlot(uint64_t* time, uint64_t* asn) {
+   *time = opentimers_getTime()+OPENTIMERS_FROM_RADIOTIMER_UP((PORT_RADIOTIMER_WIDTH)(radio_getTimerPeriod()-radio_getTimerValue()));
+   *asn  = ieee154e_asnToUint64(&ieee154e_vars.asn)+1;
 }
 
 //from upper layer that want to send the ASN to compute timing or latency
@@ -1944,7 +2035,7 @@ void synchronizePacket(PORT_RADIOTIMER_WIDTH timeReceived) {
    // skip a slot and increase the temporary slot length to be 2 slots long
    if (currentValue<timeReceived || currentPeriod-currentValue<RESYNCHRONIZATIONGUARD) {
       newPeriod                  +=  TsSlotDuration;
-      incrementAsnOffset();
+      incrementAsnOffset(1);
    }
    newPeriod                      =  (PORT_RADIOTIMER_WIDTH)((PORT_SIGNED_INT_WIDTH)newPeriod+timeCorrection);
    
@@ -2042,8 +2133,14 @@ void notif_sendDone(OpenQueueEntry_t* packetSent, owerror_t error) {
    // associate this packet with the virtual component
    // COMPONENT_IEEE802154E_TO_RES so RES can knows it's for it
    packetSent->owner              = COMPONENT_IEEE802154E_TO_SIXTOP;
-   // post RES's sendDone task
-   scheduler_push_task(task_sixtopNotifSendDone,TASKPRIO_SIXTOP_NOTIF_TXDONE);
+   // it is no longer queued for transmission
+   openqueue_macDequeue(packetSent);
+   // post RES's sendDone task, which handles all the packets sent
+   scheduler_push_task_flags(
+      task_sixtopNotifSendDone,
+      TASKPRIO_SIXTOP_NOTIF_TXDONE,
+      TASK_FLAG_COALESCE
+   );
    // wake up the scheduler
    SCHEDULER_WAKEUP();
 }
@@ -2061,8 +2158,12 @@ void notif_receive(OpenQueueEntry_t* packetReceived) {
                    (errorparameter_t)packetReceived->l2_asn.bytes0and1,
                    (errorparameter_t)packetReceived->l2_timeCorrection);
 #endif
-   // post RES's Receive task
-   scheduler_push_task(task_sixtopNotifReceive,TASKPRIO_SIXTOP_NOTIF_RX);
+   // post RES's Receive task, which handles all the packets received
+   scheduler_push_task_flags(
+      task_sixtopNotifReceive,
+      TASKPRIO_SIXTOP_NOTIF_RX,
+      TASK_FLAG_COALESCE
+   );
    // wake up the scheduler
    SCHEDULER_WAKEUP();
 }
@@ -2070,6 +2171,9 @@ void notif_receive(OpenQueueEntry_t* packetReceived) {
 //======= stats
 
 port_INLINE void resetStats() {
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_MACSTATS);
+#endif
    ieee154e_stats.numSyncPkt      =    0;
    ieee154e_stats.numSyncAck      =    0;
    ieee154e_stats.minCorrection   =  127;
@@ -2080,6 +2184,9 @@ port_INLINE void resetStats() {
 }
 
 void updateStats(PORT_SIGNED_INT_WIDTH timeCorrection) {
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_MACSTATS);
+#endif
    // update minCorrection
    if (timeCorrection<ieee154e_stats.minCorrection) {
      ieee154e_stats.minCorrection = timeCorrection;
@@ -2196,6 +2303,9 @@ void endSlot() {
    ieee154e_vars.syncCapturedTime = 0;
    
    //computing duty cycle.
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_MACSTATS);
+#endif
    ieee154e_stats.numTicsOn+=ieee154e_vars.radioOnTics;//accumulate and tics the radio is on for that window
    ieee154e_stats.numTicsTotal+=radio_getTimerPeriod();//increment total tics by timer period.
 
@@ -2262,6 +2372,51 @@ void endSlot() {
    changeState(S_SLEEP);
 }
 
+/**
+\brief Stretch the current idle slot up to the start of the next active slot.
+
+Rather than waking up at each idle slot only to find out it is not active,
+the slot timer is programmed to fire at the next active slot. As for the other
+compound slots (serial RX, resynchronization), the ASN is advanced right
+away.
+
+Call this function from an idle slot, before endSlot().
+*/
+port_INLINE void skipIdleSlots() {
+   frameLength_t frameLength;
+   uint16_t      numSlots;
+   
+   frameLength = schedule_getFrameLength();
+   if (frameLength==0 || ieee154e_vars.nextActiveSlotOffset>=frameLength) {
+      return;
+   }
+   
+   // number of idle slots between this one and the next active one
+   numSlots = (ieee154e_vars.nextActiveSlotOffset+frameLength-ieee154e_vars.slotOffset-1)%frameLength;
+   if (numSlots>MAXSKIPPEDSLOTS) {
+      numSlots = MAXSKIPPEDSLOTS;
+   }
+   
+   // wake up in time to declare myself desynchronized
+   if (idmanager_getIsDAGroot()==FALSE) {
+      if (numSlots>=ieee154e_vars.deSyncTimeout) {
+         numSlots = ieee154e_vars.deSyncTimeout-1;
+      }
+      ieee154e_vars.deSyncTimeout -= numSlots;
+   }
+   
+   if (numSlots==0) {
+      return;
+   }
+   
+   // keep the time correction already applied to this slot
+   radio_setTimerPeriod(radio_getTimerPeriod()+numSlots*TsSlotDuration);
+   incrementAsnOffset(numSlots);
+#ifdef ADAPTIVE_SYNC
+   adaptive_sync_countCompensationTimeout_compoundSlots(numSlots);
+#endif
+}
+
 bool ieee154e_isSynch(){
    return ieee154e_vars.isSync;
 }
@@ -30,6 +30,7 @@ static const uint8_t chTemplate_default[] = {
 #define EBPERIOD                    30 // in seconds: sending EB every 30 seconds
 #define MAXKAPERIOD               2000 // in slots: @15ms per slot -> ~30 seconds. Max value used by adaptive synchronization.
 #define DESYNCTIMEOUT             2333 // in slots: @15ms per slot -> ~35 seconds. A larger DESYNCTIMEOUT is needed if using a larger KATIMEOUT.
+#define MAXSKIPPEDSLOTS           (0xffff/PORT_TsSlotDuration-2) // max number of idle slots merged into the current one, so the slot still fits a 16-bit timer
 #define LIMITLARGETIMECORRECTION     5 // threshold number of ticks to declare a timeCorrection "large"
 #define LENGTH_IEEE154_MAX         128 // max length of a valid radio packet  
 #define DUTY_CYCLE_WINDOW_LIMIT    (0xFFFFFFFF>>1) // limit of the dutycycle window
@@ -273,7 +274,8 @@ typedef struct {
 // admin
 void               ieee154e_init(void);
 // public
-PORT_RADIOTIMER_WIDTH   ieee154e_asnDiff(asn_t* someASN);
+uint32_t           ieee154e_asnDiff(asn_t* someASN);
+uint64_t           ieee154e_asnToTime(asn_t* asn);
 bool               ieee154e_isSynch(void);
 void               ieee154e_getAsn(uint8_t* array);
 void               ieee154e_setIsAckEnabled(bool isEnabled);
@@ -28,6 +28,8 @@ void IEEE802154_security_getFrameCounter(macFrameCounter_t reference,
                                          uint8_t*          array);
 uint8_t IEEE802154_security_authLengthChecking(uint8_t securityLevel);
 
+open_addr_t* IEEE802154_security_txKeySource(uint8_t keyIdMode);
+
 uint8_t IEEE802154_security_auxLengthChecking(uint8_t KeyIdMode,
                                               uint8_t    frameCounterSuppression,
                                               uint8_t frameCounterSize);
@@ -220,21 +222,18 @@ void IEEE802154_security_prependAuxiliarySecurityHeader(OpenQueueEntry_t* msg){
    //insert the keyIdMode field
    switch (msg->l2_keyIdMode){
       case IEEE154_ASH_KEYIDMODE_IMPLICIT: //no KeyIDMode field - implicit
-    	 temp_keySource = &ieee802154_security_vars.m_macDefaultKeySource;
-         memcpy(&(msg->l2_keySource), temp_keySource, sizeof(open_addr_t));
          break;
       case IEEE154_ASH_KEYIDMODE_DEFAULTKEYSOURCE:// macDefaultKeySource
-         msg->l2_keySource = ieee802154_security_vars.m_macDefaultKeySource;
          break;
       case IEEE154_ASH_KEYIDMODE_EXPLICIT_16: //keySource with 16b address
-         temp_keySource = &msg->l2_keySource;
+         temp_keySource = IEEE802154_security_txKeySource(msg->l2_keyIdMode);
          packetfunctions_reserveHeaderSize(msg, sizeof(uint8_t));
          *((uint8_t*)(msg->payload)) = temp_keySource->addr_64b[6];
          packetfunctions_reserveHeaderSize(msg, sizeof(uint8_t));
          *((uint8_t*)(msg->payload)) = temp_keySource->addr_64b[7];
          break;
       case IEEE154_ASH_KEYIDMODE_EXPLICIT_64: //keySource with 64b address
-         temp_keySource = &msg->l2_keySource;
+         temp_keySource = IEEE802154_security_txKeySource(msg->l2_keyIdMode);
          packetfunctions_writeAddress(msg,temp_keySource,OW_LITTLE_ENDIAN);
          break;
       default://error
@@ -291,15 +290,17 @@ owerror_t IEEE802154_security_outgoingFrameSecurity(OpenQueueEntry_t*   msg){
    uint8_t len_a;
    uint8_t* m;
    uint8_t len_m;
+   open_addr_t* keySource;
 
    //the frame counter is carried in the frame, otherwise 1;
    frameCounterSuppression = IEEE154_ASH_FRAMECOUNTER_SUPPRESSED;
 
    //search for a key
+   keySource = IEEE802154_security_txKeySource(msg->l2_keyIdMode);
    keyDescriptor = IEEE802154_security_keyDescriptorLookup(msg->l2_keyIdMode,
-                                                           &msg->l2_keySource,
+                                                           keySource,
                                                            msg->l2_keyIndex,
-                                                           &msg->l2_keySource,
+                                                           keySource,
                                                            (idmanager_getMyID(ADDR_PANID)),
                                                            msg->l2_frameType);
 
@@ -463,22 +464,22 @@ void IEEE802154_security_retrieveAuxiliarySecurityHeader(OpenQueueEntry_t*
       case IEEE154_ASH_KEYIDMODE_IMPLICIT:
          //key is derived implicitly
          temp_addr = &ieee802154_security_vars.m_macDefaultKeySource;
-         memcpy(&(msg->l2_keySource), temp_addr, sizeof(open_addr_t));
+         memcpy(&(ieee802154_security_vars.rxKeySource), temp_addr, sizeof(open_addr_t));
          break;
       case IEEE154_ASH_KEYIDMODE_DEFAULTKEYSOURCE:
-         msg->l2_keySource = ieee802154_security_vars.m_macDefaultKeySource;
+         ieee802154_security_vars.rxKeySource = ieee802154_security_vars.m_macDefaultKeySource;
          break;
       case IEEE154_ASH_KEYIDMODE_EXPLICIT_16:
          packetfunctions_readAddress(((uint8_t*)(msg->payload)+tempheader->headerLength),
                                      ADDR_16B,
-                                     &msg->l2_keySource,
+                                     &ieee802154_security_vars.rxKeySource,
                                      OW_LITTLE_ENDIAN);
          tempheader->headerLength+=2;
          break;
       case IEEE154_ASH_KEYIDMODE_EXPLICIT_64:
          packetfunctions_readAddress(((uint8_t*)(msg->payload)+tempheader->headerLength),
                                      ADDR_64B,
-                                     &msg->l2_keySource,
+                                     &ieee802154_security_vars.rxKeySource,
                                      OW_LITTLE_ENDIAN);
          tempheader->headerLength+=8;
          break;
@@ -520,9 +521,9 @@ owerror_t IEEE802154_security_incomingFrame(OpenQueueEntry_t* msg){
 
    //key descriptor lookup procedure
    keyDescriptor = IEEE802154_security_keyDescriptorLookup(msg->l2_keyIdMode,
-                                                          &msg->l2_keySource,
+                                                          &ieee802154_security_vars.rxKeySource,
                                                           msg->l2_keyIndex,
-                                                          &msg->l2_keySource,
+                                                          &ieee802154_security_vars.rxKeySource,
                                                           idmanager_getMyID(ADDR_PANID),
                                                           msg->l2_frameType);
 
@@ -534,7 +535,7 @@ owerror_t IEEE802154_security_incomingFrame(OpenQueueEntry_t* msg){
    }
 
    //device descriptor lookup
-   deviceDescriptor = IEEE802154_security_deviceDescriptorLookup(&msg->l2_keySource,
+   deviceDescriptor = IEEE802154_security_deviceDescriptorLookup(&ieee802154_security_vars.rxKeySource,
                                                                 idmanager_getMyID(ADDR_PANID),
                                                                 keyDescriptor);
 
@@ -675,6 +676,22 @@ uint8_t IEEE802154_security_authLengthChecking(uint8_t securityLevel){
    return authlen;
 }
 
+/**
+\brief Identification of the key source of a frame sent with the given KeyIdMode.
+       The implicit and default modes use the macDefaultKeySource, the explicit
+       ones our own 64-bit address, so it needs not be kept in the packet.
+*/
+open_addr_t* IEEE802154_security_txKeySource(uint8_t keyIdMode){
+
+   switch (keyIdMode) {
+      case IEEE154_ASH_KEYIDMODE_EXPLICIT_16:
+      case IEEE154_ASH_KEYIDMODE_EXPLICIT_64:
+         return idmanager_getMyID(ADDR_64B);
+      default:
+         return &ieee802154_security_vars.m_macDefaultKeySource;
+   }
+}
+
 /**
 \brief Identification of the length of the IEEE802.15.4 Auxiliary Security Header.
 */
@@ -215,7 +215,8 @@ void adaptive_sync_countCompensationTimeout_compoundSlots(uint16_t compoundSlots
    uint8_t  compensateTicks;
    uint16_t newSlotDuration;
    
-   newSlotDuration  = TsSlotDuration*(compoundSlots+1);
+   // the current slot already lasts compoundSlots+1 slots
+   newSlotDuration  = radio_getTimerPeriod();
    
    // if clockState is not set yet, don't compensate.
    if(adaptive_sync_vars.clockState == S_NONE) {
@@ -6,6 +6,7 @@
 #include "openserial.h"
 #include "IEEE802154E.h"
 #include "fragment.h"
+#include "debugpins.h"
 
 //=========================== variables =======================================
 
@@ -36,6 +37,9 @@ void neighbors_init() {
    
    // clear module variables
    memset(&neighbors_vars,0,sizeof(neighbors_vars_t));
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_NEIGHBORS);
+#endif
    
    // set myDAGrank
    if (idmanager_getIsDAGroot()==TRUE) {
@@ -86,6 +90,10 @@ bool neighbors_getPreferredParentEui64(open_addr_t* addressToWrite) {
    dagrank_t minRankVal;
    uint8_t   minRankIdx;
    
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_NEIGHBORS);
+#endif
+   
    addressToWrite->type = ADDR_NONE;
    
    foundPreferred       = FALSE;
@@ -141,7 +149,7 @@ conditions:
 */
 open_addr_t* neighbors_getKANeighbor(uint16_t kaPeriod) {
    uint8_t         i;
-   uint16_t        timeSinceHeard;
+   uint32_t        timeSinceHeard;
    open_addr_t*    addrPreferred;
    open_addr_t*    addrOther;
    
@@ -321,6 +329,10 @@ void neighbors_indicateRx(open_addr_t* l2_src,
    uint8_t i;
    bool    newNeighbor;
    
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_NEIGHBORS);
+#endif
+   
    // update existing neighbor
    newNeighbor = TRUE;
    for (i=0;i<MAXNUMNEIGHBORS;i++) {
@@ -395,6 +407,10 @@ void neighbors_indicateTx(open_addr_t* l2_dest,
                           bool         was_finally_acked,
                           asn_t*       asnTs) {
    uint8_t i;
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_NEIGHBORS);
+#endif
+   
    // don't run through this function if packet was sent to broadcast address
    if (packetfunctions_isBroadcastMulticast(l2_dest)==TRUE) {
       return;
@@ -438,6 +454,10 @@ void neighbors_indicateRxDIO(OpenQueueEntry_t* msg) {
    uint8_t          i;
    uint8_t          temp_8b;
   
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_NEIGHBORS);
+#endif
+  
    // take ownership over the packet
    msg->owner = COMPONENT_NEIGHBORS;
    
@@ -488,10 +508,34 @@ void  neighbors_getNeighbor(open_addr_t* address, uint8_t addr_type, uint8_t ind
    }
 }
 
+/**
+\brief Find the row of the neighbor table a neighbor is in.
+
+\param[in] address The 64-bit address of the neighbor.
+
+\returns The index of its row, or MAXNUMNEIGHBORS if it is not a neighbor.
+*/
+uint8_t neighbors_getIndex(open_addr_t* address) {
+   uint8_t i;
+   
+   if (address->type!=ADDR_64B) {
+      return MAXNUMNEIGHBORS;
+   }
+   for (i=0;i<MAXNUMNEIGHBORS;i++) {
+      if (isThisRowMatching(address,i)) {
+         return i;
+      }
+   }
+   return MAXNUMNEIGHBORS;
+}
+
 //===== setters
 
 void neighbors_setMyDAGrank(dagrank_t rank){
     neighbors_vars.myDAGrank = rank;
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_NEIGHBORS);
+#endif
 }
 
 //===== managing routing info
@@ -513,6 +557,10 @@ void neighbors_updateMyDAGrankAndNeighborPreference() {
    bool      prefParentFound;
    uint32_t  rankIncreaseIntermediary; // stores intermediary results of rankIncrease calculation
    
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_NEIGHBORS);
+#endif
+   
    // if I'm a DAGroot, my DAGrank is always MINHOPRANKINCREASE
    if ((idmanager_getIsDAGroot())==TRUE) {
        // the dagrank is not set through setting command, set rank to MINHOPRANKINCREASE here 
@@ -567,7 +615,11 @@ void neighbors_updateMyDAGrankAndNeighborPreference() {
 
 void  neighbors_removeOld() {
    uint8_t    i;
-   uint16_t   timeSinceHeard;
+   uint32_t   timeSinceHeard;
+   
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_NEIGHBORS);
+#endif
    
    for (i=0;i<MAXNUMNEIGHBORS;i++) {
       if (neighbors_vars.neighbors[i].used==1) {
@@ -674,6 +726,7 @@ bool isNeighbor(open_addr_t* neighbor) {
 
 void removeNeighbor(uint8_t neighborIndex) {
    fragment_deleteNeighbor(&(neighbors_vars.neighbors[neighborIndex].addr_64b));
+   openqueue_neighborRemoved(neighborIndex);
    neighbors_vars.neighbors[neighborIndex].used                      = FALSE;
    neighbors_vars.neighbors[neighborIndex].parentPreference          = 0;
    neighbors_vars.neighbors[neighborIndex].stableNeighbor            = FALSE;
@@ -105,6 +105,7 @@ void          neighbors_indicateRxDIO(OpenQueueEntry_t* msg);
 
 // get addresses
 void          neighbors_getNeighbor(open_addr_t* address,uint8_t addr_type,uint8_t index);
+uint8_t       neighbors_getIndex(open_addr_t* address);
 // managing routing info
 void          neighbors_updateMyDAGrankAndNeighborPreference(void);
 // maintenance
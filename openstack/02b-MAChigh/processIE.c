@@ -346,10 +346,6 @@ port_INLINE uint8_t processIE_prependScheduleIE(
       }
    }
    
-   // record the position of cellObjects
-   pkt->l2_scheduleIE_numOfCells  = numOfCells;
-   pkt->l2_scheduleIE_cellObjects = pkt->payload;
-   
    //===== number of cells
    
    // reserve space
@@ -376,9 +372,6 @@ port_INLINE uint8_t processIE_prependScheduleIE(
    *((uint8_t*)(pkt->payload)) = temp8b;
    
    len += 1;
-  
-   // record the frameID 
-   pkt->l2_scheduleIE_frameID = frameID;
    
    //===== length
    
@@ -5,6 +5,7 @@
 #include "packetfunctions.h"
 #include "sixtop.h"
 #include "idmanager.h"
+#include "debugpins.h"
 
 //=========================== variables =======================================
 
@@ -30,6 +31,9 @@ void schedule_init() {
 
    // reset local variables
    memset(&schedule_vars,0,sizeof(schedule_vars_t));
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    for (running_slotOffset=0;running_slotOffset<MAXACTIVESLOTS;running_slotOffset++) {
       schedule_resetEntry(&schedule_vars.scheduleBuf[running_slotOffset]);
    }
@@ -175,6 +179,9 @@ void schedule_setFrameLength(frameLength_t newFrameLength) {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    schedule_vars.frameLength = newFrameLength;
    if (newFrameLength <= MAXACTIVESLOTS) {
@@ -192,6 +199,9 @@ void schedule_setFrameHandle(uint8_t frameHandle) {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    schedule_vars.frameHandle = frameHandle;
    
@@ -207,6 +217,9 @@ void schedule_setFrameNumber(uint8_t frameNumber) {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    schedule_vars.frameNumber = frameNumber;
    
@@ -279,6 +292,9 @@ owerror_t schedule_addActiveSlot(
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    // find an empty schedule entry container
    slotContainer = &schedule_vars.scheduleBuf[0];
@@ -365,6 +381,9 @@ owerror_t schedule_removeActiveSlot(slotOffset_t slotOffset, open_addr_t* neighb
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    // find the schedule entry
    slotContainer = &schedule_vars.scheduleBuf[0];
@@ -483,6 +502,9 @@ void schedule_syncSlotOffset(slotOffset_t targetSlotOffset) {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    while (schedule_vars.currentScheduleEntry->slotOffset!=targetSlotOffset) {
       schedule_advanceSlot();
@@ -498,6 +520,9 @@ void schedule_advanceSlot() {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    schedule_vars.currentScheduleEntry = schedule_vars.currentScheduleEntry->next;
    
@@ -641,6 +666,9 @@ bool schedule_getOkToSend() {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    if (schedule_vars.currentScheduleEntry->shared==FALSE) {
       // non-shared slot: backoff does not apply
@@ -674,6 +702,9 @@ void schedule_resetBackoff() {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    // reset backoffExponent
    schedule_vars.backoffExponent = MINBE-1;
@@ -690,6 +721,9 @@ void schedule_indicateRx(asn_t* asnTimestamp) {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    // increment usage statistics
    schedule_vars.currentScheduleEntry->numRx++;
@@ -707,6 +741,9 @@ void schedule_indicateTx(asn_t* asnTimestamp, bool succesfullTx) {
    
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_SCHEDULE);
+#endif
    
    // increment usage statistics
    if (schedule_vars.currentScheduleEntry->numTx==0xFF) {
@@ -35,6 +35,11 @@ owerror_t     sixtop_send_internal(
 void          sixtop_maintenance_timer_cb(opentimer_id_t id);
 void          sixtop_timeout_timer_cb(opentimer_id_t id);
 
+//=== from lower layer
+
+void          sixtop_notifSendDone(OpenQueueEntry_t* msg);
+void          sixtop_notifReceive(OpenQueueEntry_t* msg);
+
 //=== EB/KA task
 
 void          timer_sixtop_management_fired(void);
@@ -128,6 +133,7 @@ void sixtop_init() {
    
    sixtop_vars.maintenanceTimerId = opentimers_start(
       sixtop_vars.periodMaintenance,
+      SIXTOP_MAINTENANCE_SLACK_MS,
       TIMER_PERIODIC,
       TIME_MS,
       sixtop_maintenance_timer_cb
@@ -135,6 +141,7 @@ void sixtop_init() {
    
    sixtop_vars.timeoutTimerId     = opentimers_start(
       SIX2SIX_TIMEOUT_MS,
+      SIX2SIX_SLACK_MS,
       TIMER_ONESHOT,
       TIME_MS,
       sixtop_timeout_timer_cb
@@ -225,6 +232,10 @@ void sixtop_addCells(open_addr_t* neighbor, uint16_t numCells){
       sizeof(open_addr_t)
    );
    
+   // keep the cells, for sixtop_six2six_sendDone() to schedule
+   sixtop_vars.frameID = frameID;
+   memcpy(sixtop_vars.cellList,cellList,sizeof(sixtop_vars.cellList));
+   
    // create packet
    len  = 0;
    len += processIE_prependScheduleIE(pkt,type,frameID,flag,cellList);
@@ -307,6 +318,10 @@ void sixtop_removeCell(open_addr_t* neighbor){
    );
  
    
+   // keep the cells, for sixtop_six2six_sendDone() to schedule
+   sixtop_vars.frameID = frameID;
+   memcpy(sixtop_vars.cellList,cellList,sizeof(sixtop_vars.cellList));
+   
    // create packet
    len  = 0;
    len += processIE_prependScheduleIE(pkt,type,frameID, flag,cellList);
@@ -386,6 +401,10 @@ void sixtop_removeCellByInfo(open_addr_t*  neighbor,cellInfo_ht* cellInfo){
    );
  
    
+   // keep the cells, for sixtop_six2six_sendDone() to schedule
+   sixtop_vars.frameID = frameID;
+   memcpy(sixtop_vars.cellList,cellList,sizeof(sixtop_vars.cellList));
+   
    // create packet
    len  = 0;
    len += processIE_prependScheduleIE(pkt,type,frameID, flag,cellList);
@@ -458,20 +477,37 @@ owerror_t sixtop_send(OpenQueueEntry_t *msg) {
 
 //======= from lower layer
 
+/**
+\brief Handle all the packets sent by the MAC layer.
+
+This task is pushed with TASK_FLAG_COALESCE, once for any number of packets
+sent since it last ran. It may therefore find no packet, when it handled the
+packet which pushed it the last time it ran.
+*/
 void task_sixtopNotifSendDone() {
    OpenQueueEntry_t* msg;
    
-   // get recently-sent packet from openqueue
-   msg = openqueue_sixtopGetSentPacket();
-   if (msg==NULL) {
-      openserial_printCritical(
-         COMPONENT_SIXTOP,
-         ERR_NO_SENT_PACKET,
-         (errorparameter_t)0,
-         (errorparameter_t)0
-      );
-      return;
+   // get recently-sent packets from openqueue
+   while ((msg=openqueue_sixtopGetSentPacket())!=NULL) {
+      sixtop_notifSendDone(msg);
+   }
+}
+
+/**
+\brief Handle all the packets received by the MAC layer.
+
+Same as task_sixtopNotifSendDone(), for received packets.
+*/
+void task_sixtopNotifReceive() {
+   OpenQueueEntry_t* msg;
+   
+   // get received packets from openqueue
+   while ((msg=openqueue_sixtopGetReceivedPacket())!=NULL) {
+      sixtop_notifReceive(msg);
    }
+}
+
+void sixtop_notifSendDone(OpenQueueEntry_t* msg) {
    
    // take ownership
    msg->owner = COMPONENT_SIXTOP;
@@ -532,22 +568,9 @@ void task_sixtopNotifSendDone() {
    }
 }
 
-void task_sixtopNotifReceive() {
-   OpenQueueEntry_t* msg;
+void sixtop_notifReceive(OpenQueueEntry_t* msg) {
    uint16_t          lenIE;
    
-   // get received packet from openqueue
-   msg = openqueue_sixtopGetReceivedPacket();
-   if (msg==NULL) {
-      openserial_printCritical(
-         COMPONENT_SIXTOP,
-         ERR_NO_RECEIVED_PACKET,
-         (errorparameter_t)0,
-         (errorparameter_t)0
-      );
-      return;
-   }
-   
    // take ownership
    msg->owner = COMPONENT_SIXTOP;
    
@@ -691,9 +714,9 @@ owerror_t sixtop_send_internal(
                             msg->l2_dsn,
                             &(msg->l2_nextORpreviousHop)
                             );
-   // change owner to IEEE802154E fetches it from queue
-   msg->owner  = COMPONENT_SIXTOP_TO_IEEE802154E;
-   return E_SUCCESS;
+   // change owner to IEEE802154E fetches it from queue, behind the packets
+   // already queued to the same neighbor
+   return openqueue_sixtopEnqueue(msg);
 }
 
 // timer interrupt callbacks
@@ -904,14 +927,7 @@ void timer_sixtop_six2six_timeout_fired(void) {
 }
 
 void sixtop_six2six_sendDone(OpenQueueEntry_t* msg, owerror_t error){
-   uint8_t i,numOfCells;
-   uint8_t* ptr;
-   cellInfo_ht cellList[SCHEDULEIEMAXNUMCELLS];
    
-   memset(cellList,0,SCHEDULEIEMAXNUMCELLS*sizeof(cellInfo_ht));
-  
-   ptr = msg->l2_scheduleIE_cellObjects;
-   numOfCells = msg->l2_scheduleIE_numOfCells;
    msg->owner = COMPONENT_SIXTOP_RES;
   
    if(error == E_FAIL) {
@@ -925,44 +941,22 @@ void sixtop_six2six_sendDone(OpenQueueEntry_t* msg, owerror_t error){
          sixtop_vars.six2six_state = SIX_WAIT_ADDRESPONSE;
          break;
       case SIX_WAIT_ADDRESPONSE_SENDDONE:
-         if (error == E_SUCCESS && numOfCells > 0){
-             for (i=0;i<numOfCells;i++){
-               //TimeSlot 2B
-               cellList[i].tsNum       = *(ptr);
-               cellList[i].tsNum      |= (*(ptr+1))<<8;
-               //Ch.Offset 2B
-               cellList[i].choffset    = *(ptr+2);
-               cellList[i].choffset   |= (*(ptr+3))<<8;
-               //LinkOption bitmap 1B
-               cellList[i].linkoptions = *(ptr+4);
-               ptr += 5;
-             }
+         if (error == E_SUCCESS){
              sixtop_addCellsByState(
-                 msg->l2_scheduleIE_frameID,
-                 numOfCells,
-                 cellList,
+                 sixtop_vars.frameID,
+                 SCHEDULEIEMAXNUMCELLS,
+                 sixtop_vars.cellList,
                  &(msg->l2_nextORpreviousHop),
                  sixtop_vars.six2six_state);
          }
          sixtop_vars.six2six_state = SIX_IDLE;
          break;
       case SIX_WAIT_REMOVEREQUEST_SENDDONE:
-         if(error == E_SUCCESS && numOfCells > 0){
-            for (i=0;i<numOfCells;i++){
-               //TimeSlot 2B
-               cellList[i].tsNum       = *(ptr);
-               cellList[i].tsNum      |= (*(ptr+1))<<8;
-               //Ch.Offset 2B
-               cellList[i].choffset    = *(ptr+2);
-               cellList[i].choffset   |= (*(ptr+3))<<8;
-               //LinkOption bitmap 1B
-               cellList[i].linkoptions = *(ptr+4);
-               ptr += 5;
-            }
+         if(error == E_SUCCESS){
             sixtop_removeCellsByState(
-               msg->l2_scheduleIE_frameID,
-               numOfCells,
-               cellList,
+               sixtop_vars.frameID,
+               SCHEDULEIEMAXNUMCELLS,
+               sixtop_vars.cellList,
                &(msg->l2_nextORpreviousHop)
             );
          }
@@ -1188,6 +1182,11 @@ void sixtop_linkResponse(
    sixtopPkt->owner   = COMPONENT_SIXTOP_RES;
     
    memcpy(&(sixtopPkt->l2_nextORpreviousHop),tempNeighbor,sizeof(open_addr_t));
+   
+   // keep the cells, for sixtop_six2six_sendDone() to schedule
+   sixtop_vars.frameID = frameID;
+   memcpy(sixtop_vars.cellList,cellList,sizeof(sixtop_vars.cellList));
+   
    // set SubFrameAndLinkIE
    len += processIE_prependScheduleIE(sixtopPkt,
                                                   type,
@@ -48,6 +48,8 @@ typedef enum {
 //=========================== typedef =========================================
 
 #define SIX2SIX_TIMEOUT_MS 4000
+#define SIX2SIX_SLACK_MS   500
+#define SIXTOP_MAINTENANCE_SLACK_MS 250 // how late maintenance may run, to share a wakeup
 #define SIXTOP_MINIMAL_EBPERIOD 5 // minist period of sending EB
 
 //=========================== module variables ================================
@@ -65,6 +67,8 @@ typedef struct {
    six2six_state_t      six2six_state;
    uint8_t              commandID;
    six2six_handler_t    handler;
+   uint8_t              frameID;                 // slotframe of the cells in the 6top packet in flight
+   cellInfo_ht          cellList[SCHEDULEIEMAXNUMCELLS]; // cells in the 6top packet in flight
 } sixtop_vars_t;
 
 //=========================== prototypes ======================================
@@ -8,6 +8,10 @@
 #include "forwarding.h"
 #include "openbridge.h"
 #include "openserial.h"
+#include "openqueue.h"
+#include "idmanager.h"
+#include "IEEE802154E.h"
+#include <stdio.h>
 
 //=========================== variables =======================================
 
@@ -46,7 +50,7 @@ void fragment_cancelToBridge(FragmentQueueEntry_t* buffer);
 bool fragment_completeRX(FragmentQueueEntry_t* buffer);
 // timer
 void fragment_disableTimer(FragmentQueueEntry_t* buffer);
-void fragment_activateTimer(FragmentQueueEntry_t* buffer);
+void fragment_activateTimer(FragmentQueueEntry_t* buffer, asn_t* rxAsn);
 
 // action functions
 void fragment_action(FragmentQueueEntry_t* buffer);
@@ -313,7 +317,7 @@ void fragment_retrieveHeader(OpenQueueEntry_t* msg) {
 
    // First received fragment: activate timer.
    if (buffer->number==1)
-      fragment_activateTimer(buffer);
+      fragment_activateTimer(buffer,&msg->l2_asn);
    // last received fragment = completed message: stop timer
    else if ( fragment_completeRX(buffer) )
       fragment_disableTimer(buffer);
@@ -471,7 +475,7 @@ bool fragment_completeRX(FragmentQueueEntry_t* buffer) {
 }
 
 /**
-\brief Store a fragment in a packet to send it
+\brief Reserve a packet to send a fragment in, referencing its payload
 
 \note Must be called in interrupted mode
 */
@@ -494,7 +498,7 @@ owerror_t fragment_reservePkt(FragmentQueueEntry_t* buffer, uint8_t fragment) {
 
    buffer->list[fragment].state = FRAGMENT_RESERVING;
    ENABLE_INTERRUPTS();
-   pkt = openqueue_getFreePacketBuffer(COMPONENT_FRAGMENT);
+   pkt = openqueue_getFreeFragmentBuffer(buffer->msg);
    DISABLE_INTERRUPTS();
    if (pkt==NULL) {
       buffer->list[fragment].state = FRAGMENT_ASSIGNED;
@@ -507,10 +511,11 @@ owerror_t fragment_reservePkt(FragmentQueueEntry_t* buffer, uint8_t fragment) {
    offset           = buffer->list[fragment].fragment_offset;
    ENABLE_INTERRUPTS();
    actual_sent      = (fragment == 0) ? 0 : (offset<<3);
-   if ( actual_frag_size > 0 ) {
-      packetfunctions_reserveHeaderSize(pkt, actual_frag_size * sizeof(uint8_t));
-      memcpy(pkt->payload, buffer->msg->payload+actual_sent, actual_frag_size * sizeof(uint8_t));
-   }
+   // the payload is not copied: the MAC reads it from the message,
+   // which is kept until all fragments are done
+   pkt->fragmentPayload = buffer->msg->payload+actual_sent;
+   pkt->fragmentLength  = actual_frag_size;
+   pkt->length          = actual_frag_size;
    if ( fragment != 0 ) { // offset
       packetfunctions_reserveHeaderSize(pkt, sizeof(uint8_t));
       fragment_setOffset(pkt, offset);
@@ -930,11 +935,18 @@ void fragment_timeout_timer_cb(opentimer_id_t id) {
    ENABLE_INTERRUPTS();
 }
 
-void fragment_activateTimer(FragmentQueueEntry_t* buffer) {
+void fragment_activateTimer(FragmentQueueEntry_t* buffer, asn_t* rxAsn) {
+   uint64_t timeout;
    INTERRUPT_DECLARATION();
+
+   // RFC 4944: the timeout runs from the reception of the first fragment,
+   // not from when this task gets to it
+   timeout = ieee154e_asnToTime(rxAsn)+opentimers_toTicks(FRAGMENT_TIMEOUT_MS,TIME_MS);
    DISABLE_INTERRUPTS();
    if (buffer->timerId==TOO_MANY_TIMERS_ERROR)
-      buffer->timerId = opentimers_start(FRAGMENT_TIMEOUT_MS,
+      buffer->timerId = opentimers_startAt(timeout,
+                     FRAGMENT_TIMEOUT_MS,
+                     FRAGMENT_SLACK_MS,
                      TIMER_ONESHOT, TIME_MS, fragment_timeout_timer_cb);
    // I am not checking TOO_MANY_TIMERS_ERROR. If you are experiencing
    // problems in your network, increase FRAGQLENGTH and MAX_NUM_TIMERS
@@ -1037,7 +1049,7 @@ void fragment_assemble(FragmentQueueEntry_t* buffer) {
 	 }
       if ( received >= 125 ) { // ask for a large packet
          ENABLE_INTERRUPTS();
-         if ( openqueue_toBigPacket(buffer->msg, received) == NULL ) {
+         if ( openqueue_toBigPacket(buffer->msg, received, 0) == NULL ) {
             openserial_printError(COMPONENT_FRAGMENT,
                                   ERR_NO_FREE_PACKET_BUFFER,
                                   (errorparameter_t)0,
@@ -9,6 +9,7 @@
 */
 
 #include "opendefs.h"
+#include "opentimers.h"
 
 //=========================== define ==========================================
 
@@ -34,7 +35,7 @@ typedef enum fragment_states {
    // outgoing values
    FRAGMENT_ASSIGNED,  // assigned for an outgoing fragment
    FRAGMENT_RESERVING, // trying to acquire a OpenQueue packet
-   FRAGMENT_RESERVED,  // payload copied to OpenQueue packet
+   FRAGMENT_RESERVED,  // OpenQueue packet referencing the payload
                        // message fragment ready to be forwarded
                        // message fragment ready to be sent
    FRAGMENT_SENDING,   // packet attempted to be sent (on layer 2)
@@ -82,6 +83,7 @@ typedef enum fragment_actions {
 #define FRAGMENT_MOTE2PC_TOMESH   ((uint8_t)'T')
 
 #define FRAGMENT_TIMEOUT_MS     60000
+#define FRAGMENT_SLACK_MS       6000
 #define FRAGMENT_TX_MAX_PACKETS     1
 
 //=========================== typedef =========================================
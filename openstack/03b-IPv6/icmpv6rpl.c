@@ -76,6 +76,7 @@ void icmpv6rpl_init() {
    dioPeriod                                = icmpv6rpl_vars.dioPeriod - 0x80 + (openrandom_get16b()&0xff);
    icmpv6rpl_vars.timerIdDIO                = opentimers_start(
                                                 dioPeriod,
+                                                TIMER_DIO_SLACK,
                                                 TIMER_PERIODIC,
                                                 TIME_MS,
                                                 icmpv6rpl_timer_DIO_cb
@@ -124,6 +125,7 @@ void icmpv6rpl_init() {
    daoPeriod                                = icmpv6rpl_vars.daoPeriod - 0x80 + (openrandom_get16b()&0xff);
    icmpv6rpl_vars.timerIdDAO                = opentimers_start(
                                                 daoPeriod,
+                                                TIMER_DAO_SLACK,
                                                 TIMER_PERIODIC,
                                                 TIME_MS,
                                                 icmpv6rpl_timer_DAO_cb
@@ -253,7 +255,7 @@ void icmpv6rpl_receive(OpenQueueEntry_t* msg) {
    task.
 */
 void icmpv6rpl_timer_DIO_cb(opentimer_id_t id) {
-   scheduler_push_task(icmpv6rpl_timer_DIO_task,TASKPRIO_RPL);
+   scheduler_push_task_deadline(icmpv6rpl_timer_DIO_task,TASKPRIO_RPL,TASK_DURATION_SENDPKT,TASK_DEADLINE_SENDPKT);
 }
 
 /**
@@ -369,7 +371,7 @@ void sendDIO() {
    task.
 */
 void icmpv6rpl_timer_DAO_cb(opentimer_id_t id) {
-   scheduler_push_task(icmpv6rpl_timer_DAO_task,TASKPRIO_RPL);
+   scheduler_push_task_deadline(icmpv6rpl_timer_DAO_task,TASKPRIO_RPL,TASK_DURATION_SENDPKT,TASK_DEADLINE_SENDPKT);
 }
 
 /**
@@ -14,6 +14,8 @@
 
 #define TIMER_DIO_TIMEOUT         10000
 #define TIMER_DAO_TIMEOUT         60000
+#define TIMER_DIO_SLACK           1000
+#define TIMER_DAO_SLACK           6000
 
 // Non-Storing Mode of Operation (1)
 #define MOP_DIO_A                 0<<5
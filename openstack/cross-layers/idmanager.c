@@ -5,6 +5,7 @@
 #include "openserial.h"
 #include "neighbors.h"
 #include "schedule.h"
+#include "debugpins.h"
 
 //=========================== variables =======================================
 
@@ -18,6 +19,9 @@ void idmanager_init() {
    
    // reset local variables
    memset(&idmanager_vars, 0, sizeof(idmanager_vars_t));
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_ID);
+#endif
    
    // isDAGroot
 #ifdef DAGROOT
@@ -67,6 +71,9 @@ bool idmanager_getIsDAGroot() {
 void idmanager_setIsDAGroot(bool newRole) {
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+#ifdef OPENSIM
+   debugpins_state_changed(STATUS_ID);
+#endif
    idmanager_vars.isDAGroot = newRole;
    neighbors_updateMyDAGrankAndNeighborPreference();
    schedule_startDAGroot();
@@ -104,20 +111,21 @@ open_addr_t* idmanager_getMyID(uint8_t type) {
 }
 
 owerror_t idmanager_setMyID(open_addr_t* newID) {
+   open_addr_t* myID;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
    switch (newID->type) {
      case ADDR_16B:
-        memcpy(&idmanager_vars.my16bID,newID,sizeof(open_addr_t));
+        myID = &idmanager_vars.my16bID;
         break;
      case ADDR_64B:
-        memcpy(&idmanager_vars.my64bID,newID,sizeof(open_addr_t));
+        myID = &idmanager_vars.my64bID;
         break;
      case ADDR_PANID:
-        memcpy(&idmanager_vars.myPANID,newID,sizeof(open_addr_t));
+        myID = &idmanager_vars.myPANID;
         break;
      case ADDR_PREFIX:
-        memcpy(&idmanager_vars.myPrefix,newID,sizeof(open_addr_t));
+        myID = &idmanager_vars.myPrefix;
         break;
      case ADDR_128B:
         //don't set 128b, but rather prefix and 64b
@@ -128,6 +136,13 @@ owerror_t idmanager_setMyID(open_addr_t* newID) {
         ENABLE_INTERRUPTS();
         return E_FAIL;
    }
+#ifdef OPENSIM
+   // RPL sets the prefix again on each DIO
+   if (memcmp(myID,newID,sizeof(open_addr_t))!=0) {
+      debugpins_state_changed(STATUS_ID);
+   }
+#endif
+   memcpy(myID,newID,sizeof(open_addr_t));
    ENABLE_INTERRUPTS();
    return E_SUCCESS;
 }
@@ -4,6 +4,8 @@
 #include "packetfunctions.h"
 #include "IEEE802154E.h"
 #include "ieee802154_security_driver.h"
+#include "fragment.h"
+#include "debugpins.h"
 
 //=========================== variables =======================================
 
@@ -11,11 +13,41 @@ openqueue_vars_t openqueue_vars;
 
 bigqueue_vars_t bigqueue_vars;
 
+static const uint8_t openqueue_reserved[OPENQUEUE_NUMCLASSES] = {
+   OPENQUEUE_RESERVED_CONTROL,
+   OPENQUEUE_RESERVED_6P,
+   OPENQUEUE_RESERVED_FORWARD,
+   OPENQUEUE_RESERVED_LOCAL,
+   OPENQUEUE_RESERVED_RX,
+};
+
+static const uint8_t openqueue_maxShare[OPENQUEUE_NUMCLASSES] = {
+   OPENQUEUE_MAXSHARE_CONTROL,
+   OPENQUEUE_MAXSHARE_6P,
+   OPENQUEUE_MAXSHARE_FORWARD,
+   OPENQUEUE_MAXSHARE_LOCAL,
+   OPENQUEUE_MAXSHARE_RX,
+};
+
+static const uint16_t openqueue_maxSojourn[OPENQUEUE_NUMCLASSES] = {
+   OPENQUEUE_MAXSOJOURN_CONTROL,
+   OPENQUEUE_MAXSOJOURN_6P,
+   OPENQUEUE_MAXSOJOURN_FORWARD,
+   OPENQUEUE_MAXSOJOURN_LOCAL,
+   OPENQUEUE_MAXSOJOURN_RX,
+};
+
 //=========================== prototypes ======================================
 
 void openqueue_reset_entry(OpenQueueEntry_t* entry);
-
-void bigqueue_reset_entry(BigQueueEntry_t* entry);
+uint8_t openqueue_ctz(uint32_t bitmap);
+uint8_t openqueue_class(uint8_t creator);
+OpenQueueEntry_t* openqueue_allocate(uint8_t creator, uint8_t cls);
+bool    openqueue_admit(uint8_t cls);
+void    openqueue_macInsert(uint8_t list, uint8_t i);
+void    openqueue_macUnlink(uint8_t i);
+uint8_t openqueue_macFirst(uint8_t list, open_addr_t* toNeighbor);
+uint8_t openqueue_macBefore(uint8_t i, uint8_t j);
 
 //=========================== public ==========================================
 
@@ -26,11 +58,20 @@ void bigqueue_reset_entry(BigQueueEntry_t* entry);
 */
 void openqueue_init() {
    uint8_t i;
+   openqueue_vars.freeEntries = OPENQUEUE_ALLENTRIES;
+   memset(&openqueue_vars.macList[0],OPENQUEUE_NOENTRY,sizeof(openqueue_vars.macList));
+   memset(&openqueue_vars.macHead[0],OPENQUEUE_NOENTRY,sizeof(openqueue_vars.macHead));
+   memset(&openqueue_vars.macTail[0],OPENQUEUE_NOENTRY,sizeof(openqueue_vars.macTail));
+   openqueue_vars.macSeqNext = 0;
+   memset(&openqueue_vars.numInClass[0],0,sizeof(openqueue_vars.numInClass));
+   memset(&openqueue_vars.numRefused[0],0,sizeof(openqueue_vars.numRefused));
+   memset(&openqueue_vars.numDropped[0],0,sizeof(openqueue_vars.numDropped));
+   memset(&openqueue_vars.maxSojourn[0],0,sizeof(openqueue_vars.maxSojourn));
    for (i=0;i<QUEUELENGTH;i++){
       openqueue_reset_entry(&(openqueue_vars.queue[i]));
    }
    for (i=0;i<BIGQUEUELENGTH;i++){
-      bigqueue_vars.queue[i].in_use = FALSE;
+      bigqueue_vars.freeSegments[i] = BIGQUEUE_ALLSEGMENTS;
    }
 }
 
@@ -53,6 +94,27 @@ bool debugPrint_queue() {
    return TRUE;
 }
 
+/**
+\brief Trigger this module to print the counters of its traffic classes, over
+   serial.
+
+\returns TRUE if this function printed something, FALSE otherwise.
+*/
+bool debugPrint_queueStats() {
+   openqueue_stats_t output;
+   INTERRUPT_DECLARATION();
+   
+   DISABLE_INTERRUPTS();
+   memcpy(&output.numInClass[0],&openqueue_vars.numInClass[0],sizeof(output.numInClass));
+   memcpy(&output.numRefused[0],&openqueue_vars.numRefused[0],sizeof(output.numRefused));
+   memcpy(&output.numDropped[0],&openqueue_vars.numDropped[0],sizeof(output.numDropped));
+   memcpy(&output.maxSojourn[0],&openqueue_vars.maxSojourn[0],sizeof(output.maxSojourn));
+   ENABLE_INTERRUPTS();
+   
+   openserial_printStatus(STATUS_QUEUESTATS,(uint8_t*)&output,sizeof(openqueue_stats_t));
+   return TRUE;
+}
+
 //======= called by any component
 
 /**
@@ -64,63 +126,66 @@ get a new packet buffer to start creating a new packet.
 \note Once a packet has been allocated, it is up to the creator of the packet
       to free it using the openqueue_freePacketBuffer() function.
 
+This takes the free entry with the lowest index, in constant time. The traffic
+class of the packet, given by its creator, can not use more than its maximum
+share of the queue, nor the entries reserved for the other classes. The packet
+is counted in that class until it is handed to the MAC, see
+openqueue_sixtopEnqueue().
+
 \returns A pointer to the queue entry when it could be allocated, or NULL when
          it could not be allocated (buffer full or not synchronized).
 */
 OpenQueueEntry_t* openqueue_getFreePacketBuffer(uint8_t creator) {
-   uint8_t i;
-   INTERRUPT_DECLARATION();
-   DISABLE_INTERRUPTS();
+   return openqueue_allocate(creator,openqueue_class(creator));
+}
+
+/**
+\brief Request a new (free) packet buffer for a fragment of a datagram.
+
+The fragment is created by COMPONENT_FRAGMENT, and counted in the traffic class
+of the creator of the datagram, so that the fragments of a datagram this mote
+generated are held to the share of OPENQUEUE_CLASS_LOCAL, and those of a
+datagram it relays to OPENQUEUE_CLASS_FORWARD. It stays in that class when
+queued for the MAC.
+
+\param[in] datagram The datagram the fragment is a part of.
+
+\returns A pointer to the queue entry when it could be allocated, or NULL when
+         it could not be allocated.
+*/
+OpenQueueEntry_t* openqueue_getFreeFragmentBuffer(OpenQueueEntry_t* datagram) {
+   return openqueue_allocate(COMPONENT_FRAGMENT,openqueue_class(datagram->creator));
+}
+
+owerror_t openqueue_freePacketBuffer_atomic(OpenQueueEntry_t* pkt) {
+   uint8_t  i;
+   uint16_t run;
    
-   // refuse to allocate if we're not in sync
-   if (ieee154e_isSynch()==FALSE && creator > COMPONENT_IEEE802154E){
-     ENABLE_INTERRUPTS();
-     return NULL;
+   // pkt has to point into the queue
+   if (pkt<&openqueue_vars.queue[0] || pkt>=&openqueue_vars.queue[QUEUELENGTH]) {
+      return E_FAIL;
    }
    
-   // if you get here, I will try to allocate a buffer for you
-   
-   // walk through queue and find free entry
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (openqueue_vars.queue[i].owner==COMPONENT_NULL) {
-         openqueue_vars.queue[i].creator=creator;
-         openqueue_vars.queue[i].owner=COMPONENT_OPENQUEUE;
-         ENABLE_INTERRUPTS(); 
-         return &openqueue_vars.queue[i];
-      }
+   if (pkt->owner==COMPONENT_NULL) {
+      // log the error
+      openserial_printCritical(COMPONENT_OPENQUEUE,ERR_FREEING_UNUSED,
+                            (errorparameter_t)0,
+                            (errorparameter_t)0);
    }
-   ENABLE_INTERRUPTS();
-   return NULL;
-}
-
-owerror_t openqueue_freePacketBuffer_atomic(OpenQueueEntry_t* pkt) {
-   uint8_t i;
-   uint8_t j;
-
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (&openqueue_vars.queue[i]==pkt) {
-         if (openqueue_vars.queue[i].owner==COMPONENT_NULL) {
-            // log the error
-            openserial_printCritical(COMPONENT_OPENQUEUE,ERR_FREEING_UNUSED,
-                                  (errorparameter_t)0,
-                                  (errorparameter_t)0);
-         }
-	 if ( pkt->big )
-            for (j=0;j<BIGQUEUELENGTH;j++)
-               if ( (uint8_t*)&(bigqueue_vars.queue[j]) == pkt->big ) {
-
-                  if ( ! bigqueue_vars.queue[j].in_use ) 
-                     openserial_printError(COMPONENT_OPENQUEUE,ERR_FREEING_BIG,
-                                  (errorparameter_t)0,
-				  (errorparameter_t)0);
-                  bigqueue_vars.queue[j].in_use = FALSE;
-               }
-         openqueue_reset_entry(&(openqueue_vars.queue[i]));
-         return E_SUCCESS;
+   if (pkt->big) {
+      // give the run of segments back to the pool
+      if ( pkt->big>=&bigqueue_vars.segment[0][0] && pkt->big<&bigqueue_vars.segment[0][0]+sizeof(bigqueue_vars.segment) ) {
+         i   = (pkt->big-&bigqueue_vars.segment[0][0])/BIGQUEUE_SEGMENTSIZE;
+         run = (uint16_t)((((uint32_t)1<<bigqueue_vars.runLength[i])-1)<<(i%BIGQUEUE_SLOTSEGMENTS));
+         if ( (bigqueue_vars.freeSegments[i/BIGQUEUE_SLOTSEGMENTS] & run)!=0 )
+            openserial_printError(COMPONENT_OPENQUEUE,ERR_FREEING_BIG,
+                         (errorparameter_t)0,
+                         (errorparameter_t)0);
+         bigqueue_vars.freeSegments[i/BIGQUEUE_SLOTSEGMENTS] |= run;
       }
    }
-
-   return E_FAIL;
+   openqueue_reset_entry(pkt);
+   return E_SUCCESS;
 }
 
 /**
@@ -152,10 +217,17 @@ owerror_t openqueue_freePacketBuffer(OpenQueueEntry_t* pkt) {
 \param creator The identifier of the component, taken in COMPONENT_*.
 */
 void openqueue_removeAllCreatedBy(uint8_t creator) {
-   uint8_t i;
+   uint8_t  i;
+   uint32_t inUse;
+   
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++){
+   
+   // only walk through the entries in use, creators change too often to be counted
+   inUse = ~openqueue_vars.freeEntries & OPENQUEUE_ALLENTRIES;
+   while (inUse!=0) {
+      i      = openqueue_ctz(inUse);
+      inUse &= inUse-1;
       if (openqueue_vars.queue[i].creator==creator) {
          FragmentQueueEntry_t* buffer;
 
@@ -174,10 +246,17 @@ void openqueue_removeAllCreatedBy(uint8_t creator) {
 \param owner The identifier of the component, taken in COMPONENT_*.
 */
 void openqueue_removeAllOwnedBy(uint8_t owner) {
-   uint8_t i;
+   uint8_t  i;
+   uint32_t inUse;
+   
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++){
+   
+   // only walk through the entries in use, owners change too often to be counted
+   inUse = ~openqueue_vars.freeEntries & OPENQUEUE_ALLENTRIES;
+   while (inUse!=0) {
+      i      = openqueue_ctz(inUse);
+      inUse &= inUse-1;
       if (openqueue_vars.queue[i].owner==owner) {
          FragmentQueueEntry_t* buffer;
 
@@ -190,26 +269,73 @@ void openqueue_removeAllOwnedBy(uint8_t owner) {
    ENABLE_INTERRUPTS();
 }
 
-OpenQueueEntry_t* openqueue_toBigPacket(OpenQueueEntry_t* pkt, uint16_t start) {
+/**
+\brief Move a packet to a big packet, for its payload to grow past an entry.
+
+The big packet is a run of adjacent segments of the pool, so the layers see
+its payload as one buffer, and the fragments of it can be sent from where they
+are. What the entry holds of the payload so far is moved to the end of the
+run, the layers above writing the rest of the datagram in place.
+
+A run never crosses a slot: any BIGQUEUELENGTH big packets, up to
+BIG_PACKET_SIZE bytes each, fit in the pool however the smaller ones before
+them were placed. The room is cut to what the slot leaves.
+
+\param pkt   The packet to move.
+\param start When not 0, the size of the datagram the payload starts, the
+             payload then being moved start bytes before the end of the run.
+\param room  Bytes to keep free in front of the payload.
+
+\returns pkt when it could be moved, NULL when the pool has no run long enough.
+*/
+OpenQueueEntry_t* openqueue_toBigPacket(OpenQueueEntry_t* pkt, uint16_t start, uint16_t room) {
+   uint8_t  s;
    uint8_t  i;
+   uint16_t size;
+   uint8_t  numSegments;
+   uint16_t run;
    uint8_t* payload;
    INTERRUPT_DECLARATION();
+   
+   // the payload of a fragment is not in its entry
+   if (pkt->fragmentPayload != NULL) {
+      openserial_printError(COMPONENT_OPENQUEUE,ERR_FRAGMENT_LENGTH,
+                            (errorparameter_t)pkt->length,
+                            (errorparameter_t)pkt->fragmentLength);
+      return NULL;
+   }
+   
+   size = start > 0 ? start : pkt->length;
+   if (size > BIGQUEUE_SLOTSEGMENTS*BIGQUEUE_SEGMENTSIZE) {
+      return NULL;
+   }
+   if (size+room > BIGQUEUE_SLOTSEGMENTS*BIGQUEUE_SEGMENTSIZE) {
+      room = BIGQUEUE_SLOTSEGMENTS*BIGQUEUE_SEGMENTSIZE-size;
+   }
+   numSegments = (size+room+BIGQUEUE_SEGMENTSIZE-1)/BIGQUEUE_SEGMENTSIZE;
+   run         = (uint16_t)(((uint32_t)1<<numSegments)-1);
+   
    DISABLE_INTERRUPTS();
 
-   for (i=0;i<BIGQUEUELENGTH;i++) {
-      if (! bigqueue_vars.queue[i].in_use) {
-         bigqueue_vars.queue[i].in_use = TRUE;
-         payload  = ((uint8_t*)&(bigqueue_vars.queue[i].buffer));
-         payload += BIG_PACKET_SIZE; // end of buffer
-         payload -= start > 0 ? start : pkt->length;
-	 // - IEEE802154_SECURITY_TAG_LEN; Is footer needed here ?
-         memcpy(payload, pkt->payload, pkt->length);
-         pkt->payload    = payload;
-         pkt->l4_payload = payload - pkt->length + pkt->l4_length;
-         pkt->big = (uint8_t*)&(bigqueue_vars.queue[i]);
+   // first fit, slot by slot
+   for (s=0;s<BIGQUEUELENGTH;s++) {
+      for (i=0;i+numSegments<=BIGQUEUE_SLOTSEGMENTS;i++) {
+         if ((bigqueue_vars.freeSegments[s] & (run<<i))==(run<<i)) {
+            bigqueue_vars.freeSegments[s] &= ~(run<<i);
+            i       += s*BIGQUEUE_SLOTSEGMENTS;
+            bigqueue_vars.runLength[i]  = numSegments;
+            payload  = &bigqueue_vars.segment[i][0];
+            payload += numSegments*BIGQUEUE_SEGMENTSIZE; // end of run
+            payload -= size;
+            // - IEEE802154_SECURITY_TAG_LEN; Is footer needed here ?
+            memcpy(payload, pkt->payload, pkt->length);
+            pkt->payload    = payload;
+            pkt->l4_payload = payload - pkt->length + pkt->l4_length;
+            pkt->big        = &bigqueue_vars.segment[i][0];
 
-         ENABLE_INTERRUPTS();
-         return pkt;
+            ENABLE_INTERRUPTS();
+            return pkt;
+         }
       }
    }
 
@@ -219,6 +345,79 @@ OpenQueueEntry_t* openqueue_toBigPacket(OpenQueueEntry_t* pkt, uint16_t start) {
 
 //======= called by RES
 
+/**
+\brief Hand a packet over to the MAC.
+
+The packet is queued behind the packets already queued to the same neighbor
+in the same or a higher traffic class, on the list of its row of the neighbor
+table, so the MAC finds it without
+walking through the queue. Packets to a node not in the neighbor table, and
+broadcast packets, go on a list of their own; the EBs sixtop broadcasts go on
+another one.
+
+A packet the component which allocated it handed on, such as a received frame
+being relayed, is counted from now on in the class of its creator, if that
+class admits it. The ASN is recorded, for openqueue_macDrop().
+
+\param[in] msg The packet, with its next hop set.
+
+\returns E_SUCCESS when the packet was queued.
+\returns E_FAIL when the class of its creator is full, the packet is then
+          still to be freed by the caller.
+*/
+owerror_t openqueue_sixtopEnqueue(OpenQueueEntry_t* msg) {
+   uint8_t list;
+   uint8_t i;
+   uint8_t cls;
+   uint8_t array[5];
+   
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   
+   // count the packet in the class of its creator, a fragment of a datagram
+   // stays in the class of the datagram
+   i   = msg-&openqueue_vars.queue[0];
+   if (msg->fragmentPayload!=NULL) {
+      cls = openqueue_vars.entryClass[i];
+   } else {
+      cls = openqueue_class(msg->creator);
+   }
+   if (cls!=openqueue_vars.entryClass[i]) {
+      openqueue_vars.numInClass[openqueue_vars.entryClass[i]]--;
+      if (openqueue_admit(cls)==FALSE) {
+         openqueue_vars.numInClass[openqueue_vars.entryClass[i]]++;
+         openqueue_vars.numRefused[cls]++;
+         ENABLE_INTERRUPTS();
+         return E_FAIL;
+      }
+      openqueue_vars.entryClass[i] = cls;
+      openqueue_vars.numInClass[cls]++;
+   }
+   
+   if (msg->creator==COMPONENT_SIXTOP && packetfunctions_isBroadcastMulticast(&msg->l2_nextORpreviousHop)) {
+      list = OPENQUEUE_LIST_EB;
+   } else {
+      list = neighbors_getIndex(&msg->l2_nextORpreviousHop);
+      if (list>=MAXNUMNEIGHBORS) {
+         list = OPENQUEUE_LIST_OTHER;
+      }
+   }
+   
+   // a packet sent again goes to the back of its class
+   openqueue_macUnlink(i);
+   openqueue_macInsert(list,i);
+   
+   ieee154e_getAsn(array);
+   msg->l2_enqueueAsn.bytes0and1 = ((uint16_t) array[1] << 8) | ((uint16_t) array[0]);
+   msg->l2_enqueueAsn.bytes2and3 = ((uint16_t) array[3] << 8) | ((uint16_t) array[2]);
+   msg->l2_enqueueAsn.byte4      = array[4];
+   
+   msg->owner = COMPONENT_SIXTOP_TO_IEEE802154E;
+   
+   ENABLE_INTERRUPTS();
+   return E_SUCCESS;
+}
+
 OpenQueueEntry_t* openqueue_sixtopGetSentPacket() {
    uint8_t i;
    INTERRUPT_DECLARATION();
@@ -249,67 +448,199 @@ OpenQueueEntry_t* openqueue_sixtopGetReceivedPacket() {
    return NULL;
 }
 
+//======= called by neighbors
+
+/**
+\brief Move the packets queued to a neighbor being removed from the neighbor
+   table onto the list of packets to non-neighbors, before its row is reused.
+
+\param[in] neighborIndex The row of the neighbor in the neighbor table.
+*/
+void openqueue_neighborRemoved(uint8_t neighborIndex) {
+   uint8_t i;
+   uint8_t other;
+   uint8_t prev;
+   uint8_t next;
+   uint8_t first;
+   
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   
+   // merge both lists, keeping the order the packets are sent in
+   i     = openqueue_vars.macHead[neighborIndex];
+   prev  = OPENQUEUE_NOENTRY;
+   other = openqueue_vars.macHead[OPENQUEUE_LIST_OTHER];
+   while (i!=OPENQUEUE_NOENTRY) {
+      next = openqueue_vars.macNext[i];
+      while (other!=OPENQUEUE_NOENTRY) {
+         first = openqueue_macBefore(other,i);
+         if (first!=other) {
+            break;
+         }
+         prev  = other;
+         other = openqueue_vars.macNext[other];
+      }
+      // insert i between prev and other
+      openqueue_vars.macList[i] = OPENQUEUE_LIST_OTHER;
+      openqueue_vars.macNext[i] = other;
+      if (prev==OPENQUEUE_NOENTRY) {
+         openqueue_vars.macHead[OPENQUEUE_LIST_OTHER] = i;
+      } else {
+         openqueue_vars.macNext[prev] = i;
+      }
+      if (other==OPENQUEUE_NOENTRY) {
+         openqueue_vars.macTail[OPENQUEUE_LIST_OTHER] = i;
+      }
+      prev = i;
+      i    = next;
+   }
+   openqueue_vars.macHead[neighborIndex] = OPENQUEUE_NOENTRY;
+   openqueue_vars.macTail[neighborIndex] = OPENQUEUE_NOENTRY;
+   
+   ENABLE_INTERRUPTS();
+}
+
 //======= called by IEEE80215E
 
+/**
+\brief Get the next packet to send to a neighbor, the oldest of the highest
+   traffic class.
+
+\param[in] toNeighbor The neighbor, or the anycast address for the next
+   packet to any neighbor, EBs excepted.
+
+\returns The packet, or NULL if there is none.
+*/
 OpenQueueEntry_t* openqueue_macGetDataPacket(open_addr_t* toNeighbor) {
    uint8_t i;
+   uint8_t j;
+   uint8_t list;
+   
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
+   
+   i = OPENQUEUE_NOENTRY;
    if (toNeighbor->type==ADDR_64B) {
-      // a neighbor is specified, look for a packet unicast to that neigbhbor
-      for (i=0;i<QUEUELENGTH;i++) {
-         if (openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-            packetfunctions_sameAddress(toNeighbor,&openqueue_vars.queue[i].l2_nextORpreviousHop)) {
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
-         }
+      // a neighbor is specified, look for a packet unicast to that neigbhbor,
+      // on its list, and on the one of the packets queued before it was a neighbor
+      list = neighbors_getIndex(toNeighbor);
+      if (list<MAXNUMNEIGHBORS) {
+         i = openqueue_macFirst(list,toNeighbor);
       }
+      j = openqueue_macFirst(OPENQUEUE_LIST_OTHER,toNeighbor);
+      i = openqueue_macBefore(i,j);
    } else if (toNeighbor->type==ADDR_ANYCAST) {
-      // anycast case: look for a packet which is either not created by RES
-      // or an KA (created by RES, but not broadcast)
-      for (i=0;i<QUEUELENGTH;i++) {
-         if (openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-             ( openqueue_vars.queue[i].creator!=COMPONENT_SIXTOP ||
-                (
-                   openqueue_vars.queue[i].creator==COMPONENT_SIXTOP &&
-                   packetfunctions_isBroadcastMulticast(&(openqueue_vars.queue[i].l2_nextORpreviousHop))==FALSE
-                )
-             )
-            ) {
-            ENABLE_INTERRUPTS();
-            return &openqueue_vars.queue[i];
+      // anycast case: look for the next packet which is not an EB, among the
+      // heads of the lists
+      for (list=0;list<OPENQUEUE_NUMLISTS;list++) {
+         if (list!=OPENQUEUE_LIST_EB) {
+            j = openqueue_macFirst(list,NULL);
+            i = openqueue_macBefore(i,j);
          }
       }
    }
+   
    ENABLE_INTERRUPTS();
-   return NULL;
+   return i==OPENQUEUE_NOENTRY ? NULL : &openqueue_vars.queue[i];
 }
 
-OpenQueueEntry_t* openqueue_macGetEBPacket() {
+/**
+\brief Get the EB to send instead of a data packet.
+
+\param[in] dataToSend The data packet the MAC would send otherwise, or NULL.
+
+\returns The EB, if there is one and it is to be sent before dataToSend, or
+         NULL.
+*/
+OpenQueueEntry_t* openqueue_macGetEBPacket(OpenQueueEntry_t* dataToSend) {
    uint8_t i;
+   uint8_t j;
    INTERRUPT_DECLARATION();
    DISABLE_INTERRUPTS();
-   for (i=0;i<QUEUELENGTH;i++) {
-      if (openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
-          openqueue_vars.queue[i].creator==COMPONENT_SIXTOP              &&
-          packetfunctions_isBroadcastMulticast(&(openqueue_vars.queue[i].l2_nextORpreviousHop))) {
-         ENABLE_INTERRUPTS();
-         return &openqueue_vars.queue[i];
+   i = openqueue_macFirst(OPENQUEUE_LIST_EB,NULL);
+   if (i!=OPENQUEUE_NOENTRY && dataToSend!=NULL) {
+      j = dataToSend-&openqueue_vars.queue[0];
+      if (openqueue_macBefore(i,j)!=i) {
+         i = OPENQUEUE_NOENTRY;
       }
    }
    ENABLE_INTERRUPTS();
-   return NULL;
+   return i==OPENQUEUE_NOENTRY ? NULL : &openqueue_vars.queue[i];
+}
+
+/**
+\brief Take a packet the MAC is done with off its list.
+
+\param[in] pkt The packet.
+*/
+void openqueue_macDequeue(OpenQueueEntry_t* pkt) {
+   uint8_t i;
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   i = pkt-&openqueue_vars.queue[0];
+   openqueue_macUnlink(i);
+   ENABLE_INTERRUPTS();
+}
+
+/**
+\brief Whether the MAC is to drop a packet it took, rather than send it.
+
+The MAC drops the packets which waited for it longer than the maximum sojourn
+of their traffic class, OPENQUEUE_MAXSOJOURN_*, so that a relay under overload
+does not send packets their destination has given up on. The packet is then to
+be handed back as not sent.
+
+\param[in] pkt The packet, as returned by openqueue_macGetDataPacket().
+
+\returns TRUE if the packet is to be dropped, FALSE otherwise.
+*/
+bool openqueue_macDrop(OpenQueueEntry_t* pkt) {
+   uint8_t  cls;
+   uint32_t sojourn;
+   
+   cls     = openqueue_vars.entryClass[pkt-&openqueue_vars.queue[0]];
+   sojourn = ieee154e_asnDiff(&pkt->l2_enqueueAsn);
+   if (openqueue_maxSojourn[cls]>0 && sojourn>openqueue_maxSojourn[cls]) {
+      openqueue_vars.numDropped[cls]++;
+      return TRUE;
+   }
+   if (sojourn>openqueue_vars.maxSojourn[cls]) {
+      openqueue_vars.maxSojourn[cls] = sojourn>0xffff ? 0xffff : (uint16_t)sojourn;
+   }
+   return FALSE;
 }
 
 //=========================== private =========================================
 
 void openqueue_reset_entry(OpenQueueEntry_t* entry) {
+   uint8_t i;
+   uint8_t cls;
+   
+   i = entry-&openqueue_vars.queue[0];
+#ifdef OPENSIM
+   if (entry->owner!=COMPONENT_NULL) {
+      debugpins_queue_free(i,entry->owner);
+   }
+   debugpins_state_changed(STATUS_QUEUE);
+#endif
+   // take it off its list, if still queued for the MAC
+   openqueue_macUnlink(i);
+   // give the entry back
+   if ((openqueue_vars.freeEntries & ((uint32_t)1<<i))==0) {
+      openqueue_vars.freeEntries |= (uint32_t)1<<i;
+      cls = openqueue_vars.entryClass[i];
+      if (openqueue_vars.numInClass[cls]>0) {
+         openqueue_vars.numInClass[cls]--;
+      }
+   }
    //admin
    entry->creator                      = COMPONENT_NULL;
    entry->owner                        = COMPONENT_NULL;
    entry->payload                      = &(entry->packet[127 - IEEE802154_SECURITY_TAG_LEN]); // Footer is longer if security is used
    entry->length                       = 0;
    entry->big                          = NULL;
+   entry->fragmentPayload              = NULL;
+   entry->fragmentLength               = 0;
    //l4
    entry->l4_protocol                  = IANA_UNDEFINED;
    //l3
@@ -324,3 +655,218 @@ void openqueue_reset_entry(OpenQueueEntry_t* entry) {
    //l2-security
    entry->l2_securityLevel             = 0;
 }
+
+/**
+\brief Index of the lowest bit set in bitmap, which must not be 0.
+*/
+uint8_t openqueue_ctz(uint32_t bitmap) {
+#ifdef __GNUC__
+   return (uint8_t)__builtin_ctzl(bitmap);
+#else
+   // multiply the lowest bit set by a de Bruijn sequence
+   static const uint8_t debruijn[32] = {
+       0, 1,28, 2,29,14,24, 3,30,22,20,15,25,17, 4, 8,
+      31,27,13,23,21,19,16, 7,26,12,18, 6,11, 5,10, 9,
+   };
+   return debruijn[(uint32_t)((bitmap & (~bitmap+1))*0x077CB531UL)>>27];
+#endif
+}
+
+/**
+\brief Traffic class of the packets a component creates.
+*/
+uint8_t openqueue_class(uint8_t creator) {
+   switch (creator) {
+      case COMPONENT_IEEE802154E:
+         return OPENQUEUE_CLASS_RX;
+      case COMPONENT_SIXTOP:
+      case COMPONENT_ICMPv6:
+      case COMPONENT_ICMPv6ROUTER:
+      case COMPONENT_ICMPv6RPL:
+         return OPENQUEUE_CLASS_CONTROL;
+      case COMPONENT_SIXTOP_RES:
+         return OPENQUEUE_CLASS_6P;
+      case COMPONENT_OPENBRIDGE:
+      case COMPONENT_FRAGMENT:       // relayed fragments, see openqueue_getFreeFragmentBuffer()
+      case COMPONENT_IPHC:
+      case COMPONENT_FORWARDING:
+         return OPENQUEUE_CLASS_FORWARD;
+      default:
+         return OPENQUEUE_CLASS_LOCAL;
+   }
+}
+
+/**
+\brief Take a free entry for creator, counted in traffic class cls.
+*/
+OpenQueueEntry_t* openqueue_allocate(uint8_t creator, uint8_t cls) {
+   uint8_t i;
+   
+   INTERRUPT_DECLARATION();
+   DISABLE_INTERRUPTS();
+   
+   // refuse to allocate if we're not in sync
+   if (ieee154e_isSynch()==FALSE && creator > COMPONENT_IEEE802154E){
+     ENABLE_INTERRUPTS();
+     return NULL;
+   }
+   
+   // if you get here, I will try to allocate a buffer for you
+   
+   // queue full, for that class
+   if (openqueue_admit(cls)==FALSE) {
+      openqueue_vars.numRefused[cls]++;
+      ENABLE_INTERRUPTS();
+      return NULL;
+   }
+   
+   // take the free entry with the lowest index
+   i = openqueue_ctz(openqueue_vars.freeEntries);
+   openqueue_vars.freeEntries &= ~((uint32_t)1<<i);
+   openqueue_vars.entryClass[i] = cls;
+   openqueue_vars.numInClass[cls]++;
+   openqueue_vars.queue[i].creator=creator;
+   openqueue_vars.queue[i].owner=COMPONENT_OPENQUEUE;
+#ifdef OPENSIM
+   debugpins_queue_alloc(i,creator);
+   debugpins_state_changed(STATUS_QUEUE);
+#endif
+   ENABLE_INTERRUPTS(); 
+   return &openqueue_vars.queue[i];
+}
+
+/**
+\brief Whether an entry can be allocated to traffic class cls.
+
+It can if the class is below its maximum share, and an entry is left once
+the entries the other classes are guaranteed, and do not use, are set aside.
+*/
+bool openqueue_admit(uint8_t cls) {
+   uint8_t k;
+   uint8_t numUsed;
+   uint8_t numSetAside;
+   
+   if (openqueue_vars.numInClass[cls]>=openqueue_maxShare[cls]) {
+      return FALSE;
+   }
+   numUsed     = 0;
+   numSetAside = 0;
+   for (k=0;k<OPENQUEUE_NUMCLASSES;k++) {
+      numUsed += openqueue_vars.numInClass[k];
+      if (k!=cls && openqueue_vars.numInClass[k]<openqueue_reserved[k]) {
+         numSetAside += openqueue_reserved[k]-openqueue_vars.numInClass[k];
+      }
+   }
+   return QUEUELENGTH-numUsed>numSetAside;
+}
+
+/**
+\brief Queue entry i on a list, behind the entries of the same or a higher
+   traffic class.
+*/
+void openqueue_macInsert(uint8_t list, uint8_t i) {
+   uint8_t cls;
+   uint8_t prev;
+   uint8_t next;
+   
+   cls  = openqueue_vars.entryClass[i];
+   prev = openqueue_vars.macTail[list];
+   next = OPENQUEUE_NOENTRY;
+   if (prev!=OPENQUEUE_NOENTRY && openqueue_vars.entryClass[prev]>cls) {
+      // jump ahead of the lower classes
+      prev = OPENQUEUE_NOENTRY;
+      next = openqueue_vars.macHead[list];
+      while (openqueue_vars.entryClass[next]<=cls) {
+         prev = next;
+         next = openqueue_vars.macNext[next];
+      }
+   }
+   
+   openqueue_vars.macList[i] = list;
+   openqueue_vars.macNext[i] = next;
+   openqueue_vars.macSeq[i]  = openqueue_vars.macSeqNext++;
+   if (prev==OPENQUEUE_NOENTRY) {
+      openqueue_vars.macHead[list] = i;
+   } else {
+      openqueue_vars.macNext[prev] = i;
+   }
+   if (next==OPENQUEUE_NOENTRY) {
+      openqueue_vars.macTail[list] = i;
+   }
+}
+
+/**
+\brief Take entry i off the list it is on, if any.
+
+Packets are mostly taken off at the head of their list, the oldest first.
+*/
+void openqueue_macUnlink(uint8_t i) {
+   uint8_t list;
+   uint8_t prev;
+   
+   list = openqueue_vars.macList[i];
+   if (list==OPENQUEUE_NOENTRY) {
+      return;
+   }
+   if (openqueue_vars.macHead[list]==i) {
+      prev = OPENQUEUE_NOENTRY;
+      openqueue_vars.macHead[list] = openqueue_vars.macNext[i];
+   } else {
+      prev = openqueue_vars.macHead[list];
+      while (openqueue_vars.macNext[prev]!=i) {
+         prev = openqueue_vars.macNext[prev];
+      }
+      openqueue_vars.macNext[prev] = openqueue_vars.macNext[i];
+   }
+   if (openqueue_vars.macTail[list]==i) {
+      openqueue_vars.macTail[list] = prev;
+   }
+   openqueue_vars.macList[i] = OPENQUEUE_NOENTRY;
+   openqueue_vars.macNext[i] = OPENQUEUE_NOENTRY;
+}
+
+/**
+\brief Oldest entry of a list the MAC can send, optionally only to toNeighbor.
+
+The entries the MAC is sending, or other components took back, are skipped.
+
+\returns The entry, or OPENQUEUE_NOENTRY if there is none.
+*/
+uint8_t openqueue_macFirst(uint8_t list, open_addr_t* toNeighbor) {
+   uint8_t i;
+   
+   for (i=openqueue_vars.macHead[list];i!=OPENQUEUE_NOENTRY;i=openqueue_vars.macNext[i]) {
+      if (
+            openqueue_vars.queue[i].owner==COMPONENT_SIXTOP_TO_IEEE802154E &&
+            (
+               toNeighbor==NULL ||
+               packetfunctions_sameAddress(toNeighbor,&openqueue_vars.queue[i].l2_nextORpreviousHop)
+            )
+         ) {
+         return i;
+      }
+   }
+   return OPENQUEUE_NOENTRY;
+}
+
+/**
+\brief Of entries i and j, either of which can be OPENQUEUE_NOENTRY, the one
+   to send first: of the highest traffic class, then queued first.
+*/
+uint8_t openqueue_macBefore(uint8_t i, uint8_t j) {
+   uint8_t clsI;
+   uint8_t clsJ;
+   
+   if (i==OPENQUEUE_NOENTRY) {
+      return j;
+   }
+   if (j==OPENQUEUE_NOENTRY) {
+      return i;
+   }
+   clsI = openqueue_vars.entryClass[i];
+   clsJ = openqueue_vars.entryClass[j];
+   if (clsI!=clsJ) {
+      return clsI<clsJ ? i : j;
+   }
+   return (int16_t)(openqueue_vars.macSeq[i]-openqueue_vars.macSeq[j])<=0 ? i : j;
+}
@@ -10,34 +10,159 @@
 
 #include "opendefs.h"
 #include "IEEE802154.h"
+#include "neighbors.h"
 
 //=========================== define ==========================================
 
+/// entries of the queue, boards can set their own in board_info.h
+#ifndef QUEUELENGTH
 #define QUEUELENGTH  30
+#endif
 
 #define BIG_PACKET_SIZE LARGE_PACKET_SIZE
-#define BIGQUEUELENGTH  10
+
+// big packets are taken from a pool of segments, each a run of adjacent ones
+// within a slot, a slot holding one big packet of BIG_PACKET_SIZE bytes or
+// several smaller ones. One datagram is fragmented at a time, the other slots
+// are for the ones being reassembled and the smaller ones
+
+/// slots of the pool, as many full-size big packets it holds, boards can set their own in board_info.h
+#ifndef BIGQUEUELENGTH
+#define BIGQUEUELENGTH          4
+#endif
+#define BIGQUEUE_SEGMENTSIZE    128 ///< bytes in a segment
+#define BIGQUEUE_SLOTSEGMENTS   ((BIG_PACKET_SIZE+BIGQUEUE_SEGMENTSIZE-1)/BIGQUEUE_SEGMENTSIZE) ///< segments in a slot
+#define BIGQUEUE_NUMSEGMENTS    (BIGQUEUELENGTH*BIGQUEUE_SLOTSEGMENTS) ///< segments in the pool
+#define BIGQUEUE_HEADROOM       96  ///< bytes kept in front of a big packet built down the stack, for the headers still to come
+
+/// a bit per segment of a slot
+#if BIGQUEUE_SLOTSEGMENTS>16
+#error "openqueue keeps the free segments of a slot in a 16-bit bitmap, BIGQUEUE_SLOTSEGMENTS can not exceed 16"
+#endif
+#define BIGQUEUE_ALLSEGMENTS    ((uint16_t)(((uint32_t)1<<BIGQUEUE_SLOTSEGMENTS)-1))
+
+/// a bit per entry of the queue
+#if QUEUELENGTH>32
+#error "openqueue keeps the free entries in a 32-bit bitmap, QUEUELENGTH can not exceed 32"
+#endif
+#define OPENQUEUE_ALLENTRIES    ((uint32_t)(((uint64_t)1<<QUEUELENGTH)-1))
+
+/// no entry, or no list
+#define OPENQUEUE_NOENTRY       0xff
+
+// the lists the packets queued for the MAC are on, each in FIFO order
+// 0..MAXNUMNEIGHBORS-1: unicast to the neighbor in that row of the neighbor table
+#define OPENQUEUE_LIST_OTHER    MAXNUMNEIGHBORS     ///< to non-neighbors, and broadcast but EBs
+#define OPENQUEUE_LIST_EB       (MAXNUMNEIGHBORS+1) ///< broadcast by sixtop
+#define OPENQUEUE_NUMLISTS      (MAXNUMNEIGHBORS+2)
+
+// entries each traffic class is guaranteed, whatever the other classes use
+#ifndef OPENQUEUE_RESERVED_CONTROL
+#define OPENQUEUE_RESERVED_CONTROL   4
+#endif
+#ifndef OPENQUEUE_RESERVED_6P
+#define OPENQUEUE_RESERVED_6P        2
+#endif
+#ifndef OPENQUEUE_RESERVED_FORWARD
+#define OPENQUEUE_RESERVED_FORWARD   4
+#endif
+#ifndef OPENQUEUE_RESERVED_LOCAL
+#define OPENQUEUE_RESERVED_LOCAL     0
+#endif
+#ifndef OPENQUEUE_RESERVED_RX
+#define OPENQUEUE_RESERVED_RX        2
+#endif
+
+// entries each traffic class can use at most
+#ifndef OPENQUEUE_MAXSHARE_CONTROL
+#define OPENQUEUE_MAXSHARE_CONTROL   QUEUELENGTH
+#endif
+#ifndef OPENQUEUE_MAXSHARE_6P
+#define OPENQUEUE_MAXSHARE_6P        (QUEUELENGTH/4)
+#endif
+#ifndef OPENQUEUE_MAXSHARE_FORWARD
+#define OPENQUEUE_MAXSHARE_FORWARD   QUEUELENGTH
+#endif
+#ifndef OPENQUEUE_MAXSHARE_LOCAL
+#define OPENQUEUE_MAXSHARE_LOCAL     (QUEUELENGTH/2)
+#endif
+#ifndef OPENQUEUE_MAXSHARE_RX
+#define OPENQUEUE_MAXSHARE_RX        QUEUELENGTH
+#endif
+
+// slots a packet of each traffic class can wait for the MAC before it is
+// dropped, 0 for no limit: @15ms per slot -> 1000 slots is 15 seconds
+#ifndef OPENQUEUE_MAXSOJOURN_CONTROL
+#define OPENQUEUE_MAXSOJOURN_CONTROL 0
+#endif
+#ifndef OPENQUEUE_MAXSOJOURN_6P
+#define OPENQUEUE_MAXSOJOURN_6P      0
+#endif
+#ifndef OPENQUEUE_MAXSOJOURN_FORWARD
+#define OPENQUEUE_MAXSOJOURN_FORWARD 1000
+#endif
+#ifndef OPENQUEUE_MAXSOJOURN_LOCAL
+#define OPENQUEUE_MAXSOJOURN_LOCAL   1000
+#endif
+#define OPENQUEUE_MAXSOJOURN_RX      0   // not queued for the MAC
+
+#if OPENQUEUE_RESERVED_CONTROL+OPENQUEUE_RESERVED_6P+OPENQUEUE_RESERVED_FORWARD+OPENQUEUE_RESERVED_LOCAL+OPENQUEUE_RESERVED_RX>QUEUELENGTH
+#error "openqueue reserves more entries than QUEUELENGTH"
+#endif
 
 //=========================== typedef =========================================
 
+/// traffic classes, by decreasing priority
+typedef enum {
+   OPENQUEUE_CLASS_CONTROL = 0,       ///< RPL and ICMPv6, sixtop's EBs and KAs
+   OPENQUEUE_CLASS_6P,                ///< 6top negotiation
+   OPENQUEUE_CLASS_FORWARD,           ///< relayed, or sent on by the bridge
+   OPENQUEUE_CLASS_LOCAL,             ///< generated by the transport layer and applications
+   OPENQUEUE_CLASS_RX,                ///< received by the MAC, and its ACKs, until handed on
+   OPENQUEUE_NUMCLASSES,
+} openqueue_class_t;
+
 typedef struct {
    uint8_t  creator;
    uint8_t  owner;
 } debugOpenQueueEntry_t;
 
+/**
+\brief Payload of the STATUS_QUEUESTATS status element.
+*/
+BEGIN_PACK
 typedef struct {
-   bool     in_use;
-   uint8_t  buffer[BIG_PACKET_SIZE];
-} BigQueueEntry_t;
+   uint8_t  numInClass[OPENQUEUE_NUMCLASSES];
+   uint16_t numRefused[OPENQUEUE_NUMCLASSES];
+   uint16_t numDropped[OPENQUEUE_NUMCLASSES];
+   uint16_t maxSojourn[OPENQUEUE_NUMCLASSES];
+} openqueue_stats_t;
+END_PACK
 
 //=========================== module variables ================================
 
 typedef struct {
    OpenQueueEntry_t queue[QUEUELENGTH];
+   uint32_t         freeEntries;                         // bit i set when queue[i] is free
+   // packets queued for the MAC
+   uint8_t          macList[QUEUELENGTH];                // list queue[i] is on
+   uint8_t          macNext[QUEUELENGTH];                // entry behind queue[i] on its list
+   uint16_t         macSeq[QUEUELENGTH];                 // order queue[i] was queued in
+   uint8_t          macHead[OPENQUEUE_NUMLISTS];
+   uint8_t          macTail[OPENQUEUE_NUMLISTS];
+   uint16_t         macSeqNext;
+   // traffic classes
+   uint8_t          entryClass[QUEUELENGTH];             // class queue[i] is counted in
+   uint8_t          numInClass[OPENQUEUE_NUMCLASSES];    // entries in use, per class
+   uint16_t         numRefused[OPENQUEUE_NUMCLASSES];    // allocations refused, per class
+   uint16_t         numDropped[OPENQUEUE_NUMCLASSES];    // packets dropped after waiting too long for the MAC, per class
+   uint16_t         maxSojourn[OPENQUEUE_NUMCLASSES];    // longest a packet the MAC took waited for it, in slots, per class
 } openqueue_vars_t;
 
 typedef struct {
-   BigQueueEntry_t queue[BIGQUEUELENGTH];
+   uint8_t          segment[BIGQUEUE_NUMSEGMENTS][BIGQUEUE_SEGMENTSIZE];
+   uint16_t         freeSegments[BIGQUEUELENGTH];        // bit i of slot s set when segment[s*BIGQUEUE_SLOTSEGMENTS+i] is free
+   uint8_t          runLength[BIGQUEUE_NUMSEGMENTS];     // segments in the run a big packet took from segment[i]
 } bigqueue_vars_t;
 
 //=========================== prototypes ======================================
@@ -45,19 +170,26 @@ typedef struct {
 // admin
 void               openqueue_init(void);
 bool               debugPrint_queue(void);
+bool               debugPrint_queueStats(void);
 // called by any component
 OpenQueueEntry_t*  openqueue_getFreePacketBuffer(uint8_t creator);
+OpenQueueEntry_t*  openqueue_getFreeFragmentBuffer(OpenQueueEntry_t* datagram);
 owerror_t         openqueue_freePacketBuffer(OpenQueueEntry_t* pkt);
 void               openqueue_removeAllCreatedBy(uint8_t creator);
 void               openqueue_removeAllOwnedBy(uint8_t owner);
 
-OpenQueueEntry_t* openqueue_toBigPacket(OpenQueueEntry_t* pkt, uint16_t start);
+OpenQueueEntry_t* openqueue_toBigPacket(OpenQueueEntry_t* pkt, uint16_t start, uint16_t room);
 // called by res
+owerror_t          openqueue_sixtopEnqueue(OpenQueueEntry_t* msg);
 OpenQueueEntry_t*  openqueue_sixtopGetSentPacket(void);
 OpenQueueEntry_t*  openqueue_sixtopGetReceivedPacket(void);
+// called by neighbors
+void               openqueue_neighborRemoved(uint8_t neighborIndex);
 // called by IEEE80215E
 OpenQueueEntry_t*  openqueue_macGetDataPacket(open_addr_t* toNeighbor);
-OpenQueueEntry_t*  openqueue_macGetEBPacket(void);
+OpenQueueEntry_t*  openqueue_macGetEBPacket(OpenQueueEntry_t* dataToSend);
+void               openqueue_macDequeue(OpenQueueEntry_t* pkt);
+bool               openqueue_macDrop(OpenQueueEntry_t* pkt);
 
 /**
 \}
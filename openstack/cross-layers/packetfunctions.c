@@ -1,6 +1,7 @@
 #include "packetfunctions.h"
 #include "openserial.h"
 #include "idmanager.h"
+#include "openqueue.h"
 
 //=========================== variables =======================================
 
@@ -269,7 +270,7 @@ void packetfunctions_reserveHeaderSize(OpenQueueEntry_t* pkt, uint16_t header_le
    bool error;
 
    error = pkt->big ?
-	   pkt->length + header_length > BIG_PACKET_SIZE :
+	   pkt->length + header_length > BIG_PACKET_SIZE || (uint8_t*)(pkt->payload)-header_length < pkt->big :
 	   (uint8_t*)(pkt->payload)-header_length < (uint8_t*)(pkt->packet);
    // Check if is needed to reserve a big packet.
    // Layer 2 does not need support for large packets as messages
@@ -277,7 +278,7 @@ void packetfunctions_reserveHeaderSize(OpenQueueEntry_t* pkt, uint16_t header_le
    // This one tries to acquire a big buffer if needed on layer 3
    // and up.
    if ( error && (pkt->owner > COMPONENT_FRAGMENT) && (pkt->big == NULL) )
-      error = ( openqueue_toBigPacket(pkt, 0) == NULL );
+      error = ( openqueue_toBigPacket(pkt, 0, header_length+BIGQUEUE_HEADROOM) == NULL );
 
    pkt->payload -= header_length;
    pkt->length  += header_length;
@@ -321,27 +322,60 @@ void packetfunctions_tossFooter(OpenQueueEntry_t* pkt, uint8_t header_length) {
 // function duplicates a frame from one OpenQueueEntry structure to the other,
 // updating pointers to the new memory location. Used to make a local copy of
 // the frame before transmission (where it can possibly be encrypted). 
-void packetfunctions_duplicatePacket(OpenQueueEntry_t* dst, OpenQueueEntry_t* src) {
+// Returns E_FAIL when the payload of a fragment does not fit in front of it.
+owerror_t packetfunctions_duplicatePacket(OpenQueueEntry_t* dst, OpenQueueEntry_t* src) {
+   // assert
+   if (
+         src->fragmentPayload != NULL &&
+         (
+            src->fragmentLength > src->length ||
+            src->fragmentLength > src->payload - src->packet
+         )
+      ) {
+      openserial_printError(COMPONENT_PACKETFUNCTIONS,ERR_FRAGMENT_LENGTH,
+                            (errorparameter_t)src->length,
+                            (errorparameter_t)src->fragmentLength);
+      return E_FAIL;
+   }
+
    // make a copy of the frame
    memcpy(dst, src, sizeof(OpenQueueEntry_t));
 
    // Calculate where payload starts in the buffer
    dst->payload = &dst->packet[src->payload - src->packet]; // update pointers
 
+   // gather the payload of a fragment, sent from its big packet, behind the headers
+   if (src->fragmentPayload != NULL) {
+      dst->payload -= src->fragmentLength;
+      memcpy(dst->payload, src->payload, src->length - src->fragmentLength);
+      memcpy(dst->payload + src->length - src->fragmentLength, src->fragmentPayload, src->fragmentLength);
+      dst->fragmentPayload = NULL;
+      dst->fragmentLength  = 0;
+   }
+
+   // pointers which are not set stay NULL, e.g. l4_payload of a frame without upper layer
+
    // update l2_FrameCounter pointer
-   dst->l2_FrameCounter = dst->payload + (src->l2_FrameCounter - src->payload);
+   if (src->l2_FrameCounter != NULL) {
+      dst->l2_FrameCounter = dst->payload + (src->l2_FrameCounter - src->payload);
+   }
 
    // update l2_ASNpayload pointer
-   dst->l2_ASNpayload = dst->payload + (src->l2_ASNpayload - src->payload);
-
-   // update l2_scheduleIE_cellObjects pointer
-   dst->l2_scheduleIE_cellObjects = dst->payload + (src->l2_scheduleIE_cellObjects - src->payload);
+   if (src->l2_ASNpayload != NULL) {
+      dst->l2_ASNpayload = dst->payload + (src->l2_ASNpayload - src->payload);
+   }
 
    // update l2_payload pointer
-   dst->l2_payload = dst->payload + (src->l2_payload - src->payload);
+   if (src->l2_payload != NULL) {
+      dst->l2_payload = dst->payload + (src->l2_payload - src->payload);
+   }
 
    // update l4_payload pointer
-   dst->l4_payload = dst->payload + (src->l4_payload - src->payload);
+   if (src->l4_payload != NULL) {
+      dst->l4_payload = dst->payload + (src->l4_payload - src->payload);
+   }
+
+   return E_SUCCESS;
 }
 
 //======= CRC calculation
@@ -41,7 +41,7 @@ void     packetfunctions_reserveFooterSize(OpenQueueEntry_t* pkt, uint8_t header
 void     packetfunctions_tossFooter(OpenQueueEntry_t* pkt, uint8_t header_length);
 
 // packet duplication
-void packetfunctions_duplicatePacket(OpenQueueEntry_t* dst, OpenQueueEntry_t* src);
+owerror_t packetfunctions_duplicatePacket(OpenQueueEntry_t* dst, OpenQueueEntry_t* src);
 
 // calculate CRC
 void     packetfunctions_calculateCRC(OpenQueueEntry_t* msg);
@@ -54,6 +54,7 @@ int mote_main(void) {
    
    opentimers_start(
       APP_DLY_TIMER0_ms,     // duration
+      OPENTIMERS_SLACK_NONE, // slack
       TIMER_PERIODIC,        // type
       TIME_MS,               // timetype
       cb_timer0              // callback
@@ -61,6 +62,7 @@ int mote_main(void) {
    
    opentimers_start(
       APP_DLY_TIMER1_ms,     // duration
+      OPENTIMERS_SLACK_NONE, // slack
       TIMER_PERIODIC,        // type
       TIME_MS,               // timetype
       cb_timer1              // callback
@@ -68,6 +70,7 @@ int mote_main(void) {
    
    opentimers_start(
       APP_DLY_TIMER2_ms,     // duration
+      OPENTIMERS_SLACK_NONE, // slack
       TIMER_PERIODIC,        // type
       TIME_MS,               // timetype
       cb_timer2              // callback
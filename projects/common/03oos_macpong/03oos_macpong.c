@@ -63,7 +63,7 @@ void macpong_send(uint8_t payloadCtr) {
    OpenQueueEntry_t* pkt;
    uint8_t i;
    
-   pkt = openqueue_getFreePacketBuffer(COMPONENT_UECHO);
+   pkt = openqueue_getFreePacketBuffer(COMPONENT_IPHC);
    if (pkt==NULL) {
       openserial_printError(
          COMPONENT_IPHC,
@@ -92,6 +92,7 @@ void macpong_send(uint8_t payloadCtr) {
 void iphc_init(void) {
    macpong_vars.timerId    = opentimers_start(
       5000,
+      OPENTIMERS_SLACK_NONE,
       TIMER_PERIODIC,TIME_MS,
       macpong_initSend
    );
@@ -348,6 +348,7 @@ void serial_rx_REQ_TX(void) {
    // init opentimers to send packets periodically
    mercator_vars.sendTimerId  = opentimers_start(
       htons(req->txifdur),
+      OPENTIMERS_SLACK_NONE,
       TIMER_PERIODIC,
       TIME_MS,
       cb_sendPacket
@@ -78,6 +78,7 @@ int mote_main(void) {
    
    // start the timer
    opentimers_start(APP_DLY_TIMER_ms,
+                    OPENTIMERS_SLACK_NONE,
                     TIMER_PERIODIC,TIME_MS,
                     cb_timer);
       
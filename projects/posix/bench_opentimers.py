@@ -0,0 +1,267 @@
+'''
+Microbenchmark of the opentimers driver.
+
+Compiles drivers/common/opentimers.c of the working tree, and that of a
+baseline revision, against a simulated 16-bit hardware timer, then prints, per
+number of timers (MAX_NUM_TIMERS), the time it takes on the host to:
+
+- handle a compare event of the hardware timer, with all but one of the
+  timers running periodically ("expiry");
+- start a one-shot timer and stop it, elapsing after all others ("start/stop")
+  or before all others ("start/stop first").
+
+Each figure is the best of a few runs, to filter out the noise of the host.
+The number of times each periodic timer fired is checked against the
+simulated time, so a broken driver fails the benchmark.
+
+The baseline defaults to the revision before the min-heap engine.
+
+usage: python bench_opentimers.py [numTimers ...] [--events n] [--runs n]
+                                  [--baseline rev]
+'''
+
+import sys
+import os
+import argparse
+import re
+import shutil
+import subprocess
+import tempfile
+
+#============================ defines =========================================
+
+REPO              = os.path.join(os.path.dirname(os.path.abspath(__file__)),'..','..')
+DEFAULT_NUMTIMERS = [10,32,64,128]
+DEFAULT_EVENTS    = 100000
+DEFAULT_RUNS      = 5
+SOURCE            = 'drivers/common/opentimers'
+INCLUDES          = [
+    'inc',
+    'bsp/boards',
+    'bsp/boards/common',
+    'bsp/boards/posix',
+    'bsp/chips',
+    'drivers/common',
+    'kernel',
+]
+
+# simulates the hardware timer, and times the driver
+BENCH_C = r'''
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "opendefs.h"
+#include "opentimers.h"
+#include "bsp_timer.h"
+
+#define PERIOD(i) (200+37*(i))
+
+// older drivers take no slack
+#ifdef OPENTIMERS_SLACK_NONE
+#define START(d,t,cb) opentimers_start(d,OPENTIMERS_SLACK_NONE,t,TIME_TICS,cb)
+#else
+#define START(d,t,cb) opentimers_start(d,t,TIME_TICS,cb)
+#endif
+
+static bsp_timer_cbt    bench_cb;
+static PORT_TIMER_WIDTH bench_counter;
+static PORT_TIMER_WIDTH bench_lastCompare;
+static bool             bench_armed;
+static uint64_t         bench_ticks;
+static uint32_t         bench_fired[MAX_NUM_TIMERS];
+
+void bsp_timer_set_callback(bsp_timer_cbt cb) {
+   bench_cb = cb;
+}
+
+void bsp_timer_reset(void) {
+   bench_counter     = 0;
+   bench_lastCompare = 0;
+   bench_armed       = FALSE;
+}
+
+void bsp_timer_scheduleIn(PORT_TIMER_WIDTH delayTicks) {
+   bench_lastCompare += delayTicks;
+   bench_armed        = TRUE;
+}
+
+void bsp_timer_cancel_schedule(void) {
+   bench_armed = FALSE;
+}
+
+PORT_TIMER_WIDTH bsp_timer_get_currentValue(void) {
+   return bench_counter;
+}
+
+void leds_error_blink(void) {
+}
+
+void board_reset(void) {
+   abort();
+}
+
+static void bench_timer_cb(opentimer_id_t id) {
+   bench_fired[id]++;
+}
+
+// advance the counter to the compare value, and fire
+static void bench_step(void) {
+   if (bench_armed==FALSE) {
+      abort();
+   }
+   bench_ticks   += (PORT_TIMER_WIDTH)(bench_lastCompare-bench_counter);
+   bench_counter  = bench_lastCompare;
+   bench_armed    = FALSE;
+   bench_cb();
+}
+
+static double bench_ns(struct timespec* start, int n) {
+   struct timespec end;
+
+   clock_gettime(CLOCK_MONOTONIC,&end);
+   return ((end.tv_sec-start->tv_sec)*1e9+(end.tv_nsec-start->tv_nsec))/n;
+}
+
+int main(int argc, char** argv) {
+   struct timespec start;
+   opentimer_id_t  ids[MAX_NUM_TIMERS];
+   opentimer_id_t  id;
+   double          nsExpiry;
+   double          nsLast;
+   double          nsFirst;
+   int             events;
+   int             i;
+
+   events = atoi(argv[1]);
+
+   opentimers_init();
+   for (i=0;i<MAX_NUM_TIMERS-1;i++) {
+      ids[i] = START(PERIOD(i),TIMER_PERIODIC,bench_timer_cb);
+   }
+
+   clock_gettime(CLOCK_MONOTONIC,&start);
+   for (i=0;i<events;i++) {
+      bench_step();
+   }
+   nsExpiry = bench_ns(&start,events);
+
+   for (i=0;i<MAX_NUM_TIMERS-1;i++) {
+      if (bench_fired[ids[i]]+1<bench_ticks/PERIOD(i) || bench_fired[ids[i]]>bench_ticks/PERIOD(i)+1) {
+         printf("FAIL timer %d fired %u times in %llu ticks\n",
+            i,bench_fired[ids[i]],(unsigned long long)bench_ticks);
+         return 1;
+      }
+   }
+
+   clock_gettime(CLOCK_MONOTONIC,&start);
+   for (i=0;i<events;i++) {
+      id = START(50000,TIMER_ONESHOT,bench_timer_cb);
+      opentimers_stop(id);
+   }
+   nsLast = bench_ns(&start,events);
+
+   clock_gettime(CLOCK_MONOTONIC,&start);
+   for (i=0;i<events;i++) {
+      id = START(10,TIMER_ONESHOT,bench_timer_cb);
+      opentimers_stop(id);
+   }
+   nsFirst = bench_ns(&start,events);
+
+   printf("%.1f %.1f %.1f\n",nsExpiry,nsLast,nsFirst);
+   return 0;
+}
+'''
+
+#============================ helpers =========================================
+
+def git(*args):
+    return subprocess.check_output(['git','-C',REPO]+list(args)).decode()
+
+def defaultBaseline():
+    '''
+    revision before the one introducing the min-heap engine, HEAD if none does
+    '''
+    revs = git('log','--format=%H','-S','opentimers_siftUp','--',SOURCE+'.c').split()
+    return revs[-1]+'^' if revs else 'HEAD'
+
+def build(tmp,name,numTimers,sources):
+    '''
+    compiles the benchmark against the given opentimers.c/.h, returns its path
+    '''
+    src = os.path.join(tmp,name)
+    os.makedirs(src,exist_ok=True)
+    for (ext,content) in sources.items():
+        # older headers do not let MAX_NUM_TIMERS be overridden
+        content = re.sub(
+            r'#define MAX_NUM_TIMERS\s+\d+',
+            '#ifndef MAX_NUM_TIMERS\n\\g<0>\n#endif',
+            content,
+        ) if '#ifndef MAX_NUM_TIMERS' not in content else content
+        with open(os.path.join(src,'opentimers'+ext),'w') as f:
+            f.write(content)
+    with open(os.path.join(src,'bench.c'),'w') as f:
+        f.write(BENCH_C)
+    prog = os.path.join(src,'bench_{0}'.format(numTimers))
+    subprocess.check_call(
+        [
+            'gcc','-O2','-w',
+            '-DGOLDEN_IMAGE_NONE',
+            '-DMAX_NUM_TIMERS={0}'.format(numTimers),
+            '-I'+src,
+        ]+
+        ['-I'+os.path.join(REPO,i) for i in INCLUDES]+
+        [
+            os.path.join(src,'opentimers.c'),
+            os.path.join(src,'bench.c'),
+            '-o',prog,
+        ]
+    )
+    return prog
+
+#============================ main ============================================
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('numTimers', type=int, nargs='*', default=DEFAULT_NUMTIMERS)
+    parser.add_argument('--events',  type=int, default=DEFAULT_EVENTS)
+    parser.add_argument('--runs',    type=int, default=DEFAULT_RUNS)
+    parser.add_argument('--baseline',default=None)
+    args = parser.parse_args()
+
+    baseline = args.baseline or defaultBaseline()
+    versions = [
+        (
+            'baseline',
+            dict((ext,git('show','{0}:{1}{2}'.format(baseline,SOURCE,ext))) for ext in ['.c','.h']),
+        ),
+        (
+            'tree',
+            dict((ext,open(os.path.join(REPO,SOURCE+ext)).read()) for ext in ['.c','.h']),
+        ),
+    ]
+
+    print('baseline: {0}'.format(git('rev-parse','--short',baseline).strip()))
+    print('{0:>7} {1:>9} {2:>12} {3:>15} {4:>17}'.format(
+        'timers','version','expiry (ns)','start/stop (ns)','start/stop first',
+    ))
+    tmp = tempfile.mkdtemp(prefix='owsn-')
+    try:
+        for numTimers in args.numTimers:
+            for (name,sources) in versions:
+                prog = build(tmp,name,numTimers,sources)
+                best = None
+                for _ in range(args.runs):
+                    out  = subprocess.check_output([prog,str(args.events)]).decode().split()
+                    if out[0]=='FAIL':
+                        break
+                    best = [min(a,float(b)) for (a,b) in zip(best,out)] if best else [float(b) for b in out]
+                if out[0]=='FAIL':
+                    print('{0:>7} {1:>9} {2}'.format(numTimers,name,' '.join(out)))
+                    continue
+                print('{0:>7} {1:>9} {2:>12.1f} {3:>15.1f} {4:>17.1f}'.format(numTimers,name,*best))
+                sys.stdout.flush()
+    finally:
+        shutil.rmtree(tmp)
+
+if __name__=='__main__':
+    main()
@@ -0,0 +1,149 @@
+'''
+Throughput benchmark of the POSIX board.
+
+Starts the radio medium and numMotes motes, each as its own process, makes
+mote 1 DAG root through its serial port, lets the network run for the given
+number of seconds and prints the statistics of the medium together with the
+CPU time the motes used.
+
+Motes send an EB every EBPERIOD (30s), so a network takes about that long per
+hop to form; short runs mostly measure the idle cost of the motes.
+
+Build the motes first:
+
+    scons board=posix toolchain=gcc oos_openwsn
+
+usage: python bench_posix.py [duration] [numMotes ...] [--topology full|chain|geo]
+                             [--slowdown n] [--prog path]
+'''
+
+import sys
+import os
+import argparse
+import resource
+import shutil
+import signal
+import subprocess
+import tempfile
+import time
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 120
+DEFAULT_NUMMOTES  = [10,50,100]
+DEFAULT_PROG      = os.path.join(
+    os.path.dirname(os.path.abspath(__file__)),
+    '..','..','build','posix_gcc','projects','common','03oos_openwsn_prog',
+)
+
+HDLC_FLAG         = 0x7e
+HDLC_ESCAPE       = 0x7d
+HDLC_ESCAPE_MASK  = 0x20
+SETROOT           = [ord('R'),ord('Y')]+[0xbb,0xbb,0x00,0x00,0x00,0x00,0x00,0x00]
+
+#============================ helpers =========================================
+
+def crc16(data):
+    # CRC-16/X.25, as computed by openhdlc
+    crc = 0xffff
+    for b in data:
+        crc ^= b
+        for _ in range(8):
+            crc = (crc>>1)^0x8408 if crc&1 else crc>>1
+    return (~crc)&0xffff
+
+def hdlcify(payload):
+    crc    = crc16(payload)
+    frame  = [HDLC_FLAG]
+    for b in payload+[crc&0xff,crc>>8]:
+        if b in [HDLC_FLAG,HDLC_ESCAPE]:
+            frame += [HDLC_ESCAPE,b^HDLC_ESCAPE_MASK]
+        else:
+            frame += [b]
+    frame += [HDLC_FLAG]
+    return bytearray(frame)
+
+def waitFor(path,timeout=10):
+    start = time.time()
+    while not os.path.exists(path):
+        if time.time()-start>timeout:
+            raise SystemError('{0} did not appear'.format(path))
+        time.sleep(0.05)
+
+def run(prog,numMotes,duration,topology,slowdown):
+    tmp      = tempfile.mkdtemp(prefix='owsn-')
+    medium   = os.path.join(tmp,'medium')
+    devnull  = open(os.devnull,'w')
+    cpuStart = resource.getrusage(resource.RUSAGE_CHILDREN)
+
+    hub = subprocess.Popen(
+        [prog,'--hub','--medium',medium,'--topology',topology],
+        stdout=subprocess.PIPE,
+    )
+    hub.stdout.readline()
+
+    motes = []
+    for id in range(1,numMotes+1):
+        motes += [subprocess.Popen(
+            [
+                prog,
+                '--id',       str(id),
+                '--medium',   medium,
+                '--serial',   os.path.join(tmp,'mote{0}'.format(id)),
+                '--slowdown', str(slowdown),
+            ],
+            stdout=devnull,
+        )]
+
+    # mote 1 is DAG root
+    root = os.path.join(tmp,'mote1')
+    waitFor(root)
+    fd = os.open(root,os.O_RDWR|os.O_NOCTTY)
+    os.write(fd,bytes(hdlcify(SETROOT)))
+
+    time.sleep(duration)
+
+    hub.send_signal(signal.SIGINT)
+    stats = hub.stdout.readline().decode()
+    hub.wait()
+    for m in motes:
+        m.wait()
+    os.close(fd)
+    cpuEnd = resource.getrusage(resource.RUSAGE_CHILDREN)
+    shutil.rmtree(tmp)
+
+    # "medium: key=value key=value ..."
+    stats = dict(kv.split('=') for kv in stats.split()[1:])
+    stats['cpu'] = (cpuEnd.ru_utime+cpuEnd.ru_stime)-(cpuStart.ru_utime+cpuStart.ru_stime)
+    return stats
+
+#============================ main ============================================
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('duration',  type=float, nargs='?', default=DEFAULT_DURATION)
+    parser.add_argument('numMotes',  type=int,   nargs='*', default=DEFAULT_NUMMOTES)
+    parser.add_argument('--topology',default='chain', choices=['full','chain','geo'])
+    parser.add_argument('--slowdown',type=int,   default=1)
+    parser.add_argument('--prog',    default=DEFAULT_PROG)
+    args = parser.parse_args()
+
+    print('{0:>7} {1:>9} {2:>7} {3:>10} {4:>12} {5:>12} {6:>9} {7:>10}'.format(
+        'motes','time (s)','heard','frames','frames/s','deliveries','dropped','cpu/mote',
+    ))
+    for numMotes in args.numMotes:
+        stats = run(args.prog,numMotes,args.duration,args.topology,args.slowdown)
+        print('{0:>7} {1:>9.1f} {2:>7} {3:>10} {4:>12} {5:>12} {6:>9} {7:>9.1f}%'.format(
+            numMotes,
+            float(stats['duration']),
+            stats['heard'],
+            stats['frames'],
+            stats['framesPerSec'],
+            stats['deliveries'],
+            stats['dropped'],
+            100.0*stats['cpu']/float(stats['duration'])/numMotes,
+        ))
+        sys.stdout.flush()
+
+if __name__=='__main__':
+    main()
@@ -0,0 +1,189 @@
+'''
+Compares the OpenOS and FreeRTOS kernels on the POSIX board.
+
+Runs the same network once per kernel, as bench_posix.py does, collecting the
+STATUS_SCHEDSTATS rows the motes print over their serial port, then prints,
+per kernel, the share of the time the motes spent asleep, the latency of the
+tasks of the stack and the CPU time the motes used.
+
+Build the motes of both kernels with the scheduler instrumentation first:
+
+    scons board=posix toolchain=gcc kernel=openos   schedstats=1 oos_openwsn
+    scons board=posix toolchain=gcc kernel=freertos schedstats=1 oos_openwsn
+
+(copying the first 03oos_openwsn_prog aside before building the second).
+
+usage: python compare_kernels.py openosProg freertosProg [duration] [numMotes]
+                                 [--topology full|chain|geo]
+'''
+
+import sys
+import os
+import argparse
+import resource
+import selectors
+import shutil
+import signal
+import struct
+import subprocess
+import tempfile
+import time
+
+from bench_posix import hdlcify, waitFor, SETROOT, HDLC_FLAG, HDLC_ESCAPE, HDLC_ESCAPE_MASK
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 120
+DEFAULT_NUMMOTES  = 10
+NUMBINS           = 12
+TASKPRIO_MAX      = 12
+SERFRAME_STATUS   = ord('S')
+STATUS_SCHEDSTATS = 11
+ROW               = struct.Struct('<BBIIHH{0}H{0}H'.format(NUMBINS))
+
+#============================ helpers =========================================
+
+def statusRows(frame):
+    '''
+    returns the STATUS_SCHEDSTATS row of an HDLC frame, None if it is not one
+    '''
+    payload = bytearray()
+    escape  = False
+    for b in frame:
+        if b==HDLC_ESCAPE:
+            escape = True
+            continue
+        if escape:
+            b      ^= HDLC_ESCAPE_MASK
+            escape  = False
+        payload.append(b)
+    # type, moteId (2B), statusElement, row, CRC (2B)
+    if len(payload)!=4+ROW.size+2 or payload[0]!=SERFRAME_STATUS or payload[3]!=STATUS_SCHEDSTATS:
+        return None
+    return ROW.unpack(bytes(payload[4:-2]))
+
+def percentile(bins,p):
+    '''
+    upper bound, in 32kHz ticks, of the bin holding the p-th percentile
+    '''
+    total = sum(bins)
+    count = 0
+    for (b,n) in enumerate(bins):
+        count += n
+        if count>=p*total:
+            return (1<<b)-1 if b<NUMBINS-1 else float('inf')
+    return 0
+
+def run(prog,numMotes,duration,topology):
+    tmp      = tempfile.mkdtemp(prefix='owsn-')
+    medium   = os.path.join(tmp,'medium')
+    devnull  = open(os.devnull,'w')
+    cpuStart = resource.getrusage(resource.RUSAGE_CHILDREN)
+
+    hub = subprocess.Popen(
+        [prog,'--hub','--medium',medium,'--topology',topology],
+        stdout=subprocess.PIPE,
+    )
+    hub.stdout.readline()
+
+    motes = []
+    for id in range(1,numMotes+1):
+        motes += [subprocess.Popen(
+            [
+                prog,
+                '--id',       str(id),
+                '--medium',   medium,
+                '--serial',   os.path.join(tmp,'mote{0}'.format(id)),
+            ],
+            stdout=devnull,
+        )]
+
+    # read the serial port of every mote
+    sel = selectors.DefaultSelector()
+    fds = []
+    for id in range(1,numMotes+1):
+        path = os.path.join(tmp,'mote{0}'.format(id))
+        waitFor(path)
+        fd   = os.open(path,os.O_RDWR|os.O_NOCTTY|os.O_NONBLOCK)
+        sel.register(fd,selectors.EVENT_READ,id)
+        fds += [fd]
+
+    # mote 1 is DAG root
+    os.write(fds[0],bytes(hdlcify(SETROOT)))
+
+    # last row of each mote, by row index
+    rows   = dict((id,{}) for id in range(1,numMotes+1))
+    buf    = dict((id,bytearray()) for id in range(1,numMotes+1))
+    end    = time.time()+duration
+    while time.time()<end:
+        for (key,_) in sel.select(timeout=end-time.time()):
+            try:
+                buf[key.data] += os.read(key.fd,4096)
+            except OSError:
+                continue
+            frames = buf[key.data].split(bytes([HDLC_FLAG]))
+            buf[key.data] = frames.pop()
+            for frame in frames:
+                row = statusRows(frame)
+                if row is not None:
+                    rows[key.data][row[0]] = row
+
+    hub.send_signal(signal.SIGINT)
+    hub.stdout.readline()
+    hub.wait()
+    for m in motes:
+        m.wait()
+    for fd in fds:
+        os.close(fd)
+    cpuEnd = resource.getrusage(resource.RUSAGE_CHILDREN)
+    shutil.rmtree(tmp)
+
+    stats = {
+        'cpu':      (cpuEnd.ru_utime+cpuEnd.ru_stime)-(cpuStart.ru_utime+cpuStart.ru_stime),
+        'asleep':   0,
+        'awake':    0,
+        'latency':  [0]*NUMBINS,
+        'reported': 0,
+    }
+    for moteRows in rows.values():
+        if not moteRows:
+            continue
+        stats['reported'] += 1
+        last = max(moteRows.values(),key=lambda r: r[2]+r[3])
+        stats['asleep']   += last[2]
+        stats['awake']    += last[3]
+        for r in moteRows.values():
+            if r[0]<TASKPRIO_MAX:
+                stats['latency'] = [a+b for (a,b) in zip(stats['latency'],r[6:6+NUMBINS])]
+    return stats
+
+#============================ main ============================================
+
+def main():
+    parser = argparse.ArgumentParser()
+    parser.add_argument('openosProg')
+    parser.add_argument('freertosProg')
+    parser.add_argument('duration',  type=float, nargs='?', default=DEFAULT_DURATION)
+    parser.add_argument('numMotes',  type=int,   nargs='?', default=DEFAULT_NUMMOTES)
+    parser.add_argument('--topology',default='chain', choices=['full','chain','geo'])
+    args = parser.parse_args()
+
+    print('{0:>9} {1:>9} {2:>9} {3:>8} {4:>12} {5:>12} {6:>10}'.format(
+        'kernel','reported','asleep','tasks','latency p50','latency p99','cpu/mote',
+    ))
+    for (kernel,prog) in [('openos',args.openosProg),('freertos',args.freertosProg)]:
+        stats = run(prog,args.numMotes,args.duration,args.topology)
+        total = stats['asleep']+stats['awake']
+        print('{0:>9} {1:>9} {2:>8.2f}% {3:>8} {4:>12} {5:>12} {6:>9.2f}%'.format(
+            kernel,
+            '{0}/{1}'.format(stats['reported'],args.numMotes),
+            100.0*stats['asleep']/total if total else 0,
+            sum(stats['latency']),
+            percentile(stats['latency'],0.50),
+            percentile(stats['latency'],0.99),
+            100.0*stats['cpu']/args.duration/args.numMotes,
+        ))
+        sys.stdout.flush()
+
+if __name__=='__main__':
+    main()
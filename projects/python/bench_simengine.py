@@ -0,0 +1,149 @@
+'''
+Benchmark of the native simulation engine.
+
+Runs the full OpenWSN stack on 10, 100 and 1000 motes attached to a single
+SimEngine, laid out on a grid where each mote hears its 8 neighbors. With -g,
+the motes are placed on the plane half the range of the propagation model
+apart, and the engine derives the links from their positions. Mote 0 is made
+DAGroot over its (emulated) serial port. Prints how many simulated seconds
+are executed per wall-clock second.
+
+usage: python bench_simengine.py [-t numThreads] [-g] [simulatedSeconds] [numMotes ...]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import math
+import time
+
+import oos_openwsn
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 60
+DEFAULT_NUMMOTES  = [10,100,1000]
+LINK_PDR          = 1.0
+LINK_RSSI         = -70
+DAGROOT_PREFIX    = [0xbb,0xbb,0x00,0x00,0x00,0x00,0x00,0x00]
+
+HDLC_FLAG         = 0x7e
+HDLC_ESCAPE       = 0x7d
+HDLC_ESCAPE_MASK  = 0x20
+HDLC_CRCINIT      = 0xffff
+
+#============================ helpers =========================================
+
+def _crcTable():
+    table = []
+    for b in range(256):
+        v = b
+        for _ in range(8):
+            if v & 1:
+                v = (v>>1)^0x8408
+            else:
+                v = v>>1
+        table.append(v)
+    return table
+
+FCSTAB = _crcTable()
+
+def hdlcify(payload):
+    crc = HDLC_CRCINIT
+    for b in payload:
+        crc = (crc>>8)^FCSTAB[(crc^b) & 0xff]
+    crc = (~crc) & 0xffff
+    out = [HDLC_FLAG]
+    for b in payload+[crc & 0xff, (crc>>8) & 0xff]:
+        if b in [HDLC_FLAG,HDLC_ESCAPE]:
+            out += [HDLC_ESCAPE, b^HDLC_ESCAPE_MASK]
+        else:
+            out += [b]
+    out += [HDLC_FLAG]
+    return ''.join([chr(b) for b in out])
+
+def buildNetwork(numMotes,numThreads=1,boot=True,geo=False):
+    engine = oos_openwsn.SimEngine(1,numThreads)
+    motes  = []
+    for i in range(numMotes):
+        mote = oos_openwsn.OpenMote()
+        engine.addMote(mote)
+        motes += [mote]
+
+    # grid topology
+    side = int(math.ceil(math.sqrt(numMotes)))
+    if geo:
+        # the engine derives the links from the positions
+        spacing = engine.setPropagation()/2
+        for i in range(numMotes):
+            engine.setPosition(i,(i%side)*spacing,(i/side)*spacing)
+    else:
+        for i in range(numMotes):
+            (x,y) = (i%side, i/side)
+            for dx in [-1,0,1]:
+                for dy in [-1,0,1]:
+                    if (dx,dy)==(0,0):
+                        continue
+                    (nx,ny) = (x+dx,y+dy)
+                    if nx<0 or nx>=side or ny<0:
+                        continue
+                    j = ny*side+nx
+                    if j>=numMotes:
+                        continue
+                    engine.setLink(i,j,LINK_PDR,LINK_RSSI)
+
+    # motes restored from a snapshot are not booted
+    if not boot:
+        return (engine,motes)
+
+    # boot
+    for mote in motes:
+        mote.supply_on()
+
+    # mote 0 is DAGroot
+    engine.serialInput(0,hdlcify([ord('R'),ord('Y')]+DAGROOT_PREFIX))
+
+    return (engine,motes)
+
+#============================ main ============================================
+
+def main():
+    duration   = DEFAULT_DURATION
+    numMotes   = DEFAULT_NUMMOTES
+    numThreads = 1
+    geo        = False
+    args       = sys.argv[1:]
+    if len(args)>1 and args[0]=='-t':
+        numThreads = int(args[1])
+        args       = args[2:]
+    if len(args)>0 and args[0]=='-g':
+        geo        = True
+        args       = args[1:]
+    if len(args)>0:
+        duration = float(args[0])
+    if len(args)>1:
+        numMotes = [int(n) for n in args[1:]]
+
+    print '{0:>8} {1:>10} {2:>10} {3:>14} {4:>12} {5:>12}'.format(
+        'motes','sim (s)','wall (s)','sim-s/wall-s','events','frames rx',
+    )
+    for n in numMotes:
+        (engine,motes) = buildNetwork(n,numThreads,geo=geo)
+        start   = time.time()
+        engine.run(duration)
+        wall    = time.time()-start
+        stats   = engine.getStats()
+        print '{0:>8} {1:>10.1f} {2:>10.2f} {3:>14.1f} {4:>12} {5:>12}'.format(
+            n,
+            duration,
+            wall,
+            duration/wall,
+            stats['numEvents'],
+            stats['numFramesRx'],
+        )
+
+if __name__=='__main__':
+    main()
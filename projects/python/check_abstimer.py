@@ -0,0 +1,84 @@
+'''
+Check of the abstimer, which serves the bsp_timer and the radiotimer from the
+single compare channel of the sctimer.
+
+Runs a network of numMotes motes, then checks, on each mote, that the slot
+timer and the opentimers were both served, and that no interrupt nested
+another. Prints, per mote, how many events were served late, after they were
+due, by how many interrupts, and how many the last interrupt served late.
+
+Must be built with abstimer=1.
+
+usage: python check_abstimer.py [seconds] [numMotes]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+from bench_simengine import buildNetwork
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 120
+DEFAULT_NUMMOTES  = 9
+
+#============================ helpers =========================================
+
+def check(name,ok):
+    print '{0:<50} {1}'.format(name,'OK' if ok else 'FAILED')
+    return ok
+
+#============================ main ============================================
+
+def main():
+    duration = DEFAULT_DURATION
+    numMotes = DEFAULT_NUMMOTES
+    args     = sys.argv[1:]
+    if len(args)>0:
+        duration = float(args[0])
+    if len(args)>1:
+        numMotes = int(args[1])
+    ok       = True
+
+    (engine,motes) = buildNetwork(numMotes)
+    engine.run(duration)
+
+    states = [mote.getState() for mote in motes]
+    if 'abstimer_dbg' not in states[0]:
+        print 'not built with abstimer=1'
+        sys.exit(1)
+
+    for (i,s) in enumerate(states):
+        d   = s['abstimer_dbg']
+        ok  = check('mote {0}: {1} slots, {2} compares'.format(i,d['num_radiotimer_overflow'],d['num_radiotimer_compare']),
+            d['num_radiotimer_overflow']>0 and d['num_radiotimer_compare']>0
+        ) and ok
+        ok  = check('mote {0}: {1} bsp_timer events, no nested interrupt'.format(i,d['num_bsp_timer']),
+            d['num_bsp_timer']==s['opentimers_vars']['numWakeups'] and d['nested_isr']==0
+        ) and ok
+    ok      = check('{0} frames received'.format(engine.getStats()['numFramesRx']),
+        engine.getStats()['numFramesRx']>0
+    ) and ok
+
+    print
+    print '{0:>9} {1:>12} {2:>12} {3:>12} {4:>12}'.format(
+        'mote','events','late','late isrs','last isr',
+    )
+    for (i,s) in enumerate(states):
+        d        = s['abstimer_dbg']
+        events   = d['num_radiotimer_overflow']+d['num_radiotimer_compare']+d['num_bsp_timer']
+        print '{0:>9} {1:>12} {2:>12} {3:>12} {4:>12}'.format(
+            i,
+            events,
+            d['num_late_schedule'],
+            d['count_late'],
+            d['consecutive_late'],
+        )
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
@@ -0,0 +1,72 @@
+'''
+Check of the timer coalescing of opentimers.
+
+Runs a network of numMotes motes, then checks, on each mote, that timers
+fired, and that some fired late, in the wakeup of another timer, within
+their slack. Prints, per mote, the number of wakeups of the opentimers
+hardware timer per minute, and how many more there would be if each timer
+fired when it elapses. The last mote, furthest from the DAG root in the grid,
+stands for a leaf node.
+
+usage: python check_opentimers.py [seconds] [numMotes]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+from bench_simengine import buildNetwork
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 300
+DEFAULT_NUMMOTES  = 9
+
+#============================ helpers =========================================
+
+def check(name,ok):
+    print '{0:<50} {1}'.format(name,'OK' if ok else 'FAILED')
+    return ok
+
+#============================ main ============================================
+
+def main():
+    duration = DEFAULT_DURATION
+    numMotes = DEFAULT_NUMMOTES
+    args     = sys.argv[1:]
+    if len(args)>0:
+        duration = float(args[0])
+    if len(args)>1:
+        numMotes = int(args[1])
+    ok       = True
+
+    (engine,motes) = buildNetwork(numMotes)
+    engine.run(duration)
+
+    vars = [mote.getState()['opentimers_vars'] for mote in motes]
+    for (i,v) in enumerate(vars):
+        ok  = check('mote {0}: {1} timers fired, {2} coalesced'.format(i,v['numFired'],v['numCoalesced']),
+            v['numFired']>0 and 0<v['numCoalesced']<=v['numFired']
+        ) and ok
+
+    print
+    print '{0:>9} {1:>12} {2:>12} {3:>12} {4:>8}'.format(
+        'mote','wakeups/min','timers/min','no slack/min','saved',
+    )
+    for (i,v) in enumerate(vars):
+        perMin   = 60.0/duration
+        noSlack  = v['numWakeups']+v['numCoalesced']
+        print '{0:>9} {1:>12.1f} {2:>12.1f} {3:>12.1f} {4:>7.1f}%'.format(
+            '{0}{1}'.format(i,' (leaf)' if i==numMotes-1 else ''),
+            v['numWakeups']*perMin,
+            v['numFired']*perMin,
+            noSlack*perMin,
+            100.0*v['numCoalesced']/noSlack if noSlack else 0,
+        )
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
@@ -0,0 +1,98 @@
+'''
+Check of the propagation model of the native simulation engine.
+
+Places motes at random on the plane and verifies that the links the engine
+derives from their positions are exactly the pairs of motes closer than the
+range of the model, as found by comparing every pair. Then times how long
+deriving the links takes as the number of motes grows at constant density,
+which should grow linearly.
+
+usage: python check_propagation.py [numMotes ...]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import math
+import random
+import time
+
+import oos_openwsn
+
+#============================ defines =========================================
+
+DEFAULT_NUMMOTES  = [500,1000,5000]
+NEIGHBORS         = 10          # average number of motes in range of a mote
+
+#============================ helpers =========================================
+
+def place(numMotes,seed):
+    '''
+    returns an engine with numMotes motes placed at random, and their positions
+    '''
+    engine = oos_openwsn.SimEngine()
+    rng    = engine.setPropagation()
+    # NEIGHBORS motes within range, on average
+    side   = rng*math.sqrt(math.pi*numMotes/NEIGHBORS)
+    prng   = random.Random(seed)
+    pos    = []
+    for i in range(numMotes):
+        engine.addMote(oos_openwsn.OpenMote())
+        pos += [(prng.uniform(0,side),prng.uniform(0,side))]
+        engine.setPosition(i,pos[i][0],pos[i][1])
+    return (engine,rng,pos)
+
+def bruteForceLinks(rng,pos):
+    numLinks = 0
+    for i in range(len(pos)):
+        for j in range(len(pos)):
+            if i!=j and math.hypot(pos[i][0]-pos[j][0],pos[i][1]-pos[j][1])<rng:
+                numLinks += 1
+    return numLinks
+
+#============================ main ============================================
+
+def main():
+    numMotes = DEFAULT_NUMMOTES
+    if len(sys.argv)>1:
+        numMotes = [int(n) for n in sys.argv[1:]]
+
+    ok = True
+
+    # links match the pairs in range
+    (engine,rng,pos) = place(300,1)
+    engine.run(0)
+    expected = bruteForceLinks(rng,pos)
+    found    = engine.getStats()['numLinks']
+    print 'range {0:.1f}m: {1} links, {2} pairs in range {3}'.format(
+        rng,found,expected,'OK' if found==expected else 'MISMATCH',
+    )
+    ok = ok and found==expected
+
+    # moving a mote far away removes its links
+    engine.setPosition(0,-10*rng,-10*rng)
+    pos[0] = (-10*rng,-10*rng)
+    engine.run(0)
+    expected = bruteForceLinks(rng,pos)
+    found    = engine.getStats()['numLinks']
+    print 'after move: {0} links, {1} pairs in range {2}'.format(
+        found,expected,'OK' if found==expected else 'MISMATCH',
+    )
+    ok = ok and found==expected
+
+    # cost grows with the number of motes, not its square
+    print '{0:>8} {1:>10} {2:>14}'.format('motes','links','update (ms)')
+    for n in numMotes:
+        (engine,rng,pos) = place(n,2)
+        start = time.time()
+        engine.run(0)
+        wall  = time.time()-start
+        print '{0:>8} {1:>10} {2:>14.1f}'.format(n,engine.getStats()['numLinks'],1000*wall)
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
@@ -0,0 +1,164 @@
+'''
+Check of the scheduler instrumentation, built with schedstats=1.
+
+Runs a network of numMotes motes, then checks, on each mote, that:
+- each task started was counted once in the latency and run time histograms
+  of its priority;
+- the MAC interrupt handlers were counted, none nested;
+- the STATUS_SCHEDSTATS rows printed over serial are consistent with the
+  histograms returned by getState(), which they can only lag.
+Prints the histograms of mote 1, in host microseconds: the simulated time
+stands still while a mote runs, then the counters of its deadline-aware
+dispatch.
+
+usage: python check_schedstats.py [seconds] [numMotes]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import struct
+
+from bench_simengine import buildNetwork, HDLC_FLAG, HDLC_ESCAPE, HDLC_ESCAPE_MASK
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 60
+DEFAULT_NUMMOTES  = 10
+NUMBINS           = 12
+TASKPRIOS         = [
+    'NONE',
+    'SIXTOP_NOTIF_RX',
+    'SIXTOP_NOTIF_TXDONE',
+    'SIXTOP',
+    'RPL',
+    'TCP_TIMEOUT',
+    'COAP',
+    'ADAPTIVE_SYNC',
+    'OTF',
+    'BUTTON',
+    'SIXTOP_TIMEOUT',
+    'SNIFFER',
+]
+ISRS              = [
+    'IEEE154E_NEWSLOT',
+    'IEEE154E_TIMER',
+    'IEEE154E_STARTOFFRAME',
+    'IEEE154E_ENDOFFRAME',
+]
+SERFRAME_STATUS   = ord('S')
+STATUS_SCHEDSTATS = 11
+ROW               = struct.Struct('<BBIIHH{0}H{0}H'.format(NUMBINS))
+
+#============================ helpers =========================================
+
+def check(name,ok):
+    print '{0:<50} {1}'.format(name,'OK' if ok else 'FAILED')
+    return ok
+
+def statusRows(data,rows):
+    '''
+    appends the STATUS_SCHEDSTATS rows of the HDLC frames in data to rows
+    '''
+    for frame in data.split(chr(HDLC_FLAG)):
+        payload = []
+        escape  = False
+        for c in frame:
+            b = ord(c)
+            if b==HDLC_ESCAPE:
+                escape = True
+                continue
+            if escape:
+                b      ^= HDLC_ESCAPE_MASK
+                escape  = False
+            payload += [b]
+        # type, moteId (2B), statusElement, row, CRC (2B)
+        if len(payload)!=4+ROW.size+2 or payload[0]!=SERFRAME_STATUS or payload[3]!=STATUS_SCHEDSTATS:
+            continue
+        fields = ROW.unpack(''.join([chr(b) for b in payload[4:-2]]))
+        rows  += [(fields[0],fields[1],list(fields[6:6+NUMBINS]),list(fields[6+NUMBINS:]))]
+
+def percentile(bins,p):
+    '''
+    upper bound, in ticks, of the bin holding the p-th percentile
+    '''
+    total = sum(bins)
+    count = 0
+    for (b,n) in enumerate(bins):
+        count += n
+        if count>=p*total:
+            return (1<<b)-1 if b<NUMBINS-1 else float('inf')
+    return 0
+
+def printHist(name,bins):
+    print '{0:<28} {1:>8} {2:>8} {3:>8}   {4}'.format(
+        name,
+        sum(bins),
+        percentile(bins,0.50),
+        percentile(bins,0.99),
+        ' '.join(['{0:>5}'.format(n) for n in bins]),
+    )
+
+#============================ main ============================================
+
+def main():
+    duration = DEFAULT_DURATION
+    numMotes = DEFAULT_NUMMOTES
+    args     = sys.argv[1:]
+    if len(args)>0:
+        duration = float(args[0])
+    if len(args)>1:
+        numMotes = int(args[1])
+    ok       = True
+
+    (engine,motes) = buildNetwork(numMotes)
+    if 'taskLatency' not in motes[0].getState()['scheduler_dbg']:
+        print 'built without schedstats=1, nothing to check'
+        sys.exit(1)
+    rows = [[] for _ in motes]
+    engine.set_serialCallback(lambda i,data: statusRows(data,rows[i]))
+    engine.run(duration)
+
+    for (i,mote) in enumerate(motes):
+        dbg = mote.getState()['scheduler_dbg']
+        ok  = check('mote {0}: tasks counted once'.format(i),
+            [sum(h) for h in dbg['taskLatency']]==[sum(h) for h in dbg['taskRuntime']] and
+            sum([sum(h) for h in dbg['taskRuntime']])>0
+        ) and ok
+        ok  = check('mote {0}: interrupt handlers counted, not nested'.format(i),
+            dbg['isrNestingMax']==1 and
+            [sum(h) for h in dbg['isrDuration']]==[h[0] for h in dbg['isrNesting']] and
+            sum(dbg['isrNesting'][ISRS.index('IEEE154E_NEWSLOT')])>0
+        ) and ok
+        current = dbg['taskLatency']+dbg['isrDuration']
+        lagging = all([
+            row<len(current) and all([a<=b for (a,b) in zip(first,current[row])])
+            for (row,nestingMax,first,second) in rows[i]
+        ])
+        ok  = check('mote {0}: {1} rows printed over serial'.format(i,len(rows[i])),
+            len(rows[i])>0 and lagging
+        ) and ok
+
+    dbg = motes[1].getState()['scheduler_dbg']
+    print
+    print '{0:<28} {1:>8} {2:>8} {3:>8}   {4}'.format('mote 1 (us)','count','p50','p99','bins')
+    for (prio,name) in enumerate(TASKPRIOS):
+        if sum(dbg['taskLatency'][prio])==0:
+            continue
+        printHist('latency '+name,dbg['taskLatency'][prio])
+        printHist('run time '+name,dbg['taskRuntime'][prio])
+    for (isr,name) in enumerate(ISRS):
+        printHist(name,dbg['isrDuration'][isr])
+    print
+    print 'mote 1: {0} tasks deferred past a slot boundary, {1} started late'.format(
+        dbg['numTasksDeferred'],
+        dbg['numTasksLate'],
+    )
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
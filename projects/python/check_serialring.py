@@ -0,0 +1,115 @@
+'''
+Check of the serial port shared through OpenMote.serialRing().
+
+Runs the same network twice: once handing the serial output to Python through
+SimEngine.set_serialCallback() and making mote 0 DAGroot with
+SimEngine.serialInput(), then with every mote's serial port switched to a
+shared ring, drained every second of simulated time, and the DAGroot command
+written to the ring of mote 0. The motes must write the same bytes, and each
+record of the rings must be a whole HDLC frame. Prints the time spent by the
+host consuming the serial output either way.
+
+usage: python check_serialring.py [seconds] [numMotes]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import time
+
+import serialring
+from bench_simengine import buildNetwork, hdlcify, DAGROOT_PREFIX, HDLC_FLAG
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 60
+DEFAULT_NUMMOTES  = 10
+STEP              = 1.0
+
+#============================ helpers =========================================
+
+def splitFrames(data):
+    frames = []
+    start  = 0
+    for i in range(len(data)):
+        if ord(data[i])==HDLC_FLAG and i>start:
+            frames += [data[start:i+1]]
+            start   = i+1
+    return frames
+
+def runCallback(duration,numMotes):
+    (engine,motes) = buildNetwork(numMotes,boot=False)
+    output         = [[] for _ in motes]
+    spent          = [0.0]
+    def serialCb(moteIndex,data):
+        start = time.time()
+        output[moteIndex] += splitFrames(data)
+        spent[0]         += time.time()-start
+    engine.set_serialCallback(serialCb)
+    for mote in motes:
+        mote.supply_on()
+    engine.serialInput(0,hdlcify([ord('R'),ord('Y')]+DAGROOT_PREFIX))
+    engine.run(duration)
+    return (output,spent[0])
+
+def runRing(duration,numMotes):
+    (engine,motes) = buildNetwork(numMotes,boot=False)
+    rings          = [serialring.SerialRing(mote) for mote in motes]
+    output         = [[] for _ in motes]
+    spent          = 0.0
+    command        = hdlcify([ord('R'),ord('Y')]+DAGROOT_PREFIX)
+    assert rings[0].write(command)==len(command)
+    for mote in motes:
+        mote.supply_on()
+    elapsed = 0.0
+    while elapsed<duration:
+        engine.run(min(STEP,duration-elapsed))
+        elapsed += STEP
+        start    = time.time()
+        for (i,ring) in enumerate(rings):
+            for frame in ring.frames():
+                output[i] += [frame.tobytes()]
+        spent   += time.time()-start
+    stats = [mote.getNotifStats() for mote in motes]
+    return (output,spent,stats)
+
+#============================ main ============================================
+
+def main():
+    duration = DEFAULT_DURATION
+    numMotes = DEFAULT_NUMMOTES
+    args     = sys.argv[1:]
+    if len(args)>0:
+        duration = float(args[0])
+    if len(args)>1:
+        numMotes = int(args[1])
+
+    (expected,spentCallback)   = runCallback(duration,numMotes)
+    (found,spentRing,stats)    = runRing(duration,numMotes)
+
+    ok = True
+    print '{0:>6} {1:>8} {2:>9} {3:>8} {4:>8}'.format('mote','frames','dropped','rx','result')
+    for i in range(numMotes):
+        same  = expected[i]==found[i]
+        whole = all([f[0]==chr(HDLC_FLAG) and f[-1]==chr(HDLC_FLAG) for f in found[i]])
+        print '{0:>6} {1:>8} {2:>9} {3:>8} {4:>8}'.format(
+            i,
+            len(found[i]),
+            stats[i]['numSerialDropped'],
+            stats[i]['numSerialRxBytes'],
+            'OK' if (same and whole) else 'DIFFERS',
+        )
+        ok = ok and same and whole and stats[i]['numSerialDropped']==0
+    ok = ok and stats[0]['numSerialRxBytes']>0
+
+    numBytes = sum([len(f) for frames in found for f in frames])
+    print 'serial output: {0} bytes, host time {1:.3f}s with the callback, {2:.3f}s with the rings'.format(
+        numBytes,spentCallback,spentRing,
+    )
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
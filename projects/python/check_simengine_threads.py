@@ -0,0 +1,88 @@
+'''
+Determinism check of the multi-threaded native simulation engine.
+
+Simulates the same network with 1 thread, then with more threads, and
+verifies that every run produces the same radio trace (every frame sent and
+delivered), the same ASN on every mote and the same serial output.
+
+usage: python check_simengine_threads.py [simulatedSeconds] [numMotes] [numThreads ...]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import hashlib
+import time
+
+from bench_simengine import buildNetwork
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 120
+DEFAULT_NUMMOTES  = 100
+DEFAULT_THREADS   = [2,4]
+
+#============================ helpers =========================================
+
+def simulate(duration,numMotes,numThreads):
+    (engine,motes) = buildNetwork(numMotes,numThreads)
+    serial = [hashlib.md5() for _ in range(numMotes)]
+    def serialCb(id,bytes):
+        serial[id].update(bytes)
+    engine.set_serialCallback(serialCb)
+
+    start = time.time()
+    engine.run(duration)
+    wall  = time.time()-start
+
+    stats = engine.getStats()
+    trace = {
+        'traceDigest':   stats['traceDigest'],
+        'numEvents':     stats['numEvents'],
+        'numFramesTx':   stats['numFramesTx'],
+        'numFramesRx':   stats['numFramesRx'],
+        'numCollisions': stats['numCollisions'],
+        'asns':          engine.getAsns(),
+        'serial':        [h.hexdigest() for h in serial],
+    }
+    return (trace,wall,stats['numWindows'])
+
+#============================ main ============================================
+
+def main():
+    duration   = DEFAULT_DURATION
+    numMotes   = DEFAULT_NUMMOTES
+    numThreads = DEFAULT_THREADS
+    if len(sys.argv)>1:
+        duration   = float(sys.argv[1])
+    if len(sys.argv)>2:
+        numMotes   = int(sys.argv[2])
+    if len(sys.argv)>3:
+        numThreads = [int(n) for n in sys.argv[3:]]
+
+    (reference,wall,_) = simulate(duration,numMotes,1)
+    print '{0:>8} {1:>10} {2:>10} {3:>18} {4:>8}'.format(
+        'threads','wall (s)','windows','trace digest','result',
+    )
+    print '{0:>8} {1:>10.2f} {2:>10} {3:>18x} {4:>8}'.format(
+        1,wall,'-',reference['traceDigest'],'ref',
+    )
+
+    ok = True
+    for n in numThreads:
+        (trace,wall,windows) = simulate(duration,numMotes,n)
+        mismatch = [k for k in sorted(reference.keys()) if trace[k]!=reference[k]]
+        print '{0:>8} {1:>10.2f} {2:>10} {3:>18x} {4:>8}'.format(
+            n,wall,windows,trace['traceDigest'],'OK' if not mismatch else 'MISMATCH',
+        )
+        for k in mismatch:
+            print '   differs: {0}'.format(k)
+        ok = ok and not mismatch
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
@@ -0,0 +1,115 @@
+'''
+Check of the binary trace and of its replay.
+
+Records a network of numMotes motes, then replays the inputs of the DAG root
+and of the last mote, each into a single mote of its own engine, recording
+that run too. A replayed mote must go through exactly the same events as the
+recorded one: same timers, tasks, packet buffers, and frames sent, at the
+same times and ASNs. With -t, the network is recorded on several threads.
+
+usage: python check_simtrace.py [-t numThreads] [seconds] [numMotes]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import shutil
+import tempfile
+
+import oos_openwsn
+import simtrace
+from bench_simengine import buildNetwork, hdlcify, DAGROOT_PREFIX
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 120
+DEFAULT_NUMMOTES  = 10
+
+#============================ helpers =========================================
+
+def events(records,mote):
+    return [
+        (r.time,r.type,r.arg,r.asn,r.payload)
+        for r in records if r.mote==mote
+    ]
+
+def replay(path,traceMote,duration,replayPath):
+    engine = oos_openwsn.SimEngine()
+    mote   = oos_openwsn.OpenMote()
+    engine.addMote(mote)
+    engine.replay(0,path,traceMote)
+    engine.startTrace(replayPath)
+    mote.supply_on()
+    engine.run(duration)
+    engine.stopTrace()
+    return engine.getStats()
+
+#============================ main ============================================
+
+def main():
+    duration   = DEFAULT_DURATION
+    numMotes   = DEFAULT_NUMMOTES
+    numThreads = 1
+    args       = sys.argv[1:]
+    if len(args)>1 and args[0]=='-t':
+        numThreads = int(args[1])
+        args       = args[2:]
+    if len(args)>0:
+        duration = float(args[0])
+    if len(args)>1:
+        numMotes = int(args[1])
+
+    tmp  = tempfile.mkdtemp(prefix='simtrace-')
+    path = os.path.join(tmp,'network.trace')
+    ok   = True
+
+    # record a network, from the boot of its motes
+    (engine,motes) = buildNetwork(numMotes,numThreads,boot=False)
+    engine.startTrace(path)
+    for mote in motes:
+        mote.supply_on()
+    engine.serialInput(0,hdlcify([ord('R'),ord('Y')]+DAGROOT_PREFIX))
+    engine.run(duration)
+    numRecords = engine.stopTrace()
+    (header,records) = simtrace.read(path)
+    print 'recorded {0} motes for {1}s: {2} records, {3} bytes'.format(
+        numMotes,duration,numRecords,os.path.getsize(path),
+    )
+    ok = ok and numRecords==len(records) and header['numDropped']==0
+
+    print '{0:>6} {1:>9} {2:>6} {3:>9} {4:>7} {5:>8}'.format(
+        'mote','records','tx','replayed','missed','result',
+    )
+    for traceMote in [0,numMotes-1]:
+        replayPath = os.path.join(tmp,'mote{0}.trace'.format(traceMote))
+        stats      = replay(path,traceMote,duration,replayPath)
+        expected   = events(records,traceMote)
+        found      = events(simtrace.read(replayPath)[1],0)
+        same       = expected==found
+        print '{0:>6} {1:>9} {2:>6} {3:>9} {4:>7} {5:>8}'.format(
+            traceMote,
+            len(expected),
+            len([e for e in expected if e[1]==simtrace.RADIO_TX]),
+            stats['numReplayed'],
+            stats['numReplayMissed'],
+            'OK' if same else 'DIFFERS',
+        )
+        if not same:
+            for (i,(e,f)) in enumerate(zip(expected,found)):
+                if e!=f:
+                    print '   first difference at record {0}:'.format(i)
+                    print '   recorded {0}'.format(e[:4])
+                    print '   replayed {0}'.format(f[:4])
+                    break
+            else:
+                print '   {0} records recorded, {1} replayed'.format(len(expected),len(found))
+        ok = ok and same and stats['numReplayMissed']==0
+
+    shutil.rmtree(tmp)
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
@@ -0,0 +1,99 @@
+'''
+Check of OpenMote.snapshot() and OpenMote.restore().
+
+Lets a network form, snapshots every mote, then keeps simulating the
+original network while forks of it are restored from the snapshots into
+fresh motes and engines. Every fork must behave exactly like the original:
+same frames received, same ASN on every mote and same serial output.
+
+usage: python check_snapshot.py [formationSeconds] [experimentSeconds] [numMotes] [numForks]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import hashlib
+import time
+
+from bench_simengine import buildNetwork
+
+#============================ defines =========================================
+
+DEFAULT_FORMATION  = 300
+DEFAULT_EXPERIMENT = 60
+DEFAULT_NUMMOTES   = 25
+DEFAULT_NUMFORKS   = 2
+
+#============================ helpers =========================================
+
+def experiment(engine,numMotes,duration):
+    serial = [hashlib.md5() for _ in range(numMotes)]
+    def serialCb(id,bytes):
+        serial[id].update(bytes)
+    engine.set_serialCallback(serialCb)
+
+    framesRx = engine.getStats()['numFramesRx']
+    start    = time.time()
+    engine.run(duration)
+    wall     = time.time()-start
+
+    return ({
+        'numFramesRx':   engine.getStats()['numFramesRx']-framesRx,
+        'asns':          engine.getAsns(),
+        'serial':        [h.hexdigest() for h in serial],
+    },wall)
+
+#============================ main ============================================
+
+def main():
+    formation  = DEFAULT_FORMATION
+    duration   = DEFAULT_EXPERIMENT
+    numMotes   = DEFAULT_NUMMOTES
+    numForks   = DEFAULT_NUMFORKS
+    if len(sys.argv)>1:
+        formation  = float(sys.argv[1])
+    if len(sys.argv)>2:
+        duration   = float(sys.argv[2])
+    if len(sys.argv)>3:
+        numMotes   = int(sys.argv[3])
+    if len(sys.argv)>4:
+        numForks   = int(sys.argv[4])
+
+    # form the network
+    (engine,motes) = buildNetwork(numMotes)
+    start      = time.time()
+    engine.run(formation)
+    print 'formation: {0:.1f} s simulated in {1:.2f} s'.format(formation,time.time()-start)
+
+    # snapshot
+    start      = time.time()
+    snapshots  = [mote.snapshot() for mote in motes]
+    print 'snapshot:  {0} bytes for {1} motes in {2:.3f} s'.format(
+        sum([len(s) for s in snapshots]),numMotes,time.time()-start,
+    )
+
+    (reference,wall) = experiment(engine,numMotes,duration)
+    print '{0:>8} {1:>10} {2:>10} {3:>8}'.format('run','wall (s)','frames rx','result')
+    print '{0:>8} {1:>10.2f} {2:>10} {3:>8}'.format('original',wall,reference['numFramesRx'],'ref')
+
+    ok = True
+    for f in range(numForks):
+        (engine,motes) = buildNetwork(numMotes,boot=False)
+        for (mote,snapshot) in zip(motes,snapshots):
+            mote.restore(snapshot)
+        (trace,wall) = experiment(engine,numMotes,duration)
+        mismatch = [k for k in sorted(reference.keys()) if trace[k]!=reference[k]]
+        print '{0:>8} {1:>10.2f} {2:>10} {3:>8}'.format(
+            'fork {0}'.format(f),wall,trace['numFramesRx'],'OK' if not mismatch else 'MISMATCH',
+        )
+        for k in mismatch:
+            print '   differs: {0}'.format(k)
+        ok = ok and not mismatch
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
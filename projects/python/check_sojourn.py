@@ -0,0 +1,81 @@
+'''
+Check of the maximum sojourn of the packets in openqueue, under a CoAP storm.
+
+Must be built with cstorm=1, for the queues to build up, and the default
+OPENQUEUE_MAXSOJOURN_FORWARD and OPENQUEUE_MAXSOJOURN_LOCAL, or maxSojourn
+given to this script. Runs a network of numMotes motes, then checks that
+packets were dropped after waiting too long for the MAC, and that, on each
+mote, no forwarded or local packet the MAC took had waited longer. Prints,
+per mote, the packets dropped and the longest wait in each class.
+
+usage: python check_sojourn.py [seconds] [numMotes] [maxSojourn]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+from bench_simengine import buildNetwork
+
+#============================ defines =========================================
+
+DEFAULT_DURATION   = 300
+DEFAULT_NUMMOTES   = 9
+DEFAULT_MAXSOJOURN = 1000 # slots, OPENQUEUE_MAXSOJOURN_FORWARD and _LOCAL
+
+CLASSES            = ['control','6p','forward','local','rx']
+FORWARD            = 2
+LOCAL              = 3
+
+SLOT_S             = 0.015
+
+#============================ helpers =========================================
+
+def check(name,ok):
+    print '{0:<50} {1}'.format(name,'OK' if ok else 'FAILED')
+    return ok
+
+#============================ main ============================================
+
+def main():
+    duration   = DEFAULT_DURATION
+    numMotes   = DEFAULT_NUMMOTES
+    maxSojourn = DEFAULT_MAXSOJOURN
+    args       = sys.argv[1:]
+    if len(args)>0:
+        duration   = float(args[0])
+    if len(args)>1:
+        numMotes   = int(args[1])
+    if len(args)>2:
+        maxSojourn = int(args[2])
+    ok         = True
+
+    (engine,motes) = buildNetwork(numMotes)
+    engine.run(duration)
+
+    queues = [mote.getState()['openqueue_vars'] for mote in motes]
+
+    ok  = check('packets dropped, the queues built up',
+        sum([sum(q['numDropped']) for q in queues])>0
+    ) and ok
+    for (i,q) in enumerate(queues):
+        ok  = check('mote {0}: waited {1} forwarded, {2} local'.format(i,q['maxSojourn'][FORWARD],q['maxSojourn'][LOCAL]),
+            q['maxSojourn'][FORWARD]<=maxSojourn and q['maxSojourn'][LOCAL]<=maxSojourn
+        ) and ok
+
+    print
+    print '{0:>5} {1:>30} {2:>30}'.format('mote','dropped','longest wait (s)')
+    print '{0:>5} {1:>30} {2:>30}'.format('',' '.join(['{0:>5}'.format(c) for c in CLASSES]),' '.join(['{0:>5}'.format(c) for c in CLASSES]))
+    for (i,q) in enumerate(queues):
+        print '{0:>5} {1:>30} {2:>30}'.format(
+            i,
+            ' '.join(['{0:>5}'.format(n) for n in q['numDropped']]),
+            ' '.join(['{0:>5.1f}'.format(n*SLOT_S) for n in q['maxSojourn']]),
+        )
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
@@ -0,0 +1,100 @@
+'''
+Check of OpenMote.getStateDelta().
+
+Runs a network of numMotes motes, then checks, on mote 1 (a neighbor of the
+DAG root, hence synchronized), that:
+- getStateDelta() returns all modules, and getStateDelta(generation) none
+  while the mote does not run;
+- after a slot frame, only the modules which were written to are returned;
+- the returned buffers are views over the mote's memory, not copies;
+- a restored mote returns all of its modules.
+Prints the time of getState() and of getStateDelta() on all motes.
+
+usage: python check_statedelta.py [seconds] [numMotes]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+import time
+
+from bench_simengine import buildNetwork
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 60
+DEFAULT_NUMMOTES  = 10
+MODULES           = [
+    'idmanager_vars',
+    'ieee154e_stats',
+    'schedule_vars',
+    'openqueue_vars',
+    'neighbors_vars',
+]
+NUM_POLLS         = 100
+
+#============================ helpers =========================================
+
+def check(name,ok):
+    print '{0:<50} {1}'.format(name,'OK' if ok else 'FAILED')
+    return ok
+
+def timeit(fn,args):
+    start = time.time()
+    for _ in range(NUM_POLLS):
+        for arg in args:
+            fn(arg)
+    return (time.time()-start)/(NUM_POLLS*len(args))
+
+#============================ main ============================================
+
+def main():
+    duration = DEFAULT_DURATION
+    numMotes = DEFAULT_NUMMOTES
+    args     = sys.argv[1:]
+    if len(args)>0:
+        duration = float(args[0])
+    if len(args)>1:
+        numMotes = int(args[1])
+    ok       = True
+
+    (engine,motes) = buildNetwork(numMotes)
+    engine.run(duration)
+    mote = motes[1]
+
+    # all modules, then none
+    (generation,modules) = mote.getStateDelta()
+    ok = check('all modules returned',sorted(modules)==sorted(MODULES)) and ok
+    ok = check('no module changed while not running',mote.getStateDelta(generation)==(generation,{})) and ok
+
+    # a slot frame changes the schedule and the MAC statistics, not the id
+    schedule = str(modules['schedule_vars'])
+    engine.run(1)
+    (newGeneration,delta) = mote.getStateDelta(generation)
+    ok = check('generation advances',newGeneration>generation) and ok
+    ok = check('schedule and MAC statistics changed','schedule_vars' in delta and 'ieee154e_stats' in delta) and ok
+    ok = check('identity did not change','idmanager_vars' not in delta) and ok
+
+    # views are not copies
+    ok = check('views follow the mote',str(modules['schedule_vars'])!=schedule) and ok
+    ok = check('views are read-only',isinstance(modules['schedule_vars'],buffer)) and ok
+
+    # a restored mote changed entirely
+    blob = mote.snapshot()
+    mote.restore(blob)
+    (_,delta) = mote.getStateDelta(newGeneration)
+    ok = check('restored mote returns all modules',sorted(delta)==sorted(MODULES)) and ok
+
+    # cost of a poll, all modules or the changed ones (none here)
+    polls = [(m,m.getStateDelta()[0]) for m in motes]
+    print 'getState():              {0:8.1f} us/mote'.format(1e6*timeit(lambda (m,g): m.getState(),polls))
+    print 'getStateDelta():         {0:8.1f} us/mote'.format(1e6*timeit(lambda (m,g): m.getStateDelta(),polls))
+    print 'getStateDelta(current):  {0:8.1f} us/mote'.format(1e6*timeit(lambda (m,g): m.getStateDelta(g),polls))
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
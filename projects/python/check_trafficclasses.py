@@ -0,0 +1,83 @@
+'''
+Check of the traffic classes of openqueue, under a CoAP storm.
+
+Must be built with cstorm=1, for each mote to send a CoAP packet to the
+DAG root every CSTORM_PERIOD_MS, more than the network can carry. Runs a
+network of numMotes motes, then checks that the queue of some mote saturated,
+refusing locally generated packets, that no control or 6top packet was
+refused, and that each mote is still synchronized and has a DAG rank. Prints,
+per mote, the entries in use and the allocations refused in each class.
+
+usage: python check_trafficclasses.py [seconds] [numMotes]
+'''
+
+import sys
+import os
+if __name__=='__main__':
+    here = sys.path[0]
+    sys.path.insert(0, os.path.join(here, '..','common'))# contains openwsn module
+
+from bench_simengine import buildNetwork
+
+#============================ defines =========================================
+
+DEFAULT_DURATION  = 300
+DEFAULT_NUMMOTES  = 9
+
+CLASSES           = ['control','6p','forward','local','rx']
+CONTROL           = 0
+SIXP              = 1
+LOCAL             = 3
+
+NO_RANK           = 0xffff
+
+#============================ helpers =========================================
+
+def check(name,ok):
+    print '{0:<50} {1}'.format(name,'OK' if ok else 'FAILED')
+    return ok
+
+#============================ main ============================================
+
+def main():
+    duration = DEFAULT_DURATION
+    numMotes = DEFAULT_NUMMOTES
+    args     = sys.argv[1:]
+    if len(args)>0:
+        duration = float(args[0])
+    if len(args)>1:
+        numMotes = int(args[1])
+    ok       = True
+
+    (engine,motes) = buildNetwork(numMotes)
+    engine.run(duration)
+
+    states = [mote.getState() for mote in motes]
+    queues = [s['openqueue_vars'] for s in states]
+
+    ok  = check('local packets refused, the queue saturated',
+        sum([q['numRefused'][LOCAL] for q in queues])>0
+    ) and ok
+    for (i,s) in enumerate(states):
+        q   = s['openqueue_vars']
+        ok  = check('mote {0}: {1} control, {2} 6top refused'.format(i,q['numRefused'][CONTROL],q['numRefused'][SIXP]),
+            q['numRefused'][CONTROL]==0 and q['numRefused'][SIXP]==0
+        ) and ok
+        ok  = check('mote {0}: synchronized, rank {1}'.format(i,s['neighbors_vars']['myDAGrank']),
+            s['ieee154e_vars']['isSync'] and s['neighbors_vars']['myDAGrank']!=NO_RANK
+        ) and ok
+
+    print
+    print '{0:>5} {1:>30} {2:>30}'.format('mote','in use','refused')
+    print '{0:>5} {1:>30} {2:>30}'.format('',' '.join(['{0:>5}'.format(c) for c in CLASSES]),' '.join(['{0:>5}'.format(c) for c in CLASSES]))
+    for (i,q) in enumerate(queues):
+        print '{0:>5} {1:>30} {2:>30}'.format(
+            i,
+            ' '.join(['{0:>5}'.format(n) for n in q['numInClass']]),
+            ' '.join(['{0:>5}'.format(n) for n in q['numRefused']]),
+        )
+
+    sys.exit(0 if ok else 1)
+
+if __name__=='__main__':
+    main()
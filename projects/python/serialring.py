@@ -0,0 +1,68 @@
+'''
+Host side of the serial port a mote shares through OpenMote.serialRing().
+
+The layout of the ring is described in bsp/boards/python/serialring_obj.h.
+'''
+
+import struct
+
+#============================ defines =========================================
+
+TX_SIZE           = 8192
+RX_SIZE           = 1024
+INDEXES           = struct.Struct('=6I')
+TX_INDEXES        = struct.Struct('=3I') # txHead, txEnd, txTail
+RX_INDEXES        = struct.Struct('=2I') # rxHead, rxTail
+INDEX             = struct.Struct('=I')
+LENGTH            = struct.Struct('=H')
+OFFSET_TXTAIL     = 8
+OFFSET_RXHEAD     = 12
+OFFSET_NUMDROPPED = 20
+
+#============================ classes =========================================
+
+class SerialRing(object):
+
+    def __init__(self,mote):
+        self.view = mote.serialRing()
+        assert len(self.view)==INDEXES.size+TX_SIZE+RX_SIZE
+        self.tx   = self.view[INDEXES.size:INDEXES.size+TX_SIZE]
+        self.rx   = self.view[INDEXES.size+TX_SIZE:]
+
+    def frames(self):
+        '''
+        yields the HDLC frames written by the mote, flags included, each as a
+        memoryview over the ring valid until the next one is read
+        '''
+        while True:
+            (head,end,tail) = TX_INDEXES.unpack_from(self.view,0)
+            if tail==head:
+                return
+            if head>tail:
+                stop = head
+            elif tail<end:
+                stop = end
+            else:
+                # the mote wrapped around
+                INDEX.pack_into(self.view,OFFSET_TXTAIL,0)
+                continue
+            while tail<stop:
+                (length,) = LENGTH.unpack_from(self.tx,tail)
+                yield self.tx[tail+LENGTH.size:tail+LENGTH.size+length]
+                tail += (LENGTH.size+length+1)&~1
+                INDEX.pack_into(self.view,OFFSET_TXTAIL,tail)
+
+    def write(self,data):
+        '''
+        appends bytes for the mote to read, returns how many fit
+        '''
+        (head,tail) = RX_INDEXES.unpack_from(self.view,OFFSET_RXHEAD)
+        num         = min(len(data),(tail-head-1)%RX_SIZE)
+        first       = min(num,RX_SIZE-head)
+        self.rx[head:head+first] = data[:first]
+        self.rx[:num-first]      = data[first:num]
+        INDEX.pack_into(self.view,OFFSET_RXHEAD,(head+num)%RX_SIZE)
+        return num
+
+    def numDropped(self):
+        return INDEX.unpack_from(self.view,OFFSET_NUMDROPPED)[0]
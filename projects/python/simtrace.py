@@ -0,0 +1,123 @@
+'''
+Reader of the binary traces recorded by SimEngine.startTrace().
+
+As a script, prints the records of a trace, optionally only those of one
+mote, one per line.
+
+usage: python simtrace.py trace [moteIndex]
+'''
+
+import sys
+import struct
+
+#============================ defines =========================================
+
+MAGIC             = 0x52544f57
+VERSION           = 1
+HEADER            = struct.Struct('<IHHIIQQQ')
+RECORD            = struct.Struct('<QIHBB5s3x')
+ALIGN             = 8
+
+BOOT              = 1
+RADIO_TX          = 2
+RADIO_RX          = 3
+RADIO_COLLISION   = 4
+TIMER             = 5
+TASK              = 6
+QUEUE_ALLOC       = 7
+QUEUE_FREE        = 8
+SERIAL_IN         = 9
+
+TYPE_NAMES        = {
+    BOOT:             'boot',
+    RADIO_TX:         'tx',
+    RADIO_RX:         'rx',
+    RADIO_COLLISION:  'collision',
+    TIMER:            'timer',
+    TASK:             'task',
+    QUEUE_ALLOC:      'alloc',
+    QUEUE_FREE:       'free',
+    SERIAL_IN:        'serial',
+}
+
+#============================ classes =========================================
+
+class Record(object):
+    __slots__ = ['time','arg','mote','type','asn','payload']
+
+    def __init__(self,time,arg,mote,type,asn,payload):
+        self.time    = time
+        self.arg     = arg
+        self.mote    = mote
+        self.type    = type
+        self.asn     = asn
+        self.payload = payload
+
+    def __str__(self):
+        out = '{0:>14} mote {1:>4} asn 0x{2:010x} {3:<9}'.format(
+            self.time,self.mote,self.asn,TYPE_NAMES.get(self.type,self.type),
+        )
+        if self.type==TASK:
+            out += ' 0x{0:x}'.format(self.arg)
+        elif self.type in [QUEUE_ALLOC,QUEUE_FREE]:
+            out += ' entry {0} component {1}'.format(self.arg&0xff,self.arg>>8)
+        elif self.type in [RADIO_TX,RADIO_RX]:
+            out += ' freq {0}'.format(self.arg&0xff)
+            if self.type==RADIO_RX:
+                out += ' rssi {0}'.format(struct.unpack('b',struct.pack('B',(self.arg>>8)&0xff))[0])
+        elif self.type==TIMER:
+            out += ' event {0}'.format(self.arg)
+        if self.payload:
+            out += ' ' + ''.join(['{0:02x}'.format(ord(b)) for b in self.payload])
+        return out
+
+#============================ helpers =========================================
+
+def read(path):
+    '''
+    returns (header,records), header being a dict
+    '''
+    with open(path,'rb') as f:
+        data = f.read()
+    if len(data)<HEADER.size:
+        raise ValueError('{0} is not a trace'.format(path))
+    (magic,version,recordLen,unitsPerSec,_,numRecords,length,numDropped) = HEADER.unpack_from(data,0)
+    if magic!=MAGIC or version!=VERSION or recordLen!=RECORD.size:
+        raise ValueError('{0} is not a trace'.format(path))
+    header = {
+        'unitsPerSec':  unitsPerSec,
+        'numRecords':   numRecords,
+        'numDropped':   numDropped,
+    }
+
+    # a trace which was not stopped ends at the first zeroed record
+    end     = HEADER.size+length if length else len(data)
+    records = []
+    offset  = HEADER.size
+    while offset+RECORD.size<=end:
+        (time,arg,mote,type,plen,asn) = RECORD.unpack_from(data,offset)
+        if type==0:
+            break
+        asn      = sum([ord(b)<<(8*i) for (i,b) in enumerate(asn)])
+        payload  = data[offset+RECORD.size:offset+RECORD.size+plen]
+        records += [Record(time,arg,mote,type,asn,payload)]
+        offset  += (RECORD.size+plen+ALIGN-1)//ALIGN*ALIGN
+    return (header,records)
+
+#============================ main ============================================
+
+def main():
+    if len(sys.argv)<2:
+        print __doc__
+        sys.exit(1)
+    (header,records) = read(sys.argv[1])
+    mote = int(sys.argv[2]) if len(sys.argv)>2 else None
+    for r in records:
+        if mote is None or r.mote==mote:
+            print r
+    print '{0} records, {1} dropped, time in units of 1/{2} s'.format(
+        len(records),header['numDropped'],header['unitsPerSec'],
+    )
+
+if __name__=='__main__':
+    main()